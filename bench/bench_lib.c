@@ -0,0 +1,45 @@
+/* Latência da libcminus: analisa o mesmo fonte N vezes em memória e
+   relata o tempo por compilação. Uso: bench_lib arquivo N */
+#include "cminus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double relogio(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Uso: %s arquivo N\n", argv[0]);
+        return 1;
+    }
+    FILE *f = fopen(argv[1], "rb");
+    if (f == NULL) {
+        perror("Erro ao abrir arquivo");
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long tam = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *fonte = (char *) malloc(tam);
+    tam = (long) fread(fonte, 1, tam, f);
+    fclose(f);
+
+    int n = atoi(argv[2]);
+    int simbolos = 0, ok = 1;
+    double inicio = relogio();
+    for (int k = 0; k < n; k++) {
+        CmResultado *r = cmCompilaFonte(fonte, (size_t) tam);
+        ok = ok && cmOk(r);
+        simbolos = cmNumSimbolos(r);
+        cmLibera(r);
+    }
+    double segundos = relogio() - inicio;
+    printf("LIB: %d compilação(ões) em %.3f s (%.1f us cada), %d símbolo(s), %s\n",
+           n, segundos, n > 0 ? segundos / n * 1e6 : 0.0, simbolos, ok ? "ok" : "ERRO");
+    free(fonte);
+    return !ok;
+}
@@ -0,0 +1,108 @@
+/* Gerador de carga do servidor de compilação (--servidor): C conexões,
+   cada uma numa thread, mandam juntas N pedidos com o mesmo fonte e o
+   tempo de cada resposta vira os percentis. Uso: carga socket arquivo N C */
+#include "servidor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+static double relogio(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char *caminho;
+static char *fonte;
+static unsigned tam;
+
+typedef struct {
+    int n;
+    double *latencias;
+    int falhas;
+} Cliente;
+
+static void *cliente(void *arg) {
+    Cliente *c = (Cliente *) arg;
+    int fd = servidorConecta(caminho);
+    for (int k = 0; k < c->n; k++) {
+        char *texto;
+        double t0 = relogio();
+        if (fd < 0 || servidorPede(fd, fonte, tam, &texto) < 0) {
+            c->falhas += c->n - k;
+            break;
+        }
+        c->latencias[k] = relogio() - t0;
+        free(texto);
+    }
+    if (fd >= 0) close(fd);
+    return NULL;
+}
+
+static int crescente(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 5) {
+        fprintf(stderr, "Uso: %s socket arquivo N C\n", argv[0]);
+        return 1;
+    }
+    caminho = argv[1];
+    FILE *f = fopen(argv[2], "rb");
+    if (f == NULL) {
+        perror("Erro ao abrir arquivo");
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long lidos = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    fonte = (char *) malloc(lidos > 0 ? lidos : 1);
+    tam = (unsigned) fread(fonte, 1, lidos, f);
+    fclose(f);
+
+    int n = atoi(argv[3]), nc = atoi(argv[4]);
+    if (n < 1 || nc < 1) {
+        fprintf(stderr, "N e C devem ser >= 1\n");
+        return 1;
+    }
+    if (nc > n) nc = n;
+    Cliente *cs = (Cliente *) calloc(nc, sizeof(Cliente));
+    pthread_t *ts = (pthread_t *) malloc(sizeof(pthread_t) * nc);
+    double *latencias = (double *) calloc(n, sizeof(double));
+    int dados = 0;
+    for (int k = 0; k < nc; k++) {
+        cs[k].n = n / nc + (k < n % nc);
+        cs[k].latencias = latencias + dados;
+        dados += cs[k].n;
+    }
+
+    double inicio = relogio();
+    for (int k = 0; k < nc; k++) pthread_create(&ts[k], NULL, cliente, &cs[k]);
+    for (int k = 0; k < nc; k++) pthread_join(ts[k], NULL);
+    double segundos = relogio() - inicio;
+
+    int falhas = 0;
+    for (int k = 0; k < nc; k++) falhas += cs[k].falhas;
+    /* só as respostas que chegaram (as falhas ficam com latência 0) */
+    int m = 0;
+    for (int k = 0; k < nc; k++)
+        for (int i = 0; i < cs[k].n - cs[k].falhas; i++) latencias[m++] = cs[k].latencias[i];
+    qsort(latencias, m, sizeof(double), crescente);
+
+    printf("CARGA: %d pedido(s), %d conexão(ões), %d falha(s), %.3f s (%.0f pedidos/s)\n",
+           n, nc, falhas, segundos, segundos > 0 ? m / segundos : 0.0);
+    if (m > 0)
+        printf("CARGA: latência p50 %.1f us, p90 %.1f us, p99 %.1f us, máx %.1f us\n",
+               latencias[m / 2] * 1e6, latencias[m * 9 / 10] * 1e6,
+               latencias[m * 99 / 100] * 1e6, latencias[m - 1] * 1e6);
+    free(latencias);
+    free(cs);
+    free(ts);
+    free(fonte);
+    return falhas > 0;
+}
@@ -0,0 +1,9 @@
+#!/bin/bash
+# Marca cada linha de stderr do compilador com o tempo desde o início:
+# diagnostico.sh cminus [opções] arquivo
+agora() { local t=${EPOCHREALTIME/[.,]/}; echo $(( (t - inicio) / 1000 )); }
+inicio=${EPOCHREALTIME/[.,]/}
+"$@" 2>&1 >/dev/null | while IFS= read -r linha; do
+  printf '%7d ms  %s\n' "$(agora)" "$linha"
+done
+printf '%7d ms  (fim)\n' "$(agora)"
@@ -0,0 +1,22 @@
+#!/bin/bash
+# Gera um único programa com n funções: gera_enorme.sh arquivo n
+# Comentários com chaves e ';' testam a pré-varredura da análise paralela.
+saida=$1
+n=$2
+# identificadores de C- só têm letras: os dígitos de n viram a..j (em R)
+letras() { local s=$1; s=${s//0/a}; s=${s//1/b}; s=${s//2/c}; s=${s//3/d}; s=${s//4/e}
+  s=${s//5/f}; s=${s//6/g}; s=${s//7/h}; s=${s//8/i}; s=${s//9/j}; R=$s; }
+{
+  printf 'int g[100];\n'
+  for ((f = 1; f <= n; f++)); do
+    letras $f
+    printf '/* f%s { ; } */\nint f%s(int x, int v[])\n{\n  int i; int s;\n  i = 0; s = %d;\n' $R $R $f
+    printf '  while (i < x) { /* } */\n    if (s > 1000) s = s - x * %d; else s = s + i / (%d + 1);\n' $f $f
+    printf '    v[i - i / 100 * 100] = s;\n    i = i + 1;\n  }\n  return s;\n}\n'
+    if (( f % 1000 == 0 )); then printf 'int h%s;\n' $R; fi
+  done
+  printf 'void main(void)\n{\n  int t; t = input();\n'
+  letras $n
+  printf '  output(fb(t, g) + f%s(t, g));\n' $R
+  printf '}\n'
+} > "$saida"
@@ -0,0 +1,24 @@
+#!/bin/bash
+# Gera um corpus de programas para o modo lote: gera_lote.sh dir n
+# O programa k tem de 1 a 60 funções (tamanhos variados, determinístico).
+dir=$1
+n=$2
+# identificadores de C- só têm letras: os dígitos de n viram a..j (em R)
+letras() { local s=$1; s=${s//0/a}; s=${s//1/b}; s=${s//2/c}; s=${s//3/d}; s=${s//4/e}
+  s=${s//5/f}; s=${s//6/g}; s=${s//7/h}; s=${s//8/i}; s=${s//9/j}; R=$s; }
+mkdir -p "$dir"
+for ((k = 1; k <= n; k++)); do
+  nf=$(( (k * 37) % 60 + 1 ))
+  {
+    printf 'int g[100];\n'
+    for ((f = 1; f <= nf; f++)); do
+      letras $f
+      printf 'int f%s(int x, int v[])\n{\n  int i; int s;\n  i = 0; s = %d;\n' $R $f
+      printf '  while (i < x) {\n    if (s > 1000) s = s - x * %d; else s = s + i / (%d + 1);\n' $f $f
+      printf '    v[i - i / 100 * 100] = s;\n    i = i + 1;\n  }\n  return s;\n}\n'
+    done
+    printf 'void main(void)\n{\n  int t; t = input();\n'
+    for ((f = 1; f <= nf; f++)); do letras $f; printf '  output(f%s(t, g));\n' $R; done
+    printf '}\n'
+  } > "$dir/p$k.txt"
+done
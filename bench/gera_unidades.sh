@@ -0,0 +1,40 @@
+#!/bin/bash
+# Gera um programa dividido em k unidades de n funções cada (ub.txt,
+# uc.txt, ...), mais main.txt (que importa todas) e tudo.txt (o mesmo
+# programa num arquivo só): gera_unidades.sh dir k n
+dir=$1
+k=$2
+n=$3
+# identificadores de C- só têm letras: os dígitos de n viram a..j (em R)
+letras() { local s=$1; s=${s//0/a}; s=${s//1/b}; s=${s//2/c}; s=${s//3/d}; s=${s//4/e}
+  s=${s//5/f}; s=${s//6/g}; s=${s//7/h}; s=${s//8/i}; s=${s//9/j}; R=$s; }
+mkdir -p "$dir"
+for ((u = 1; u <= k; u++)); do
+  letras $u
+  U=$R
+  {
+    printf 'int g%s[100];\n' $U
+    for ((f = 1; f <= n; f++)); do
+      letras $f
+      printf 'int u%sx%s(int x, int v[])\n{\n  int i; int s;\n  i = 0; s = %d;\n' $U $R $f
+      printf '  while (i < x) {\n    if (s > 1000) s = s - x * %d; else s = s + i / (%d + 1);\n' $f $f
+      printf '    v[i - i / 100 * 100] = s;\n    i = i + 1;\n  }\n  return s;\n}\n'
+    done
+  } > "$dir/u$U.txt"
+done
+{
+  printf 'void main(void)\n{\n  int t; t = input();\n'
+  letras $n
+  N=$R
+  for ((u = 1; u <= k; u++)); do
+    letras $u
+    printf '  output(u%sxb(t, g%s) + u%sx%s(t, g%s));\n' $R $R $R $N $R
+  done
+  printf '}\n'
+} > "$dir/corpo"
+for ((u = 1; u <= k; u++)); do
+  letras $u
+  printf 'import u%s;\n' $R
+done | cat - "$dir/corpo" > "$dir/main.txt"
+cat "$dir"/u*.txt "$dir/corpo" > "$dir/tudo.txt"
+rm "$dir/corpo"
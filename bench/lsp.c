@@ -0,0 +1,200 @@
+/* Latência do servidor de linguagem (--lsp): abre um fonte gerado por
+   bench/gera_enorme.sh e mede o tempo de cada edição até os diagnósticos
+   chegarem. N edições trocam um dígito numa função qualquer; depois vêm
+   uma linha nova no início (todos os pedaços mudam de linha) e uma
+   mudança na assinatura de fb (main passa a ter um erro).
+   Uso: lsp cminus arquivo N */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static double relogio(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static FILE *para, *de;
+static int proximoId = 1;
+
+static void manda(const char *corpo) {
+    fprintf(para, "Content-Length: %zu\r\n\r\n%s", strlen(corpo), corpo);
+    fflush(para);
+}
+
+/* próxima mensagem do servidor (NULL se ele fechou) */
+static char *recebe(void) {
+    char linha[256];
+    long n = -1;
+    while (fgets(linha, sizeof(linha), de) != NULL) {
+        if (strcmp(linha, "\r\n") == 0) {
+            if (n < 0) continue;
+            char *corpo = (char *) malloc(n + 1);
+            if (fread(corpo, 1, n, de) != (size_t) n) {
+                free(corpo);
+                return NULL;
+            }
+            corpo[n] = '\0';
+            return corpo;
+        }
+        if (strncmp(linha, "Content-Length:", 15) == 0) n = atol(linha + 15);
+    }
+    return NULL;
+}
+
+/* espera os diagnósticos; devolve quantos vieram */
+static int diagnosticos(void) {
+    char *m;
+    while ((m = recebe()) != NULL) {
+        if (strstr(m, "\"textDocument/publishDiagnostics\"") != NULL) {
+            int n = 0;
+            for (char *p = m; (p = strstr(p, "\"severity\"")) != NULL; p++) n++;
+            free(m);
+            return n;
+        }
+        free(m);
+    }
+    fprintf(stderr, "o servidor fechou\n");
+    exit(1);
+}
+
+/* pedido com id: espera a resposta */
+static void pede(const char *metodo, const char *params) {
+    char buf[512];
+    int id = proximoId++;
+    snprintf(buf, sizeof(buf), "{\"jsonrpc\":\"2.0\",\"id\":%d,\"method\":\"%s\",\"params\":%s}", id, metodo, params);
+    manda(buf);
+    char esperado[32];
+    snprintf(esperado, sizeof(esperado), "\"id\":%d", id);
+    char *m;
+    while ((m = recebe()) != NULL) {
+        int achou = strstr(m, esperado) != NULL;
+        free(m);
+        if (achou) return;
+    }
+}
+
+/* troca o trecho de (l1, c1) a (l2, c2) por 'texto' (já escapado) */
+static double edita(int l1, int c1, int l2, int c2, const char *texto, int *nDiags) {
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+             "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didChange\",\"params\":{\"textDocument\":"
+             "{\"uri\":\"file:///enorme.txt\",\"version\":%d},\"contentChanges\":[{\"range\":{\"start\":"
+             "{\"line\":%d,\"character\":%d},\"end\":{\"line\":%d,\"character\":%d}},\"text\":\"%s\"}]}}",
+             proximoId++, l1, c1, l2, c2, texto);
+    double t0 = relogio();
+    manda(buf);
+    int n = diagnosticos();
+    if (nDiags != NULL) *nDiags = n;
+    return relogio() - t0;
+}
+
+static int crescente(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 4) {
+        fprintf(stderr, "Uso: %s cminus arquivo N\n", argv[0]);
+        return 1;
+    }
+    FILE *f = fopen(argv[2], "rb");
+    if (f == NULL) {
+        perror("Erro ao abrir arquivo");
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    long tam = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *fonte = (char *) malloc(tam + 1);
+    tam = (long) fread(fonte, 1, tam, f);
+    fonte[tam] = '\0';
+    fclose(f);
+    int n = atoi(argv[3]);
+    if (n < 2) n = 2;
+
+    /* linhas "  i = 0; s = K;" (uma por função) e a de "int fb(" */
+    int *linhas = (int *) malloc(sizeof(int) * (tam / 8 + 1));
+    int nLinhas = 0, linhaF1 = -1, l = 0, totalLinhas = 0;
+    for (char *p = fonte; *p != '\0'; l++) {
+        if (strncmp(p, "  i = 0; s = ", 13) == 0) linhas[nLinhas++] = l;
+        if (strncmp(p, "int fb(", 7) == 0) linhaF1 = l;
+        char *nl = strchr(p, '\n');
+        if (nl == NULL) break;
+        p = nl + 1;
+    }
+    totalLinhas = l;
+    if (nLinhas == 0 || linhaF1 < 0) {
+        fprintf(stderr, "%s não parece gerado por gera_enorme.sh\n", argv[2]);
+        return 1;
+    }
+
+    /* o texto vai numa string JSON */
+    char *didOpen = (char *) malloc(2 * tam + 256), *q = didOpen;
+    q += sprintf(q, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/didOpen\",\"params\":{\"textDocument\":"
+                    "{\"uri\":\"file:///enorme.txt\",\"languageId\":\"cminus\",\"version\":0,\"text\":\"");
+    for (long i = 0; i < tam; i++) {
+        if (fonte[i] == '\n') { *q++ = '\\'; *q++ = 'n'; }
+        else if (fonte[i] == '"' || fonte[i] == '\\') { *q++ = '\\'; *q++ = fonte[i]; }
+        else *q++ = fonte[i];
+    }
+    strcpy(q, "\"}}}");
+
+    int ida[2], volta[2];
+    if (pipe(ida) < 0 || pipe(volta) < 0) {
+        perror("pipe");
+        return 1;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(ida[0], 0);
+        dup2(volta[1], 1);
+        close(ida[1]);
+        close(volta[0]);
+        execl(argv[1], argv[1], "--lsp", (char *) NULL);
+        perror("exec");
+        _exit(1);
+    }
+    close(ida[0]);
+    close(volta[1]);
+    para = fdopen(ida[1], "w");
+    de = fdopen(volta[0], "r");
+
+    pede("initialize", "{\"capabilities\":{}}");
+    double t0 = relogio();
+    manda(didOpen);
+    int nd = diagnosticos();
+    printf("abertura: %d linhas, %d funções, %.1f ms, %d diagnóstico(s)\n", totalLinhas, nLinhas,
+           1000 * (relogio() - t0), nd);
+
+    /* um dígito a mais e a menos em funções espalhadas pelo arquivo */
+    double *lat = (double *) malloc(sizeof(double) * n);
+    for (int k = 0; k + 1 < n; k += 2) {
+        int alvo = linhas[(int) ((k / 2 * 7919L) % nLinhas)];
+        lat[k] = edita(alvo, 13, alvo, 13, "1", NULL);
+        lat[k + 1] = edita(alvo, 13, alvo, 14, "", NULL);
+    }
+    int m = n - n % 2;
+    qsort(lat, m, sizeof(double), crescente);
+    printf("edição numa função (%d): p50 %.2f ms, p99 %.2f ms, máx %.2f ms\n", m, 1000 * lat[m / 2],
+           1000 * lat[(int) (m * 0.99)], 1000 * lat[m - 1]);
+
+    double t = edita(0, 0, 0, 0, "\\n", NULL);
+    t += edita(0, 0, 1, 0, "", NULL);
+    printf("linha nova no início e de volta: %.2f ms cada\n", 1000 * t / 2);
+
+    /* fb(int x, int v[]) ganha um parâmetro: main chama fb com dois */
+    t = edita(linhaF1, 7, linhaF1, 12, "int x, int y", &nd);
+    printf("assinatura de fb: %.2f ms, %d diagnóstico(s)\n", 1000 * t, nd);
+    edita(linhaF1, 7, linhaF1, 19, "int x", NULL);
+
+    pede("shutdown", "null");
+    manda("{\"jsonrpc\":\"2.0\",\"method\":\"exit\"}");
+    int st;
+    waitpid(pid, &st, 0);
+    return WIFEXITED(st) ? WEXITSTATUS(st) : 1;
+}
@@ -0,0 +1,49 @@
+#!/bin/bash
+# Compilação separada (--exporta e import no fonte) x arquivo único, com
+# os fontes de gera_unidades.sh: separada.sh cminus runtime.o dir processos
+cminus=$1
+runtime=$2
+dir=$3
+p=$4
+set -e
+agora() { local t=${EPOCHREALTIME/[.,]/}; echo $((t / 1000)); }
+unidades=$(ls "$dir"/u*.txt | sed 's/\.txt$//')
+
+compilaUnidade() { "$cminus" --exporta "$1.cmi" -c -o "$1.o" "$1.txt" > /dev/null; }
+export -f compilaUnidade
+export cminus
+liga() { gcc -o "$dir/separado" "$dir"/u*.o "$dir/main.o" "$runtime"; }
+
+t0=$(agora)
+"$cminus" -c -o "$dir/tudo.o" "$dir/tudo.txt" > /dev/null
+gcc -o "$dir/tudo" "$dir/tudo.o" "$runtime"
+t1=$(agora)
+echo "SEPARADA: arquivo único: $((t1 - t0)) ms"
+
+t0=$(agora)
+echo $unidades | tr ' ' '\n' | xargs -P "$p" -I{} bash -c 'compilaUnidade {}'
+"$cminus" -c -o "$dir/main.o" "$dir/main.txt" > /dev/null
+liga
+t1=$(agora)
+echo "SEPARADA: $(echo $unidades | wc -w) unidade(s) e main, $p processo(s): $((t1 - t0)) ms"
+
+if [ "$(echo 50 | "$dir/tudo")" != "$(echo 50 | "$dir/separado")" ]; then
+  echo "SEPARADA: saídas diferentes"
+  exit 1
+fi
+
+# o corpo de uma função muda: só a unidade dela é recompilada, e main só
+# se a interface mudou
+u=$(echo $unidades | cut -d' ' -f1)
+sed -i '0,/s = 1;/s//s = 2;/' "$u.txt"
+t0=$(agora)
+"$cminus" --exporta "$u.cmi.novo" -c -o "$u.o" "$u.txt" > /dev/null
+if cmp -s "$u.cmi" "$u.cmi.novo"; then
+  rm "$u.cmi.novo"
+else
+  mv "$u.cmi.novo" "$u.cmi"
+  "$cminus" -c -o "$dir/main.o" "$dir/main.txt" > /dev/null
+fi
+liga
+t1=$(agora)
+echo "SEPARADA: uma função mudou, interface igual: $((t1 - t0)) ms"
@@ -2,11 +2,79 @@
 #define _ANALYZE_H_
 
 #include "arvore.h"
+#include "interface.h"
 
 // Constuir a tabela de símbolos
 void buildSymTab(TreeNode *);
 
+// Se diferente de zero, buildSymTab imprime a tabela (padrão: 1)
+extern int imprimeTabela;
+
 // Checagem de tipos
 void typeCheck(TreeNode *);
 
+// Análise por declaração (esteira.h), no lugar de buildSymTab + typeCheck:
+// analyzeInicia recomeça a tabela; analyzeDeclaracao insere e verifica uma
+// declaração de topo assim que ela fica pronta, sem olhar os irmãos, e
+// devolve 0 se ela usa um nome ainda não declarado e só será verificada no
+// fim; analyzeTermina confere main, imprime a tabela e verifica as que
+// ficaram para o fim.
+void analyzeInicia(void);
+int analyzeDeclaracao(TreeNode *decl);
+void analyzeTermina(void);
+
+// Tira da tabela as locais de uma declaração já verificada (--continuo:
+// ficam só as globais e as assinaturas das funções)
+void analyzeDescarta(TreeNode *decl);
+
+// Análise incremental (incremental.h), no lugar de buildSymTab + typeCheck:
+// analyzeAssinaturas recomeça a tabela e insere as globais e as assinaturas
+// das funções da lista de declarações; analyzeFuncao insere e verifica o
+// corpo de uma função, com a tabela completa, e retém os erros; as locais
+// ficam na tabela (e nos campos 'sym' da árvore) até analyzeDescarta. Os
+// erros retidos saem com analyzeRetido (em ordem) e são liberados com
+// analyzeLiberaRetidos; analyzeRelata relata um erro como se a análise o
+// tivesse achado. analyzeTermina fecha a análise.
+void analyzeAssinaturas(TreeNode *lista);
+int analyzeFuncao(TreeNode *decl);
+const char *analyzeRetido(int i, int *linha);
+void analyzeLiberaRetidos(void);
+void analyzeRelata(int linha, const char *mensagem);
+
+// Número de erros semânticos da última análise
+int analyzeErrors(void);
+
+// Tamanho (em células int) do segmento de variáveis globais
+int analyzeGlobalSize(void);
+
+// Número de funções (incluindo input e output); o loc de uma função é seu índice
+int analyzeFunctionCount(void);
+
+// Renumeração depois da eliminação de código morto (poda.h): novos
+// tamanhos do segmento de globais e da tabela de funções
+void analyzeCompacta(int tamanhoGlobais, int nFuncoes);
+
+// Compilação separada (interface.h): os símbolos das interfaces entram em
+// toda análise, logo depois das predefinidas, sem declaração na árvore
+// (NULL: sem importações). analyzeImportadas devolve quantas funções e
+// quantas células de globais vieram delas; os índices do programa começam
+// depois. O vetor tem de durar até a última análise.
+void analyzeImporta(Interface **interfaces, int n);
+const Interface *analyzeImportada(int i);
+int analyzeImportadas(int *celulas);
+
+// import nome; no fonte: a análise carrega nome.cmi do diretório dado aqui
+// (NULL: o corrente) e insere os símbolos como os de analyzeImporta, que
+// vêm antes na contagem de analyzeImportada. As carregadas assim ficam até
+// analyzeLiberaImportadas ou a próxima análise.
+void analyzeDiretorio(const char *dir);
+void analyzeLiberaImportadas(void);
+
+// Se zero, a falta de main não é erro (unidade que só exporta; padrão: 1)
+extern int exigeMain;
+
+// Índices fixos das funções predefinidas (inseridas primeiro por buildSymTab)
+#define FUN_INPUT 0
+#define FUN_OUTPUT 1
+
 #endif
\ No newline at end of file
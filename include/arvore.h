@@ -25,7 +25,8 @@ typedef enum
   NO_ARRAY_IDX,
   NO_CHAMADA,
   NO_ID,
-  NO_NUM
+  NO_NUM,
+  NO_IMPORT     /* import nome; (compilação separada, interface.h) */
 } NodeType;
 
 typedef enum {
@@ -50,6 +51,12 @@ typedef struct TreeNode
 
   ExpType type;
   int scopeId;
+
+  /* símbolo resolvido pela análise semântica (declarações e usos) */
+  struct BucketListRec *sym;
+
+  /* NO_ARRAY_IDX: índice não provado dentro dos limites (limites.h) */
+  int verificaLimite;
 } TreeNode;
 
 // Funções auxiliares
@@ -60,6 +67,12 @@ TreeNode *novoNoToken(NodeType tipo, char *lexema, int lineno);
 
 void imprimeArvore(TreeNode *arvore, int indent);
 
+// Cópia profunda de um nó e seus filhos (sem os irmãos)
+TreeNode *copiaArvore(TreeNode *arvore);
+
+// Libera um nó e seus filhos (sem os irmãos)
+void liberaArvore(TreeNode *arvore);
+
 extern TreeNode *raizArvore;
 
 #endif
\ No newline at end of file
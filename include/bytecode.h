@@ -0,0 +1,87 @@
+#ifndef _BYTECODE_H_
+#define _BYTECODE_H_
+
+#include <stdio.h>
+#include "arvore.h"
+
+// Instruções da máquina de pilha. Operandos (quando há) seguem o opcode
+// no vetor de código. Endereços são índices de células int na memória da VM:
+// globais a partir de 0, frames logo acima.
+typedef enum
+{
+  OP_HALT,
+  OP_CONST,   // k        : empilha k
+  OP_LOADL,   // d        : empilha mem[fp+d]
+  OP_STOREL,  // d        : mem[fp+d] = desempilha
+  OP_LOADG,   // a        : empilha mem[a]
+  OP_STOREG,  // a        : mem[a] = desempilha
+  OP_ADDRL,   // d        : empilha fp+d (array local)
+  OP_ADDRG,   // a        : empilha a (array global)
+  OP_LOADI,   //          : i, b -> mem[b+i]
+  OP_STOREI,  //          : v, i, b -> mem[b+i] = v
+  OP_STOREIK, //          : como STOREI, mas deixa v na pilha
+  OP_DUP,
+  OP_POP,
+  OP_ADD,
+  OP_SUB,
+  OP_MUL,
+  OP_DIV,
+  OP_LT,
+  OP_LE,
+  OP_GT,
+  OP_GE,
+  OP_EQ,
+  OP_NE,
+  OP_JMP,     // alvo
+  OP_JZ,      // alvo     : desvia se desempilhado == 0
+  OP_JNLT,    // alvo     : b, a -> desvia se !(a < b)  (comparação + desvio)
+  OP_JNLE,
+  OP_JNGT,
+  OP_JNGE,
+  OP_JNEQ,
+  OP_JNNE,
+  OP_CALL,    // f        : chama a função de índice f
+  OP_RET,     //          : retorna o topo da pilha
+  OP_RETV,    //          : retorno sem valor
+  OP_INPUT,
+  OP_OUTPUT,
+  OP_LIMITE,  // n        : erro se o índice no topo não está em [0, n)
+  OP_LIMITEL, // d        : erro se o índice no topo não está em [0, mem[fp+d])
+  OP_COUNT
+} OpCode;
+
+typedef struct
+{
+  char *nome;
+  int entrada;    // índice da primeira instrução (-1 para predefinidas)
+  int nparams;    // células dos parâmetros (int x[] leva o tamanho junto)
+  int frameSize;  // células de parâmetros + locais
+  int maxPilha;   // profundidade máxima da pilha de operandos
+  int retornaValor; // 1 se a função é int
+} BcFuncao;
+
+typedef struct
+{
+  int *codigo;
+  int nCodigo;
+  int capCodigo;
+
+  BcFuncao *funcoes;  // indexadas pelo loc do símbolo da função
+  int nFuncoes;
+  int principal;      // índice de main
+
+  int tamGlobais;
+} Bytecode;
+
+// Compila a árvore analisada (sem erros semânticos) para bytecode
+Bytecode *bcCompila(TreeNode *arvore);
+
+void bcLibera(Bytecode *bc);
+
+// Número de operandos de cada opcode
+int bcOperandos(OpCode op);
+
+// Listagem legível do código gerado
+void bcImprime(Bytecode *bc, FILE *saida);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef _CHAMADAS_H_
+#define _CHAMADAS_H_
+
+#include <stdio.h>
+#include "arvore.h"
+#include "symtab.h"
+
+// Grafo de chamadas do programa, a partir dos NO_CHAMADA resolvidos pela
+// semântica. As funções são indexadas pelo loc do símbolo (0 = input,
+// 1 = output, depois as importadas e as do programa na ordem de
+// declaração). As
+// componentes fortemente conexas (Tarjan) dão as funções recursivas,
+// inclusive mutuamente, e uma ordem de baixo para cima: cada função vem
+// depois de tudo o que ela chama fora da sua componente.
+
+typedef struct
+{
+  int nFuncoes;
+  BucketList *sym;        // por função
+  TreeNode **decl;        // NO_DECLARACAO_FUN (NULL para input, output e importadas)
+  int *inicioChamados;    // função f: chamados[inicioChamados[f] .. inicioChamados[f+1])
+  int *chamados;          // sem repetição
+  int nSccs;
+  int *scc;               // por função: componente (numerada de baixo para cima)
+  int *ordem;             // funções de baixo para cima (componentes contíguas)
+  char *recursiva;        // chama a si mesma, direta ou indiretamente
+  char *alcancavel;       // alcançável a partir de main
+  int main;               // índice de main (-1 se não houver)
+} GrafoChamadas;
+
+// Monta o grafo de uma árvore analisada sem erros
+GrafoChamadas *chamadasConstroi(TreeNode *arvore);
+
+void chamadasLibera(GrafoChamadas *g);
+
+// Exportação: DOT (Graphviz) ou JSON
+void chamadasDot(GrafoChamadas *g, FILE *saida);
+void chamadasJson(GrafoChamadas *g, FILE *saida);
+
+#endif
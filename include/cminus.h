@@ -0,0 +1,109 @@
+#ifndef _CMINUS_H_
+#define _CMINUS_H_
+
+// libcminus: o compilador como biblioteca (make lib: bin/libcminus.a e
+// bin/libcminus.so). bin/cminus é só a linha de comando em volta dela
+// (src/main.c).
+//
+// O compilador guarda estado em globais (flex, bison, tabela de símbolos),
+// então as chamadas de compilação são serializadas por uma trava: várias
+// threads podem chamar, uma de cada vez compila. Os resultados são
+// independentes entre si e podem ser usados e liberados em qualquer ordem.
+
+#include <stddef.h>
+#include "arvore.h"
+#include "symtab.h"
+#include "diagnostico.h"
+
+// --- Compilação de um arquivo, com todos os passes (a linha de comando) ---
+
+typedef struct
+{
+  int expandeInline;      // --inline
+  int bytecode;           // --bytecode
+  int executa;            // --run
+  int stats;              // --stats
+  int ir;                 // --ir
+  int assembly;           // -S
+  int objeto;             // -c
+  int traduzC;            // --emit-c
+  int cfg;                // --cfg
+  int poda;               // desligada por --sem-poda
+  int sintaxe;            // --sintaxe
+  int esteira;            // --esteira
+  int continuo;           // --continuo
+  int retemErros;         // --retem-erros
+  int jit;                // --jit
+  int verificado;         // --checked
+  int relatorioFluxo;     // --fluxo
+  int relatorioRegs;      // --regalloc
+  int processosParse;     // -j com um arquivo só (particao.h)
+  int listagem;           // fases, tabela e árvore em stdout
+  const char *chamadas;   // --chamadas
+  const char *saida;      // -o
+  const char *cache;      // --cache
+  const char *exporta;    // --exporta: interface da unidade (interface.h)
+  const char **importa;   // --importa: interfaces de outras unidades
+  int nImporta;
+} CmOpcoes;
+
+// Poda ligada, listagem ligada, um processo; o resto desligado
+void cmOpcoesPadrao(CmOpcoes *op);
+
+typedef struct
+{
+  int linhas;             // linhas lidas
+  int errosSemanticos;
+} CmArquivo;
+
+// Compila 'arquivo' como a linha de comando: listagens em stdout,
+// diagnósticos em stdout/stderr, saídas (-S, -c, --emit-c) gravadas em
+// disco. Devolve 0 se deu certo (erros semânticos só em info).
+int cmCompilaArquivo(const char *arquivo, const CmOpcoes *op, CmArquivo *info);
+
+// --- Compilação em memória: análise léxica, sintática e semântica ---
+
+typedef struct
+{
+  DiagTipo tipo;
+  int linha;              // 0: sem linha (falta de main)
+  char *mensagem;         // como seria impressa, sem o '\n'
+} CmDiagnostico;
+
+typedef struct
+{
+  const char *nome;
+  int escopo;             // 0 = global
+  int linha;
+  int loc;                // função: índice; variável: célula
+  ExpType tipo;
+  IdKind kind;
+  int tamanho;            // arrays
+  int numParams;          // funções
+} CmSimbolo;
+
+typedef struct CmResultado CmResultado;
+
+// Analisa 'tam' bytes de 'fonte' sem gravar arquivos nem imprimir nada (só
+// lê as interfaces de import nome;, nome.cmi no diretório corrente).
+// Sempre devolve um resultado (liberar com cmLibera).
+CmResultado *cmCompilaFonte(const char *fonte, size_t tam);
+
+// 1 se não houve nenhum diagnóstico
+int cmOk(const CmResultado *r);
+
+int cmNumDiagnosticos(const CmResultado *r);
+const CmDiagnostico *cmDiagnostico(const CmResultado *r, int i);
+
+// Raiz da árvore (NO_PROGRAMA; NULL se a análise sintática falhou). A
+// tabela de símbolos é liberada no fim da compilação, então os campos 'sym'
+// dos nós vêm zerados; os símbolos estão em cmSimbolo.
+const TreeNode *cmArvore(const CmResultado *r);
+
+// Tabela de símbolos (vazia se a análise sintática falhou)
+int cmNumSimbolos(const CmResultado *r);
+const CmSimbolo *cmSimbolo(const CmResultado *r, int i);
+
+void cmLibera(CmResultado *r);
+
+#endif
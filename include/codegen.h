@@ -0,0 +1,23 @@
+#ifndef _CODEGEN_H_
+#define _CODEGEN_H_
+
+#include <stdio.h>
+#include "arvore.h"
+#include "ir.h"
+
+// Gera assembly x86-64 (GNU as, convenção System V) para o programa.
+// Funções e globais de C- viram símbolos cm_<nome>; o executável é ligado
+// com o runtime (obj/runtime.o), que fornece cm_input e cm_output. Os
+// símbolos importados de outras unidades (interface.h) ficam para o
+// ligador, e só a unidade que define main tem o ponto de entrada.
+// Os vregs vão para registradores por varredura linear (regalloc.h).
+void codeGen(TreeNode *arvore, IrPrograma *ir, FILE *saida);
+
+// O mesmo código, codificado em processo e gravado como objeto ELF64
+// (objeto.h), sem passar pelo montador. Retorna 0 se ok.
+int codeGenObjeto(TreeNode *arvore, IrPrograma *ir, const char *origem, FILE *saida);
+
+// Se ligado, relata em stderr a alocação de registradores de cada função
+extern int relatorioRegs;
+
+#endif
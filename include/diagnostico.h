@@ -0,0 +1,33 @@
+#ifndef _DIAGNOSTICO_H_
+#define _DIAGNOSTICO_H_
+
+#include <stdarg.h>
+
+// Erros léxicos, sintáticos e semânticos passam todos por diagRelata. Sem
+// coletor, saem como sempre: léxicos e sintáticos em stdout, semânticos em
+// stderr. Com um coletor instalado (libcminus, cminus.h), cada um vira uma
+// chamada com tipo, linha e mensagem, e nada é impresso.
+
+typedef enum
+{
+  DIAG_LEXICO,
+  DIAG_SINTATICO,
+  DIAG_SEMANTICO
+} DiagTipo;
+
+// 'mensagem' é o texto que seria impresso (com o '\n' final); vale só
+// durante a chamada
+typedef void (*DiagColetor)(void *ctx, DiagTipo tipo, int linha, const char *mensagem);
+
+// Instala o coletor (NULL volta à impressão)
+void diagInstala(DiagColetor coletor, void *ctx);
+
+// O coletor instalado agora, para quem troca por um seu e depois repassa
+// as mensagens (esteira.h)
+void diagAtual(DiagColetor *coletor, void **ctx);
+
+// 'linha' é 0 quando o erro não tem linha (falta de main)
+void diagRelata(DiagTipo tipo, int linha, const char *fmt, ...);
+void diagRelataV(DiagTipo tipo, int linha, const char *fmt, va_list ap);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef _ESTEIRA_H_
+#define _ESTEIRA_H_
+
+#include "arvore.h"
+
+// Compilação em esteira (--esteira): análise léxica, sintática e semântica
+// em três threads ligadas por filas circulares de um produtor e um
+// consumidor. A thread do léxico roda o flex e enfileira token, lexema e
+// linha; o bison, na thread que chamou, lê essa fila por lexFila; cada
+// declaração de topo, assim que é reduzida, vai para a thread da semântica
+// (analyzeDeclaracao), antes de o arquivo terminar. Cada estágio mexe só
+// nas suas globais: flex, bison e árvore, tabela de símbolos.
+
+// Token corrente para o bison: no lugar de yylval, yylineno e yytext, que
+// na esteira pertencem à thread do léxico (veja o início de cminus.y)
+extern int linhaToken;
+extern char *textoToken;
+
+// yylex do bison: direto do flex ou, na esteira, da fila de tokens
+int lexFila(void);
+
+// Chamada pela gramática a cada declaração de topo reduzida; devolve o nó
+// que fica na lista de declarações (NULL se já foi analisado e liberado)
+TreeNode *esteiraDeclaracao(TreeNode *decl);
+
+// Erros semânticos da esteira e do modo contínuo: com 0 (padrão), cada um
+// sai assim que a declaração é verificada, e um erro sintático mais adiante
+// pode vir depois deles; com 1 (--retem-erros), ficam retidos até o fim de
+// yyparse e só saem se a sintaxe deu certo, como na análise normal
+extern int esteiraRetem;
+
+// 1 enquanto a thread da semântica pode estar lendo as declarações já
+// reduzidas: num erro sintático o bison não deve liberá-las
+int esteiraLendoArvore(void);
+
+typedef struct
+{
+  int semantica;        /* 1 se a análise semântica foi feita na esteira */
+  int declaracoes;      /* declarações de topo analisadas */
+  int adiantadas;       /* ... antes do fim da análise sintática */
+  int adiadas;          /* --continuo: verificadas só no fim */
+  double primeiroErro;  /* segundos até o primeiro erro semântico, ou -1 */
+} EsteiraStats;
+
+// Analisa o arquivo já aberto no flex (lexReinicia) e devolve o resultado
+// de yyparse. Com 'comSemantica', faz também buildSymTab e typeCheck por
+// declaração; falta só analyzeTermina depois. Se uma thread não puder ser
+// criada, o estágio correspondente roda do jeito normal (stats->semantica
+// diz se a semântica foi feita).
+int esteiraAnalisa(int comSemantica, EsteiraStats *stats);
+
+// Modo --continuo, sem threads: cada declaração de topo é analisada quando
+// a regra reduz e, se não ficou para o fim, sai da árvore e tem os nós e as
+// locais liberados na hora. Sobram na tabela só as globais e as assinaturas
+// das funções, então a memória é limitada pela maior função, não pelo
+// arquivo. Devolve o resultado de yyparse; falta analyzeTermina depois.
+int esteiraContinua(EsteiraStats *stats);
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef _FLUXO_H_
+#define _FLUXO_H_
+
+#include <stdio.h>
+#include "ir.h"
+
+// Análise de fluxo de dados sobre a IR. Cada função vira um grafo de blocos
+// básicos (FluxoCfg); um problema (FluxoProblema) tem um conjunto de bits
+// gen/kill por bloco e é resolvido por lista de trabalho, na ordem reversa
+// pós-ordem (para frente) ou pós-ordem (para trás). Nos programas
+// estruturados de C- isso converge em poucas passadas por bloco. Os avisos
+// de return ausente e código inalcançável usam outro grafo, o da árvore
+// (grafo.h), porque saem antes das reescritas e falam de linhas do fonte.
+
+#define FLUXO_BITS (8 * (int) sizeof(unsigned long))
+
+static inline void fluxoPoe(unsigned long *c, int b) { c[b / FLUXO_BITS] |= 1UL << (b % FLUXO_BITS); }
+static inline void fluxoTira(unsigned long *c, int b) { c[b / FLUXO_BITS] &= ~(1UL << (b % FLUXO_BITS)); }
+static inline int fluxoTem(const unsigned long *c, int b) { return (c[b / FLUXO_BITS] >> (b % FLUXO_BITS)) & 1; }
+
+typedef struct
+{
+  int ini, fim;       // primeira e última instrução
+  int succ[2];
+  int nSucc;
+  int *pred;
+  int nPred;
+} FluxoBloco;
+
+typedef struct
+{
+  IrFuncao *f;
+  FluxoBloco *blocos;
+  int nBlocos;
+  int *blocoDe;       // por instrução: bloco que a contém
+  int *blocoRotulo;   // por rótulo: bloco que ele inicia
+  int *ordem;         // blocos alcançáveis em ordem reversa pós-ordem
+  int nOrdem;
+} FluxoCfg;
+
+typedef enum { FLUXO_FRENTE, FLUXO_TRAS } FluxoDirecao;
+typedef enum { FLUXO_UNIAO, FLUXO_INTERSECAO } FluxoEncontro;
+
+typedef struct
+{
+  FluxoDirecao direcao;
+  FluxoEncontro encontro;
+  int nBits;
+  int nPalavras;
+  unsigned long *gen, *kill;  // por bloco, nPalavras palavras cada
+  unsigned long *in, *out;
+  unsigned long *fronteira;   // entrada (frente) ou saída (trás) da função
+  int iteracoes;              // blocos processados até o ponto fixo
+} FluxoProblema;
+
+FluxoCfg *fluxoCfg(IrFuncao *f);
+
+void fluxoLiberaCfg(FluxoCfg *cfg);
+
+// Problema vazio com nBits bits (gen, kill e fronteira zerados)
+FluxoProblema *fluxoNovo(FluxoCfg *cfg, FluxoDirecao direcao, FluxoEncontro encontro, int nBits);
+
+// Ponto fixo: out = gen | (in & ~kill) para frente, in = gen | (out & ~kill) para trás
+void fluxoResolve(FluxoCfg *cfg, FluxoProblema *p);
+
+void fluxoLibera(FluxoProblema *p);
+
+static inline unsigned long *fluxoConj(FluxoProblema *p, unsigned long *base, int bloco)
+{
+  return base + (size_t) bloco * p->nPalavras;
+}
+
+// vregs lidos pela instrução (em u, com espaço para fluxoMaxUsos(f))
+// e vreg definido (-1: nenhum)
+int fluxoUsos(IrInstr *i, int *u);
+int fluxoDefinicao(IrInstr *i);
+int fluxoMaxUsos(IrFuncao *f);
+
+// Vivacidade dos vregs (para trás, união): in/out = vivos na entrada/saída
+FluxoProblema *fluxoVivacidade(FluxoCfg *cfg);
+
+// Definições que alcançam cada bloco (para frente, união). O bit k é a
+// definição defs[k] (posição da instrução); defs é alocado aqui
+FluxoProblema *fluxoDefinicoes(FluxoCfg *cfg, int **defs, int *nDefs);
+
+// Locais escalares possivelmente sem valor (para frente, união sobre as
+// células do frame, a partir das declarações em f->decls). Cada variável
+// lida antes de receber valor em algum caminho gera um aviso em 'avisos'.
+// Devolve o número de avisos; 'iteracoes' recebe o custo do ponto fixo.
+int fluxoNaoInicializadas(FluxoCfg *cfg, FILE *avisos, int *iteracoes);
+
+// --fluxo: roda as três análises em cada função e relata blocos e iterações
+extern int relatorioFluxo;
+
+// Avisos de uso sem inicialização (e relatório com --fluxo) do programa todo
+int fluxoPrograma(IrPrograma *ir, FILE *saida);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef _GRAFO_H_
+#define _GRAFO_H_
+
+#include <stdio.h>
+#include "arvore.h"
+
+// Grafo de fluxo de controle de uma função, montado direto da árvore em
+// blocos básicos. Tudo fica em vetores compactos, no formato CSR: os
+// comandos de cada bloco são contíguos em cmds, e sucessores/predecessores
+// são faixas de succ/pred. Os blocos são numerados na ordem do código; o
+// bloco 0 é a entrada e o último (saida) é a saída virtual, que recebe os
+// returns e o fim do corpo.
+//
+// Um comando é uma expressão (atribuição, chamada), a condição de um
+// if/while (sempre o último comando do bloco) ou um NO_RETURN.
+//
+// Não é o grafo da análise de fluxo (fluxo.h), que é de instruções da IR:
+// este roda antes das reescritas (puras, poda, inline) e aponta para nós e
+// linhas do fonte, que a IR já não tem; aquele é o que a alocação de
+// registradores precisa, com faixas de instruções e os vregs. Um não se
+// deriva do outro sem refazer a travessia, então cada passe monta o seu e
+// o deste vive só durante os avisos.
+
+// marcas por bloco
+#define GRAFO_ALCANCAVEL 1   // alcançável a partir da entrada
+#define GRAFO_APOS_RETURN 2  // começa logo depois de um return
+#define GRAFO_FIM_CORPO 4    // chega ao fim do corpo (sai sem return)
+
+typedef struct
+{
+  TreeNode *funcao;     // NO_DECLARACAO_FUN
+  int nBlocos;          // inclui a saída virtual
+  int saida;
+  int nCmds;
+  TreeNode **cmds;
+  int *inicioCmds;      // bloco b: cmds[inicioCmds[b] .. inicioCmds[b+1])
+  int *inicioSucc;      // bloco b: succ[inicioSucc[b] .. inicioSucc[b+1])
+  int *succ;
+  int *inicioPred;
+  int *pred;
+  unsigned char *marca;
+} Grafo;
+
+Grafo *grafoConstroi(TreeNode *funcao);
+
+void grafoLibera(Grafo *g);
+
+// Lista os blocos (comandos por linha, sucessores, marcas)
+void grafoImprime(Grafo *g, FILE *saida);
+
+// Monta o grafo de cada função e avisa em stderr: função int que pode
+// terminar sem return, comandos inalcançáveis depois de return e blocos
+// inalcançáveis (condição constante). Com 'listagem' != NULL, imprime os
+// grafos nela. Devolve o número de avisos.
+int grafoVerifica(TreeNode *arvore, FILE *listagem);
+
+#endif
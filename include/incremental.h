@@ -0,0 +1,51 @@
+#ifndef _INCREMENTAL_H_
+#define _INCREMENTAL_H_
+
+#include <stdint.h>
+#include "arvore.h"
+
+// Análise semântica incremental (--cache dir). Primeiro entram na tabela as
+// globais e as assinaturas de todas as funções (analyzeAssinaturas); depois
+// cada função é verificada sozinha, com a tabela completa. O resultado de
+// uma função só depende do seu corpo e dos símbolos globais com os nomes
+// que ela usa, então a chave da função é um hash da subárvore (tipos de nó,
+// lexemas e linhas relativas ao início da função) e das assinaturas desses
+// nomes. Os diagnósticos de cada chave ficam num arquivo por fonte em 'dir';
+// na próxima análise, uma função com a mesma chave não é verificada e seus
+// diagnósticos são repetidos, com as linhas deslocadas se ela mudou de
+// lugar. Mudar uma assinatura muda a chave de quem usa o nome.
+
+typedef struct
+{
+  int funcoes;          /* funções analisadas */
+  int acertos;          /* ... com a chave no cache */
+  double segundos;      /* análise semântica, com a leitura e a gravação do cache */
+} IncrementalStats;
+
+// Insere e verifica o programa em 'raiz' (já analisado sintaticamente) com
+// o cache de 'arquivo' em 'dir'; falta analyzeTermina depois. As funções
+// que vêm do cache ficam sem as anotações da análise (tipos, símbolos),
+// então os passes seguintes não podem rodar.
+void incrementalAnalisa(TreeNode *raiz, const char *dir, const char *arquivo, IncrementalStats *stats);
+
+// O mesmo cache só em memória, para quem analisa o mesmo fonte várias vezes
+// no mesmo processo (lsp.h)
+typedef struct Incremental Incremental;
+
+Incremental *incrementalCria(void);
+void incrementalLibera(Incremental *inc);
+
+// A parte da chave de uma declaração que só depende da sua subárvore; quem
+// guarda a árvore entre uma análise e outra pode guardar o hash junto
+uint64_t incrementalHashArvore(TreeNode *decl);
+
+// Como incrementalAnalisa, para a lista de declarações 'lista'. 'hashes'
+// tem o incrementalHashArvore de cada declaração da lista, na ordem (NULL:
+// calcula). 'prepara' (se não for NULL) é chamada antes de verificar cada
+// função que não veio do cache. Depois o cache tem só as funções desta
+// análise. Entre uma chamada e outra, só são percorridas as funções que
+// mudaram e as que usam um nome global cuja assinatura mudou.
+void incrementalVerifica(Incremental *inc, TreeNode *lista, const uint64_t *hashes,
+                         void (*prepara)(TreeNode *decl, void *ctx), void *ctx, IncrementalStats *stats);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef _INLINE_H_
+#define _INLINE_H_
+
+#include "arvore.h"
+
+// Expansão de chamadas (inlining) guiada por modelo de custo.
+// Deve rodar depois de buildSymTab/typeCheck sem erros.
+// Cada chamada expandida é relatada em stderr; retorna o total expandido.
+int inlineFunctions(TreeNode *);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef _INTERFACE_H_
+#define _INTERFACE_H_
+
+#include "arvore.h"
+#include "symtab.h"
+
+// Compilação separada: uma unidade compilada com --exporta grava a sua
+// interface, as funções (tipo e parâmetros) e as globais que ela define,
+// num arquivo binário compacto. Quem importa (import nome; no fonte, que
+// lê nome.cmi ao lado dele, ou --importa) carrega a interface direto na
+// tabela de símbolos (analyze.h), sem reler o fonte da outra unidade, e
+// liga com o objeto dela (-c ou -S).
+//
+// Arquivo: "CMI1", número de símbolos e, por símbolo, kind, tipo,
+// tamanho, número de parâmetros, tamanho do nome, o nome e um byte por
+// parâmetro (tipo, mais 4 se for int x[]); inteiros na ordem da máquina.
+
+typedef struct
+{
+  char *nome;
+  ExpType tipo;
+  IdKind kind;
+  int tamanho;            // arrays: número de elementos
+  int numParams;          // funções
+  ExpType *paramTypes;
+  char *paramArray;       // 1 se o parâmetro é int x[]
+} InterfaceSimbolo;
+
+typedef struct
+{
+  char *arquivo;
+  InterfaceSimbolo *simbolos;
+  int n;
+} Interface;
+
+// Grava a interface das declarações de topo da árvore já analisada, sem
+// erros (só o que a árvore define, não o que ela importou). Devolve 0 se
+// o arquivo foi gravado.
+int interfaceGrava(TreeNode *arvore, const char *arquivo);
+
+// NULL (com a mensagem em stderr) se o arquivo não existe ou não é uma
+// interface
+Interface *interfaceCarrega(const char *arquivo);
+
+// Como interfaceCarrega, sem imprimir: no NULL, 'motivo' diz por quê
+// (import no fonte, que sai como erro semântico)
+Interface *interfaceLe(const char *arquivo, const char **motivo);
+
+void interfaceLibera(Interface *i);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef _IR_H_
+#define _IR_H_
+
+#include <stdio.h>
+#include "arvore.h"
+#include "symtab.h"
+
+// Representação intermediária de três endereços com registradores virtuais
+// (vregs). Em cada função, os vregs 0..frameSize-1 são as próprias células
+// do frame (parâmetros e locais escalares, pelo loc do símbolo); os
+// temporários vêm depois. Arrays locais ocupam células mas só são acessados
+// pelo endereço (IR_ADDR).
+typedef enum
+{
+  IR_LI,      // d = imm
+  IR_MOV,     // d = a
+  IR_ADD,     // d = a + b
+  IR_SUB,
+  IR_MUL,
+  IR_DIV,
+  IR_CMP,     // d = (a cc b)
+  IR_LOADG,   // d = global escalar sym
+  IR_STOREG,  // global escalar sym = a
+  IR_ADDR,    // d = endereço do array sym (global ou local)
+  IR_LOAD,    // d = a[b]
+  IR_STORE,   // a[b] = c
+  IR_LABEL,   // rótulo imm
+  IR_JMP,     // goto imm
+  IR_BR,      // if (a cc b) goto imm; cc em cc
+  IR_BZ,      // if (a == 0) goto imm
+  IR_BNZ,     // if (a != 0) goto imm
+  IR_CALL,    // d = sym(args) (d = -1 se void)
+  IR_RET,     // return a (a = -1 se void)
+  IR_LIMITE   // erro de execução se a não está em [0, imm), ou em [0, b) se
+              // b >= 0 (parâmetro int x[]) (--checked)
+} IrOp;
+
+// Condições de comparação
+typedef enum { CC_LT, CC_LE, CC_GT, CC_GE, CC_EQ, CC_NE } IrCond;
+
+typedef struct
+{
+  IrOp op;
+  int d, a, b, c;
+  int imm;
+  IrCond cc;
+  BucketList sym;
+  int *args;
+  int nargs;
+  int lineno;
+} IrInstr;
+
+// Declaração de local escalar: a partir da instrução pos a célula
+// sym->loc é uma variável nova, ainda sem valor (células são reaproveitadas
+// entre blocos irmãos)
+typedef struct
+{
+  int pos;
+  BucketList sym;
+} IrDecl;
+
+typedef struct
+{
+  BucketList sym;
+  IrInstr *instr;
+  int n;
+  int cap;
+  int nvregs;     // total de vregs (células do frame + temporários)
+  int nrotulos;
+  char *ehPonteiro; // por vreg: guarda endereço (array) e não int
+  IrDecl *decls;    // locais escalares, na ordem do código
+  int nDecls;
+} IrFuncao;
+
+typedef struct
+{
+  IrFuncao *funcoes;
+  int nFuncoes;
+} IrPrograma;
+
+// Gera a IR de todas as funções da árvore analisada (sem erros)
+IrPrograma *irGera(TreeNode *arvore);
+
+void irLibera(IrPrograma *ir);
+
+void irImprime(IrPrograma *ir, FILE *saida);
+
+// Condição negada (!(a cc b) == (a neg(cc) b))
+IrCond irNegaCond(IrCond cc);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _JIT_H_
+#define _JIT_H_
+
+#include "bytecode.h"
+
+// Compilação em tempo de execução (JIT) das funções quentes da VM.
+// Cada função é traduzida, instrução de bytecode por instrução, para
+// x86-64 em memória executável (mmap). O código nativo usa o mesmo frame
+// da VM (células int em mem, operandos logo acima das locais), então a
+// execução pode passar do interpretador para o nativo no meio de um laço.
+
+// Chamadas + desvios de volta de laço até a função ser compilada
+#define JIT_LIMIAR 1000
+
+// fp: frame na memória da VM; continua: NULL para o início da função ou
+// uma entrada de laço (entradaLaco) para a troca no meio da execução
+typedef int (*JitNativo)(int *fp, void *continua);
+
+typedef struct
+{
+  Bytecode *bc;
+  int *mem;
+  int *limite;             // fim da memória da VM
+  JitNativo *nativo;       // por função: NULL enquanto interpretada
+  void **entradaLaco;      // por posição do bytecode: início de laço no nativo
+  char *limitePilhaC;      // abaixo disto a pilha do processo estourou
+
+  // chamada de função ainda interpretada a partir do código nativo
+  int (*chamaVm)(int funcao, int *fp);
+  // erro de execução (não retorna)
+  void (*falha)(const char *erro, const char *funcao);
+
+  int compiladas;
+  long bytes;
+  struct JitMapa *mapas;   // regiões mmap com o código gerado
+} Jit;
+
+Jit *jitCria(Bytecode *bc, int *mem, int *limite,
+             int (*chamaVm)(int, int *), void (*falha)(const char *, const char *));
+
+// Compila a função de índice f; retorna 0 se o código nativo foi instalado
+int jitCompila(Jit *jit, int f);
+
+void jitLibera(Jit *jit);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef _JSON_H_
+#define _JSON_H_
+
+#include <stddef.h>
+
+// JSON mínimo para o servidor de linguagem (lsp.h): leitura para uma
+// árvore de valores e escrita num buffer que cresce.
+
+typedef enum
+{
+  JSON_NULO,
+  JSON_BOOL,
+  JSON_NUMERO,
+  JSON_TEXTO,
+  JSON_LISTA,
+  JSON_OBJETO
+} JsonTipo;
+
+typedef struct Json
+{
+  JsonTipo tipo;
+  double numero;          // JSON_NUMERO; JSON_BOOL: 0 ou 1
+  char *texto;            // JSON_TEXTO, em UTF-8
+  char *chave;            // membro de um objeto
+  struct Json *filho;     // lista e objeto: o primeiro elemento
+  struct Json *irmao;
+} Json;
+
+// Lê 'tam' bytes; NULL se não for um valor JSON válido
+Json *jsonLe(const char *texto, size_t tam);
+void jsonLibera(Json *v);
+
+// Membro 'chave' de um objeto (NULL se 'v' não for objeto ou não tiver)
+Json *jsonCampo(const Json *v, const char *chave);
+
+// Texto de um JSON_TEXTO (NULL para os outros tipos)
+const char *jsonTexto(const Json *v);
+
+// Número inteiro de um JSON_NUMERO ('padrao' para os outros tipos)
+int jsonInt(const Json *v, int padrao);
+
+// --- Escrita ---
+
+typedef struct
+{
+  char *p;                // sempre terminado em '\0'
+  size_t n, cap;
+} JsonSaida;
+
+// Acrescenta texto já formatado como JSON
+void jsonPoe(JsonSaida *s, const char *fmt, ...);
+
+// Acrescenta 'texto' como string JSON, com aspas e escapes
+void jsonPoeTexto(JsonSaida *s, const char *texto);
+
+// Acrescenta um valor lido (para devolver o id de um pedido)
+void jsonPoeValor(JsonSaida *s, const Json *v);
+
+void jsonLiberaSaida(JsonSaida *s);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef _LIMITES_H_
+#define _LIMITES_H_
+
+#include <stdio.h>
+#include "arvore.h"
+
+// Análise de intervalos dos índices de array. Acompanha, por função, o
+// intervalo de valores de cada local escalar (com alargamento nos laços e
+// refinamento pelas condições de if/while) e classifica cada NO_ARRAY_IDX
+// de array com tamanho conhecido: provado dentro de [0, size-1]
+// (verificaLimite = 0), provado fora (aviso em avisos, se não NULL) ou
+// desconhecido. Só desliga marcas, então pode rodar de novo depois do
+// inline para provar mais acessos.
+// Arrays parâmetros ficam sempre desconhecidos: o tamanho vem com eles em
+// execução (st_celula_tamanho), e o teste compara com ele.
+
+typedef struct
+{
+  int acessos;     // NO_ARRAY_IDX analisados
+  int seguros;     // provados dentro dos limites
+  int fora;        // provados fora dos limites (avisados)
+} LimitesStats;
+
+void analisaLimites(TreeNode *arvore, LimitesStats *stats, FILE *avisos);
+
+// --checked: os geradores (bytecode/VM/JIT, -S/-c e --emit-c) testam em
+// execução os acessos com verificaLimite ligado
+extern int modoVerificado;
+
+// O acesso precisa de teste em execução no modo verificado?
+int precisaTesteLimite(TreeNode *acesso);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _LOTE_H_
+#define _LOTE_H_
+
+// Compilação de vários arquivos num processo só (modo lote), em sequência
+// ou com vários processos trabalhadores (-j N). O compilador guarda estado
+// em variáveis globais em quase todos os passes, então cada trabalhador é
+// um processo (fork) com sua própria tabela de símbolos e seu próprio heap.
+// Os arquivos são distribuídos do maior para o menor por um cursor
+// compartilhado: quem termina pega o próximo. A saída de cada arquivo
+// (stdout e stderr) é capturada e despejada na ordem da linha de comando,
+// então o resultado não depende do escalonamento.
+
+typedef struct
+{
+  int ok;
+  int linhas;
+  double segundos;
+} LoteArquivo;
+
+// Compila um arquivo; devolve 1 se deu certo e as linhas lidas
+typedef int (*LoteCompila)(char *arquivo, int *linhas);
+
+// Chamada na ordem dos arquivos, depois da saída do arquivo
+typedef void (*LoteRelata)(char *arquivo, LoteArquivo *r);
+
+// Compila arquivos[0 .. n) com 'trabalhadores' processos (1 = no próprio
+// processo, sem captura). Preenche res[0 .. n).
+void loteExecuta(char **arquivos, int n, int trabalhadores,
+                 LoteCompila compila, LoteRelata relata, LoteArquivo *res);
+
+// Relógio monotônico, em segundos
+double loteRelogio(void);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _LSP_H_
+#define _LSP_H_
+
+// Servidor de linguagem (--lsp): Language Server Protocol em stdin/stdout,
+// para editores. Publica os diagnósticos de cada documento aberto, responde
+// hover (tipo e kind do símbolo, da tabela de símbolos) e ir para a
+// definição (a linha do registro na tabela).
+//
+// Cada documento fica dividido em pedaços, um por declaração de topo (o
+// corte de particao.c: depois de '}' ou ';' com profundidade zero, fora de
+// comentários), cada um com a sua árvore. Uma edição só relê os pedaços
+// que ela tocou: a varredura recomeça no pedaço da edição e para no
+// primeiro corte que coincide com um corte antigo; os pedaços seguintes
+// só mudam de linha. A semântica usa a análise incremental em memória
+// (incremental.h): só são verificadas as funções que mudaram e as que
+// usam um nome global cuja assinatura mudou.
+//
+// Os pedaços são analisados sintaticamente um a um, então um erro de
+// sintaxe numa declaração não esconde os erros das outras.
+
+// Atende até a notificação "exit"; devolve 0 se antes veio "shutdown".
+// Com 'stats', relata em stderr o tempo de cada atualização. O processo
+// inteiro fica com o servidor: ele usa o analisador sem a trava da
+// libcminus e troca o stdout por stderr, para nada além do protocolo sair
+// no stdout original.
+int lspExecuta(int stats);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef _OBJETO_H_
+#define _OBJETO_H_
+
+#include <stdio.h>
+#include "x86.h"
+
+// Grava o código de um X86Asm em modo binário (já finalizado) como objeto
+// ELF64 relocável: .text com as funções, .data, .bss com as globais,
+// tabela de símbolos e relocações para as chamadas e os acessos a globais.
+// O objeto é ligado como o assembly do -S (gcc prog.o obj/runtime.o).
+// Retorna 0 se o arquivo foi gravado.
+int objEscreveElf(X86Asm *a, const char *origem, FILE *saida);
+
+#endif
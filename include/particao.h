@@ -0,0 +1,25 @@
+#ifndef _PARTICAO_H_
+#define _PARTICAO_H_
+
+// Análise sintática paralela de um arquivo grande. Uma pré-varredura acha
+// os pontos seguros de corte: fim de declaração ('}' ou ';') com
+// profundidade de chaves zero, fora de comentários. O arquivo é dividido
+// nesses pontos em pedaços de tamanho parecido, e cada pedaço é analisado
+// (flex + bison) num processo, começando na linha certa. Cada
+// trabalhador serializa sua lista de declarações numa região compartilhada
+// e o processo principal remonta a árvore na ordem do fonte.
+
+// Tamanho mínimo de um pedaço: abaixo disso o fork não se paga
+#define PARTICAO_MIN_BYTES 65536
+
+// Analisa 'arquivo' com até 'trabalhadores' processos e deixa a árvore em
+// raizArvore. Devolve o número de pedaços se deu certo; -1 se o arquivo é
+// pequeno demais para dividir ou se algum pedaço tem erro, e então a
+// análise sequencial deve ser feita (ela relata os erros na ordem de
+// sempre; o analisador léxico pode ter ficado num pedaço, então chame
+// lexReinicia antes). 'linhas' recebe o número de linhas do arquivo (como
+// yylineno no fim da análise). Nunca usa mais processos que núcleos: o
+// primeiro pedaço é analisado pelo próprio processo principal.
+int particaoAnalisa(const char *arquivo, int trabalhadores, int *linhas);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef _PODA_H_
+#define _PODA_H_
+
+#include "arvore.h"
+
+// Eliminação de funções e globais mortas no programa todo. A partir de
+// main, segue as chamadas (grafo de chamadas) e os usos de globais
+// (NO_VAR) das funções alcançadas; as declarações que sobram saem da
+// árvore e os índices de funções e globais são renumerados sem buracos.
+// Roda logo depois da semântica (sem erros), antes de todo o resto.
+
+typedef struct
+{
+  int funcoes;       // declarações de função removidas
+  int globais;       // declarações de global removidas
+  int nos;           // nós da árvore liberados
+  long bytesArvore;  // memória da árvore liberada (nós e lexemas)
+  long bytesGlobais; // segmento de globais a menos (células int)
+} PodaStats;
+
+void podaPrograma(TreeNode *arvore, PodaStats *stats);
+
+#endif
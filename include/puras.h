@@ -0,0 +1,31 @@
+#ifndef _PURAS_H_
+#define _PURAS_H_
+
+#include "arvore.h"
+
+// Avaliação em tempo de compilação de chamadas a funções puras. Uma função
+// é pura se não lê nem escreve globais, não usa arrays (nem locais nem
+// parâmetros), não chama input/output e só chama funções puras (decidido
+// de baixo para cima nas componentes do grafo de chamadas, então recursão
+// é permitida). Uma chamada int a função pura com todos os argumentos
+// constantes é executada por um interpretador da árvore com orçamento de
+// passos e profundidade; se terminar (sem divisão por zero), o nó da
+// chamada vira NO_NUM com o resultado. Uma função que estoura o orçamento
+// não é mais tentada na mesma compilação, e todas as chamadas dividem um
+// teto de passos. Deve rodar depois da semântica sem erros.
+
+#define PURAS_MAX_PASSOS 1000000          // por chamada avaliada
+#define PURAS_MAX_PASSOS_TOTAL 20000000   // por compilação
+#define PURAS_MAX_PROFUNDIDADE 500
+
+typedef struct
+{
+  int puras;        // funções do programa que são puras
+  int avaliadas;    // chamadas substituídas pelo resultado
+  int desistencias; // chamadas candidatas deixadas como estão (orçamento ou divisão por zero)
+  long passos;      // passos do interpretador, no total
+} PurasStats;
+
+void avaliaPuras(TreeNode *arvore, PurasStats *stats);
+
+#endif
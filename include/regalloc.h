@@ -0,0 +1,47 @@
+#ifndef _REGALLOC_H_
+#define _REGALLOC_H_
+
+#include <stdio.h>
+#include "ir.h"
+#include "x86.h"
+
+// Alocação de registradores por varredura linear (linear scan) sobre os
+// intervalos de vida dos vregs, numerados pela ordem das instruções da IR.
+// Um intervalo pode ser dividido: fica no registrador até a posição
+// 'divisao' e na sua célula do frame dali em diante. Intervalos que cruzam
+// chamadas só recebem registradores preservados pelo chamado.
+
+#define RA_MAX_REGS 10
+
+typedef struct
+{
+  int nvregs;
+  int *inicio;          // primeira posição do intervalo (-1: vreg sem uso)
+  int *fim;             // última posição
+  X86Reg *reg;          // registrador (SEM_REG: sempre na memória)
+  int *divisao;         // a partir desta posição o vreg vive na memória
+  int nPalavras;        // tamanho dos conjuntos de vivos, em palavras
+  unsigned long *vivosRotulo;  // por rótulo: vregs vivos na entrada
+  int *posRotulo;       // por rótulo: posição da instrução IR_LABEL
+  X86Reg salvos[RA_MAX_REGS];  // preservados pelo chamado que foram usados
+  int nSalvos;
+  // estatísticas
+  int nIntervalos;
+  int nRegistrador;     // inteiros em registrador
+  int nDivididos;       // parte em registrador, parte na memória
+  int nMemoria;         // sempre na memória
+} Alocacao;
+
+Alocacao *raAloca(IrFuncao *f);
+
+void raLibera(Alocacao *ra);
+
+// Onde o vreg v está na posição pos: registrador ou SEM_REG (célula do frame)
+X86Reg raLocal(Alocacao *ra, int v, int pos);
+
+int raVivoRotulo(Alocacao *ra, int rotulo, int v);
+
+// Uma linha por função: "REGALLOC: 'f' ..."
+void raRelatorio(Alocacao *ra, IrFuncao *f, FILE *saida);
+
+#endif
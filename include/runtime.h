@@ -0,0 +1,24 @@
+#ifndef _RUNTIME_H_
+#define _RUNTIME_H_
+
+// Runtime das funções predefinidas de C- (input e output),
+// compartilhado por todos os caminhos de execução. Entrada e saída passam
+// por buffers próprios (read/write por bloco); a saída pendente é
+// descarregada em cm_flush e na saída do processo.
+
+// Lê um inteiro da entrada padrão (0 no fim da entrada)
+int cm_input(void);
+
+// Escreve um inteiro seguido de quebra de linha na saída padrão
+void cm_output(int valor);
+
+// Descarrega a saída pendente
+void cm_flush(void);
+
+// Erro de execução: divisão por zero (não retorna)
+void cm_div_zero(void);
+
+// Erro de execução: índice fora dos limites (--checked; não retorna)
+void cm_indice_invalido(void);
+
+#endif
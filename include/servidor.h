@@ -0,0 +1,32 @@
+#ifndef _SERVIDOR_H_
+#define _SERVIDOR_H_
+
+// Servidor de compilação (--servidor caminho): um processo que fica no ar
+// e analisa fontes pedidos por um socket Unix local, com cmCompilaFonte
+// (cminus.h). Quem pede não paga a partida de um processo por compilação;
+// o servidor mantém quente o que já carregou (código, heap, buffers do
+// flex). Cada conexão tem sua thread e pode mandar vários pedidos; as
+// compilações em si são uma de cada vez (a trava da libcminus).
+//
+// Protocolo, inteiros de 32 bits sem sinal em ordem de rede:
+//   pedido:   tamanho, fonte (tamanho bytes)
+//   resposta: diagnósticos (0 = ok), tamanho, texto (tamanho bytes)
+// O texto tem um diagnóstico por linha, como a linha de comando imprime.
+// Um pedido com tamanho acima de SERVIDOR_MAX_FONTE fecha a conexão.
+
+#define SERVIDOR_MAX_FONTE (64 << 20)
+
+// Escuta em 'caminho' (um socket antigo no mesmo caminho é removido) e
+// atende até receber SIGINT ou SIGTERM; então remove o socket e devolve 0.
+// Devolve 1 se não conseguiu escutar.
+int servidorExecuta(const char *caminho);
+
+// Cliente: conecta em 'caminho'; devolve o descritor ou -1
+int servidorConecta(const char *caminho);
+
+// Cliente: manda um pedido e lê a resposta. 'texto' recebe o texto
+// alocado com malloc (liberar com free). Devolve o número de diagnósticos
+// ou -1 se a conexão falhou.
+int servidorPede(int fd, const char *fonte, unsigned tam, char **texto);
+
+#endif
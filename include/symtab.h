@@ -15,9 +15,11 @@ typedef struct BucketListRec {
     ExpType type;
     IdKind kind;    
     
-    int size;
+    int size;       // arrays: número de elementos
+    int frameSize;  // funções: células de parâmetros + locais
     int numParams;
     ExpType * paramTypes;
+    char * paramArray;  // 1 se o parâmetro é int x[]
 
     struct BucketListRec * next;
 } * BucketList;
@@ -30,6 +32,25 @@ int st_lookup_scope(char * name, int scope);
 BucketList st_lookup_rec(char * name);
 BucketList st_lookup_scope_rec(char * name, int scope);
 void printSymTab(FILE * listing);
-void st_set_params(char * name, int numParams, ExpType * types);
+void st_set_params(char * name, int numParams, ExpType * types, char * arrays);
+
+// Um parâmetro int x[] ocupa duas células do frame: o endereço (loc) e,
+// na seguinte, o tamanho do array passado, um argumento escondido que os
+// geradores usam para testar os índices (--checked, limites.h)
+int st_celula_tamanho(BucketList s);
+
+// Células dos parâmetros de uma função: uma por parâmetro e mais uma por
+// int x[]
+int st_celulas_params(BucketList f);
+
+// Libera todos os símbolos (os TreeNode->sym ficam inválidos)
+void st_limpa(void);
+
+// Libera os símbolos dos escopos >= primeiro, que devem ser os últimos
+// inseridos
+void st_descarta_escopos(int primeiro);
+
+// Chama 'visita' para cada símbolo da tabela, sem ordem definida
+void st_percorre(void (*visita)(BucketList l, void *ctx), void *ctx);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef _TRADUCAO_H_
+#define _TRADUCAO_H_
+
+#include <stdio.h>
+#include "arvore.h"
+
+// Traduz o programa verificado para uma unidade de tradução C portátil.
+// Globais e funções viram static cm_<nome>; input e output chamam o
+// runtime (src/runtime.c), e um main em C chama cm_main. A aritmética
+// mantém a semântica da VM (overflow com volta, divisão por zero é erro)
+// e a ordem de avaliação da esquerda para a direita.
+void traduzParaC(TreeNode *arvore, const char *origem, FILE *saida);
+
+// Compilação separada (interface.h): globais e funções saem sem static, as
+// importadas são declaradas extern e o main em C só sai na unidade que
+// define main
+extern int traducaoSeparada;
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef _VM_H_
+#define _VM_H_
+
+#include "bytecode.h"
+#include "jit.h"
+
+// Estatísticas de uma execução
+typedef struct
+{
+  long instrucoes;     // interpretadas
+  double segundos;
+  int compiladas;      // funções compiladas pelo JIT
+  long bytesJit;
+} VmStats;
+
+// Se ligado, compila as funções quentes para código nativo (jit.h)
+extern int usaJit;
+
+// Executa o programa a partir de main. Retorna 0 em caso de sucesso
+// ou 1 se houve erro de execução (já relatado em stderr).
+int vmExecuta(Bytecode *bc, VmStats *stats);
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef _X86_H_
+#define _X86_H_
+
+#include <stdio.h>
+
+// Emissão de instruções x86-64. Em modo texto (saida != NULL) escreve
+// sintaxe AT&T para o GNU as; em modo binário codifica as instruções num
+// buffer (JIT). Os geradores de código só falam com esta interface.
+
+typedef enum
+{
+  RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+  R8, R9, R10, R11, R12, R13, R14, R15,
+  SEM_REG = -1
+} X86Reg;
+
+// Códigos de condição (os seis primeiros na mesma ordem de IrCond;
+// B/AE/BE/A são as comparações sem sinal)
+typedef enum { X86_L, X86_LE, X86_G, X86_GE, X86_E, X86_NE, X86_B, X86_AE, X86_BE, X86_A } X86Cond;
+
+typedef enum { X86_ADD, X86_SUB, X86_IMUL, X86_CMP, X86_XOR, X86_TEST } X86Alu;
+
+// Operando de memória: desloc(base, indice, escala) ou simbolo(%rip)
+typedef struct
+{
+  X86Reg base;
+  X86Reg indice;
+  int escala;
+  int desloc;
+  const char *simbolo;
+} X86Mem;
+
+// Desvio com rel32 a corrigir quando o rótulo for definido
+typedef struct
+{
+  int pos;
+  int rotulo;
+} X86Pendencia;
+
+// Referência a símbolo no código binário (rel32 a relocar)
+typedef struct
+{
+  int pos;
+  char *simbolo;
+  int addend;
+  int chamada;  // alvo de call (função) ou dado rip-relativo
+} X86Reloc;
+
+// Símbolo definido no modo binário: função no código ou global no .bss
+typedef struct
+{
+  char *nome;
+  int bss;
+  int pos;
+  int tamanho;
+} X86Simbolo;
+
+typedef struct
+{
+  FILE *saida;
+  const char *prefixoRotulo;  // rótulos locais: <prefixo><n>
+
+  // modo binário
+  unsigned char *codigo;
+  int n, cap;
+  int *rotulos;               // posição de cada rótulo (-1: indefinido)
+  int capRotulos;
+  X86Pendencia *pendencias;
+  int nPendencias, capPendencias;
+  X86Reloc *relocs;
+  int nRelocs, capRelocs;
+  X86Simbolo *simbolos;
+  int nSimbolos, capSimbolos;
+  int tamBss;
+} X86Asm;
+
+// Inicia o modo binário; x86_finaliza resolve os desvios (0 se ok)
+void x86_binario(X86Asm *a);
+int x86_finaliza(X86Asm *a);
+void x86_libera(X86Asm *a);
+int x86_posicao(X86Asm *a, int rotulo);
+
+X86Mem x86_mem(X86Reg base, int desloc);
+X86Mem x86_mem_idx(X86Reg base, X86Reg indice, int escala, int desloc);
+X86Mem x86_mem_sym(const char *simbolo);
+
+// Largura w em bytes: 4 (int) ou 8 (endereços)
+void x86_mov_rr(X86Asm *a, int w, X86Reg dst, X86Reg src);
+void x86_mov_ri(X86Asm *a, X86Reg dst, int imm);
+void x86_mov_ri64(X86Asm *a, X86Reg dst, long long imm);
+void x86_load(X86Asm *a, int w, X86Reg dst, X86Mem m);
+void x86_store(X86Asm *a, int w, X86Mem m, X86Reg src);
+void x86_store_i(X86Asm *a, X86Mem m, int imm);  // int imediato na memória
+void x86_lea(X86Asm *a, X86Reg dst, X86Mem m);
+void x86_movsx(X86Asm *a, X86Reg dst, X86Reg src);  // int -> 64 bits
+void x86_alu(X86Asm *a, X86Alu op, int w, X86Reg dst, X86Reg src);
+void x86_alu_ri(X86Asm *a, X86Alu op, int w, X86Reg dst, int imm);
+void x86_alu_rm(X86Asm *a, X86Alu op, int w, X86Reg dst, X86Mem m);
+void x86_sar_ri(X86Asm *a, int w, X86Reg r, int imm);
+void x86_neg(X86Asm *a, X86Reg r);
+void x86_cdq(X86Asm *a);
+void x86_idiv(X86Asm *a, X86Reg r);
+void x86_setcc(X86Asm *a, X86Cond cc, X86Reg dst);  // dst = cc ? 1 : 0 (32 bits)
+void x86_push(X86Asm *a, X86Reg r);
+void x86_push_m(X86Asm *a, X86Mem m);
+void x86_pop(X86Asm *a, X86Reg r);
+void x86_ret(X86Asm *a);
+
+void x86_label(X86Asm *a, int rotulo);
+void x86_jmp(X86Asm *a, int rotulo);
+void x86_jcc(X86Asm *a, X86Cond cc, int rotulo);
+void x86_call(X86Asm *a, const char *simbolo);
+void x86_call_r(X86Asm *a, X86Reg r);  // chamada indireta
+void x86_jmp_r(X86Asm *a, X86Reg r);
+
+// Diretivas (no modo binário, funções e globais viram símbolos)
+void x86_text(X86Asm *a);
+void x86_funcao(X86Asm *a, const char *simbolo);
+void x86_fim_funcao(X86Asm *a, const char *simbolo);
+void x86_bss(X86Asm *a, const char *simbolo, int bytes);
+
+#endif
@@ -1,12 +1,20 @@
 #include "../include/analyze.h"
 #include "../include/symtab.h"
+#include "../include/diagnostico.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 
-// Contador para alocação de memória
+// Contador para alocação de memória: deslocamento no frame da função atual
 static int location = 0;
 
+// Próxima posição livre no segmento de globais
+static int globalLocation = 0;
+
+// Funções são numeradas em ordem de declaração (input = 0, output = 1)
+static int nextFunction = 0;
+
 // Escopo atual (0 = global)
 static int scope = 0;
 
@@ -16,6 +24,13 @@ static int scopeTop = -1;
 static int nextScopeId = 0;
 static int globalScopeId = -1;
 
+// Maior deslocamento usado na função atual (tamanho do frame). Ao sair de
+// um bloco, location volta ao valor da entrada: blocos irmãos reutilizam
+// as mesmas células.
+static int maxLocation = 0;
+static int locationStack[MAX_SCOPE_STACK];
+static int locationTop = -1;
+
 static int activeScopeStack[MAX_SCOPE_STACK];
 static int activeTop = -1;
 
@@ -93,41 +108,155 @@ static ExpType currentFuncType(void) {
   return Void; /* default quando fora de função */
 }
 
+// buildSymTab imprime a tabela de símbolos ao final
+int imprimeTabela = 1;
+
+// Erros semânticos encontrados na última análise
+static int semanticErrors = 0;
+
+// Na análise por declaração (analyzeDeclaracao), os erros da checagem de
+// tipos ficam retidos até se saber se a declaração é verificada agora ou no
+// fim, por usar um nome que ainda não foi declarado
+typedef struct {
+  int linha;
+  char *mensagem;
+} ErroRetido;
+
+static int retendo = 0;
+static ErroRetido *retidos = NULL;
+static int nRetidos = 0, capRetidos = 0;
+
+// Nomes que st_lookup_visible não achou
+static int naoResolvidos = 0;
+
+// Análise incremental: as funções e globais já estão na tabela
+static int assinaturasProntas = 0;
+
+// Compilação separada: interfaces importadas, inseridas em toda análise
+static Interface **importadas = NULL;
+static int nImportadas = 0;
+static int funcoesImportadas = 0, celulasImportadas = 0;
+
+// ... e as de import no fonte, carregadas pela própria análise
+static const char *diretorio = NULL;
+static Interface **doFonte = NULL;
+static int nDoFonte = 0, capDoFonte = 0;
+
+// Sem main não é erro numa unidade que só exporta
+int exigeMain = 1;
+
+static void semanticError(int linha, const char *fmt, ...) {
+  va_list ap;
+  if (!retendo) {
+    va_start(ap, fmt);
+    diagRelataV(DIAG_SEMANTICO, linha, fmt, ap);
+    va_end(ap);
+    semanticErrors++;
+    return;
+  }
+  va_start(ap, fmt);
+  int n = vsnprintf(NULL, 0, fmt, ap);
+  va_end(ap);
+  if (nRetidos == capRetidos) {
+    capRetidos = capRetidos ? capRetidos * 2 : 16;
+    retidos = (ErroRetido *) realloc(retidos, sizeof(ErroRetido) * capRetidos);
+  }
+  ErroRetido *e = &retidos[nRetidos++];
+  e->linha = linha;
+  e->mensagem = (char *) malloc(n + 1);
+  va_start(ap, fmt);
+  vsnprintf(e->mensagem, n + 1, fmt, ap);
+  va_end(ap);
+}
+
+int analyzeErrors(void) {
+  return semanticErrors;
+}
+
+int analyzeGlobalSize(void) {
+  return globalLocation;
+}
+
+int analyzeFunctionCount(void) {
+  return nextFunction;
+}
+
+void analyzeCompacta(int tamanhoGlobais, int nFuncoes) {
+  globalLocation = tamanhoGlobais;
+  nextFunction = nFuncoes;
+}
+
+void analyzeImporta(Interface **interfaces, int n) {
+  importadas = interfaces;
+  nImportadas = (interfaces != NULL) ? n : 0;
+}
+
+const Interface *analyzeImportada(int i) {
+  if (i >= 0 && i < nImportadas) return importadas[i];
+  i -= nImportadas;
+  return (i >= 0 && i < nDoFonte) ? doFonte[i] : NULL;
+}
+
+void analyzeDiretorio(const char *dir) {
+  diretorio = dir;
+}
+
+void analyzeLiberaImportadas(void) {
+  for (int k = 0; k < nDoFonte; k++) interfaceLibera(doFonte[k]);
+  free(doFonte);
+  doFonte = NULL;
+  nDoFonte = capDoFonte = 0;
+}
+
+int analyzeImportadas(int *celulas) {
+  if (celulas != NULL) *celulas = celulasImportadas;
+  return funcoesImportadas;
+}
+
 static BucketList st_lookup_visible(char * name) {
   for (int i = activeTop; i >= 0; --i) {
     int sc = activeScopeStack[i];
     BucketList b = st_lookup_scope_rec(name, sc);
     if (b != NULL) return b;
   }
+  naoResolvidos++;
   return NULL;
 }
 
-// ==== função para percorrer a árvore ====
 static void traverse(TreeNode *t,
                      void (*preProc)(TreeNode *),
-                     void (*postProc)(TreeNode *))
+                     void (*postProc)(TreeNode *));
+
+// ==== percorre um nó e seus filhos, sem os irmãos ====
+static void traverseNo(TreeNode *t,
+                       void (*preProc)(TreeNode *),
+                       void (*postProc)(TreeNode *))
 {
-  if (t != NULL)
-  {
-    if (preProc) preProc(t);
+  if (preProc) preProc(t);
 
-    /* antes de descer aos filhos, empilhamos este nó como pai */
-    if (parentTop < MAX_SCOPE_STACK - 1) parentStack[++parentTop] = t;
+  /* antes de descer aos filhos, empilhamos este nó como pai */
+  if (parentTop < MAX_SCOPE_STACK - 1) parentStack[++parentTop] = t;
 
-    traverse(t->filho, preProc, postProc);
+  traverse(t->filho, preProc, postProc);
 
-    /* ao terminar filhos, removemos o nó para que postProc veja o pai correto */
-    parentTop--;
+  /* ao terminar filhos, removemos o nó para que postProc veja o pai correto */
+  parentTop--;
 
-    if (postProc) postProc(t);
+  if (postProc) postProc(t);
+}
 
-    /* e então processamos irmão (não é filho, então não altera a pilha de pais) */
-    traverse(t->irmao, preProc, postProc);
-  }
+// ==== função para percorrer a árvore ====
+static void traverse(TreeNode *t,
+                     void (*preProc)(TreeNode *),
+                     void (*postProc)(TreeNode *))
+{
+  /* irmãos não são filhos, então não alteram a pilha de pais */
+  for (; t != NULL; t = t->irmao)
+    traverseNo(t, preProc, postProc);
 }
 
 // Checar tipos
-static int countParamNodes(TreeNode *paramNode, ExpType *outTypes) {
+static int countParamNodes(TreeNode *paramNode, ExpType *outTypes, char *outArrays) {
   int count = 0;
   TreeNode *p = paramNode;
   while (p != NULL) {
@@ -142,6 +271,7 @@ static int countParamNodes(TreeNode *paramNode, ExpType *outTypes) {
       ExpType t = Integer; /* default int */
       if (p->filho != NULL && p->filho->tipoNo == NO_TIPO_VOID) t = Void;
       if (outTypes != NULL) outTypes[count] = t;
+      if (outArrays != NULL) outArrays[count] = (p->tipoNo == NO_PARAM && p->attr.valor == 1);
       count++;
     }
     p = p->irmao;
@@ -162,11 +292,82 @@ static int countArgNodesAndFillTypes(TreeNode *argNode, ExpType *outTypes) {
   return count;
 }
 
+/* um símbolo de outra unidade, sem declaração na árvore; 'linha' é a do
+   import no fonte (0 com --importa) */
+static void insereImportado(const Interface *i, const InterfaceSimbolo *s, int linha)
+{
+  if (st_lookup_rec(s->nome) != NULL)
+  {
+    semanticError(linha, "ERRO SEMÂNTICO: '%s' de %s já foi importado ou é predefinido.\n", s->nome, i->arquivo);
+    return;
+  }
+  if (s->kind == ID_FUN)
+  {
+    st_insert(s->nome, linha, nextFunction++, globalScopeId, s->tipo, ID_FUN);
+    st_set_params(s->nome, s->numParams, s->paramTypes, s->paramArray);
+    return;
+  }
+  st_insert(s->nome, linha, globalLocation, globalScopeId, s->tipo, s->kind);
+  if (s->kind == ID_ARRAY) st_lookup_rec(s->nome)->size = s->tamanho;
+  globalLocation += (s->kind == ID_ARRAY) ? s->tamanho : 1;
+}
+
+/* import nome; carrega nome.cmi do diretório do fonte e insere como as de
+   --importa. Os índices das importadas vêm antes dos do programa: a
+   gramática põe os import antes das declarações, mas o lsp.h analisa
+   pedaços soltos do documento, então a ordem é conferida aqui também. */
+static void importaUnidade(TreeNode *t)
+{
+  const char *nome = t->attr.lexema;
+  if (nextFunction != FUN_OUTPUT + 1 + funcoesImportadas || globalLocation != celulasImportadas)
+  {
+    semanticError(t->lineno, "ERRO SEMÂNTICO: import '%s' depois de declarações. Linha %d.\n", nome, t->lineno);
+    return;
+  }
+
+  const char *dir = (diretorio != NULL) ? diretorio : ".";
+  size_t tam = strlen(dir) + strlen(nome) + 6;
+  char *caminho = (char *) malloc(tam);
+  snprintf(caminho, tam, "%s/%s.cmi", dir, nome);
+  for (int k = 0; k < nDoFonte; k++)
+  {
+    if (strcmp(doFonte[k]->arquivo, caminho) == 0)
+    {
+      semanticError(t->lineno, "ERRO SEMÂNTICO: unidade '%s' importada duas vezes. Linha %d.\n", nome, t->lineno);
+      free(caminho);
+      return;
+    }
+  }
+  const char *motivo;
+  Interface *i = interfaceLe(caminho, &motivo);
+  if (i == NULL)
+  {
+    semanticError(t->lineno, "ERRO SEMÂNTICO: import '%s': %s: %s. Linha %d.\n", nome, caminho, motivo, t->lineno);
+    free(caminho);
+    return;
+  }
+  free(caminho);
+
+  if (nDoFonte == capDoFonte)
+  {
+    capDoFonte = capDoFonte ? capDoFonte * 2 : 4;
+    doFonte = (Interface **) realloc(doFonte, sizeof(Interface *) * capDoFonte);
+  }
+  doFonte[nDoFonte++] = i;
+  for (int j = 0; j < i->n; j++) insereImportado(i, &i->simbolos[j], t->lineno);
+  funcoesImportadas = nextFunction - (FUN_OUTPUT + 1);
+  celulasImportadas = globalLocation;
+}
+
 // === quando chegar em um nó, inserir declarações ou verificar usos ===
 static void insertNode(TreeNode *t)
 {
   switch (t->tipoNo)
   {
+  case NO_IMPORT:
+    importaUnidade(t);
+    break;
+
   case NO_DECLARACAO_FUN:
   {
     TreeNode *tipoNode = t->filho;
@@ -175,32 +376,43 @@ static void insertNode(TreeNode *t)
     char *funcName = idNode->attr.lexema;
 
     /* insere a função no escopo atual (geralmente global) */
-    if (st_lookup_rec(funcName) == NULL)
+    if (assinaturasProntas && t->sym != NULL)
+    {
+      /* análise incremental: a assinatura já entrou em analyzeAssinaturas */
+    }
+    else if (st_lookup_rec(funcName) == NULL)
     {
       ExpType funcType = (tipoNode->tipoNo == NO_TIPO_INT) ? Integer : Void;
-      st_insert(funcName, t->lineno, location++, currentScope(), funcType, ID_FUN);
+      st_insert(funcName, t->lineno, nextFunction++, currentScope(), funcType, ID_FUN);
 
       /* contar e registrar parâmetros (eles serão inseridos no próximo passo, já no escopo da função) */
       int nparams = 0;
       ExpType *types = NULL;
       if (paramsNode != NULL) {
-        nparams = countParamNodes(paramsNode, NULL);
+        nparams = countParamNodes(paramsNode, NULL, NULL);
         if (nparams > 0) {
           types = (ExpType *) malloc(sizeof(ExpType) * nparams);
-          countParamNodes(paramsNode, types);
-          st_set_params(funcName, nparams, types);
+          char *arrays = (char *) malloc(nparams);
+          countParamNodes(paramsNode, types, arrays);
+          st_set_params(funcName, nparams, types, arrays);
           free(types);
+          free(arrays);
         } else {
-          st_set_params(funcName, 0, NULL);
+          st_set_params(funcName, 0, NULL, NULL);
         }
       } else {
-        st_set_params(funcName, 0, NULL);
+        st_set_params(funcName, 0, NULL, NULL);
       }
     }
     else
     {
-      fprintf(stderr, "ERRO SEMÂNTICO: Função '%s' já declarada na linha %d.\n", funcName, t->lineno);
+      semanticError(t->lineno, "ERRO SEMÂNTICO: Função '%s' já declarada na linha %d.\n", funcName, t->lineno);
     }
+    t->sym = st_lookup_rec(funcName);
+
+    /* parâmetros e locais ocupam o frame a partir do deslocamento 0 */
+    location = 0;
+    maxLocation = 0;
 
     int newScope = pushNewScope();
     t->scopeId = newScope;
@@ -211,6 +423,7 @@ static void insertNode(TreeNode *t)
   {
     int newScope = pushNewScope();
     t->scopeId = newScope;
+    if (locationTop < MAX_SCOPE_STACK - 1) locationStack[++locationTop] = location;
   }
   break;
 
@@ -222,14 +435,14 @@ static void insertNode(TreeNode *t)
 
     /* Caso: void variável => inválido */
     if (tipoNode->tipoNo == NO_TIPO_VOID) {
-      fprintf(stderr, "ERRO SEMÂNTICO: declaração inválida de variável '%s' com tipo void. Linha %d.\n", varName, t->lineno);
+      semanticError(t->lineno, "ERRO SEMÂNTICO: declaração inválida de variável '%s' com tipo void. Linha %d.\n", varName, t->lineno);
       break;
     }
 
     /* Caso: não permitir declarar variável com nome de função já declarada (no escopo global) */
     BucketList existing = st_lookup_rec(varName);
     if (existing != NULL && existing->kind == ID_FUN) {
-      fprintf(stderr, "ERRO SEMÂNTICO: declaração inválida '%s' - já existe função com esse nome. Linha %d.\n", varName, t->lineno);
+      semanticError(t->lineno, "ERRO SEMÂNTICO: declaração inválida '%s' - já existe função com esse nome. Linha %d.\n", varName, t->lineno);
       break;
     }
 
@@ -239,15 +452,24 @@ static void insertNode(TreeNode *t)
     {
       ExpType varType = (tipoNode->tipoNo == NO_TIPO_INT) ? Integer : Void;
       IdKind kind = ID_VAR;
+      int size = 1;
       if (idNode->irmao != NULL && idNode->irmao->tipoNo == NO_NUM)
       {
         kind = ID_ARRAY;
+        size = atoi(idNode->irmao->attr.lexema);
       }
-      st_insert(varName, t->lineno, location++, currentGeneratedScope(), varType, kind);
+
+      /* globais vão para o segmento de dados, locais para o frame */
+      int *loc = (cs == globalScopeId) ? &globalLocation : &location;
+      st_insert(varName, t->lineno, *loc, currentGeneratedScope(), varType, kind);
+      *loc += size;
+      if (loc == &location && location > maxLocation) maxLocation = location;
+      t->sym = st_lookup_scope_rec(varName, currentGeneratedScope());
+      if (kind == ID_ARRAY) t->sym->size = size;
     }
     else
     {
-      fprintf(stderr, "ERRO SEMÂNTICO: Variável '%s' já declarada na linha %d.\n", varName, t->lineno);
+      semanticError(t->lineno, "ERRO SEMÂNTICO: Variável '%s' já declarada na linha %d.\n", varName, t->lineno);
     }
   }
   break;
@@ -263,11 +485,17 @@ static void insertNode(TreeNode *t)
       int cs = currentScope();
       if (st_lookup_scope(paramName, cs) == -1)
       {
-        st_insert(paramName, t->lineno, location++, cs, Integer, ID_VAR);
+        /* int x[] é passado por referência: registra como array, com o
+           tamanho escondido na célula seguinte (st_celula_tamanho) */
+        IdKind kind = (t->attr.valor == 1) ? ID_ARRAY : ID_VAR;
+        st_insert(paramName, t->lineno, location++, cs, Integer, kind);
+        if (kind == ID_ARRAY) location++;
+        if (location > maxLocation) maxLocation = location;
+        t->sym = st_lookup_scope_rec(paramName, cs);
       }
       else
       {
-        fprintf(stderr, "ERRO SEMÂNTICO: Parâmetro '%s' redeclarado na linha %d.\n", paramName, t->lineno);
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Parâmetro '%s' redeclarado na linha %d.\n", paramName, t->lineno);
       }
     }
   }
@@ -288,6 +516,17 @@ static void afterNode(TreeNode *t)
     /* fechar o scope gerado (não apagar a tabela agora) */
     popGeneratedScope();
   }
+
+  /* fim do bloco: as células das suas locais ficam livres para os irmãos */
+  if (t->tipoNo == NO_BLOCO && locationTop >= 0)
+  {
+    location = locationStack[locationTop--];
+  }
+
+  if (t->tipoNo == NO_DECLARACAO_FUN && t->sym != NULL)
+  {
+    t->sym->frameSize = maxLocation;
+  }
 }
 
 //Type checking (pós-ordem)
@@ -318,7 +557,7 @@ static void checkNode(TreeNode *t) {
       if (lt == Integer && rt == Integer) {
         t->type = Integer;
       } else {
-        fprintf(stderr, "ERRO SEMÂNTICO: Operação aritmética exige int,int (obtido %s,%s). Linha %d.\n",
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Operação aritmética exige int,int (obtido %s,%s). Linha %d.\n",
                 (lt==Integer)?"int":"void",
                 (rt==Integer)?"int":"void",
                 t->lineno);
@@ -338,7 +577,7 @@ static void checkNode(TreeNode *t) {
       if (lt == Integer && rt == Integer) {
         t->type = Integer;
       } else {
-        fprintf(stderr, "ERRO SEMÂNTICO: Operação aritmética exige int,int (obtido %s,%s). Linha %d.\n",
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Operação aritmética exige int,int (obtido %s,%s). Linha %d.\n",
                 (lt==Integer)?"int":"void",
                 (rt==Integer)?"int":"void",
                 t->lineno);
@@ -358,7 +597,7 @@ static void checkNode(TreeNode *t) {
       if (lt == Integer && rt == Integer) {
         t->type = Boolean;
       } else {
-        fprintf(stderr, "ERRO SEMÂNTICO: Operação relacional exige int,int (obtido %s,%s). Linha %d.\n",
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Operação relacional exige int,int (obtido %s,%s). Linha %d.\n",
                 (lt==Integer)?"int":"void",
                 (rt==Integer)?"int":"void",
                 t->lineno);
@@ -372,14 +611,15 @@ static void checkNode(TreeNode *t) {
       char *name = t->attr.lexema;
       BucketList l = st_lookup_visible(name);
       if (l == NULL) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Variável '%s' não foi declarada. Linha %d.\n", name, t->lineno);
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Variável '%s' não foi declarada. Linha %d.\n", name, t->lineno);
         t->type = Void;
       } else {
         if (l->kind == ID_FUN) {
-          fprintf(stderr, "ERRO SEMÂNTICO: '%s' é função e foi usada como variável. Linha %d.\n", name, t->lineno);
+          semanticError(t->lineno, "ERRO SEMÂNTICO: '%s' é função e foi usada como variável. Linha %d.\n", name, t->lineno);
           t->type = Void;
         } else {
           t->type = l->type;
+          t->sym = l;
         }
       }
     }
@@ -390,26 +630,27 @@ static void checkNode(TreeNode *t) {
       char *name = t->attr.lexema;
       BucketList l = st_lookup_visible(name);
       if (l == NULL) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Chamada de função '%s' não declarada. Linha %d.\n", name, t->lineno);
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Chamada de função '%s' não declarada. Linha %d.\n", name, t->lineno);
         t->type = Void;
         break;
       }
       if (l->kind != ID_FUN) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Identificador '%s' não é função (não pode ser chamado). Linha %d.\n", name, t->lineno);
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Identificador '%s' não é função (não pode ser chamado). Linha %d.\n", name, t->lineno);
         t->type = Void;
         break;
       }
 
+      t->sym = l;
       TreeNode *argNode = t->filho;
       int nargs = (argNode == NULL) ? 0 : countArgNodesAndFillTypes(argNode, NULL);
 
       if (nargs != l->numParams) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Chamada '%s' com número inválido de parâmetros (esperado %d, obtido %d). Linha %d.\n",
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Chamada '%s' com número inválido de parâmetros (esperado %d, obtido %d). Linha %d.\n",
                 name, l->numParams, nargs, t->lineno);
       }
 
       if (l->numParams == 0 && nargs > 0) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Chamada '%s' não espera argumentos (0) mas recebeu %d. Linha %d.\n",
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Chamada '%s' não espera argumentos (0) mas recebeu %d. Linha %d.\n",
                 name, nargs, t->lineno);
       }
 
@@ -420,7 +661,7 @@ static void checkNode(TreeNode *t) {
         int limit = (nargs < l->numParams) ? nargs : l->numParams;
         for (int i = 0; i < limit; ++i) {
           if (argTypes[i] != l->paramTypes[i]) {
-            fprintf(stderr, "ERRO SEMÂNTICO: Chamada '%s' parâmetro %d tipo inválido (esperado %s, obtido %s). Linha %d.\n",
+            semanticError(t->lineno, "ERRO SEMÂNTICO: Chamada '%s' parâmetro %d tipo inválido (esperado %s, obtido %s). Linha %d.\n",
                     name, i+1,
                     (l->paramTypes[i]==Integer) ? "int" : "void",
                     (argTypes[i]==Integer) ? "int" : "void",
@@ -445,7 +686,7 @@ static void checkNode(TreeNode *t) {
 
       if (callUsedAsStatement && t->type != Void) {
         /* erro: função retorna valor mas a chamada foi feita como statement */
-        fprintf(stderr, "ERRO SEMÂNTICO: Chamada a função '%s' retorna valor e seu retorno foi ignorado. Linha %d.\n",
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Chamada a função '%s' retorna valor e seu retorno foi ignorado. Linha %d.\n",
                 name, t->lineno);
       }
     }
@@ -457,40 +698,40 @@ static void checkNode(TreeNode *t) {
       TreeNode *index = (base != NULL) ? base->irmao : NULL;
 
       if (base == NULL) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Índice de array inválido (sem base). Linha %d.\n", t->lineno);
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Índice de array inválido (sem base). Linha %d.\n", t->lineno);
         t->type = Void;
         break;
       }
 
       /* resolve o identificador da base respeitando escopos ativos */
       if (base->tipoNo != NO_VAR) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Base do index não é variável. Linha %d.\n", t->lineno);
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Base do index não é variável. Linha %d.\n", t->lineno);
         t->type = Void;
         break;
       }
 
       BucketList b = st_lookup_visible(base->attr.lexema);
       if (b == NULL) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Variável '%s' não foi declarada (uso em index). Linha %d.\n", base->attr.lexema, t->lineno);
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Variável '%s' não foi declarada (uso em index). Linha %d.\n", base->attr.lexema, t->lineno);
         t->type = Void;
         break;
       }
 
       if (b->kind != ID_ARRAY) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Identificador '%s' não é array. Linha %d.\n", base->attr.lexema, t->lineno);
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Identificador '%s' não é array. Linha %d.\n", base->attr.lexema, t->lineno);
         t->type = Void;
         break;
       }
 
       if (index == NULL) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Índice ausente para array '%s'. Linha %d.\n", base->attr.lexema, t->lineno);
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Índice ausente para array '%s'. Linha %d.\n", base->attr.lexema, t->lineno);
         t->type = Void;
         break;
       }
 
       /* index já teve seu tipo calculado (pós-ordem) */
       if (index->type != Integer) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Índice de array deve ser int (obtido %s). Linha %d.\n",
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Índice de array deve ser int (obtido %s). Linha %d.\n",
                 (index->type==Integer) ? "int" : "void", t->lineno);
         t->type = Void;
         break;
@@ -498,6 +739,7 @@ static void checkNode(TreeNode *t) {
 
       /* tudo ok: tipo do elemento do array (por enquanto usamos o mesmo tipo guardado no símbolo) */
       t->type = b->type; /* normalmente Integer */
+      base->sym = b;
     }
     break;
     case NO_ATRIBUICAO:
@@ -508,12 +750,12 @@ static void checkNode(TreeNode *t) {
       ExpType rt = (right != NULL) ? right->type : Void;
 
       if (lt == Void) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Lado esquerdo da atribuição não é variável válida. Linha %d.\n", t->lineno);
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Lado esquerdo da atribuição não é variável válida. Linha %d.\n", t->lineno);
       } else if (rt == Void && lt != Void) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Atribuição inválida: atribuir 'void' a '%s'. Linha %d.\n",
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Atribuição inválida: atribuir 'void' a '%s'. Linha %d.\n",
                 (lt==Integer)?"int":"void", t->lineno);
       } else if (lt != rt) {
-        fprintf(stderr, "ERRO SEMÂNTICO: Atribuição com tipos incompatíveis (%s = %s). Linha %d.\n",
+        semanticError(t->lineno, "ERRO SEMÂNTICO: Atribuição com tipos incompatíveis (%s = %s). Linha %d.\n",
                 (lt==Integer)?"int":"void",
                 (rt==Integer)?"int":"void",
                 t->lineno);
@@ -527,15 +769,15 @@ static void checkNode(TreeNode *t) {
       TreeNode *expr = t->filho;
       if (funcType == Void) {
         if (expr != NULL) {
-          fprintf(stderr, "ERRO SEMÂNTICO: Função 'void' retornando valor. Linha %d.\n", t->lineno);
+          semanticError(t->lineno, "ERRO SEMÂNTICO: Função 'void' retornando valor. Linha %d.\n", t->lineno);
         }
       } else { /* função int esperada */
         if (expr == NULL) {
-          fprintf(stderr, "ERRO SEMÂNTICO: Função com retorno 'int' sem valor no return. Linha %d.\n", t->lineno);
+          semanticError(t->lineno, "ERRO SEMÂNTICO: Função com retorno 'int' sem valor no return. Linha %d.\n", t->lineno);
         } else if (expr->type == Void) {
           /* <- aqui o problema anterior: se expr->type não foi definido, era Void, gerando falso-positivo.
              agora, com NO_NUM/NO_OP_* definindo tipos, isso deve resolver. */
-          fprintf(stderr, "ERRO SEMÂNTICO: Return retorna 'void' em função 'int'. Linha %d.\n", t->lineno);
+          semanticError(t->lineno, "ERRO SEMÂNTICO: Return retorna 'void' em função 'int'. Linha %d.\n", t->lineno);
         }
       }
     }
@@ -546,37 +788,75 @@ static void checkNode(TreeNode *t) {
   }
 }
 
-// função principal para construir a tabela de simbols
-void buildSymTab(TreeNode *syntaxTree)
+// Declarações cuja checagem de tipos ficou para analyzeTermina
+static TreeNode **adiadas = NULL;
+static int nAdiadas = 0, capAdiadas = 0;
+
+void analyzeInicia(void)
 {
   location = 0;
+  maxLocation = 0;
+  locationTop = -1;
+  globalLocation = 0;
+  nextFunction = 0;
   nextScopeId = 0;
   scopeTop = -1;
+  activeTop = -1;
+  parentTop = -1;
+  funcStackTop = -1;
+  semanticErrors = 0;
+  assinaturasProntas = 0;
+
+  /* símbolos e import de um arquivo anterior (modo lote, lsp.h) */
+  st_limpa();
+  analyzeLiberaImportadas();
 
   /* cria escopo global e guarda o id */
   globalScopeId = pushNewScope();  /* por exemplo, id 0 */
 
   /* inserir predefinidas no scope global */
-  st_insert("input", 0, location++, globalScopeId, Integer, ID_FUN);
-  st_set_params("input", 0, NULL);
+  st_insert("input", 0, nextFunction++, globalScopeId, Integer, ID_FUN);
+  st_set_params("input", 0, NULL, NULL);
 
   /* output recebe 1 parâmetro int */
-  st_insert("output", 0, location++, globalScopeId, Void, ID_FUN);
+  st_insert("output", 0, nextFunction++, globalScopeId, Void, ID_FUN);
   {
     ExpType outTypes[1];
     outTypes[0] = Integer;
-    st_set_params("output", 1, outTypes);
+    st_set_params("output", 1, outTypes, NULL);
   }
 
-  traverse(syntaxTree, insertNode, afterNode);
+  /* importadas logo depois: índices e células antes dos do programa */
+  for (int k = 0; k < nImportadas; k++)
+    for (int j = 0; j < importadas[k]->n; j++)
+      insereImportado(importadas[k], &importadas[k]->simbolos[j], 0);
+  funcoesImportadas = nextFunction - (FUN_OUTPUT + 1);
+  celulasImportadas = globalLocation;
+
+  nAdiadas = 0;
+}
+
+/* fim da tabela: main é obrigatória e a tabela sai em stdout */
+static void terminaTabela(void)
+{
+  if (exigeMain && st_lookup_scope_rec("main", globalScopeId) == NULL)
+  {
+    semanticError(0, "ERRO SEMÂNTICO: Função 'main' não definida.\n");
+  }
 
-  if (st_lookup_scope_rec("main", globalScopeId) == NULL)
+  if (imprimeTabela)
   {
-    fprintf(stderr, "ERRO SEMÂNTICO: Função 'main' não definida.\n");
+    printf("\n");
+    printSymTab(stdout);
   }
+}
 
-  printf("\n");
-  printSymTab(stdout);
+// função principal para construir a tabela de simbols
+void buildSymTab(TreeNode *syntaxTree)
+{
+  analyzeInicia();
+  traverse(syntaxTree, insertNode, afterNode);
+  terminaTabela();
 }
 
 /* preProc usado em typeCheck: quando entramos numa função/bloco,
@@ -632,3 +912,89 @@ void typeCheck(TreeNode * syntaxTree) {
   traverse(syntaxTree, tc_pre, tc_post_and_check);
 }
 
+/* checagem de tipos de uma declaração de topo, sem os irmãos */
+static void verificaDeclaracao(TreeNode *decl) {
+  activeTop = -1;
+  pushActiveScope(globalScopeId);
+  traverseNo(decl, tc_pre, tc_post_and_check);
+}
+
+int analyzeDeclaracao(TreeNode *decl) {
+  traverseNo(decl, insertNode, afterNode);
+
+  /* um nome não achado pode ser de uma declaração que ainda vem (chamada
+     adiante, global declarada depois): os erros retidos são descartados e
+     a declaração é verificada de novo no fim, com a tabela completa */
+  naoResolvidos = 0;
+  nRetidos = 0;
+  retendo = 1;
+  verificaDeclaracao(decl);
+  retendo = 0;
+
+  int agora = (naoResolvidos == 0);
+  for (int i = 0; i < nRetidos; i++) {
+    if (agora) semanticError(retidos[i].linha, "%s", retidos[i].mensagem);
+    free(retidos[i].mensagem);
+  }
+  nRetidos = 0;
+  if (agora) return 1;
+
+  if (nAdiadas == capAdiadas) {
+    capAdiadas = capAdiadas ? capAdiadas * 2 : 64;
+    adiadas = (TreeNode **) realloc(adiadas, sizeof(TreeNode *) * capAdiadas);
+  }
+  adiadas[nAdiadas++] = decl;
+  return 0;
+}
+
+void analyzeDescarta(TreeNode *decl) {
+  /* os escopos de uma função são numerados em seguida, a partir do dela, e
+     nada foi inserido depois das suas locais */
+  if (decl->tipoNo == NO_DECLARACAO_FUN && decl->scopeId >= 0)
+    st_descarta_escopos(decl->scopeId);
+}
+
+void analyzeAssinaturas(TreeNode *lista) {
+  analyzeInicia();
+  assinaturasProntas = 1;
+  for (TreeNode *decl = lista; decl != NULL; decl = decl->irmao) {
+    if (decl->tipoNo == NO_DECLARACAO_FUN) {
+      /* só o símbolo da função: o corpo fica para analyzeFuncao. Uma árvore
+         analisada de novo (lsp.h) traz o símbolo da análise anterior */
+      decl->sym = NULL;
+      insertNode(decl);
+      popGeneratedScope();
+    } else {
+      traverseNo(decl, insertNode, afterNode);
+    }
+  }
+}
+
+int analyzeFuncao(TreeNode *decl) {
+  nRetidos = 0;
+  retendo = 1;
+  traverseNo(decl, insertNode, afterNode);
+  verificaDeclaracao(decl);
+  retendo = 0;
+  return nRetidos;
+}
+
+const char *analyzeRetido(int i, int *linha) {
+  *linha = retidos[i].linha;
+  return retidos[i].mensagem;
+}
+
+void analyzeRelata(int linha, const char *mensagem) {
+  semanticError(linha, "%s", mensagem);
+}
+
+void analyzeLiberaRetidos(void) {
+  for (int i = 0; i < nRetidos; i++) free(retidos[i].mensagem);
+  nRetidos = 0;
+}
+
+void analyzeTermina(void) {
+  terminaTabela();
+  for (int i = 0; i < nAdiadas; i++) verificaDeclaracao(adiadas[i]);
+  nAdiadas = 0;
+}
@@ -15,8 +15,11 @@ TreeNode *novoNo(NodeType tipo, int lineno)
   no->irmao = NULL;
   no->tipoNo = tipo;
   no->lineno = lineno;
+  no->attr.lexema = NULL;
   no->type = Void;
   no->scopeId = -1;
+  no->sym = NULL;
+  no->verificaLimite = 1;
   return no;
 }
 
@@ -38,6 +41,74 @@ TreeNode *novoNoToken(NodeType tipo, char *lexema, int lineno)
   return no;
 }
 
+TreeNode *copiaArvore(TreeNode *arvore)
+{
+  if (arvore == NULL)
+    return NULL;
+
+  TreeNode *no = novoNo(arvore->tipoNo, arvore->lineno);
+  *no = *arvore;
+
+  /* nós com lexema precisam de sua própria string */
+  switch (arvore->tipoNo)
+  {
+  case NO_OP_REL:
+  case NO_OP_SOMA:
+  case NO_OP_MULT:
+  case NO_VAR:
+  case NO_CHAMADA:
+  case NO_ID:
+  case NO_NUM:
+  case NO_IMPORT:
+    if (arvore->attr.lexema != NULL)
+      no->attr.lexema = strdup(arvore->attr.lexema);
+    break;
+  default:
+    break;
+  }
+
+  no->irmao = NULL;
+  no->filho = NULL;
+  TreeNode **ultimo = &no->filho;
+  for (TreeNode *f = arvore->filho; f != NULL; f = f->irmao)
+  {
+    *ultimo = copiaArvore(f);
+    ultimo = &(*ultimo)->irmao;
+  }
+  return no;
+}
+
+void liberaArvore(TreeNode *arvore)
+{
+  if (arvore == NULL)
+    return;
+
+  TreeNode *f = arvore->filho;
+  while (f != NULL)
+  {
+    TreeNode *prox = f->irmao;
+    liberaArvore(f);
+    f = prox;
+  }
+
+  switch (arvore->tipoNo)
+  {
+  case NO_OP_REL:
+  case NO_OP_SOMA:
+  case NO_OP_MULT:
+  case NO_VAR:
+  case NO_CHAMADA:
+  case NO_ID:
+  case NO_NUM:
+  case NO_IMPORT:
+    free(arvore->attr.lexema);
+    break;
+  default:
+    break;
+  }
+  free(arvore);
+}
+
 static void imprimeIndent(int indent)
 {
   for (int i = 0; i < indent; i++)
@@ -112,6 +183,9 @@ void imprimeArvore(TreeNode *arvore, int indent)
   case NO_NUM:
     printf("[Num: %s]\n", arvore->attr.lexema);
     break;
+  case NO_IMPORT:
+    printf("[Import: %s]\n", arvore->attr.lexema);
+    break;
   default:
     printf("[No Desconhecido]\n");
   }
@@ -0,0 +1,387 @@
+#include "../include/bytecode.h"
+#include "../include/symtab.h"
+#include "../include/analyze.h"
+#include "../include/limites.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *nomesOp[OP_COUNT] = {
+  "HALT", "CONST", "LOADL", "STOREL", "LOADG", "STOREG", "ADDRL", "ADDRG",
+  "LOADI", "STOREI", "STOREIK", "DUP", "POP",
+  "ADD", "SUB", "MUL", "DIV", "LT", "LE", "GT", "GE", "EQ", "NE",
+  "JMP", "JZ", "JNLT", "JNLE", "JNGT", "JNGE", "JNEQ", "JNNE",
+  "CALL", "RET", "RETV", "INPUT", "OUTPUT", "LIMITE", "LIMITEL"
+};
+
+static Bytecode *bc;
+
+/* profundidade da pilha de operandos durante a geração da função atual */
+static int pilha = 0;
+static int maxPilha = 0;
+
+int bcOperandos(OpCode op)
+{
+  switch (op)
+  {
+  case OP_CONST: case OP_LOADL: case OP_STOREL: case OP_LOADG: case OP_STOREG:
+  case OP_ADDRL: case OP_ADDRG: case OP_JMP: case OP_JZ:
+  case OP_JNLT: case OP_JNLE: case OP_JNGT: case OP_JNGE: case OP_JNEQ: case OP_JNNE:
+  case OP_CALL: case OP_LIMITE: case OP_LIMITEL:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static void emite(int x)
+{
+  if (bc->nCodigo == bc->capCodigo)
+  {
+    bc->capCodigo = bc->capCodigo ? bc->capCodigo * 2 : 256;
+    bc->codigo = (int *) realloc(bc->codigo, sizeof(int) * bc->capCodigo);
+  }
+  bc->codigo[bc->nCodigo++] = x;
+}
+
+/* emite uma instrução e registra seu efeito na pilha de operandos */
+static void op0(OpCode op, int efeito)
+{
+  emite(op);
+  pilha += efeito;
+  if (pilha > maxPilha) maxPilha = pilha;
+}
+
+static void op1(OpCode op, int arg, int efeito)
+{
+  op0(op, efeito);
+  emite(arg);
+}
+
+/* desvio com alvo a corrigir depois; retorna a posição do operando */
+static int desvio(OpCode op, int efeito)
+{
+  op1(op, -1, efeito);
+  return bc->nCodigo - 1;
+}
+
+static void corrige(int pos)
+{
+  bc->codigo[pos] = bc->nCodigo;
+}
+
+static int ehGlobal(BucketList s)
+{
+  return s->scope == 0;
+}
+
+static void geraExpr(TreeNode *t);
+static void geraComando(TreeNode *t);
+
+/* empilha o endereço base de um array (global, local ou parâmetro) */
+static void geraBase(BucketList s)
+{
+  if (ehGlobal(s)) op1(OP_ADDRG, s->loc, 1);
+  else if (s->size > 0) op1(OP_ADDRL, s->loc, 1);
+  else op1(OP_LOADL, s->loc, 1);  /* parâmetro: a célula guarda o endereço */
+}
+
+/* --checked: testa o índice recém-empilhado do acesso; num parâmetro
+   int x[], contra o tamanho que veio com ele */
+static void geraLimite(TreeNode *acesso)
+{
+  BucketList s = acesso->filho->sym;
+  if (!precisaTesteLimite(acesso)) return;
+  if (s->size > 0) op1(OP_LIMITE, s->size, 0);
+  else op1(OP_LIMITEL, st_celula_tamanho(s), 0);
+}
+
+/* tamanho escondido do argumento de um parâmetro int x[]: o do array
+   passado, ou 0 se não for array (todo acesso falha com --checked) */
+static void geraTamanho(TreeNode *arg)
+{
+  BucketList s = (arg->tipoNo == NO_VAR) ? arg->sym : NULL;
+  if (s == NULL || s->kind != ID_ARRAY) op1(OP_CONST, 0, 1);
+  else if (ehGlobal(s) || s->size > 0) op1(OP_CONST, s->size, 1);
+  else op1(OP_LOADL, st_celula_tamanho(s), 1);
+}
+
+static OpCode opRelacional(char *op, int salto)
+{
+  if (strcmp(op, "<") == 0) return salto ? OP_JNLT : OP_LT;
+  if (strcmp(op, "<=") == 0) return salto ? OP_JNLE : OP_LE;
+  if (strcmp(op, ">") == 0) return salto ? OP_JNGT : OP_GT;
+  if (strcmp(op, ">=") == 0) return salto ? OP_JNGE : OP_GE;
+  if (strcmp(op, "==") == 0) return salto ? OP_JNEQ : OP_EQ;
+  return salto ? OP_JNNE : OP_NE;
+}
+
+static void geraChamada(TreeNode *t)
+{
+  BucketList f = t->sym;
+  int k = 0;
+  for (TreeNode *a = t->filho; a != NULL; a = a->irmao, k++)
+  {
+    geraExpr(a);
+    if (k < f->numParams && f->paramArray != NULL && f->paramArray[k]) geraTamanho(a);
+  }
+
+  if (f->loc == FUN_INPUT) op0(OP_INPUT, 1);
+  else if (f->loc == FUN_OUTPUT) op0(OP_OUTPUT, -1);
+  else op1(OP_CALL, f->loc, -st_celulas_params(f) + (f->type == Integer ? 1 : 0));
+}
+
+/* atribuição; 'valor' indica se o resultado fica na pilha */
+static void geraAtribuicao(TreeNode *t, int valor)
+{
+  TreeNode *lhs = t->filho;
+  TreeNode *rhs = lhs->irmao;
+
+  if (lhs->tipoNo == NO_ARRAY_IDX)
+  {
+    geraBase(lhs->filho->sym);
+    geraExpr(lhs->filho->irmao);
+    geraLimite(lhs);
+    geraExpr(rhs);
+    if (valor) op0(OP_STOREIK, -2);
+    else op0(OP_STOREI, -3);
+    return;
+  }
+
+  geraExpr(rhs);
+  if (valor) op0(OP_DUP, 1);
+  if (ehGlobal(lhs->sym)) op1(OP_STOREG, lhs->sym->loc, -1);
+  else op1(OP_STOREL, lhs->sym->loc, -1);
+}
+
+static void geraExpr(TreeNode *t)
+{
+  switch (t->tipoNo)
+  {
+  case NO_NUM:
+    op1(OP_CONST, atoi(t->attr.lexema), 1);
+    break;
+
+  case NO_VAR:
+    if (t->sym->kind == ID_ARRAY) geraBase(t->sym);
+    else if (ehGlobal(t->sym)) op1(OP_LOADG, t->sym->loc, 1);
+    else op1(OP_LOADL, t->sym->loc, 1);
+    break;
+
+  case NO_ARRAY_IDX:
+    geraBase(t->filho->sym);
+    geraExpr(t->filho->irmao);
+    geraLimite(t);
+    op0(OP_LOADI, -1);
+    break;
+
+  case NO_ATRIBUICAO:
+    geraAtribuicao(t, 1);
+    break;
+
+  case NO_OP_SOMA:
+  case NO_OP_MULT:
+  case NO_OP_REL:
+  {
+    geraExpr(t->filho);
+    geraExpr(t->filho->irmao);
+    char *op = t->attr.lexema;
+    if (t->tipoNo == NO_OP_REL) op0(opRelacional(op, 0), -1);
+    else if (strcmp(op, "+") == 0) op0(OP_ADD, -1);
+    else if (strcmp(op, "-") == 0) op0(OP_SUB, -1);
+    else if (strcmp(op, "*") == 0) op0(OP_MUL, -1);
+    else op0(OP_DIV, -1);
+  }
+  break;
+
+  case NO_CHAMADA:
+    geraChamada(t);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/* condição de if/while: desvia quando falsa; retorna o operando a corrigir */
+static int geraCondicao(TreeNode *cond)
+{
+  if (cond->tipoNo == NO_OP_REL)
+  {
+    geraExpr(cond->filho);
+    geraExpr(cond->filho->irmao);
+    return desvio(opRelacional(cond->attr.lexema, 1), -2);
+  }
+  geraExpr(cond);
+  return desvio(OP_JZ, -1);
+}
+
+static void geraComando(TreeNode *t)
+{
+  switch (t->tipoNo)
+  {
+  case NO_DECLARACAO_VAR:
+    break;
+
+  case NO_BLOCO:
+    for (TreeNode *c = t->filho; c != NULL; c = c->irmao)
+      geraComando(c);
+    break;
+
+  case NO_IF:
+  {
+    TreeNode *entao = t->filho->irmao;
+    TreeNode *senao = (entao != NULL) ? entao->irmao : NULL;
+    int falso = geraCondicao(t->filho);
+    if (entao != NULL) geraComando(entao);
+    if (senao != NULL)
+    {
+      int fim = desvio(OP_JMP, 0);
+      corrige(falso);
+      geraComando(senao);
+      corrige(fim);
+    }
+    else
+    {
+      corrige(falso);
+    }
+  }
+  break;
+
+  case NO_WHILE:
+  {
+    int inicio = bc->nCodigo;
+    int sai = geraCondicao(t->filho);
+    if (t->filho->irmao != NULL) geraComando(t->filho->irmao);
+    op1(OP_JMP, inicio, 0);
+    corrige(sai);
+  }
+  break;
+
+  case NO_RETURN:
+    if (t->filho != NULL)
+    {
+      geraExpr(t->filho);
+      op0(OP_RET, -1);
+    }
+    else
+    {
+      op0(OP_RETV, 0);
+    }
+    break;
+
+  case NO_ATRIBUICAO:
+    geraAtribuicao(t, 0);
+    break;
+
+  case NO_CHAMADA:
+    geraChamada(t);
+    if (t->sym->type == Integer) op0(OP_POP, -1);
+    break;
+
+  default:
+    /* expressão usada como comando: avalia e descarta */
+    geraExpr(t);
+    op0(OP_POP, -1);
+    break;
+  }
+}
+
+static void geraFuncao(TreeNode *decl)
+{
+  BucketList s = decl->sym;
+  BcFuncao *f = &bc->funcoes[s->loc];
+
+  TreeNode *corpo = decl->filho->irmao->irmao;
+  while (corpo != NULL && corpo->tipoNo != NO_BLOCO) corpo = corpo->irmao;
+
+  f->nome = s->name;
+  f->entrada = bc->nCodigo;
+  f->nparams = st_celulas_params(s);
+  f->frameSize = s->frameSize;
+  f->retornaValor = (s->type == Integer);
+
+  pilha = 0;
+  maxPilha = 0;
+  if (corpo != NULL) geraComando(corpo);
+
+  /* retorno implícito ao fim do corpo */
+  if (s->type == Integer)
+  {
+    op1(OP_CONST, 0, 1);
+    op0(OP_RET, -1);
+  }
+  else
+  {
+    op0(OP_RETV, 0);
+  }
+  f->maxPilha = maxPilha;
+}
+
+Bytecode *bcCompila(TreeNode *arvore)
+{
+  bc = (Bytecode *) calloc(1, sizeof(Bytecode));
+  bc->nFuncoes = analyzeFunctionCount();
+  bc->funcoes = (BcFuncao *) calloc(bc->nFuncoes, sizeof(BcFuncao));
+  bc->tamGlobais = analyzeGlobalSize();
+  bc->principal = -1;
+
+  for (int i = 0; i < bc->nFuncoes; i++)
+    bc->funcoes[i].entrada = -1;
+  bc->funcoes[FUN_INPUT].nome = "input";
+  bc->funcoes[FUN_OUTPUT].nome = "output";
+
+  BucketList principal = st_lookup_scope_rec("main", 0);
+  if (principal == NULL || principal->kind != ID_FUN)
+  {
+    free(bc->funcoes);
+    free(bc);
+    return NULL;
+  }
+  bc->principal = principal->loc;
+
+  /* ponto de entrada: chama main e para */
+  op1(OP_CALL, bc->principal, 0);
+  op0(OP_HALT, 0);
+
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+  {
+    if (d->tipoNo == NO_DECLARACAO_FUN && d->sym != NULL)
+      geraFuncao(d);
+  }
+
+  Bytecode *r = bc;
+  bc = NULL;
+  return r;
+}
+
+void bcLibera(Bytecode *b)
+{
+  if (b == NULL) return;
+  free(b->codigo);
+  free(b->funcoes);
+  free(b);
+}
+
+void bcImprime(Bytecode *b, FILE *saida)
+{
+  for (int pc = 0; pc < b->nCodigo; )
+  {
+    for (int i = 0; i < b->nFuncoes; i++)
+    {
+      if (b->funcoes[i].entrada == pc)
+        fprintf(saida, "%s: (params %d, frame %d, pilha %d)\n", b->funcoes[i].nome,
+                b->funcoes[i].nparams, b->funcoes[i].frameSize, b->funcoes[i].maxPilha);
+    }
+
+    OpCode op = (OpCode) b->codigo[pc];
+    fprintf(saida, "%6d  %-8s", pc, nomesOp[op]);
+    if (bcOperandos(op) == 1)
+    {
+      int arg = b->codigo[pc + 1];
+      if (op == OP_CALL) fprintf(saida, " %s", b->funcoes[arg].nome);
+      else fprintf(saida, " %d", arg);
+    }
+    fprintf(saida, "\n");
+    pc += 1 + bcOperandos(op);
+  }
+}
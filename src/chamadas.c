@@ -0,0 +1,215 @@
+#include "../include/chamadas.h"
+#include "../include/analyze.h"
+
+/* Montagem das listas de chamados: 'visto' marca com o índice do chamador
+   corrente, o que elimina repetições sem limpar nada entre funções */
+static int *lista;
+static int nLista, capLista;
+static int *visto;
+
+static void coleta(TreeNode *t, int chamador)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    if (t->tipoNo == NO_CHAMADA && t->sym != NULL && visto[t->sym->loc] != chamador)
+    {
+      visto[t->sym->loc] = chamador;
+      if (nLista == capLista)
+      {
+        capLista = capLista ? capLista * 2 : 64;
+        lista = (int *) realloc(lista, sizeof(int) * capLista);
+      }
+      lista[nLista++] = t->sym->loc;
+    }
+    coleta(t->filho, chamador);
+  }
+}
+
+/* --- Tarjan --- */
+
+static GrafoChamadas *gt;
+static int *indice, *menor, *pilha;
+static char *naPilha;
+static int proxIndice, topo, nOrdem;
+
+static void conecta(int f)
+{
+  indice[f] = menor[f] = proxIndice++;
+  pilha[topo++] = f;
+  naPilha[f] = 1;
+
+  for (int k = gt->inicioChamados[f]; k < gt->inicioChamados[f + 1]; k++)
+  {
+    int c = gt->chamados[k];
+    if (c == f) gt->recursiva[f] = 1;
+    if (indice[c] < 0)
+    {
+      conecta(c);
+      if (menor[c] < menor[f]) menor[f] = menor[c];
+    }
+    else if (naPilha[c] && indice[c] < menor[f])
+    {
+      menor[f] = indice[c];
+    }
+  }
+
+  /* raiz da componente: as componentes saem na ordem de baixo para cima */
+  if (menor[f] == indice[f])
+  {
+    int inicio = nOrdem;
+    int x;
+    do
+    {
+      x = pilha[--topo];
+      naPilha[x] = 0;
+      gt->scc[x] = gt->nSccs;
+      gt->ordem[nOrdem++] = x;
+    } while (x != f);
+    if (nOrdem - inicio > 1)
+      for (int k = inicio; k < nOrdem; k++) gt->recursiva[gt->ordem[k]] = 1;
+    gt->nSccs++;
+  }
+}
+
+GrafoChamadas *chamadasConstroi(TreeNode *arvore)
+{
+  GrafoChamadas *g = (GrafoChamadas *) calloc(1, sizeof(GrafoChamadas));
+  int n = g->nFuncoes = analyzeFunctionCount();
+  g->sym = (BucketList *) calloc(n + 1, sizeof(BucketList));
+  g->decl = (TreeNode **) calloc(n + 1, sizeof(TreeNode *));
+  g->inicioChamados = (int *) calloc(n + 1, sizeof(int));
+  g->scc = (int *) malloc(sizeof(int) * (n + 1));
+  g->ordem = (int *) malloc(sizeof(int) * (n + 1));
+  g->recursiva = (char *) calloc(n + 1, 1);
+  g->alcancavel = (char *) calloc(n + 1, 1);
+  g->main = -1;
+
+  g->sym[FUN_INPUT] = st_lookup_rec("input");
+  g->sym[FUN_OUTPUT] = st_lookup_rec("output");
+  /* importadas (compilação separada): só o símbolo, sem declaração */
+  for (int k = 0; analyzeImportada(k) != NULL; k++)
+  {
+    const Interface *i = analyzeImportada(k);
+    for (int j = 0; j < i->n; j++)
+    {
+      BucketList s = st_lookup_rec(i->simbolos[j].nome);
+      if (s != NULL && s->kind == ID_FUN && s->scope == 0 && s->loc < n) g->sym[s->loc] = s;
+    }
+  }
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_FUN && d->sym != NULL)
+    {
+      g->sym[d->sym->loc] = d->sym;
+      g->decl[d->sym->loc] = d;
+      if (strcmp(d->sym->name, "main") == 0) g->main = d->sym->loc;
+    }
+
+  /* listas de chamados, na ordem dos índices (CSR) */
+  nLista = 0;
+  visto = (int *) malloc(sizeof(int) * (n + 1));
+  for (int f = 0; f < n; f++) visto[f] = -1;
+  for (int f = 0; f < n; f++)
+  {
+    g->inicioChamados[f] = nLista;
+    if (g->decl[f] != NULL) coleta(g->decl[f]->filho, f);
+  }
+  g->inicioChamados[n] = nLista;
+  g->chamados = (int *) malloc(sizeof(int) * (nLista + 1));
+  if (nLista > 0) memcpy(g->chamados, lista, sizeof(int) * nLista);
+  free(lista);
+  lista = NULL;
+  capLista = 0;
+  free(visto);
+
+  gt = g;
+  indice = (int *) malloc(sizeof(int) * (n + 1));
+  menor = (int *) malloc(sizeof(int) * (n + 1));
+  pilha = (int *) malloc(sizeof(int) * (n + 1));
+  naPilha = (char *) calloc(n + 1, 1);
+  for (int f = 0; f < n; f++) indice[f] = -1;
+  proxIndice = topo = nOrdem = 0;
+  for (int f = 0; f < n; f++)
+    if (indice[f] < 0) conecta(f);
+  free(indice);
+  free(menor);
+  free(naPilha);
+
+  /* alcançáveis a partir de main (reaproveita a pilha) */
+  if (g->main >= 0)
+  {
+    topo = 0;
+    pilha[topo++] = g->main;
+    g->alcancavel[g->main] = 1;
+    while (topo > 0)
+    {
+      int f = pilha[--topo];
+      for (int k = g->inicioChamados[f]; k < g->inicioChamados[f + 1]; k++)
+        if (!g->alcancavel[g->chamados[k]])
+        {
+          g->alcancavel[g->chamados[k]] = 1;
+          pilha[topo++] = g->chamados[k];
+        }
+    }
+  }
+  free(pilha);
+  gt = NULL;
+  return g;
+}
+
+void chamadasLibera(GrafoChamadas *g)
+{
+  if (g == NULL) return;
+  free(g->sym);
+  free(g->decl);
+  free(g->inicioChamados);
+  free(g->chamados);
+  free(g->scc);
+  free(g->ordem);
+  free(g->recursiva);
+  free(g->alcancavel);
+  free(g);
+}
+
+static const char *nome(GrafoChamadas *g, int f)
+{
+  return g->sym[f] != NULL ? g->sym[f]->name : "?";
+}
+
+void chamadasDot(GrafoChamadas *g, FILE *saida)
+{
+  fprintf(saida, "digraph chamadas {\n");
+  fprintf(saida, "  node [shape=box];\n");
+  for (int f = 0; f < g->nFuncoes; f++)
+  {
+    fprintf(saida, "  \"%s\"", nome(g, f));
+    if (g->recursiva[f] && !g->alcancavel[f])
+      fprintf(saida, " [style=\"bold,dashed\"]");
+    else if (g->recursiva[f])
+      fprintf(saida, " [style=bold]");
+    else if (!g->alcancavel[f])
+      fprintf(saida, " [style=dashed]");
+    fprintf(saida, ";\n");
+  }
+  for (int f = 0; f < g->nFuncoes; f++)
+    for (int k = g->inicioChamados[f]; k < g->inicioChamados[f + 1]; k++)
+      fprintf(saida, "  \"%s\" -> \"%s\";\n", nome(g, f), nome(g, g->chamados[k]));
+  fprintf(saida, "}\n");
+}
+
+void chamadasJson(GrafoChamadas *g, FILE *saida)
+{
+  fprintf(saida, "{\n  \"funcoes\": [\n");
+  for (int f = 0; f < g->nFuncoes; f++)
+  {
+    fprintf(saida, "    {\"nome\": \"%s\", \"linha\": %d, \"scc\": %d, \"recursiva\": %s, \"alcancavel\": %s, \"chama\": [",
+            nome(g, f), g->decl[f] != NULL ? g->decl[f]->lineno : 0, g->scc[f],
+            g->recursiva[f] ? "true" : "false", g->alcancavel[f] ? "true" : "false");
+    for (int k = g->inicioChamados[f]; k < g->inicioChamados[f + 1]; k++)
+      fprintf(saida, "%s\"%s\"", k > g->inicioChamados[f] ? ", " : "", nome(g, g->chamados[k]));
+    fprintf(saida, "]}%s\n", f + 1 < g->nFuncoes ? "," : "");
+  }
+  fprintf(saida, "  ],\n  \"ordem\": [");
+  for (int k = 0; k < g->nFuncoes; k++)
+    fprintf(saida, "%s\"%s\"", k ? ", " : "", nome(g, g->ordem[k]));
+  fprintf(saida, "]\n}\n");
+}
@@ -374,8 +374,8 @@ static void yynoreturn yy_fatal_error ( const char* msg  );
 	(yy_hold_char) = *yy_cp; \
 	*yy_cp = '\0'; \
 	(yy_c_buf_p) = yy_cp;
-#define YY_NUM_RULES 29
-#define YY_END_OF_BUFFER 30
+#define YY_NUM_RULES 28
+#define YY_END_OF_BUFFER 29
 /* This struct is not used in this scanner,
    but its presence is necessary. */
 struct yy_trans_info
@@ -383,13 +383,12 @@ struct yy_trans_info
 	flex_int32_t yy_verify;
 	flex_int32_t yy_nxt;
 	};
-static const flex_int16_t yy_accept[42] =
+static const flex_int16_t yy_accept[40] =
     {   0,
-        0,    0,    0,    0,   30,   28,   27,   27,   28,    6,
-        7,   14,   12,   24,   13,   15,   25,   23,   20,   22,
-       21,   26,   10,   11,    8,    9,    4,    3,    4,   27,
-       19,    1,    5,   25,   16,   18,   17,   26,    2,    5,
-        0
+        0,    0,    0,    0,   29,   27,   26,   26,   27,    5,
+        6,   13,   11,   23,   12,   14,   24,   22,   19,   21,
+       20,   25,    9,   10,    7,    8,    4,    3,    4,   26,
+       18,    1,   24,   15,   17,   16,   25,    2,    0
     } ;
 
 static const YY_CHAR yy_ec[256] =
@@ -403,11 +402,11 @@ static const YY_CHAR yy_ec[256] =
        15,   16,    1,    1,   17,   17,   17,   17,   17,   17,
        17,   17,   17,   17,   17,   17,   17,   17,   17,   17,
        17,   17,   17,   17,   17,   17,   17,   17,   17,   17,
-       18,    1,   19,    1,   20,    1,   17,   17,   17,   17,
+       18,    1,   19,    1,    1,    1,   17,   17,   17,   17,
 
        17,   17,   17,   17,   17,   17,   17,   17,   17,   17,
        17,   17,   17,   17,   17,   17,   17,   17,   17,   17,
-       17,   17,   21,    1,   22,    1,    1,    1,    1,    1,
+       17,   17,   20,    1,   21,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
@@ -424,60 +423,134 @@ static const YY_CHAR yy_ec[256] =
         1,    1,    1,    1,    1
     } ;
 
-static const YY_CHAR yy_meta[23] =
+static const YY_CHAR yy_meta[22] =
     {   0,
-        1,    1,    2,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    1
+        1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
+        1
     } ;
 
-static const flex_int16_t yy_base[44] =
+static const flex_int16_t yy_base[40] =
     {   0,
-        0,    0,   20,   21,   51,   52,   23,   27,   35,   52,
-       52,   52,   52,   52,   52,   24,   37,   52,   33,   32,
-       28,   20,   52,   52,   52,   52,   52,   52,   31,   31,
-       52,   52,    0,   27,   52,   52,   52,   24,   52,    0,
-       52,   44,   37
+        1,   23,   45,   67,   89,  397,  111,  133,  155,  397,
+      397,  397,  397,  397,  397,  177,  199,  397,  221,  243,
+      265,  287,  397,  397,  397,  397,  397,  397,  309,  331,
+      397,  397,  353,  397,  397,  397,  375,  397,  397
     } ;
 
-static const flex_int16_t yy_def[44] =
+static const flex_int16_t yy_def[40] =
     {   0,
-       41,    1,   42,   42,   41,   41,   41,   41,   41,   41,
-       41,   41,   41,   41,   41,   41,   41,   41,   41,   41,
-       41,   41,   41,   41,   41,   41,   41,   41,   41,   41,
-       41,   41,   43,   41,   41,   41,   41,   41,   41,   43,
-        0,   41,   41
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,    0
     } ;
 
-static const flex_int16_t yy_nxt[75] =
+static const flex_int16_t yy_nxt[419] =
     {   0,
-        6,    7,    8,    9,   10,   11,   12,   13,   14,   15,
-       16,   17,   18,   19,   20,   21,   22,   23,   24,    6,
-       25,   26,   28,   28,   30,   30,   29,   29,   30,   30,
-       32,   38,   30,   30,   33,   38,   38,   40,   34,   38,
-       38,   39,   37,   38,   27,   27,   36,   35,   34,   31,
-       41,    5,   41,   41,   41,   41,   41,   41,   41,   41,
-       41,   41,   41,   41,   41,   41,   41,   41,   41,   41,
-       41,   41,   41,   41
+        5,    6,    7,    8,    9,   10,   11,   12,   13,   14,
+       15,   16,   17,   18,   19,   20,   21,   22,   23,   24,
+       25,   26,    5,    6,    7,    8,    9,   10,   11,   12,
+       13,   14,   15,   16,   17,   18,   19,   20,   21,   22,
+       23,   24,   25,   26,    5,   27,   27,   28,   27,   27,
+       27,   29,   27,   27,   27,   27,   27,   27,   27,   27,
+       27,   27,   27,   27,   27,   27,    5,   27,   27,   28,
+       27,   27,   27,   29,   27,   27,   27,   27,   27,   27,
+       27,   27,   27,   27,   27,   27,   27,   27,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+        5,   39,   30,   30,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,    5,   39,   30,   30,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,    5,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   31,
+       39,   39,   39,   39,   39,   39,    5,   39,   39,   39,
+       39,   39,   39,   32,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,    5,   39,
+
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       33,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+        5,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   34,   39,   39,   39,   39,
+       39,   39,    5,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   35,   39,   39,
+       39,   39,   39,   39,    5,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   36,
+       39,   39,   39,   39,   39,   39,    5,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+
+       39,   39,   39,   37,   39,   39,   39,   39,    5,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   38,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+        5,   39,   30,   30,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,    5,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   33,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,    5,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   37,   39,   39,   39,   39,    5,   39,   39,   39,
+
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39
     } ;
 
-static const flex_int16_t yy_chk[75] =
+static const flex_int16_t yy_chk[419] =
     {   0,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
         1,    1,    1,    1,    1,    1,    1,    1,    1,    1,
-        1,    1,    3,    4,    7,    7,    3,    4,    8,    8,
-       16,   22,   30,   30,   16,   38,   22,   43,   34,   22,
-       38,   29,   21,   38,   42,   42,   20,   19,   17,    9,
-        5,   41,   41,   41,   41,   41,   41,   41,   41,   41,
-       41,   41,   41,   41,   41,   41,   41,   41,   41,   41,
-       41,   41,   41,   41
+        1,    1,    2,    2,    2,    2,    2,    2,    2,    2,
+        2,    2,    2,    2,    2,    2,    2,    2,    2,    2,
+        2,    2,    2,    2,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    3,    3,    3,    3,
+        3,    3,    3,    3,    3,    3,    4,    4,    4,    4,
+        4,    4,    4,    4,    4,    4,    4,    4,    4,    4,
+        4,    4,    4,    4,    4,    4,    4,    4,    5,    5,
+        5,    5,    5,    5,    5,    5,    5,    5,    5,    5,
+
+        5,    5,    5,    5,    5,    5,    5,    5,    5,    5,
+        7,    7,    7,    7,    7,    7,    7,    7,    7,    7,
+        7,    7,    7,    7,    7,    7,    7,    7,    7,    7,
+        7,    7,    8,    8,    8,    8,    8,    8,    8,    8,
+        8,    8,    8,    8,    8,    8,    8,    8,    8,    8,
+        8,    8,    8,    8,    9,    9,    9,    9,    9,    9,
+        9,    9,    9,    9,    9,    9,    9,    9,    9,    9,
+        9,    9,    9,    9,    9,    9,   16,   16,   16,   16,
+       16,   16,   16,   16,   16,   16,   16,   16,   16,   16,
+       16,   16,   16,   16,   16,   16,   16,   16,   17,   17,
+
+       17,   17,   17,   17,   17,   17,   17,   17,   17,   17,
+       17,   17,   17,   17,   17,   17,   17,   17,   17,   17,
+       19,   19,   19,   19,   19,   19,   19,   19,   19,   19,
+       19,   19,   19,   19,   19,   19,   19,   19,   19,   19,
+       19,   19,   20,   20,   20,   20,   20,   20,   20,   20,
+       20,   20,   20,   20,   20,   20,   20,   20,   20,   20,
+       20,   20,   20,   20,   21,   21,   21,   21,   21,   21,
+       21,   21,   21,   21,   21,   21,   21,   21,   21,   21,
+       21,   21,   21,   21,   21,   21,   22,   22,   22,   22,
+       22,   22,   22,   22,   22,   22,   22,   22,   22,   22,
+
+       22,   22,   22,   22,   22,   22,   22,   22,   29,   29,
+       29,   29,   29,   29,   29,   29,   29,   29,   29,   29,
+       29,   29,   29,   29,   29,   29,   29,   29,   29,   29,
+       30,   30,   30,   30,   30,   30,   30,   30,   30,   30,
+       30,   30,   30,   30,   30,   30,   30,   30,   30,   30,
+       30,   30,   33,   33,   33,   33,   33,   33,   33,   33,
+       33,   33,   33,   33,   33,   33,   33,   33,   33,   33,
+       33,   33,   33,   33,   37,   37,   37,   37,   37,   37,
+       37,   37,   37,   37,   37,   37,   37,   37,   37,   37,
+       37,   37,   37,   37,   37,   37,   39,   39,   39,   39,
+
+       39,   39,   39,   39,   39,   39,   39,   39,   39,   39,
+       39,   39,   39,   39,   39,   39,   39,   39
     } ;
 
 /* Table of booleans, true if rule could match eol. */
-static const flex_int32_t yy_rule_can_match_eol[30] =
+static const flex_int32_t yy_rule_can_match_eol[29] =
     {   0,
 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
-    0, 0, 0, 0, 0, 0, 0, 1, 0, 0,     };
+    0, 0, 0, 0, 0, 0, 1, 0, 0,     };
 
 static yy_state_type yy_last_accepting_state;
 static char *yy_last_accepting_cpos;
@@ -493,6 +566,8 @@ int yy_flex_debug = 0;
 #define YY_MORE_ADJ 0
 #define YY_RESTORE_YY_MORE_OFFSET
 char *yytext;
+#define YY_NO_INPUT 1
+#define YY_NO_UNPUT 1
 #line 1 "cminus.l"
 #line 2 "cminus.l"
 #include <stdio.h>
@@ -500,30 +575,13 @@ char *yytext;
 #include <stdlib.h>
 #include "arvore.h"
 #include "cminus.tab.h"
+#include "diagnostico.h"
 
 extern int yylineno;
-
-// Variáveis para rastrear estruturas abertas
-int open_braces = 0;
-int open_parens = 0;
-int open_brackets = 0;
-
 int comment_start_line = 0;
+#line 583 "cminus.lex.c"
 
-void check_unclosed_structures() {
-    if (open_braces > 0) {
-        fprintf(stderr, "Erro: %d chave(s) '}' não fechada(s)\n", open_braces);
-    }
-    if (open_parens > 0) {
-        fprintf(stderr, "Erro: %d parêntese(s) ')' não fechado(s)\n", open_parens);
-    }
-    if (open_brackets > 0) {
-        fprintf(stderr, "Erro: %d colchete(s) ']' não fechado(s)\n", open_brackets);
-    }
-}
-#line 525 "cminus.lex.c"
-
-#line 527 "cminus.lex.c"
+#line 585 "cminus.lex.c"
 
 #define INITIAL 0
 #define COMMENT 1
@@ -741,10 +799,10 @@ YY_DECL
 		}
 
 	{
-#line 34 "cminus.l"
+#line 20 "cminus.l"
 
 
-#line 748 "cminus.lex.c"
+#line 806 "cminus.lex.c"
 
 	while ( /*CONSTCOND*/1 )		/* loops until end-of-file is reached */
 		{
@@ -771,13 +829,13 @@ yy_match:
 			while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 				{
 				yy_current_state = (int) yy_def[yy_current_state];
-				if ( yy_current_state >= 42 )
+				if ( yy_current_state >= 40 )
 					yy_c = yy_meta[yy_c];
 				}
 			yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
 			++yy_cp;
 			}
-		while ( yy_base[yy_current_state] != 52 );
+		while ( yy_base[yy_current_state] != 397 );
 
 yy_find_action:
 		yy_act = yy_accept[yy_current_state];
@@ -813,7 +871,7 @@ do_action:	/* This label is used only to access EOF actions. */
 
 case 1:
 YY_RULE_SETUP
-#line 36 "cminus.l"
+#line 21 "cminus.l"
 { 
     comment_start_line = yylineno;
     BEGIN(COMMENT); 
@@ -821,151 +879,133 @@ YY_RULE_SETUP
 	YY_BREAK
 case 2:
 YY_RULE_SETUP
-#line 41 "cminus.l"
+#line 26 "cminus.l"
 { BEGIN(INITIAL); }
 	YY_BREAK
 case 3:
 /* rule 3 can match eol */
 YY_RULE_SETUP
-#line 42 "cminus.l"
+#line 27 "cminus.l"
 { }
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 43 "cminus.l"
+#line 28 "cminus.l"
 { }
 	YY_BREAK
 case YY_STATE_EOF(COMMENT):
-#line 45 "cminus.l"
+#line 30 "cminus.l"
 { 
-    fprintf(stderr, "Erro: comentário não fechado (iniciado na linha %d)\n", comment_start_line); 
-    check_unclosed_structures();
+    diagRelata(DIAG_LEXICO, comment_start_line, "ERRO LÉXICO: Comentario nao fechado LINHA: %d\n", comment_start_line);
     return 0;
 }
 	YY_BREAK
 case 5:
 YY_RULE_SETUP
-#line 51 "cminus.l"
-{ /* ignora comentário de linha */ }
+#line 35 "cminus.l"
+{ return TOKEN_LEFT_PARENTHESIS; }
 	YY_BREAK
 case 6:
 YY_RULE_SETUP
-#line 53 "cminus.l"
-{ open_parens++; return TOKEN_LEFT_PARENTHESIS; }
+#line 36 "cminus.l"
+{ return TOKEN_RIGHT_PARENTHESIS; }
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 54 "cminus.l"
-{ 
-    if (open_parens > 0) open_parens--; 
-    else fprintf(stderr, "Erro: parêntese fechado ')' sem abertura na linha %d\n", yylineno);
-    return TOKEN_RIGHT_PARENTHESIS; 
-}
+#line 37 "cminus.l"
+{ return TOKEN_LEFT_BRACKET; }
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 60 "cminus.l"
-{ open_braces++; return TOKEN_LEFT_BRACKET; }
+#line 38 "cminus.l"
+{ return TOKEN_RIGHT_BRACKET; }
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 61 "cminus.l"
-{ 
-    if (open_braces > 0) open_braces--; 
-    else fprintf(stderr, "Erro: chave fechada '}' sem abertura na linha %d\n", yylineno);
-    return TOKEN_RIGHT_BRACKET; 
-}
+#line 39 "cminus.l"
+{ return TOKEN_LEFT_SQUARE_BRACKET; }
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 67 "cminus.l"
-{ open_brackets++; return TOKEN_LEFT_SQUARE_BRACKET; }
+#line 40 "cminus.l"
+{ return TOKEN_RIGHT_SQUARE_BRACKET; }
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 68 "cminus.l"
-{ 
-    if (open_brackets > 0) open_brackets--; 
-    else fprintf(stderr, "Erro: colchete fechado ']' sem abertura na linha %d\n", yylineno);
-    return TOKEN_RIGHT_SQUARE_BRACKET; 
-}
-	YY_BREAK
-case 12:
-YY_RULE_SETUP
-#line 74 "cminus.l"
+#line 42 "cminus.l"
 { return TOKEN_PLUS; }
 	YY_BREAK
-case 13:
+case 12:
 YY_RULE_SETUP
-#line 75 "cminus.l"
+#line 43 "cminus.l"
 { return TOKEN_MINUS; }
 	YY_BREAK
-case 14:
+case 13:
 YY_RULE_SETUP
-#line 76 "cminus.l"
+#line 44 "cminus.l"
 { return TOKEN_MULT; }
 	YY_BREAK
-case 15:
+case 14:
 YY_RULE_SETUP
-#line 77 "cminus.l"
+#line 45 "cminus.l"
 { return TOKEN_DIV; }
 	YY_BREAK
-case 16:
+case 15:
 YY_RULE_SETUP
-#line 78 "cminus.l"
+#line 46 "cminus.l"
 { return TOKEN_MINOR_EQUAL; }
 	YY_BREAK
-case 17:
+case 16:
 YY_RULE_SETUP
-#line 79 "cminus.l"
+#line 47 "cminus.l"
 { return TOKEN_GREATER_EQUAL; }
 	YY_BREAK
-case 18:
+case 17:
 YY_RULE_SETUP
-#line 80 "cminus.l"
+#line 48 "cminus.l"
 { return TOKEN_EQUAL_EQUAL; }
 	YY_BREAK
-case 19:
+case 18:
 YY_RULE_SETUP
-#line 81 "cminus.l"
+#line 49 "cminus.l"
 { return TOKEN_NOT_EQUAL; }
 	YY_BREAK
-case 20:
+case 19:
 YY_RULE_SETUP
-#line 82 "cminus.l"
+#line 50 "cminus.l"
 { return TOKEN_MINOR; }
 	YY_BREAK
-case 21:
+case 20:
 YY_RULE_SETUP
-#line 83 "cminus.l"
+#line 51 "cminus.l"
 { return TOKEN_GREATER; }
 	YY_BREAK
-case 22:
+case 21:
 YY_RULE_SETUP
-#line 84 "cminus.l"
+#line 52 "cminus.l"
 { return TOKEN_EQUAL; }
 	YY_BREAK
-case 23:
+case 22:
 YY_RULE_SETUP
-#line 85 "cminus.l"
+#line 53 "cminus.l"
 { return TOKEN_SEMICOLON; }
 	YY_BREAK
-case 24:
+case 23:
 YY_RULE_SETUP
-#line 86 "cminus.l"
+#line 54 "cminus.l"
 { return TOKEN_COMMA; }
 	YY_BREAK
-case 25:
+case 24:
 YY_RULE_SETUP
-#line 88 "cminus.l"
+#line 56 "cminus.l"
 { 
     yylval.lexema = strdup(yytext);
     return TOKEN_NUM; 
-    }
+}
 	YY_BREAK
-case 26:
+case 25:
 YY_RULE_SETUP
-#line 93 "cminus.l"
+#line 61 "cminus.l"
 {
     if (strcmp(yytext, "if") == 0) return TOKEN_IF;
     else if (strcmp(yytext, "else") == 0) return TOKEN_ELSE;
@@ -973,39 +1013,37 @@ YY_RULE_SETUP
     else if (strcmp(yytext, "return") == 0) return TOKEN_RETURN;
     else if (strcmp(yytext, "void") == 0) return TOKEN_VOID;
     else if (strcmp(yytext, "while") == 0) return TOKEN_WHILE;
-    else{
+    else if (strcmp(yytext, "import") == 0) return TOKEN_IMPORT;
+    else {
         yylval.lexema = strdup(yytext);
         return TOKEN_ID;
     }
 }
 	YY_BREAK
-case 27:
-/* rule 27 can match eol */
+case 26:
+/* rule 26 can match eol */
 YY_RULE_SETUP
-#line 106 "cminus.l"
+#line 75 "cminus.l"
 { /* ignora espaços, tabs e novas linhas */ }
 	YY_BREAK
-case 28:
+case 27:
 YY_RULE_SETUP
-#line 108 "cminus.l"
+#line 77 "cminus.l"
 {
-    fprintf(stderr, "Erro léxico na linha %d: caractere inválido '%s'\n", yylineno, yytext);
+    diagRelata(DIAG_LEXICO, yylineno, "ERRO LÉXICO: %s LINHA: %d\n", yytext, yylineno);
     return 0;
 }
 	YY_BREAK
 case YY_STATE_EOF(INITIAL):
-#line 113 "cminus.l"
-{ 
-    check_unclosed_structures();
-    return 0; 
-}
+#line 82 "cminus.l"
+{ return 0; }
 	YY_BREAK
-case 29:
+case 28:
 YY_RULE_SETUP
-#line 118 "cminus.l"
+#line 84 "cminus.l"
 ECHO;
 	YY_BREAK
-#line 1009 "cminus.lex.c"
+#line 1047 "cminus.lex.c"
 
 	case YY_END_OF_BUFFER:
 		{
@@ -1300,7 +1338,7 @@ static int yy_get_next_buffer (void)
 		while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 			{
 			yy_current_state = (int) yy_def[yy_current_state];
-			if ( yy_current_state >= 42 )
+			if ( yy_current_state >= 40 )
 				yy_c = yy_meta[yy_c];
 			}
 		yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
@@ -1328,11 +1366,11 @@ static int yy_get_next_buffer (void)
 	while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 		{
 		yy_current_state = (int) yy_def[yy_current_state];
-		if ( yy_current_state >= 42 )
+		if ( yy_current_state >= 40 )
 			yy_c = yy_meta[yy_c];
 		}
 	yy_current_state = yy_nxt[yy_base[yy_current_state] + yy_c];
-	yy_is_jam = (yy_current_state == 41);
+	yy_is_jam = (yy_current_state == 39);
 
 		return yy_is_jam ? 0 : yy_current_state;
 }
@@ -2020,5 +2058,13 @@ void yyfree (void * ptr )
 
 #define YYTABLES_NAME "yytables"
 
-#line 118 "cminus.l"
+#line 84 "cminus.l"
 
+
+/* Recomeça a leitura em outro arquivo (modo lote): buffer, linha e
+   estado (um comentário não fechado deixa o analisador em COMMENT) */
+void lexReinicia(FILE *f) {
+    yyrestart(f);
+    yylineno = 1;
+    BEGIN(INITIAL);
+}
@@ -1,18 +1,36 @@
 %{
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "arvore.h"
-#include "symtab.h"
+#include "diagnostico.h"
+#include "esteira.h"
+
+// O bison lê o token corrente por lexFila (esteira.h): direto do flex ou,
+// com --esteira, da fila que a thread do léxico enche. Lexema, linha e texto
+// do token vêm de lá, e não das globais que o flex reescreve ao avançar.
+#define yylex lexFila
+#define yylval valorToken
+#define yylineno linhaToken
+#define yytext textoToken
 
 // Declarações externas para funções e variáveis do analisador léxico
 extern int yylex(void);
-extern FILE *yyin;
 extern int yylineno;
 extern char* yytext;
 
+// Libera um nó e os irmãos (listas descartadas num erro sintático)
+static void descarta(TreeNode *t) {
+    while (t != NULL) {
+        TreeNode *prox = t->irmao;
+        liberaArvore(t);
+        t = prox;
+    }
+}
+
 // Função para tratamento de erro padrão do bison
 void yyerror(const char* s) {
-    printf("ERRO SINTÁTICO: %s LINHA: %d\n", yytext, yylineno);
+    diagRelata(DIAG_SINTATICO, yylineno, "ERRO SINTÁTICO: %s LINHA: %d\n", yytext, yylineno);
 }
 %}
 
@@ -34,6 +52,7 @@ void yyerror(const char* s) {
 %token TOKEN_LEFT_BRACKET TOKEN_RIGHT_BRACKET
 %token TOKEN_LEFT_SQUARE_BRACKET TOKEN_RIGHT_SQUARE_BRACKET
 %token TOKEN_IF TOKEN_ELSE TOKEN_INT TOKEN_RETURN TOKEN_VOID TOKEN_WHILE
+%token TOKEN_IMPORT
 
 /* Definição de tokens (símbolos terminais) que carregam um lexema*/
 %token <lexema> TOKEN_NUM
@@ -51,47 +70,116 @@ void yyerror(const char* s) {
 %precedence TOKEN_ELSE
 
 /* Definição dos tipos dos símbolos não-terminais (mapeiam para union) */
-%type <no> program declaration_list declaration var_declaration type_specifier
+%type <no> program import_list import_declaration
+%type <no> declaration_list declaration var_declaration type_specifier
 %type <no> fun_declaration params param_list param compound_stmt
 %type <no> local_declarations statement_list statement expression_stmt
 %type <no> selection_stmt iteration_stmt return_stmt expression var
 %type <no> simple_expression relop additive_expression addop term
 %type <no> mulop factor call args arg_list
 
+/* Num erro sintático o bison descarta o que está na pilha: subárvores e
+   lexemas são liberados (a libcminus compila muitas vezes no mesmo
+   processo). A lista de declarações pode estar com a thread da semântica
+   (esteira.h). A raiz, no sucesso, fica em raizArvore. */
+%destructor { descarta($$); } <no>
+%destructor { free($$); } <lexema>
+%destructor { if (!esteiraLendoArvore()) descarta($$); } declaration_list declaration
+%destructor { if (!esteiraLendoArvore()) descarta($$); } import_list import_declaration
+%destructor { } program
+
 %%
 
 /* Regra Inicial: program
-   Um programa consiste em uma lista de declarações.
+   Um programa consiste em uma lista de importações (possivelmente vazia)
+   seguida de uma lista de declarações; só importações também é aceito (um
+   pedaço do documento no lsp.h, ou a falta de main na semântica).
    A raiz da árvore (raizArvore) aponta para este nó.
 */
 program:
-    declaration_list
+    import_list declaration_list
     {
         $$ = novoNo(NO_PROGRAMA, yylineno);
-        
-        $$->filho = $1;
+
+        /* as duas listas vêm de trás para frente (veja declaration_list):
+           as declarações são invertidas primeiro e as importações entram
+           na frente delas */
+        TreeNode *lista = NULL;
+        TreeNode *t = $2;
+        while (t != NULL) {
+            TreeNode *prox = t->irmao;
+            t->irmao = lista;
+            lista = t;
+            t = prox;
+        }
+        t = $1;
+        while (t != NULL) {
+            TreeNode *prox = t->irmao;
+            t->irmao = lista;
+            lista = t;
+            t = prox;
+        }
+        $$->filho = lista;
         raizArvore = $$;
     }
+    | import_list import_declaration
+    {
+        $$ = novoNo(NO_PROGRAMA, yylineno);
+
+        TreeNode *lista = NULL;
+        if ($2 != NULL) {
+            $2->irmao = $1;
+            $1 = $2;
+        }
+        TreeNode *t = $1;
+        while (t != NULL) {
+            TreeNode *prox = t->irmao;
+            t->irmao = lista;
+            lista = t;
+            t = prox;
+        }
+        $$->filho = lista;
+        raizArvore = $$;
+    }
+    ;
+
+/* Importações: import nome; antes de qualquer declaração. Cada uma segue
+   para a semântica como uma declaração de topo, que carrega a interface
+   da unidade (interface.h) na tabela de símbolos. */
+import_list:
+    import_list import_declaration
+    {
+        if ($2 != NULL) {
+            $2->irmao = $1;
+            $$ = $2;
+        } else {
+            $$ = $1;
+        }
+    }
+    | /* empty */ { $$ = NULL; }
+    ;
+
+import_declaration:
+    TOKEN_IMPORT TOKEN_ID TOKEN_SEMICOLON
+    {
+        $$ = esteiraDeclaracao(novoNoToken(NO_IMPORT, $2, yylineno));
+        free($2);
+    }
     ;
 
 /* Lista de declarações (variáveis ou funções).
-   Lógica de Lista Encadeada: Percorre os irmãos de $1 até o fim 
-   e anexa a nova declaração ($2) lá.
+   Cada declaração é um nó só, então ela entra no início da lista e
+   program inverte no fim: anexar no fim percorreria a lista inteira a cada
+   declaração (quadrático num arquivo com milhares de funções).
 */
 declaration_list:
     declaration_list declaration 
     {
-        // Lógica de Lista: anexa 'declaraçao' ($2) como irmão do último item
-        // da 'declaration_list' ($1)
-        TreeNode *t = $1;
-        if (t != NULL){
-            while(t->irmao != NULL){
-                t = t->irmao;
-            }
-            t->irmao = $2;
-            $$ = $1;
-        } else {
+        if ($2 != NULL) {
+            $2->irmao = $1;
             $$ = $2;
+        } else {
+            $$ = $1;
         }
     }
     | declaration
@@ -100,9 +188,11 @@ declaration_list:
     }
     ;
 
+/* com --esteira, cada declaração pronta já segue para a semântica; com
+   --continuo, é analisada aqui mesmo e, já liberada, não entra na lista (NULL) */
 declaration:
-    var_declaration { $$ = $1;}
-    | fun_declaration { $$ = $1;}
+    var_declaration { $$ = esteiraDeclaracao($1); }
+    | fun_declaration { $$ = esteiraDeclaracao($1); }
     ;
 
 /* Declaração de Variável: int x; ou int x[10]; */
@@ -189,6 +279,7 @@ param:
         $$ = novoNo(NO_PARAM, yylineno);
         $$->filho = $1;
         $$->filho->irmao = novoNoToken(NO_ID, $2, yylineno);
+        $$->attr.valor = 1; /* marca parâmetro array (passado por referência) */
         free($2);
     }
     ;
@@ -413,38 +504,3 @@ arg_list:
     | expression { $$ = $1; }
     ;
 %%
-
-int main(int argc, char **argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Uso: %s arquivo_de_entrada\n", argv[0]);
-        return 1;
-    }
-
-    FILE *f = fopen(argv[1], "r");
-    if (!f) {
-        perror("Erro ao abrir arquivo");
-        return 1;
-    }
-
-    yyin = f;
-    
-    printf("=== Iniciando análise sintática ===\n");
-    
-    int result = yyparse();
-    
-    if (result == 0) {
-        printf("=== Análise sintática concluída com SUCESSO ===\n");
-        
-        printf("\n=== Construindo Tabela de Símbolos ===\n");
-        buildSymTab(raizArvore);
-        typeCheck(raizArvore);
-        
-        printf("\n=== Árvore Sintática Abstrata ===\n");
-        imprimeArvore(raizArvore, 0); 
-    } else {
-        printf("=== Análise sintática concluída com ERROS ===\n");
-    }
-    
-    fclose(f);
-    return result;
-}
\ No newline at end of file
@@ -0,0 +1,485 @@
+#include "../include/codegen.h"
+#include "../include/x86.h"
+#include "../include/regalloc.h"
+#include "../include/objeto.h"
+#include "../include/symtab.h"
+#include "../include/limites.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Frame de uma função (rbp = base):
+     16(%rbp)...        argumentos além do sexto
+     -8*(v+1)(%rbp)     célula do vreg v; os vregs 0..frameSize-1 são as
+                        células do frame, na posição dada pelo loc do símbolo
+     abaixo dos vregs   registradores preservados pelo chamado
+   Arrays locais ocupam suas células a partir de -8*(loc+size)(%rbp),
+   com elementos int de 4 bytes. Inteiros usam os 32 bits baixos da célula;
+   endereços, os 64 bits. Um vreg fica na célula quando o alocador não lhe
+   deu registrador (ou depois da divisão do seu intervalo). */
+
+static const X86Reg regsArg[6] = { RDI, RSI, RDX, RCX, R8, R9 };
+
+int relatorioRegs = 0;
+
+static X86Asm saida;
+static IrFuncao *fn;
+static Alocacao *ra;
+static int pos;              /* instrução corrente */
+static int baseRotulo = 0;   /* rótulos da IR viram baseRotulo + n */
+static int proxRotulo = 0;
+
+/* arestas de desvio condicional que precisam de movimentos */
+typedef struct { int rotulo, de, alvo; } Ponte;
+static Ponte *pontes;
+static int nPontes, capPontes;
+
+static char *simbolo(const char *nome)
+{
+  char *s = (char *) malloc(strlen(nome) + 4);
+  sprintf(s, "cm_%s", nome);
+  return s;
+}
+
+static X86Mem slot(int v)
+{
+  return x86_mem(RBP, -8 * (v + 1));
+}
+
+static int largura(int v)
+{
+  return fn->ehPonteiro[v] ? 8 : 4;
+}
+
+/* registrador com o valor de v: o próprio ou 'tmp' carregado da célula */
+static X86Reg le(int v, X86Reg tmp)
+{
+  X86Reg r = raLocal(ra, v, pos);
+  if (r != SEM_REG) return r;
+  x86_load(&saida, largura(v), tmp, slot(v));
+  return tmp;
+}
+
+/* registrador onde calcular v; escreve() completa se v mora na célula */
+static X86Reg destino(int v, X86Reg tmp)
+{
+  X86Reg r = raLocal(ra, v, pos);
+  return (r != SEM_REG) ? r : tmp;
+}
+
+static void escreve(int v, X86Reg r)
+{
+  if (raLocal(ra, v, pos) == SEM_REG) x86_store(&saida, 8, slot(v), r);
+}
+
+/* dst = v, com v em registrador ou na célula */
+static void copia(X86Reg dst, int v)
+{
+  X86Reg r = raLocal(ra, v, pos);
+  if (r != SEM_REG) x86_mov_rr(&saida, largura(v), dst, r);
+  else x86_load(&saida, largura(v), dst, slot(v));
+}
+
+/* dst op= v */
+static void opera(X86Alu op, X86Reg dst, int v)
+{
+  X86Reg r = raLocal(ra, v, pos);
+  if (r != SEM_REG) x86_alu(&saida, op, 4, dst, r);
+  else x86_alu_rm(&saida, op, 4, dst, slot(v));
+}
+
+/* Movimentos da aresta (posição de -> rótulo alvo): cada vreg vivo na
+   entrada do alvo vai do local que tinha em 'de' para o local do alvo.
+   Como um intervalo só passa de registrador para memória, são só
+   gravações (arestas para frente) ou cargas (arestas para trás). */
+static int movimentos(int de, int alvo, int emite)
+{
+  int n = 0;
+  int posAlvo = ra->posRotulo[alvo];
+  for (int fase = 0; fase < 2; fase++)
+  {
+    for (int v = 0; v < ra->nvregs; v++)
+    {
+      if (!raVivoRotulo(ra, alvo, v)) continue;
+      X86Reg origem = raLocal(ra, v, de);
+      X86Reg dest = raLocal(ra, v, posAlvo);
+      if (origem == dest) continue;
+      if (fase == 0 && dest == SEM_REG)
+      {
+        if (emite) x86_store(&saida, 8, slot(v), origem);
+        n++;
+      }
+      else if (fase == 1 && origem == SEM_REG)
+      {
+        if (emite) x86_load(&saida, 8, dest, slot(v));
+        n++;
+      }
+    }
+  }
+  return n;
+}
+
+static void desvioCondicional(X86Cond cc, int alvo)
+{
+  if (movimentos(pos, alvo, 0) == 0)
+  {
+    x86_jcc(&saida, cc, baseRotulo + alvo);
+    return;
+  }
+  if (nPontes == capPontes)
+  {
+    capPontes = capPontes ? capPontes * 2 : 16;
+    pontes = (Ponte *) realloc(pontes, sizeof(Ponte) * capPontes);
+  }
+  Ponte *p = &pontes[nPontes++];
+  p->rotulo = proxRotulo++;
+  p->de = pos;
+  p->alvo = alvo;
+  x86_jcc(&saida, cc, p->rotulo);
+}
+
+static void geraChamada(IrInstr *i)
+{
+  int nargs = i->nargs;
+  int naPilha = (nargs > 6) ? nargs - 6 : 0;
+
+  /* mantém a pilha alinhada em 16 bytes no call */
+  if (naPilha % 2 == 1) x86_alu_ri(&saida, X86_SUB, 8, RSP, 8);
+
+  /* empilha todos e desempilha os seis primeiros nos registradores de
+     argumento: evita sobrescrever um argumento que ainda está num deles */
+  for (int k = nargs - 1; k >= 0; k--)
+  {
+    X86Reg r = raLocal(ra, i->args[k], pos);
+    if (r != SEM_REG) x86_push(&saida, r);
+    else x86_push_m(&saida, slot(i->args[k]));
+  }
+  for (int k = 0; k < nargs && k < 6; k++)
+    x86_pop(&saida, regsArg[k]);
+
+  char *s = simbolo(i->sym->name);
+  x86_call(&saida, s);
+  free(s);
+
+  int desempilha = 8 * (naPilha + naPilha % 2);
+  if (desempilha > 0) x86_alu_ri(&saida, X86_ADD, 8, RSP, desempilha);
+  if (i->d >= 0)
+  {
+    X86Reg d = destino(i->d, RAX);
+    x86_mov_rr(&saida, 4, d, RAX);
+    escreve(i->d, d);
+  }
+}
+
+static void geraInstrucao(IrInstr *i, int rotuloFim, int rotuloDivZero, int rotuloLimite)
+{
+  X86Reg d, a, b;
+
+  switch (i->op)
+  {
+  case IR_LI:
+    d = destino(i->d, RAX);
+    x86_mov_ri(&saida, d, i->imm);
+    escreve(i->d, d);
+    break;
+
+  case IR_MOV:
+    d = destino(i->d, RAX);
+    copia(d, i->a);
+    escreve(i->d, d);
+    break;
+
+  case IR_ADD:
+  case IR_SUB:
+  case IR_MUL:
+    d = destino(i->d, RAX);
+    copia(d, i->a);
+    opera(i->op == IR_ADD ? X86_ADD : i->op == IR_SUB ? X86_SUB : X86_IMUL, d, i->b);
+    escreve(i->d, d);
+    break;
+
+  case IR_LIMITE:
+    /* sem sinal: índice negativo também fica >= tamanho */
+    a = le(i->a, RAX);
+    if (i->b >= 0) opera(X86_CMP, a, i->b);
+    else x86_alu_ri(&saida, X86_CMP, 4, a, i->imm);
+    x86_jcc(&saida, X86_AE, rotuloLimite);
+    break;
+
+  case IR_DIV:
+  {
+    /* divisor -1 é tratado à parte (INT_MIN / -1 não pode gerar exceção) */
+    int divide = proxRotulo++;
+    int pronto = proxRotulo++;
+    copia(RAX, i->a);
+    b = le(i->b, R10);
+    x86_alu(&saida, X86_TEST, 4, b, b);
+    x86_jcc(&saida, X86_E, rotuloDivZero);
+    x86_alu_ri(&saida, X86_CMP, 4, b, -1);
+    x86_jcc(&saida, X86_NE, divide);
+    x86_neg(&saida, RAX);
+    x86_jmp(&saida, pronto);
+    x86_label(&saida, divide);
+    x86_cdq(&saida);
+    x86_idiv(&saida, b);
+    x86_label(&saida, pronto);
+    d = destino(i->d, RAX);
+    x86_mov_rr(&saida, 4, d, RAX);
+    escreve(i->d, d);
+  }
+  break;
+
+  case IR_CMP:
+    a = le(i->a, RAX);
+    opera(X86_CMP, a, i->b);
+    d = destino(i->d, RAX);
+    x86_setcc(&saida, (X86Cond) i->cc, d);
+    escreve(i->d, d);
+    break;
+
+  case IR_LOADG:
+  {
+    char *s = simbolo(i->sym->name);
+    d = destino(i->d, RAX);
+    x86_load(&saida, 4, d, x86_mem_sym(s));
+    escreve(i->d, d);
+    free(s);
+  }
+  break;
+
+  case IR_STOREG:
+  {
+    char *s = simbolo(i->sym->name);
+    a = le(i->a, RAX);
+    x86_store(&saida, 4, x86_mem_sym(s), a);
+    free(s);
+  }
+  break;
+
+  case IR_ADDR:
+    d = destino(i->d, RAX);
+    if (i->sym->scope == 0)
+    {
+      char *s = simbolo(i->sym->name);
+      x86_lea(&saida, d, x86_mem_sym(s));
+      free(s);
+    }
+    else
+    {
+      x86_lea(&saida, d, x86_mem(RBP, -8 * (i->sym->loc + i->sym->size)));
+    }
+    escreve(i->d, d);
+    break;
+
+  case IR_LOAD:
+    a = le(i->a, RAX);
+    b = le(i->b, R10);
+    x86_movsx(&saida, R10, b);
+    d = destino(i->d, RAX);
+    x86_load(&saida, 4, d, x86_mem_idx(a, R10, 4, 0));
+    escreve(i->d, d);
+    break;
+
+  case IR_STORE:
+  {
+    a = le(i->a, RAX);
+    b = le(i->b, R10);
+    x86_movsx(&saida, R10, b);
+    X86Reg c = le(i->c, R11);
+    x86_store(&saida, 4, x86_mem_idx(a, R10, 4, 0), c);
+  }
+  break;
+
+  case IR_LABEL:
+    x86_label(&saida, baseRotulo + i->imm);
+    break;
+
+  case IR_JMP:
+    movimentos(pos, i->imm, 1);
+    x86_jmp(&saida, baseRotulo + i->imm);
+    break;
+
+  case IR_BR:
+    a = le(i->a, RAX);
+    opera(X86_CMP, a, i->b);
+    desvioCondicional((X86Cond) i->cc, i->imm);
+    break;
+
+  case IR_BZ:
+  case IR_BNZ:
+    a = le(i->a, RAX);
+    x86_alu(&saida, X86_TEST, 4, a, a);
+    desvioCondicional(i->op == IR_BZ ? X86_E : X86_NE, i->imm);
+    break;
+
+  case IR_CALL:
+    geraChamada(i);
+    break;
+
+  case IR_RET:
+    if (i->a >= 0) copia(RAX, i->a);
+    x86_jmp(&saida, rotuloFim);
+    break;
+  }
+}
+
+static X86Mem slotSalvo(int k)
+{
+  return slot(fn->nvregs + k);
+}
+
+static void geraFuncao(IrFuncao *f)
+{
+  char *s = simbolo(f->sym->name);
+  fn = f;
+  ra = raAloca(f);
+  if (relatorioRegs) raRelatorio(ra, f, stderr);
+
+  baseRotulo = proxRotulo;
+  proxRotulo += f->nrotulos;
+  int rotuloFim = proxRotulo++;
+  int rotuloDivZero = proxRotulo++;
+  int rotuloLimite = proxRotulo++;
+  nPontes = 0;
+
+  int bytes = 8 * (f->nvregs + ra->nSalvos);
+  bytes = (bytes + 15) & ~15;
+
+  x86_funcao(&saida, s);
+  x86_push(&saida, RBP);
+  x86_mov_rr(&saida, 8, RBP, RSP);
+  if (bytes > 0) x86_alu_ri(&saida, X86_SUB, 8, RSP, bytes);
+  for (int k = 0; k < ra->nSalvos; k++)
+    x86_store(&saida, 8, slotSalvo(k), ra->salvos[k]);
+
+  /* argumento k (int x[] passa dois, endereço e tamanho) tem loc k:
+     primeiro vai tudo para as células, depois os alocados em registrador
+     são carregados (sem conflito entre registradores) */
+  pos = 0;
+  int nparams = st_celulas_params(f->sym);
+  for (int k = 0; k < nparams && k < 6; k++)
+    x86_store(&saida, 8, slot(k), regsArg[k]);
+  for (int k = 0; k < nparams; k++)
+  {
+    X86Reg r = raLocal(ra, k, 0);
+    if (k < 6)
+    {
+      if (r != SEM_REG) x86_load(&saida, 8, r, slot(k));
+    }
+    else
+    {
+      X86Reg d = (r != SEM_REG) ? r : RAX;
+      x86_load(&saida, 8, d, x86_mem(RBP, 16 + 8 * (k - 6)));
+      if (r == SEM_REG) x86_store(&saida, 8, slot(k), RAX);
+    }
+  }
+
+  for (pos = 0; pos < f->n; pos++)
+  {
+    IrInstr *i = &f->instr[pos];
+
+    /* divisões de intervalo no meio de um bloco: grava antes da instrução
+       (no início de um bloco, os movimentos das arestas já cuidam disso) */
+    if (i->op != IR_LABEL)
+    {
+      for (int v = 0; v < f->nvregs; v++)
+        if (ra->reg[v] != SEM_REG && ra->divisao[v] == pos)
+          x86_store(&saida, 8, slot(v), ra->reg[v]);
+    }
+
+    geraInstrucao(i, rotuloFim, rotuloDivZero, rotuloLimite);
+
+    /* aresta de passagem para o rótulo seguinte */
+    if (i->op != IR_JMP && i->op != IR_RET && pos + 1 < f->n && f->instr[pos + 1].op == IR_LABEL)
+      movimentos(pos, f->instr[pos + 1].imm, 1);
+  }
+
+  x86_label(&saida, rotuloFim);
+  for (int k = 0; k < ra->nSalvos; k++)
+    x86_load(&saida, 8, ra->salvos[k], slotSalvo(k));
+  x86_mov_rr(&saida, 8, RSP, RBP);
+  x86_pop(&saida, RBP);
+  x86_ret(&saida);
+
+  for (int k = 0; k < nPontes; k++)
+  {
+    x86_label(&saida, pontes[k].rotulo);
+    movimentos(pontes[k].de, pontes[k].alvo, 1);
+    x86_jmp(&saida, baseRotulo + pontes[k].alvo);
+  }
+
+  x86_label(&saida, rotuloDivZero);
+  x86_call(&saida, "cm_div_zero");
+  if (modoVerificado)
+  {
+    x86_label(&saida, rotuloLimite);
+    x86_call(&saida, "cm_indice_invalido");
+  }
+  x86_fim_funcao(&saida, s);
+  free(s);
+  raLibera(ra);
+  ra = NULL;
+  fn = NULL;
+}
+
+static int defineMain(TreeNode *arvore)
+{
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_FUN && d->sym != NULL && strcmp(d->sym->name, "main") == 0) return 1;
+  return 0;
+}
+
+static void geraPrograma(TreeNode *arvore, IrPrograma *ir)
+{
+  baseRotulo = 0;
+  proxRotulo = 0;
+
+  x86_text(&saida);
+  for (int k = 0; k < ir->nFuncoes; k++)
+    geraFuncao(&ir->funcoes[k]);
+  free(pontes);
+  pontes = NULL;
+  capPontes = 0;
+
+  /* ponto de entrada do executável: chama cm_main e descarrega a saída.
+     Na compilação separada, só a unidade que define main o tem. */
+  if (defineMain(arvore))
+  {
+    x86_funcao(&saida, "main");
+    x86_push(&saida, RBP);
+    x86_mov_rr(&saida, 8, RBP, RSP);
+    x86_call(&saida, "cm_main");
+    x86_call(&saida, "cm_flush");
+    x86_mov_ri(&saida, RAX, 0);
+    x86_pop(&saida, RBP);
+    x86_ret(&saida);
+    x86_fim_funcao(&saida, "main");
+  }
+
+  /* globais: escalares em 4 bytes, arrays com size elementos int */
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+  {
+    if (d->tipoNo != NO_DECLARACAO_VAR || d->sym == NULL) continue;
+    char *s = simbolo(d->sym->name);
+    x86_bss(&saida, s, (d->sym->kind == ID_ARRAY) ? 4 * d->sym->size : 4);
+    free(s);
+  }
+}
+
+void codeGen(TreeNode *arvore, IrPrograma *ir, FILE *arquivo)
+{
+  saida.saida = arquivo;
+  saida.prefixoRotulo = ".L";
+
+  fprintf(arquivo, "# Gerado pelo compilador C-\n");
+  geraPrograma(arvore, ir);
+  fprintf(arquivo, "\n\t.section\t.note.GNU-stack,\"\",@progbits\n");
+}
+
+int codeGenObjeto(TreeNode *arvore, IrPrograma *ir, const char *origem, FILE *arquivo)
+{
+  x86_binario(&saida);
+  geraPrograma(arvore, ir);
+  int erro = x86_finaliza(&saida) || objEscreveElf(&saida, origem, arquivo);
+  x86_libera(&saida);
+  return erro;
+}
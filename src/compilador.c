@@ -0,0 +1,498 @@
+#include "../include/cminus.h"
+#include "../include/analyze.h"
+#include "../include/inline.h"
+#include "../include/bytecode.h"
+#include "../include/vm.h"
+#include "../include/ir.h"
+#include "../include/codegen.h"
+#include "../include/traducao.h"
+#include "../include/limites.h"
+#include "../include/fluxo.h"
+#include "../include/grafo.h"
+#include "../include/chamadas.h"
+#include "../include/poda.h"
+#include "../include/puras.h"
+#include "../include/lote.h"
+#include "../include/particao.h"
+#include "../include/esteira.h"
+#include "../include/incremental.h"
+#include "../include/interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+extern int yyparse(void);
+extern void lexReinicia(FILE *f);
+
+/* uma compilação de cada vez: flex, bison e a tabela são globais */
+static pthread_mutex_t trava = PTHREAD_MUTEX_INITIALIZER;
+
+void cmOpcoesPadrao(CmOpcoes *op) {
+    memset(op, 0, sizeof(*op));
+    op->poda = 1;
+    op->listagem = 1;
+    op->processosParse = 1;
+}
+
+/* nome da saída do -S, -c e --emit-c: o -o, ou a entrada com a extensão trocada */
+static char *nomeSaida(const char *entrada, const char *extensao, const char *saida) {
+    if (saida != NULL) return strdup(saida);
+    const char *barra = strrchr(entrada, '/');
+    const char *ponto = strrchr(entrada, '.');
+    size_t base = (ponto != NULL && (barra == NULL || ponto > barra)) ? (size_t) (ponto - entrada) : strlen(entrada);
+    char *nome = (char *) malloc(base + strlen(extensao) + 1);
+    memcpy(nome, entrada, base);
+    strcpy(nome + base, extensao);
+    return nome;
+}
+
+/* --exporta: a interface sai logo depois da semântica, antes de qualquer
+   passo mexer na árvore; com erros semânticos, não sai */
+static int exporta(const CmOpcoes *op) {
+    if (op->exporta == NULL) return 0;
+    if (analyzeErrors() > 0 || interfaceGrava(raizArvore, op->exporta) != 0) return 1;
+    if (op->listagem) printf("\n=== Interface gravada em %s ===\n", op->exporta);
+    return 0;
+}
+
+/* os import já puseram as interfaces na tabela: daqui em diante os passos
+   só veem declarações */
+static void tiraImportacoes(TreeNode *programa) {
+    while (programa->filho != NULL && programa->filho->tipoNo == NO_IMPORT) {
+        TreeNode *imp = programa->filho;
+        programa->filho = imp->irmao;
+        liberaArvore(imp);
+    }
+}
+
+/* Todos os passes sobre o arquivo já aberto. O analisador léxico e a
+   tabela de símbolos recomeçam aqui e a árvore é liberada no fim, então
+   serve uma vez por arquivo do lote. */
+static int compila(FILE *f, const char *arquivo, const CmOpcoes *op, int *linhas) {
+    lexReinicia(f);
+    raizArvore = NULL;
+    imprimeTabela = op->listagem;
+
+    if (op->listagem) printf("=== Iniciando análise sintática ===\n");
+    
+    /* arquivo grande com -j: pedaços analisados em paralelo; se não der
+       (pequeno ou com erro), a análise normal relata os erros */
+    int result = 0;
+    double inicioParse = loteRelogio();
+    int pedacos = (op->processosParse > 1 && !op->continuo) ? particaoAnalisa(arquivo, op->processosParse, linhas) : -1;
+    EsteiraStats esteira = { 0, 0, 0, 0, -1 };
+    if (pedacos < 0) {
+        if (op->processosParse > 1) lexReinicia(f);
+        if (op->continuo) result = esteiraContinua(&esteira);
+        else if (op->esteira) result = esteiraAnalisa(!op->sintaxe, &esteira);
+        else result = yyparse();
+        *linhas = linhaToken;
+    }
+    if (op->stats && !op->executa) {
+        fprintf(stderr, "SINTAXE: %d linha(s) em %.3f s (%d pedaço(s))\n",
+                *linhas, loteRelogio() - inicioParse, pedacos > 0 ? pedacos : 1);
+        if (op->continuo) {
+            fprintf(stderr, "CONTINUO: %d declaração(ões), %d verificada(s) só no fim",
+                    esteira.declaracoes, esteira.adiadas);
+            if (esteira.primeiroErro >= 0) fprintf(stderr, ", primeiro erro semântico em %.3f s", esteira.primeiroErro);
+            fprintf(stderr, "\n");
+        } else if (esteira.semantica) {
+            fprintf(stderr, "ESTEIRA: %d declaração(ões), %d analisada(s) antes do fim da análise sintática",
+                    esteira.declaracoes, esteira.adiantadas);
+            if (esteira.primeiroErro >= 0) fprintf(stderr, ", primeiro erro semântico em %.3f s", esteira.primeiroErro);
+            fprintf(stderr, "\n");
+        }
+    }
+    if (op->sintaxe || op->continuo || op->cache != NULL) {
+        if (op->listagem) printf("=== Análise sintática concluída com %s ===\n", result == 0 ? "SUCESSO" : "ERROS");
+        /* --continuo: a semântica já foi feita declaração por declaração */
+        if (op->continuo && result == 0) {
+            if (op->listagem) printf("\n=== Construindo Tabela de Símbolos ===\n");
+            analyzeTermina();
+            result = exporta(op);
+        }
+        /* --cache: só as funções que mudaram (ou cujos nomes mudaram) são
+           verificadas; as do cache ficam sem anotações para os outros passes */
+        if (op->cache != NULL && result == 0) {
+            if (op->listagem) printf("\n=== Construindo Tabela de Símbolos ===\n");
+            IncrementalStats inc;
+            incrementalAnalisa(raizArvore, op->cache, arquivo, &inc);
+            analyzeTermina();
+            fprintf(stderr, "CACHE: %d função(ões), %d do cache (%.1f%%), %d verificada(s), semântica em %.3f s\n",
+                    inc.funcoes, inc.acertos, inc.funcoes > 0 ? 100.0 * inc.acertos / inc.funcoes : 0.0,
+                    inc.funcoes - inc.acertos, inc.segundos);
+            result = exporta(op);
+        }
+        liberaArvore(raizArvore);
+        raizArvore = NULL;
+        return result;
+    }
+
+    if (result == 0) {
+        if (op->listagem) {
+            printf("=== Análise sintática concluída com SUCESSO ===\n");
+            printf("\n=== Construindo Tabela de Símbolos ===\n");
+        }
+        /* na esteira as declarações já foram inseridas e verificadas */
+        if (esteira.semantica) {
+            analyzeTermina();
+        } else {
+            buildSymTab(raizArvore);
+            typeCheck(raizArvore);
+        }
+        tiraImportacoes(raizArvore);
+        result = exporta(op);
+
+        /* com import no fonte, como com --importa: declarações sem static
+           no C, e a VM não liga unidades */
+        if (analyzeImportada(0) != NULL) {
+            traducaoSeparada = 1;
+            if (op->executa || op->bytecode) {
+                fprintf(stderr, "--run e --bytecode precisam do programa num arquivo só; com import, "
+                                "use -c, -S ou --emit-c e ligue as unidades\n");
+                result = 1;
+            }
+        }
+
+        /* os diagnósticos do fonte (return ausente, código inalcançável,
+           índices fora dos limites, uso sem inicialização) e o grafo de
+           --chamadas saem da árvore como a semântica a deixou, antes de
+           qualquer reescrita: assim não mudam com -S, --run ou --inline */
+        if (analyzeErrors() == 0) {
+            if (op->cfg && op->listagem) printf("\n=== Grafos de fluxo de controle ===\n");
+            grafoVerifica(raizArvore, (op->cfg && op->listagem) ? stdout : NULL);
+        }
+
+        if (op->chamadas != NULL && analyzeErrors() == 0) {
+            GrafoChamadas *gc = chamadasConstroi(raizArvore);
+            FILE *s = fopen(op->chamadas, "w");
+            if (s == NULL) {
+                perror("Erro ao criar arquivo de saída");
+                result = 1;
+            } else {
+                const char *ponto = strrchr(op->chamadas, '.');
+                if (ponto != NULL && strcmp(ponto, ".json") == 0) chamadasJson(gc, s);
+                else chamadasDot(gc, s);
+                fclose(s);
+            }
+            int recursivas = 0, inalcancaveis = 0;
+            for (int k = 0; k < gc->nFuncoes; k++) {
+                recursivas += gc->recursiva[k];
+                inalcancaveis += gc->decl[k] != NULL && !gc->alcancavel[k];
+            }
+            fprintf(stderr, "CHAMADAS: %d função(ões), %d componente(s), %d recursiva(s), %d inalcançável(is) a partir de main\n",
+                    gc->nFuncoes, gc->nSccs, recursivas, inalcancaveis);
+            chamadasLibera(gc);
+        }
+
+        LimitesStats limites;
+        if (analyzeErrors() == 0) analisaLimites(raizArvore, &limites, stderr);
+
+        /* a IR também alimenta a análise de fluxo (uso sem inicialização) */
+        IrPrograma *ir = NULL;
+        if (analyzeErrors() == 0) {
+            ir = irGera(raizArvore);
+            fluxoPrograma(ir, stderr);
+        }
+
+        /* daqui em diante a árvore é reescrita, e só se algum backend vai
+           consumi-la; se algo mudou, a IR dos backends é gerada de novo */
+        int geraCodigo = op->executa || op->bytecode || op->ir || op->assembly || op->objeto || op->traduzC;
+        int reescrita = 0;
+
+        /* chamadas puras com argumentos constantes viram constantes (e as
+           funções que só eram usadas assim ficam mortas para a poda) */
+        if (geraCodigo && analyzeErrors() == 0) {
+            PurasStats puras;
+            avaliaPuras(raizArvore, &puras);
+            if (puras.avaliadas > 0 || puras.desistencias > 0)
+                fprintf(stderr, "PURAS: %d função(ões) pura(s), %d chamada(s) avaliada(s) em compilação (%ld passos), %d desistência(s)\n",
+                        puras.puras, puras.avaliadas, puras.passos, puras.desistencias);
+            reescrita += puras.avaliadas;
+        }
+
+        /* funções e globais mortas saem antes dos backends (a listagem
+           sozinha mostra a árvore inteira, como a tabela); uma unidade que
+           exporta mantém tudo o que a interface anuncia */
+        if (op->poda && geraCodigo && op->exporta == NULL && analyzeErrors() == 0) {
+            PodaStats poda;
+            podaPrograma(raizArvore, &poda);
+            if (poda.funcoes > 0 || poda.globais > 0)
+                fprintf(stderr, "PODA: %d função(ões) e %d global(is) removida(s): %d nó(s), %ld bytes de árvore, %ld bytes de globais\n",
+                        poda.funcoes, poda.globais, poda.nos, poda.bytesArvore, poda.bytesGlobais);
+            reescrita += poda.funcoes + poda.globais;
+        }
+
+        if (op->expandeInline && analyzeErrors() == 0) {
+            reescrita += inlineFunctions(raizArvore);
+        }
+
+        if (reescrita > 0 && ir != NULL) {
+            /* o inline e as constantes das puras podem provar mais acessos;
+               os avisos já saíram */
+            analisaLimites(raizArvore, &limites, NULL);
+            irLibera(ir);
+            ir = irGera(raizArvore);
+        }
+        if (op->verificado && analyzeErrors() == 0)
+            fprintf(stderr, "LIMITES: %d acesso(s), %d provado(s) seguro(s), %d com teste em execução, %d fora dos limites\n",
+                    limites.acessos, limites.seguros, limites.acessos - limites.seguros, limites.fora);
+        
+        if (op->listagem) {
+            printf("\n=== Árvore Sintática Abstrata ===\n");
+            imprimeArvore(raizArvore, 0); 
+        }
+
+        if ((op->executa || op->bytecode) && analyzeErrors() == 0 && result == 0) {
+            Bytecode *bc = bcCompila(raizArvore);
+            if (op->bytecode) {
+                printf("\n=== Bytecode ===\n");
+                bcImprime(bc, stdout);
+            }
+            if (op->executa) {
+                VmStats stats;
+                result = vmExecuta(bc, &stats);
+                if (op->stats) {
+                    fprintf(stderr, "VM: %ld instruções em %.3f s (%.1f milhões/s)\n",
+                            stats.instrucoes, stats.segundos,
+                            stats.segundos > 0 ? stats.instrucoes / stats.segundos / 1e6 : 0.0);
+                    if (op->jit)
+                        fprintf(stderr, "JIT: %d função(ões) compilada(s), %ld bytes de código\n",
+                                stats.compiladas, stats.bytesJit);
+                }
+            }
+            bcLibera(bc);
+        } else if (op->executa) {
+            result = 1;
+        }
+
+        if ((op->ir || op->assembly || op->objeto) && ir != NULL) {
+            if (op->ir) {
+                printf("\n=== Representação Intermediária ===\n");
+                irImprime(ir, stdout);
+            }
+            if (op->assembly) {
+                char *nome = nomeSaida(arquivo, ".s", op->saida);
+                FILE *s = fopen(nome, "w");
+                if (s == NULL) {
+                    perror("Erro ao criar arquivo de saída");
+                    result = 1;
+                } else {
+                    codeGen(raizArvore, ir, s);
+                    fclose(s);
+                    if (op->listagem) printf("\n=== Assembly gravado em %s ===\n", nome);
+                }
+                free(nome);
+            }
+            if (op->objeto) {
+                char *nome = nomeSaida(arquivo, ".o", op->saida);
+                FILE *s = fopen(nome, "wb");
+                if (s == NULL) {
+                    perror("Erro ao criar arquivo de saída");
+                    result = 1;
+                } else {
+                    if (codeGenObjeto(raizArvore, ir, arquivo, s) != 0) {
+                        fprintf(stderr, "Erro ao gravar o objeto %s\n", nome);
+                        result = 1;
+                    }
+                    fclose(s);
+                    if (op->listagem && result == 0) printf("\n=== Objeto gravado em %s ===\n", nome);
+                }
+                free(nome);
+            }
+        } else if (op->assembly || op->objeto) {
+            result = 1;
+        }
+        irLibera(ir);
+
+        if (op->traduzC && analyzeErrors() == 0) {
+            char *nome = nomeSaida(arquivo, ".c", op->saida);
+            FILE *s = fopen(nome, "w");
+            if (s == NULL) {
+                perror("Erro ao criar arquivo de saída");
+                result = 1;
+            } else {
+                traduzParaC(raizArvore, arquivo, s);
+                fclose(s);
+                if (op->listagem) printf("\n=== Código C gravado em %s ===\n", nome);
+            }
+            free(nome);
+        } else if (op->traduzC) {
+            result = 1;
+        }
+    } else {
+        if (op->listagem) printf("=== Análise sintática concluída com ERROS ===\n");
+    }
+    
+    liberaArvore(raizArvore);
+    raizArvore = NULL;
+    return result;
+}
+
+
+int cmCompilaArquivo(const char *arquivo, const CmOpcoes *op, CmArquivo *info) {
+    info->linhas = 0;
+    info->errosSemanticos = 0;
+    FILE *f = fopen(arquivo, "r");
+    if (!f) {
+        perror("Erro ao abrir arquivo");
+        return 1;
+    }
+
+    /* as interfaces importadas valem para esta compilação */
+    Interface **importadas = (Interface **) calloc(op->nImporta + 1, sizeof(Interface *));
+    for (int k = 0; k < op->nImporta; k++) {
+        if ((importadas[k] = interfaceCarrega(op->importa[k])) == NULL) {
+            for (int j = 0; j < k; j++) interfaceLibera(importadas[j]);
+            free(importadas);
+            fclose(f);
+            return 1;
+        }
+    }
+
+    /* import no fonte: nome.cmi ao lado do arquivo */
+    const char *barra = strrchr(arquivo, '/');
+    char *dir = (barra != NULL) ? strndup(arquivo, barra - arquivo) : NULL;
+
+    pthread_mutex_lock(&trava);
+    usaJit = op->jit;
+    modoVerificado = op->verificado;
+    relatorioFluxo = op->relatorioFluxo;
+    esteiraRetem = op->retemErros;
+    relatorioRegs = op->relatorioRegs;
+    traducaoSeparada = op->nImporta > 0 || op->exporta != NULL;
+    exigeMain = op->exporta == NULL;
+    analyzeImporta(importadas, op->nImporta);
+    analyzeDiretorio(dir);
+    int result = compila(f, arquivo, op, &info->linhas);
+    info->errosSemanticos = analyzeErrors();
+    analyzeLiberaImportadas();
+    analyzeDiretorio(NULL);
+    analyzeImporta(NULL, 0);
+    exigeMain = 1;
+    traducaoSeparada = 0;
+    pthread_mutex_unlock(&trava);
+
+    for (int k = 0; k < op->nImporta; k++) interfaceLibera(importadas[k]);
+    free(importadas);
+    free(dir);
+
+    fclose(f);
+    return result;
+}
+
+/* --- Compilação em memória --- */
+
+struct CmResultado {
+    CmDiagnostico *diags;
+    int nDiags, capDiags;
+    TreeNode *arvore;
+    CmSimbolo *simbolos;
+    int nSimbolos, capSimbolos;
+};
+
+static void coleta(void *ctx, DiagTipo tipo, int linha, const char *mensagem) {
+    CmResultado *r = (CmResultado *) ctx;
+    if (r->nDiags == r->capDiags) {
+        r->capDiags = r->capDiags ? r->capDiags * 2 : 8;
+        r->diags = (CmDiagnostico *) realloc(r->diags, sizeof(CmDiagnostico) * r->capDiags);
+    }
+    CmDiagnostico *d = &r->diags[r->nDiags++];
+    d->tipo = tipo;
+    d->linha = linha;
+    d->mensagem = strdup(mensagem);
+    size_t n = strlen(d->mensagem);
+    if (n > 0 && d->mensagem[n - 1] == '\n') d->mensagem[n - 1] = '\0';
+}
+
+static void copiaSimbolo(BucketList l, void *ctx) {
+    CmResultado *r = (CmResultado *) ctx;
+    if (r->nSimbolos == r->capSimbolos) {
+        r->capSimbolos = r->capSimbolos ? r->capSimbolos * 2 : 16;
+        r->simbolos = (CmSimbolo *) realloc(r->simbolos, sizeof(CmSimbolo) * r->capSimbolos);
+    }
+    CmSimbolo *s = &r->simbolos[r->nSimbolos++];
+    s->nome = strdup(l->name);
+    s->escopo = l->scope;
+    s->linha = l->lineno;
+    s->loc = l->loc;
+    s->tipo = l->type;
+    s->kind = l->kind;
+    s->tamanho = l->size;
+    s->numParams = l->numParams;
+}
+
+/* a tabela é liberada antes de devolver a árvore: nenhum nó fica
+   apontando para ela */
+static void esqueceSimbolos(TreeNode *t) {
+    for (; t != NULL; t = t->irmao) {
+        t->sym = NULL;
+        esqueceSimbolos(t->filho);
+    }
+}
+
+CmResultado *cmCompilaFonte(const char *fonte, size_t tam) {
+    CmResultado *r = (CmResultado *) calloc(1, sizeof(CmResultado));
+
+    FILE *f = fmemopen((void *) fonte, tam, "r");
+    if (f == NULL) {
+        coleta(r, DIAG_LEXICO, 0, "ERRO: fonte ilegível");
+        return r;
+    }
+
+    pthread_mutex_lock(&trava);
+    diagInstala(coleta, r);
+    lexReinicia(f);
+    raizArvore = NULL;
+    imprimeTabela = 0;
+    if (yyparse() == 0) {
+        buildSymTab(raizArvore);
+        typeCheck(raizArvore);
+        st_percorre(copiaSimbolo, r);
+    }
+    st_limpa();
+    analyzeLiberaImportadas();
+    esqueceSimbolos(raizArvore);
+    r->arvore = raizArvore;
+    raizArvore = NULL;
+    diagInstala(NULL, NULL);
+    pthread_mutex_unlock(&trava);
+
+    fclose(f);
+    return r;
+}
+
+int cmOk(const CmResultado *r) {
+    return r->nDiags == 0;
+}
+
+int cmNumDiagnosticos(const CmResultado *r) {
+    return r->nDiags;
+}
+
+const CmDiagnostico *cmDiagnostico(const CmResultado *r, int i) {
+    return (i >= 0 && i < r->nDiags) ? &r->diags[i] : NULL;
+}
+
+const TreeNode *cmArvore(const CmResultado *r) {
+    return r->arvore;
+}
+
+int cmNumSimbolos(const CmResultado *r) {
+    return r->nSimbolos;
+}
+
+const CmSimbolo *cmSimbolo(const CmResultado *r, int i) {
+    return (i >= 0 && i < r->nSimbolos) ? &r->simbolos[i] : NULL;
+}
+
+void cmLibera(CmResultado *r) {
+    if (r == NULL) return;
+    for (int i = 0; i < r->nDiags; i++) free(r->diags[i].mensagem);
+    for (int i = 0; i < r->nSimbolos; i++) free((char *) r->simbolos[i].nome);
+    free(r->diags);
+    free(r->simbolos);
+    liberaArvore(r->arvore);
+    free(r);
+}
@@ -0,0 +1,51 @@
+#include "../include/diagnostico.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static DiagColetor coletor = NULL;
+static void *contexto = NULL;
+
+void diagInstala(DiagColetor c, void *ctx)
+{
+  coletor = c;
+  contexto = ctx;
+}
+
+void diagAtual(DiagColetor *c, void **ctx)
+{
+  *c = coletor;
+  *ctx = contexto;
+}
+
+void diagRelataV(DiagTipo tipo, int linha, const char *fmt, va_list ap)
+{
+  if (coletor == NULL)
+  {
+    vfprintf(tipo == DIAG_SEMANTICO ? stderr : stdout, fmt, ap);
+    return;
+  }
+  va_list copia;
+  va_copy(copia, ap);
+  char curta[256];
+  int n = vsnprintf(curta, sizeof(curta), fmt, ap);
+  if (n < (int) sizeof(curta))
+  {
+    coletor(contexto, tipo, linha, curta);
+  }
+  else
+  {
+    char *longa = (char *) malloc(n + 1);
+    vsnprintf(longa, n + 1, fmt, copia);
+    coletor(contexto, tipo, linha, longa);
+    free(longa);
+  }
+  va_end(copia);
+}
+
+void diagRelata(DiagTipo tipo, int linha, const char *fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  diagRelataV(tipo, linha, fmt, ap);
+  va_end(ap);
+}
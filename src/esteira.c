@@ -0,0 +1,441 @@
+#include "../include/esteira.h"
+#include "../include/analyze.h"
+#include "../include/diagnostico.h"
+#include "../include/lote.h"
+#include "cminus.tab.h"
+#include <pthread.h>
+
+extern int yylex(void);
+extern int yyparse(void);
+extern int yylineno;
+extern char *yytext;
+
+/* O flex escreve yylval; o bison lê valorToken (veja o início de cminus.y),
+   então as duas threads nunca tocam a mesma variável */
+YYSTYPE yylval;
+extern YYSTYPE valorToken;
+
+int linhaToken = 1;
+char *textoToken = "";
+
+/* --- Fila circular de um produtor e um consumidor ---
+   Produtor só escreve 'cauda', consumidor só escreve 'cabeca'. Quem acha a
+   fila vazia (ou cheia) dorme na condição; o outro lado só acorda quem dorme
+   depois de 'lote' elementos, para não trocar de thread a cada token. */
+
+typedef struct
+{
+  unsigned char *dados;
+  size_t tamElem;
+  unsigned cap;           /* potência de 2 */
+  unsigned lote;
+  unsigned cabeca;        /* próximo a ler */
+  unsigned cauda;         /* próximo a escrever */
+  int cancelada;
+  int esperaConsumidor;
+  int esperaProdutor;
+  pthread_mutex_t trava;
+  pthread_cond_t cond;
+} Fila;
+
+static void filaCria(Fila *f, size_t tamElem, unsigned cap, unsigned lote)
+{
+  f->dados = (unsigned char *) malloc(tamElem * cap);
+  f->tamElem = tamElem;
+  f->cap = cap;
+  f->lote = lote;
+  f->cabeca = f->cauda = 0;
+  f->cancelada = 0;
+  f->esperaConsumidor = f->esperaProdutor = 0;
+  pthread_mutex_init(&f->trava, NULL);
+  pthread_cond_init(&f->cond, NULL);
+}
+
+static void filaDestroi(Fila *f)
+{
+  pthread_cond_destroy(&f->cond);
+  pthread_mutex_destroy(&f->trava);
+  free(f->dados);
+}
+
+static unsigned ocupados(Fila *f)
+{
+  return __atomic_load_n(&f->cauda, __ATOMIC_SEQ_CST) - __atomic_load_n(&f->cabeca, __ATOMIC_SEQ_CST);
+}
+
+static void acorda(Fila *f)
+{
+  pthread_mutex_lock(&f->trava);
+  pthread_cond_signal(&f->cond);
+  pthread_mutex_unlock(&f->trava);
+}
+
+/* Dorme enquanto a fila estiver vazia (consumidor) ou cheia (produtor). A
+   marca de espera é escrita antes de olhar a fila de novo, e o outro lado
+   publica antes de olhar a marca: um dos dois vê o outro. */
+static void espera(Fila *f, int produtor)
+{
+  int *marca = produtor ? &f->esperaProdutor : &f->esperaConsumidor;
+  pthread_mutex_lock(&f->trava);
+  __atomic_store_n(marca, 1, __ATOMIC_SEQ_CST);
+  while (!__atomic_load_n(&f->cancelada, __ATOMIC_SEQ_CST) &&
+         (produtor ? ocupados(f) == f->cap : ocupados(f) == 0))
+    pthread_cond_wait(&f->cond, &f->trava);
+  __atomic_store_n(marca, 0, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&f->trava);
+}
+
+/* Devolve 0 se a fila foi cancelada. 'urgente' acorda o consumidor mesmo
+   antes de completar um lote (último elemento). */
+static int filaPoe(Fila *f, const void *elem, int urgente)
+{
+  while (ocupados(f) == f->cap)
+  {
+    if (__atomic_load_n(&f->cancelada, __ATOMIC_SEQ_CST)) return 0;
+    espera(f, 1);
+  }
+  if (__atomic_load_n(&f->cancelada, __ATOMIC_SEQ_CST)) return 0;
+  memcpy(f->dados + (f->cauda & (f->cap - 1)) * f->tamElem, elem, f->tamElem);
+  __atomic_store_n(&f->cauda, f->cauda + 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&f->esperaConsumidor, __ATOMIC_SEQ_CST) &&
+      (urgente || ocupados(f) >= f->lote))
+    acorda(f);
+  return 1;
+}
+
+/* Devolve 0 se a fila foi cancelada e está vazia */
+static int filaTira(Fila *f, void *elem)
+{
+  while (ocupados(f) == 0)
+  {
+    if (__atomic_load_n(&f->cancelada, __ATOMIC_SEQ_CST)) return 0;
+    espera(f, 0);
+  }
+  memcpy(elem, f->dados + (f->cabeca & (f->cap - 1)) * f->tamElem, f->tamElem);
+  __atomic_store_n(&f->cabeca, f->cabeca + 1, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&f->esperaProdutor, __ATOMIC_SEQ_CST) &&
+      f->cap - ocupados(f) >= f->lote)
+    acorda(f);
+  return 1;
+}
+
+static void filaCancela(Fila *f)
+{
+  pthread_mutex_lock(&f->trava);
+  __atomic_store_n(&f->cancelada, 1, __ATOMIC_SEQ_CST);
+  pthread_cond_broadcast(&f->cond);
+  pthread_mutex_unlock(&f->trava);
+}
+
+/* --- Estágios --- */
+
+#define TOKENS_CAP 4096
+#define TOKENS_LOTE 256
+#define DECLS_CAP 1024
+
+typedef struct
+{
+  int token;
+  int linha;
+  char *lexema;         /* TOKEN_ID e TOKEN_NUM (strdup do flex) */
+  char texto[16];       /* yytext dos outros, para yyerror */
+  char *erro;           /* erro léxico achado ao ler este token */
+  int linhaErro;
+} Token;
+
+static Fila tokens, decls;
+static int ativa = 0;       /* lexFila lê da fila */
+static int semantica = 0;   /* esteiraDeclaracao enfileira */
+static int continuo = 0;    /* esteiraDeclaracao analisa e libera */
+static int adiadas = 0;
+
+static int analisadas = 0;
+static double inicio, primeiroErro;
+
+/* --- Diagnósticos ---
+   A análise normal só chega à semântica se a sintaxe estiver certa, e
+   cada erro sai de onde foi achado. Aqui a semântica roda antes de o
+   arquivo terminar, e o léxico adiante do bison; todos os erros passam
+   por coletaEsteira e saem (ou vão ao coletor instalado antes) só pela
+   thread que chamou: os sintáticos na hora, os léxicos quando o bison lê o
+   token em que foram achados, e os semânticos no próximo token depois de a
+   thread da semântica achá-los (no modo contínuo, na hora). Com
+   esteiraRetem, os semânticos ficam até o fim de yyparse e são descartados
+   num erro sintático, como na análise normal, que nem chega à semântica. */
+
+typedef struct
+{
+  int linha;
+  char *mensagem;
+} Retido;
+
+int esteiraRetem = 0;
+
+static DiagColetor coletorAnterior = NULL;
+static void *ctxAnterior = NULL;
+static pthread_mutex_t travaRetidos = PTHREAD_MUTEX_INITIALIZER;
+static Retido *retidos = NULL;
+static int nRetidos = 0, capRetidos = 0;
+
+/* só quem roda o flex escreve; na thread do léxico, vai com o token */
+static char *erroLexico = NULL;
+static int linhaLexico = 0;
+
+static void repassa(DiagTipo tipo, int linha, const char *mensagem)
+{
+  if (coletorAnterior != NULL) coletorAnterior(ctxAnterior, tipo, linha, mensagem);
+  else fputs(mensagem, tipo == DIAG_SEMANTICO ? stderr : stdout);
+}
+
+static void coletaEsteira(void *ctx, DiagTipo tipo, int linha, const char *mensagem)
+{
+  (void) ctx;
+  if (tipo == DIAG_SEMANTICO && continuo && !esteiraRetem)
+  {
+    /* sem threads: já estamos na thread que chamou */
+    repassa(tipo, linha, mensagem);
+  }
+  else if (tipo == DIAG_SEMANTICO)
+  {
+    pthread_mutex_lock(&travaRetidos);
+    if (nRetidos == capRetidos)
+    {
+      capRetidos = capRetidos ? capRetidos * 2 : 16;
+      retidos = (Retido *) realloc(retidos, sizeof(Retido) * capRetidos);
+    }
+    retidos[nRetidos].linha = linha;
+    retidos[nRetidos].mensagem = strdup(mensagem);
+    __atomic_store_n(&nRetidos, nRetidos + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&travaRetidos);
+  }
+  else if (tipo == DIAG_LEXICO)
+  {
+    free(erroLexico);
+    erroLexico = strdup(mensagem);
+    linhaLexico = linha;
+  }
+  else
+  {
+    repassa(tipo, linha, mensagem);
+  }
+}
+
+/* na thread do bison: imprime os semânticos que a semântica já achou. Eles
+   saem fora da trava, para a semântica não esperar pela escrita. */
+static void descarregaSemanticos(void)
+{
+  if (esteiraRetem || __atomic_load_n(&nRetidos, __ATOMIC_ACQUIRE) == 0) return;
+  pthread_mutex_lock(&travaRetidos);
+  Retido *lista = retidos;
+  int n = nRetidos;
+  retidos = NULL;
+  capRetidos = 0;
+  __atomic_store_n(&nRetidos, 0, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&travaRetidos);
+
+  for (int i = 0; i < n; i++)
+  {
+    repassa(DIAG_SEMANTICO, lista[i].linha, lista[i].mensagem);
+    free(lista[i].mensagem);
+  }
+  free(lista);
+}
+
+static void retemDiagnosticos(void)
+{
+  diagAtual(&coletorAnterior, &ctxAnterior);
+  diagInstala(coletaEsteira, NULL);
+}
+
+/* volta ao coletor anterior; os semânticos que sobraram saem se a sintaxe
+   deu certo ou se não estavam retidos por ela */
+static void soltaDiagnosticos(int sintaxeOk)
+{
+  diagInstala(coletorAnterior, ctxAnterior);
+  for (int i = 0; i < nRetidos; i++)
+  {
+    if (sintaxeOk || !esteiraRetem) repassa(DIAG_SEMANTICO, retidos[i].linha, retidos[i].mensagem);
+    free(retidos[i].mensagem);
+  }
+  nRetidos = 0;
+  free(erroLexico);
+  erroLexico = NULL;
+}
+
+static void *estagioLexico(void *arg)
+{
+  (void) arg;
+  for (;;)
+  {
+    Token t;
+    t.token = yylex();
+    t.linha = yylineno;
+    t.lexema = (t.token == TOKEN_ID || t.token == TOKEN_NUM) ? yylval.lexema : NULL;
+    strncpy(t.texto, yytext, sizeof(t.texto) - 1);
+    t.texto[sizeof(t.texto) - 1] = '\0';
+    t.erro = erroLexico;
+    t.linhaErro = linhaLexico;
+    erroLexico = NULL;
+    if (!filaPoe(&tokens, &t, t.token == 0))
+    {
+      /* o bison parou antes do fim (erro sintático) */
+      free(t.lexema);
+      free(t.erro);
+      break;
+    }
+    if (t.token == 0) break;
+  }
+  return NULL;
+}
+
+static void *estagioSemantico(void *arg)
+{
+  (void) arg;
+  TreeNode *decl;
+  while (filaTira(&decls, &decl) && decl != NULL)
+  {
+    analyzeDeclaracao(decl);
+    if (primeiroErro < 0 && analyzeErrors() > 0) primeiroErro = loteRelogio() - inicio;
+    __atomic_store_n(&analisadas, analisadas + 1, __ATOMIC_RELAXED);
+  }
+  return NULL;
+}
+
+int lexFila(void)
+{
+  descarregaSemanticos();
+  if (!ativa)
+  {
+    int token = yylex();
+    if (erroLexico != NULL)
+    {
+      repassa(DIAG_LEXICO, linhaLexico, erroLexico);
+      free(erroLexico);
+      erroLexico = NULL;
+    }
+    valorToken = yylval;
+    linhaToken = yylineno;
+    textoToken = yytext;
+    return token;
+  }
+
+  static char texto[16];
+  Token t;
+  if (!filaTira(&tokens, &t)) return 0;
+  if (t.erro != NULL)
+  {
+    repassa(DIAG_LEXICO, t.linhaErro, t.erro);
+    free(t.erro);
+  }
+  if (t.lexema != NULL)
+  {
+    valorToken.lexema = t.lexema;
+    textoToken = t.lexema;
+  }
+  else
+  {
+    memcpy(texto, t.texto, sizeof(texto));
+    textoToken = texto;
+  }
+  linhaToken = t.linha;
+  return t.token;
+}
+
+TreeNode *esteiraDeclaracao(TreeNode *decl)
+{
+  if (continuo)
+  {
+    analisadas++;
+    if (analyzeDeclaracao(decl))
+    {
+      if (primeiroErro < 0 && analyzeErrors() > 0) primeiroErro = loteRelogio() - inicio;
+      analyzeDescarta(decl);
+      liberaArvore(decl);
+      return NULL;
+    }
+    /* verificada só em analyzeTermina: fica na árvore até lá */
+    adiadas++;
+    return decl;
+  }
+  if (semantica) filaPoe(&decls, &decl, 1);
+  return decl;
+}
+
+int esteiraLendoArvore(void)
+{
+  return semantica;
+}
+
+int esteiraContinua(EsteiraStats *stats)
+{
+  analisadas = 0;
+  adiadas = 0;
+  primeiroErro = -1;
+  inicio = loteRelogio();
+  analyzeInicia();
+
+  retemDiagnosticos();
+  continuo = 1;
+  int result = yyparse();
+  continuo = 0;
+  soltaDiagnosticos(result == 0);
+
+  memset(stats, 0, sizeof(*stats));
+  stats->semantica = 1;
+  stats->declaracoes = stats->adiantadas = analisadas;
+  stats->adiadas = adiadas;
+  stats->primeiroErro = primeiroErro;
+  return result;
+}
+
+int esteiraAnalisa(int comSemantica, EsteiraStats *stats)
+{
+  pthread_t lexico, semantico;
+  memset(stats, 0, sizeof(*stats));
+  stats->primeiroErro = -1;
+
+  filaCria(&tokens, sizeof(Token), TOKENS_CAP, TOKENS_LOTE);
+  filaCria(&decls, sizeof(TreeNode *), DECLS_CAP, 1);
+  analisadas = 0;
+  primeiroErro = -1;
+  inicio = loteRelogio();
+
+  retemDiagnosticos();
+  if (comSemantica)
+  {
+    analyzeInicia();
+    semantica = (pthread_create(&semantico, NULL, estagioSemantico, NULL) == 0);
+  }
+  ativa = (pthread_create(&lexico, NULL, estagioLexico, NULL) == 0);
+
+  int result = yyparse();
+  stats->adiantadas = __atomic_load_n(&analisadas, __ATOMIC_RELAXED);
+
+  if (semantica)
+  {
+    TreeNode *fim = NULL;
+    filaPoe(&decls, &fim, 1);
+    pthread_join(semantico, NULL);
+    stats->semantica = 1;
+    stats->declaracoes = analisadas;
+    stats->primeiroErro = primeiroErro;
+  }
+  if (ativa)
+  {
+    filaCancela(&tokens);
+    pthread_join(lexico, NULL);
+    Token t;
+    while (filaTira(&tokens, &t))
+    {
+      free(t.lexema);
+      free(t.erro);
+    }
+  }
+
+  ativa = 0;
+  semantica = 0;
+  soltaDiagnosticos(result == 0);
+  filaDestroi(&tokens);
+  filaDestroi(&decls);
+  return result;
+}
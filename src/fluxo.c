@@ -0,0 +1,487 @@
+#include "../include/fluxo.h"
+#include <stdlib.h>
+#include <string.h>
+
+int relatorioFluxo = 0;
+
+int fluxoUsos(IrInstr *i, int *u)
+{
+  int n = 0;
+  switch (i->op)
+  {
+  case IR_MOV: case IR_STOREG: case IR_BZ: case IR_BNZ:
+    u[n++] = i->a;
+    break;
+  case IR_LIMITE:
+    u[n++] = i->a;
+    if (i->b >= 0) u[n++] = i->b;
+    break;
+  case IR_ADD: case IR_SUB: case IR_MUL: case IR_DIV: case IR_CMP:
+  case IR_LOAD: case IR_BR:
+    u[n++] = i->a;
+    u[n++] = i->b;
+    break;
+  case IR_STORE:
+    u[n++] = i->a;
+    u[n++] = i->b;
+    u[n++] = i->c;
+    break;
+  case IR_CALL:
+    for (int k = 0; k < i->nargs; k++) u[n++] = i->args[k];
+    break;
+  case IR_RET:
+    if (i->a >= 0) u[n++] = i->a;
+    break;
+  default:
+    break;
+  }
+  return n;
+}
+
+int fluxoDefinicao(IrInstr *i)
+{
+  switch (i->op)
+  {
+  case IR_STOREG: case IR_STORE: case IR_LABEL: case IR_JMP:
+  case IR_BR: case IR_BZ: case IR_BNZ: case IR_RET: case IR_LIMITE:
+    return -1;
+  default:
+    return i->d;
+  }
+}
+
+static int terminaBloco(IrOp op)
+{
+  return op == IR_JMP || op == IR_BR || op == IR_BZ || op == IR_BNZ || op == IR_RET;
+}
+
+int fluxoMaxUsos(IrFuncao *f)
+{
+  int m = 3;
+  for (int k = 0; k < f->n; k++)
+    if (f->instr[k].nargs > m) m = f->instr[k].nargs;
+  return m;
+}
+
+/* --- Grafo de blocos --- */
+
+FluxoCfg *fluxoCfg(IrFuncao *f)
+{
+  FluxoCfg *cfg = (FluxoCfg *) calloc(1, sizeof(FluxoCfg));
+  cfg->f = f;
+
+  /* líderes: início, rótulos e instrução após desvio */
+  cfg->blocoDe = (int *) malloc(sizeof(int) * (f->n + 1));
+  for (int k = 0; k < f->n; k++)
+  {
+    if (k == 0 || f->instr[k].op == IR_LABEL || terminaBloco(f->instr[k - 1].op)) cfg->nBlocos++;
+    cfg->blocoDe[k] = cfg->nBlocos - 1;
+  }
+
+  int nb = cfg->nBlocos;
+  FluxoBloco *b = cfg->blocos = (FluxoBloco *) calloc(nb > 0 ? nb : 1, sizeof(FluxoBloco));
+  cfg->blocoRotulo = (int *) malloc(sizeof(int) * (f->nrotulos + 1));
+  for (int k = 0; k < nb; k++) b[k].ini = -1;
+  for (int k = 0; k < f->n; k++)
+  {
+    FluxoBloco *bl = &b[cfg->blocoDe[k]];
+    if (bl->ini < 0) bl->ini = k;
+    bl->fim = k;
+    if (f->instr[k].op == IR_LABEL) cfg->blocoRotulo[f->instr[k].imm] = cfg->blocoDe[k];
+  }
+
+  /* sucessores e, com as contagens, predecessores num vetor só */
+  int nArestas = 0;
+  for (int k = 0; k < nb; k++)
+  {
+    IrInstr *ult = &f->instr[b[k].fim];
+    if (ult->op == IR_JMP || ult->op == IR_BR || ult->op == IR_BZ || ult->op == IR_BNZ)
+      b[k].succ[b[k].nSucc++] = cfg->blocoRotulo[ult->imm];
+    if (ult->op != IR_JMP && ult->op != IR_RET && k + 1 < nb)
+      b[k].succ[b[k].nSucc++] = k + 1;
+    for (int s = 0; s < b[k].nSucc; s++) b[b[k].succ[s]].nPred++;
+    nArestas += b[k].nSucc;
+  }
+  int *preds = (int *) malloc(sizeof(int) * (nArestas + 1));
+  for (int k = 0, p = 0; k < nb; k++)
+  {
+    b[k].pred = preds + p;
+    p += b[k].nPred;
+    b[k].nPred = 0;
+  }
+  for (int k = 0; k < nb; k++)
+    for (int s = 0; s < b[k].nSucc; s++)
+    {
+      FluxoBloco *alvo = &b[b[k].succ[s]];
+      alvo->pred[alvo->nPred++] = k;
+    }
+
+  /* pós-ordem iterativa a partir da entrada; os inalcançáveis vão no fim */
+  cfg->ordem = (int *) malloc(sizeof(int) * (nb + 1));
+  char *visto = (char *) calloc(nb + 1, 1);
+  int *pilha = (int *) malloc(sizeof(int) * (nb + 1));
+  int *prox = (int *) calloc(nb + 1, sizeof(int));
+  int topo = 0, n = 0;
+  if (nb > 0)
+  {
+    pilha[topo++] = 0;
+    visto[0] = 1;
+  }
+  while (topo > 0)
+  {
+    int k = pilha[topo - 1];
+    if (prox[k] < b[k].nSucc)
+    {
+      int s = b[k].succ[prox[k]++];
+      if (!visto[s])
+      {
+        visto[s] = 1;
+        pilha[topo++] = s;
+      }
+    }
+    else
+    {
+      cfg->ordem[n++] = k;
+      topo--;
+    }
+  }
+  for (int k = 0, j = n - 1; k < j; k++, j--)
+  {
+    int t = cfg->ordem[k];
+    cfg->ordem[k] = cfg->ordem[j];
+    cfg->ordem[j] = t;
+  }
+  cfg->nOrdem = n;
+  for (int k = 0; k < nb; k++)
+    if (!visto[k]) cfg->ordem[n++] = k;
+
+  free(visto);
+  free(pilha);
+  free(prox);
+  return cfg;
+}
+
+void fluxoLiberaCfg(FluxoCfg *cfg)
+{
+  if (cfg == NULL) return;
+  if (cfg->nBlocos > 0) free(cfg->blocos[0].pred);
+  free(cfg->blocos);
+  free(cfg->blocoDe);
+  free(cfg->blocoRotulo);
+  free(cfg->ordem);
+  free(cfg);
+}
+
+/* --- Motor genérico --- */
+
+FluxoProblema *fluxoNovo(FluxoCfg *cfg, FluxoDirecao direcao, FluxoEncontro encontro, int nBits)
+{
+  FluxoProblema *p = (FluxoProblema *) calloc(1, sizeof(FluxoProblema));
+  p->direcao = direcao;
+  p->encontro = encontro;
+  p->nBits = nBits;
+  p->nPalavras = (nBits + FLUXO_BITS - 1) / FLUXO_BITS;
+  if (p->nPalavras == 0) p->nPalavras = 1;
+  size_t tam = (size_t) (cfg->nBlocos > 0 ? cfg->nBlocos : 1) * p->nPalavras;
+  p->gen = (unsigned long *) calloc(4 * tam + p->nPalavras, sizeof(unsigned long));
+  p->kill = p->gen + tam;
+  p->in = p->kill + tam;
+  p->out = p->in + tam;
+  p->fronteira = p->out + tam;
+  return p;
+}
+
+void fluxoLibera(FluxoProblema *p)
+{
+  if (p == NULL) return;
+  free(p->gen);
+  free(p);
+}
+
+/* encontro dos vizinhos de k (predecessores para frente, sucessores para
+   trás) em 'dest'; a fronteira entra como mais um vizinho */
+static void encontro(FluxoCfg *cfg, FluxoProblema *p, int k, unsigned long *dest, unsigned long *todos)
+{
+  FluxoBloco *b = &cfg->blocos[k];
+  int frente = p->direcao == FLUXO_FRENTE;
+  int nViz = frente ? b->nPred : b->nSucc;
+  int *viz = frente ? b->pred : b->succ;
+  unsigned long *lado = frente ? p->out : p->in;
+  int fronteira = frente ? (k == 0) : (b->nSucc == 0);
+  int uniao = p->encontro == FLUXO_UNIAO;
+
+  if (uniao) memset(dest, 0, sizeof(unsigned long) * p->nPalavras);
+  else memcpy(dest, todos, sizeof(unsigned long) * p->nPalavras);
+  for (int w = 0; w < p->nPalavras; w++)
+  {
+    unsigned long x = dest[w];
+    for (int v = 0; v < nViz; v++)
+    {
+      unsigned long y = fluxoConj(p, lado, viz[v])[w];
+      x = uniao ? (x | y) : (x & y);
+    }
+    if (fronteira) x = uniao ? (x | p->fronteira[w]) : (x & p->fronteira[w]);
+    dest[w] = x;
+  }
+}
+
+void fluxoResolve(FluxoCfg *cfg, FluxoProblema *p)
+{
+  int nb = cfg->nBlocos;
+  int np = p->nPalavras;
+  int frente = p->direcao == FLUXO_FRENTE;
+  p->iteracoes = 0;
+  if (nb == 0) return;
+
+  /* todos os bits válidos: valor inicial da interseção */
+  unsigned long *todos = (unsigned long *) calloc(np, sizeof(unsigned long));
+  for (int b = 0; b < p->nBits; b++) fluxoPoe(todos, b);
+  if (p->encontro == FLUXO_INTERSECAO)
+    for (int k = 0; k < nb; k++)
+    {
+      memcpy(fluxoConj(p, p->in, k), todos, sizeof(unsigned long) * np);
+      memcpy(fluxoConj(p, p->out, k), todos, sizeof(unsigned long) * np);
+    }
+
+  /* fila circular; cada bloco entra no máximo uma vez por vez */
+  int *fila = (int *) malloc(sizeof(int) * nb);
+  char *naFila = (char *) calloc(nb, 1);
+  int ini = 0, n = 0;
+  for (int j = 0; j < nb; j++)
+  {
+    int k = frente ? cfg->ordem[j] : cfg->ordem[nb - 1 - j];
+    fila[n++] = k;
+    naFila[k] = 1;
+  }
+
+  unsigned long *novo = (unsigned long *) malloc(sizeof(unsigned long) * np);
+  while (n > 0)
+  {
+    int k = fila[ini];
+    ini = (ini + 1) % nb;
+    n--;
+    naFila[k] = 0;
+    p->iteracoes++;
+
+    unsigned long *entra = fluxoConj(p, frente ? p->in : p->out, k);
+    unsigned long *sai = fluxoConj(p, frente ? p->out : p->in, k);
+    unsigned long *gen = fluxoConj(p, p->gen, k);
+    unsigned long *kill = fluxoConj(p, p->kill, k);
+    encontro(cfg, p, k, entra, todos);
+
+    int mudou = 0;
+    for (int w = 0; w < np; w++)
+    {
+      novo[w] = gen[w] | (entra[w] & ~kill[w]);
+      if (novo[w] != sai[w]) mudou = 1;
+    }
+    if (!mudou) continue;
+    memcpy(sai, novo, sizeof(unsigned long) * np);
+
+    FluxoBloco *b = &cfg->blocos[k];
+    int nDep = frente ? b->nSucc : b->nPred;
+    int *dep = frente ? b->succ : b->pred;
+    for (int d = 0; d < nDep; d++)
+      if (!naFila[dep[d]])
+      {
+        fila[(ini + n) % nb] = dep[d];
+        n++;
+        naFila[dep[d]] = 1;
+      }
+  }
+
+  free(novo);
+  free(fila);
+  free(naFila);
+  free(todos);
+}
+
+/* --- Análises --- */
+
+FluxoProblema *fluxoVivacidade(FluxoCfg *cfg)
+{
+  IrFuncao *f = cfg->f;
+  FluxoProblema *p = fluxoNovo(cfg, FLUXO_TRAS, FLUXO_UNIAO, f->nvregs);
+  int *u = (int *) malloc(sizeof(int) * fluxoMaxUsos(f));
+
+  /* gen = usados antes de definidos no bloco, kill = definidos */
+  for (int k = 0; k < cfg->nBlocos; k++)
+  {
+    unsigned long *gen = fluxoConj(p, p->gen, k);
+    unsigned long *kill = fluxoConj(p, p->kill, k);
+    for (int j = cfg->blocos[k].ini; j <= cfg->blocos[k].fim; j++)
+    {
+      int n = fluxoUsos(&f->instr[j], u);
+      for (int x = 0; x < n; x++)
+        if (!fluxoTem(kill, u[x])) fluxoPoe(gen, u[x]);
+      int d = fluxoDefinicao(&f->instr[j]);
+      if (d >= 0) fluxoPoe(kill, d);
+    }
+  }
+
+  free(u);
+  fluxoResolve(cfg, p);
+  return p;
+}
+
+FluxoProblema *fluxoDefinicoes(FluxoCfg *cfg, int **defs, int *nDefs)
+{
+  IrFuncao *f = cfg->f;
+
+  /* numera as definições e agrupa por vreg */
+  int n = 0;
+  int *numero = (int *) malloc(sizeof(int) * (f->n + 1));
+  int *porVreg = (int *) calloc(f->nvregs + 1, sizeof(int));
+  for (int j = 0; j < f->n; j++)
+  {
+    int d = fluxoDefinicao(&f->instr[j]);
+    numero[j] = (d >= 0) ? n++ : -1;
+    if (d >= 0) porVreg[d + 1]++;
+  }
+  for (int v = 0; v < f->nvregs; v++) porVreg[v + 1] += porVreg[v];
+  int *lista = (int *) malloc(sizeof(int) * (n + 1));
+  int *cursor = (int *) malloc(sizeof(int) * (f->nvregs + 1));
+  memcpy(cursor, porVreg, sizeof(int) * (f->nvregs + 1));
+  *defs = (int *) malloc(sizeof(int) * (n + 1));
+  for (int j = 0; j < f->n; j++)
+    if (numero[j] >= 0)
+    {
+      (*defs)[numero[j]] = j;
+      lista[cursor[fluxoDefinicao(&f->instr[j])]++] = numero[j];
+    }
+  *nDefs = n;
+
+  FluxoProblema *p = fluxoNovo(cfg, FLUXO_FRENTE, FLUXO_UNIAO, n);
+  for (int k = 0; k < cfg->nBlocos; k++)
+  {
+    unsigned long *gen = fluxoConj(p, p->gen, k);
+    unsigned long *kill = fluxoConj(p, p->kill, k);
+    for (int j = cfg->blocos[k].ini; j <= cfg->blocos[k].fim; j++)
+    {
+      int d = fluxoDefinicao(&f->instr[j]);
+      if (d < 0) continue;
+      /* a definição mata todas as outras do mesmo vreg */
+      for (int x = porVreg[d]; x < porVreg[d + 1]; x++)
+      {
+        fluxoPoe(kill, lista[x]);
+        fluxoTira(gen, lista[x]);
+      }
+      fluxoPoe(gen, numero[j]);
+    }
+  }
+
+  free(numero);
+  free(porVreg);
+  free(lista);
+  free(cursor);
+  fluxoResolve(cfg, p);
+  return p;
+}
+
+/* declaração mais recente da célula v até a posição pos (o código dos
+   blocos irmãos fica em sequência, então é a que está em vigor) */
+static int declaracaoEm(IrFuncao *f, int v, int pos)
+{
+  int achou = -1;
+  for (int d = 0; d < f->nDecls && f->decls[d].pos <= pos; d++)
+    if (f->decls[d].sym->loc == v) achou = d;
+  return achou;
+}
+
+int fluxoNaoInicializadas(FluxoCfg *cfg, FILE *avisos, int *iteracoes)
+{
+  IrFuncao *f = cfg->f;
+  int nc = f->sym->frameSize;
+  FluxoProblema *p = fluxoNovo(cfg, FLUXO_FRENTE, FLUXO_UNIAO, nc);
+  int *u = (int *) malloc(sizeof(int) * fluxoMaxUsos(f));
+
+  /* gen = células declaradas e ainda sem valor no fim do bloco,
+     kill = células que receberam valor depois da última declaração */
+  int cursor = 0;
+  for (int k = 0; k < cfg->nBlocos; k++)
+  {
+    unsigned long *gen = fluxoConj(p, p->gen, k);
+    unsigned long *kill = fluxoConj(p, p->kill, k);
+    for (int j = cfg->blocos[k].ini; j <= cfg->blocos[k].fim; j++)
+    {
+      for (; cursor < f->nDecls && f->decls[cursor].pos == j; cursor++)
+      {
+        fluxoPoe(gen, f->decls[cursor].sym->loc);
+        fluxoPoe(kill, f->decls[cursor].sym->loc);
+      }
+      int d = fluxoDefinicao(&f->instr[j]);
+      if (d >= 0 && d < nc)
+      {
+        fluxoTira(gen, d);
+        fluxoPoe(kill, d);
+      }
+    }
+  }
+  fluxoResolve(cfg, p);
+  if (iteracoes) *iteracoes = p->iteracoes;
+
+  /* refaz cada bloco alcançável a partir do in, avisando uma vez por variável */
+  int nAvisos = 0;
+  char *avisado = (char *) calloc(f->nDecls + 1, 1);
+  unsigned long *atual = (unsigned long *) malloc(sizeof(unsigned long) * p->nPalavras);
+  char *alcancavel = (char *) calloc(cfg->nBlocos + 1, 1);
+  for (int k = 0; k < cfg->nOrdem; k++) alcancavel[cfg->ordem[k]] = 1;
+  cursor = 0;
+  for (int k = 0; k < cfg->nBlocos; k++)
+  {
+    memcpy(atual, fluxoConj(p, p->in, k), sizeof(unsigned long) * p->nPalavras);
+    for (int j = cfg->blocos[k].ini; j <= cfg->blocos[k].fim; j++)
+    {
+      for (; cursor < f->nDecls && f->decls[cursor].pos == j; cursor++)
+        fluxoPoe(atual, f->decls[cursor].sym->loc);
+      IrInstr *i = &f->instr[j];
+      int n = fluxoUsos(i, u);
+      for (int x = 0; x < n && alcancavel[k]; x++)
+      {
+        if (u[x] >= nc || !fluxoTem(atual, u[x])) continue;
+        int dc = declaracaoEm(f, u[x], j);
+        if (dc < 0 || avisado[dc]) continue;
+        avisado[dc] = 1;
+        nAvisos++;
+        if (avisos)
+          fprintf(avisos, "AVISO: variável '%s' pode ser usada sem inicialização. Linha %d.\n",
+                  f->decls[dc].sym->name, i->lineno);
+      }
+      int d = fluxoDefinicao(i);
+      if (d >= 0 && d < nc) fluxoTira(atual, d);
+    }
+  }
+
+  free(u);
+  free(avisado);
+  free(atual);
+  free(alcancavel);
+  fluxoLibera(p);
+  return nAvisos;
+}
+
+int fluxoPrograma(IrPrograma *ir, FILE *saida)
+{
+  int total = 0;
+  for (int k = 0; k < ir->nFuncoes; k++)
+  {
+    IrFuncao *f = &ir->funcoes[k];
+    FluxoCfg *cfg = fluxoCfg(f);
+    int itNaoInic;
+    total += fluxoNaoInicializadas(cfg, saida, &itNaoInic);
+
+    if (relatorioFluxo)
+    {
+      FluxoProblema *viv = fluxoVivacidade(cfg);
+      int *defs, nDefs;
+      FluxoProblema *alc = fluxoDefinicoes(cfg, &defs, &nDefs);
+      fprintf(saida, "FLUXO: '%s': %d bloco(s), %d vreg(s), %d definição(ões); iterações: vivacidade %d, definições %d, não inicializadas %d\n",
+              f->sym->name, cfg->nBlocos, f->nvregs, nDefs, viv->iteracoes, alc->iteracoes, itNaoInic);
+      free(defs);
+      fluxoLibera(alc);
+      fluxoLibera(viv);
+    }
+    fluxoLiberaCfg(cfg);
+  }
+  return total;
+}
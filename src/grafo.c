@@ -0,0 +1,333 @@
+#include "../include/grafo.h"
+#include "../include/symtab.h"
+
+/* Montagem: o bloco corrente é sempre o último criado, então os comandos
+   de cada bloco saem contíguos e inicioCmds só precisa ser fechado. As
+   arestas são juntadas em pares e viram CSR no fim. */
+
+typedef struct
+{
+  Grafo *g;
+  int capCmds, capBlocos;
+  int *de, *para;
+  int nArestas, capArestas;
+  int *returns;         /* blocos terminados em return: vão para a saída */
+  int nReturns, capReturns;
+  int atual;            /* bloco corrente */
+} Montagem;
+
+static int novoBloco(Montagem *m, unsigned char marca)
+{
+  Grafo *g = m->g;
+  if (g->nBlocos + 1 >= m->capBlocos)
+  {
+    m->capBlocos = m->capBlocos ? m->capBlocos * 2 : 16;
+    g->inicioCmds = (int *) realloc(g->inicioCmds, sizeof(int) * m->capBlocos);
+    g->marca = (unsigned char *) realloc(g->marca, m->capBlocos);
+  }
+  g->inicioCmds[g->nBlocos] = g->nCmds;
+  g->marca[g->nBlocos] = marca;
+  m->atual = g->nBlocos;
+  return g->nBlocos++;
+}
+
+static void aresta(Montagem *m, int de, int para)
+{
+  if (m->nArestas == m->capArestas)
+  {
+    m->capArestas = m->capArestas ? m->capArestas * 2 : 32;
+    m->de = (int *) realloc(m->de, sizeof(int) * m->capArestas);
+    m->para = (int *) realloc(m->para, sizeof(int) * m->capArestas);
+  }
+  m->de[m->nArestas] = de;
+  m->para[m->nArestas] = para;
+  m->nArestas++;
+}
+
+static void comando(Montagem *m, TreeNode *t)
+{
+  Grafo *g = m->g;
+  if (g->nCmds == m->capCmds)
+  {
+    m->capCmds = m->capCmds ? m->capCmds * 2 : 32;
+    g->cmds = (TreeNode **) realloc(g->cmds, sizeof(TreeNode *) * m->capCmds);
+  }
+  g->cmds[g->nCmds++] = t;
+}
+
+/* valor de uma condição constante (1/0), ou -1 */
+static int constante(TreeNode *c)
+{
+  if (c->tipoNo == NO_NUM) return atoi(c->attr.lexema) != 0;
+  if (c->tipoNo != NO_OP_REL || c->filho->tipoNo != NO_NUM || c->filho->irmao->tipoNo != NO_NUM)
+    return -1;
+  int a = atoi(c->filho->attr.lexema), b = atoi(c->filho->irmao->attr.lexema);
+  char *op = c->attr.lexema;
+  if (strcmp(op, "<") == 0) return a < b;
+  if (strcmp(op, "<=") == 0) return a <= b;
+  if (strcmp(op, ">") == 0) return a > b;
+  if (strcmp(op, ">=") == 0) return a >= b;
+  if (strcmp(op, "==") == 0) return a == b;
+  return a != b;
+}
+
+static void monta(Montagem *m, TreeNode *t);
+
+/* um comando (sem os irmãos) */
+static void montaComando(Montagem *m, TreeNode *t)
+{
+  if (t == NULL) return;
+  switch (t->tipoNo)
+  {
+  case NO_DECLARACAO_VAR:
+    break;
+
+  case NO_BLOCO:
+    monta(m, t->filho);
+    break;
+
+  case NO_IF:
+  {
+    TreeNode *entao = t->filho->irmao;
+    TreeNode *senao = (entao != NULL) ? entao->irmao : NULL;
+    int valor = constante(t->filho);
+    comando(m, t->filho);
+    int teste = m->atual;
+
+    int e = novoBloco(m, 0);
+    if (valor != 0) aresta(m, teste, e);
+    montaComando(m, entao);
+    int fimEntao = m->atual;
+
+    int fimSenao = teste;
+    if (senao != NULL)
+    {
+      int s = novoBloco(m, 0);
+      if (valor != 1) aresta(m, teste, s);
+      montaComando(m, senao);
+      fimSenao = m->atual;
+    }
+
+    int junta = novoBloco(m, 0);
+    aresta(m, fimEntao, junta);
+    if (senao != NULL || valor != 1) aresta(m, fimSenao, junta);
+  }
+  break;
+
+  case NO_WHILE:
+  {
+    int valor = constante(t->filho);
+    int antes = m->atual;
+    int teste = novoBloco(m, 0);
+    aresta(m, antes, teste);
+    comando(m, t->filho);
+
+    int corpo = novoBloco(m, 0);
+    if (valor != 0) aresta(m, teste, corpo);
+    montaComando(m, t->filho->irmao);
+    aresta(m, m->atual, teste);
+
+    int depois = novoBloco(m, 0);
+    if (valor != 1) aresta(m, teste, depois);
+  }
+  break;
+
+  case NO_RETURN:
+    comando(m, t);
+    if (m->nReturns == m->capReturns)
+    {
+      m->capReturns = m->capReturns ? m->capReturns * 2 : 16;
+      m->returns = (int *) realloc(m->returns, sizeof(int) * m->capReturns);
+    }
+    m->returns[m->nReturns++] = m->atual;
+    novoBloco(m, GRAFO_APOS_RETURN);
+    break;
+
+  default:
+    comando(m, t);
+    break;
+  }
+}
+
+/* lista de comandos ligados por irmao */
+static void monta(Montagem *m, TreeNode *t)
+{
+  for (; t != NULL; t = t->irmao) montaComando(m, t);
+}
+
+Grafo *grafoConstroi(TreeNode *funcao)
+{
+  Grafo *g = (Grafo *) calloc(1, sizeof(Grafo));
+  g->funcao = funcao;
+  Montagem m;
+  memset(&m, 0, sizeof(m));
+  m.g = g;
+
+  TreeNode *corpo = funcao->filho->irmao->irmao;
+  while (corpo != NULL && corpo->tipoNo != NO_BLOCO) corpo = corpo->irmao;
+
+  novoBloco(&m, 0);
+  if (corpo != NULL) monta(&m, corpo->filho);
+  int fim = m.atual;
+  g->marca[fim] |= GRAFO_FIM_CORPO;
+
+  g->saida = novoBloco(&m, 0);
+  aresta(&m, fim, g->saida);
+  for (int k = 0; k < m.nReturns; k++) aresta(&m, m.returns[k], g->saida);
+  g->inicioCmds[g->nBlocos] = g->nCmds;
+
+  /* CSR dos sucessores e predecessores */
+  int nb = g->nBlocos;
+  g->inicioSucc = (int *) calloc(nb + 1, sizeof(int));
+  g->inicioPred = (int *) calloc(nb + 1, sizeof(int));
+  g->succ = (int *) malloc(sizeof(int) * (m.nArestas + 1));
+  g->pred = (int *) malloc(sizeof(int) * (m.nArestas + 1));
+  for (int k = 0; k < m.nArestas; k++)
+  {
+    g->inicioSucc[m.de[k] + 1]++;
+    g->inicioPred[m.para[k] + 1]++;
+  }
+  for (int b = 0; b < nb; b++)
+  {
+    g->inicioSucc[b + 1] += g->inicioSucc[b];
+    g->inicioPred[b + 1] += g->inicioPred[b];
+  }
+  int *cs = (int *) malloc(sizeof(int) * (nb + 1));
+  int *cp = (int *) malloc(sizeof(int) * (nb + 1));
+  memcpy(cs, g->inicioSucc, sizeof(int) * (nb + 1));
+  memcpy(cp, g->inicioPred, sizeof(int) * (nb + 1));
+  for (int k = 0; k < m.nArestas; k++)
+  {
+    g->succ[cs[m.de[k]]++] = m.para[k];
+    g->pred[cp[m.para[k]]++] = m.de[k];
+  }
+
+  /* alcançáveis a partir da entrada (pilha de tamanho nb basta) */
+  int topo = 0;
+  cs[topo++] = 0;
+  g->marca[0] |= GRAFO_ALCANCAVEL;
+  while (topo > 0)
+  {
+    int b = cs[--topo];
+    for (int k = g->inicioSucc[b]; k < g->inicioSucc[b + 1]; k++)
+      if (!(g->marca[g->succ[k]] & GRAFO_ALCANCAVEL))
+      {
+        g->marca[g->succ[k]] |= GRAFO_ALCANCAVEL;
+        cs[topo++] = g->succ[k];
+      }
+  }
+
+  free(cs);
+  free(cp);
+  free(m.de);
+  free(m.para);
+  free(m.returns);
+  return g;
+}
+
+void grafoLibera(Grafo *g)
+{
+  if (g == NULL) return;
+  free(g->cmds);
+  free(g->inicioCmds);
+  free(g->marca);
+  free(g->inicioSucc);
+  free(g->succ);
+  free(g->inicioPred);
+  free(g->pred);
+  free(g);
+}
+
+void grafoImprime(Grafo *g, FILE *saida)
+{
+  fprintf(saida, "%s:\n", g->funcao->sym->name);
+  for (int b = 0; b < g->nBlocos; b++)
+  {
+    fprintf(saida, "  B%d%s", b, b == g->saida ? " (saída)" : "");
+    if (g->inicioCmds[b] < g->inicioCmds[b + 1])
+    {
+      fprintf(saida, " linhas");
+      for (int k = g->inicioCmds[b]; k < g->inicioCmds[b + 1]; k++)
+        fprintf(saida, " %d", g->cmds[k]->lineno);
+    }
+    if (g->inicioSucc[b] < g->inicioSucc[b + 1])
+    {
+      fprintf(saida, " ->");
+      for (int k = g->inicioSucc[b]; k < g->inicioSucc[b + 1]; k++)
+        fprintf(saida, " B%d", g->succ[k]);
+    }
+    if (!(g->marca[b] & GRAFO_ALCANCAVEL)) fprintf(saida, " [inalcançável]");
+    fprintf(saida, "\n");
+  }
+}
+
+/* primeiro comando (na ordem do código) da região inalcançável que começa
+   em b; marca a região para não ser relatada de novo */
+static TreeNode *primeiroComando(Grafo *g, int b, char *visto, int *pilha)
+{
+  TreeNode *achou = NULL;
+  int menor = g->nCmds;
+  int topo = 0;
+  pilha[topo++] = b;
+  visto[b] = 1;
+  while (topo > 0)
+  {
+    int x = pilha[--topo];
+    if (g->inicioCmds[x] < g->inicioCmds[x + 1] && g->inicioCmds[x] < menor)
+    {
+      menor = g->inicioCmds[x];
+      achou = g->cmds[menor];
+    }
+    for (int k = g->inicioSucc[x]; k < g->inicioSucc[x + 1]; k++)
+    {
+      int s = g->succ[k];
+      if (!visto[s] && !(g->marca[s] & GRAFO_ALCANCAVEL))
+      {
+        visto[s] = 1;
+        pilha[topo++] = s;
+      }
+    }
+  }
+  return achou;
+}
+
+int grafoVerifica(TreeNode *arvore, FILE *listagem)
+{
+  int avisos = 0;
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+  {
+    if (d->tipoNo != NO_DECLARACAO_FUN || d->sym == NULL) continue;
+    Grafo *g = grafoConstroi(d);
+    if (listagem) grafoImprime(g, listagem);
+
+    /* regiões inalcançáveis: começam num bloco sem predecessores */
+    char *visto = (char *) calloc(g->nBlocos, 1);
+    int *pilha = (int *) malloc(sizeof(int) * g->nBlocos);
+    for (int b = 1; b < g->saida; b++)
+    {
+      if ((g->marca[b] & GRAFO_ALCANCAVEL) || visto[b] || g->inicioPred[b] < g->inicioPred[b + 1])
+        continue;
+      TreeNode *c = primeiroComando(g, b, visto, pilha);
+      if (c == NULL) continue;
+      avisos++;
+      if (g->marca[b] & GRAFO_APOS_RETURN)
+        fprintf(stderr, "AVISO: comando inalcançável depois de return em '%s'. Linha %d.\n", d->sym->name, c->lineno);
+      else
+        fprintf(stderr, "AVISO: bloco inalcançável em '%s' (condição constante). Linha %d.\n", d->sym->name, c->lineno);
+    }
+    free(visto);
+    free(pilha);
+
+    for (int b = 0; b < g->saida; b++)
+      if ((g->marca[b] & (GRAFO_FIM_CORPO | GRAFO_ALCANCAVEL)) == (GRAFO_FIM_CORPO | GRAFO_ALCANCAVEL) &&
+          d->sym->type == Integer)
+      {
+        avisos++;
+        fprintf(stderr, "AVISO: função '%s' do tipo int pode terminar sem return (devolve 0). Linha %d.\n",
+                d->sym->name, d->lineno);
+      }
+
+    grafoLibera(g);
+  }
+  return avisos;
+}
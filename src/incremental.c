@@ -0,0 +1,592 @@
+#include "../include/incremental.h"
+#include "../include/analyze.h"
+#include "../include/symtab.h"
+#include "../include/lote.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/* --- Hash (FNV-1a, 64 bits) --- */
+
+#define FNV_BASE 14695981039346656037ULL
+#define FNV_PRIMO 1099511628211ULL
+
+static uint64_t misturaBytes(uint64_t h, const void *dados, size_t n)
+{
+  const unsigned char *p = (const unsigned char *) dados;
+  for (size_t i = 0; i < n; i++)
+  {
+    h ^= p[i];
+    h *= FNV_PRIMO;
+  }
+  return h;
+}
+
+static uint64_t misturaInt(uint64_t h, int v)
+{
+  return misturaBytes(h, &v, sizeof(v));
+}
+
+static uint64_t misturaTexto(uint64_t h, const char *s)
+{
+  /* com o '\0', para "ab"+"c" não colidir com "a"+"bc" */
+  return misturaBytes(h, s, strlen(s) + 1);
+}
+
+static int temLexema(NodeType tipo)
+{
+  switch (tipo)
+  {
+  case NO_OP_REL:
+  case NO_OP_SOMA:
+  case NO_OP_MULT:
+  case NO_VAR:
+  case NO_CHAMADA:
+  case NO_ID:
+  case NO_NUM:
+  case NO_IMPORT:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/* subárvore de uma função: cada nó com tipo, linha relativa e lexema ou
+   valor; as marcas de descida e subida fixam a forma */
+static uint64_t hashArvore(uint64_t h, TreeNode *t, int linhaBase)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    h = misturaInt(h, (int) t->tipoNo);
+    h = misturaInt(h, t->lineno - linhaBase);
+    if (temLexema(t->tipoNo)) h = misturaTexto(h, t->attr.lexema != NULL ? t->attr.lexema : "");
+    else h = misturaInt(h, t->attr.valor);
+    h = misturaInt(h, -1);
+    h = hashArvore(h, t->filho, linhaBase);
+    h = misturaInt(h, -2);
+  }
+  return h;
+}
+
+/* --- Assinaturas das globais ---
+   O que a análise de uma função lê da tabela é o símbolo global de cada
+   nome que aparece nela. Este mapa (endereçamento aberto, potência de 2) vai
+   do hash de cada nome global ao hash da sua assinatura; é montado uma vez
+   depois de analyzeAssinaturas, quando a tabela só tem globais. Com
+   milhares de funções, procurar cada nome na tabela de símbolos, que tem
+   poucos baldes, custaria mais que verificá-las. */
+
+typedef struct
+{
+  uint64_t nome;        /* 0: posição livre */
+  uint64_t assinatura;
+} Assinatura;
+
+typedef struct
+{
+  Assinatura *a;
+  unsigned cap, n;
+} Assinaturas;
+
+static uint64_t hashNome(const char *nome)
+{
+  uint64_t h = misturaTexto(FNV_BASE, nome);
+  return h != 0 ? h : 1;
+}
+
+static Assinatura *procuraAssinatura(const Assinaturas *m, uint64_t nome)
+{
+  if (m->cap == 0) return NULL;
+  for (unsigned i = (unsigned) nome & (m->cap - 1); m->a[i].nome != 0; i = (i + 1) & (m->cap - 1))
+    if (m->a[i].nome == nome) return &m->a[i];
+  return NULL;
+}
+
+/* insere se ainda não há: vale o primeiro */
+static void poeAssinatura(Assinaturas *m, uint64_t nome, uint64_t assinatura)
+{
+  unsigned i = (unsigned) nome & (m->cap - 1);
+  for (; m->a[i].nome != 0; i = (i + 1) & (m->cap - 1))
+    if (m->a[i].nome == nome) return;
+  m->a[i].nome = nome;
+  m->a[i].assinatura = assinatura;
+  m->n++;
+}
+
+static void reservaAssinaturas(Assinaturas *m, unsigned n)
+{
+  m->cap = 16;
+  while (m->cap < 2 * n) m->cap *= 2;
+  m->a = (Assinatura *) calloc(m->cap, sizeof(Assinatura));
+  m->n = 0;
+}
+
+static void poeGlobal(BucketList l, void *ctx)
+{
+  Assinaturas *m = (Assinaturas *) ctx;
+  if (m->a == NULL)
+  {
+    m->n++;
+    return;
+  }
+  /* a cadeia vem do mais novo para o mais velho: vale o primeiro, como
+     em st_lookup_rec */
+  uint64_t h = FNV_BASE;
+  h = misturaInt(h, (int) l->kind);
+  h = misturaInt(h, (int) l->type);
+  h = misturaInt(h, l->size);
+  h = misturaInt(h, l->numParams);
+  for (int i = 0; i < l->numParams && l->paramTypes != NULL; i++) h = misturaInt(h, (int) l->paramTypes[i]);
+  poeAssinatura(m, hashNome(l->name), h);
+}
+
+static void montaAssinaturas(Assinaturas *m)
+{
+  /* a primeira passada conta os símbolos; a segunda insere */
+  m->a = NULL;
+  m->n = 0;
+  st_percorre(poeGlobal, m);
+  reservaAssinaturas(m, m->n);
+  st_percorre(poeGlobal, m);
+}
+
+/* nomes (hashes) que aparecem numa função, sem repetição depois de
+   ordenados */
+typedef struct
+{
+  uint64_t *v;
+  int n, cap;
+} Nomes;
+
+static uint64_t hashNomes(uint64_t h, TreeNode *t, const Assinaturas *m, Nomes *usados)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    if ((t->tipoNo == NO_VAR || t->tipoNo == NO_CHAMADA || t->tipoNo == NO_ID) && t->attr.lexema != NULL)
+    {
+      uint64_t nome = hashNome(t->attr.lexema);
+      Assinatura *g = procuraAssinatura(m, nome);
+      if (g == NULL) h = misturaInt(h, -3);
+      else h = misturaBytes(h, &g->assinatura, sizeof(g->assinatura));
+      if (usados->n == usados->cap)
+      {
+        usados->cap = usados->cap ? usados->cap * 2 : 16;
+        usados->v = (uint64_t *) realloc(usados->v, sizeof(uint64_t) * usados->cap);
+      }
+      usados->v[usados->n++] = nome;
+    }
+    h = hashNomes(h, t->filho, m, usados);
+  }
+  return h;
+}
+
+static int porValor(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+static void semRepeticao(Nomes *u)
+{
+  if (u->n == 0) return;  /* v pode ser NULL, e qsort não aceita */
+  qsort(u->v, u->n, sizeof(uint64_t), porValor);
+  int k = 0;
+  for (int i = 0; i < u->n; i++)
+    if (k == 0 || u->v[k - 1] != u->v[i]) u->v[k++] = u->v[i];
+  u->n = k;
+}
+
+/* --- Entradas do cache ---
+   Um diagnóstico guarda a linha relativa ao início da função e a mensagem
+   sem o número da linha, que é reposto na posição 'numero' (-1: a mensagem
+   não tem o número). */
+
+typedef struct
+{
+  int linha;
+  int numero;
+  char *texto;
+} Diagnostico;
+
+typedef struct
+{
+  uint64_t chave;
+  int n;
+  Diagnostico *diags;
+} Entrada;
+
+typedef struct
+{
+  Entrada *e;
+  int n, cap;
+} Cache;
+
+static Entrada *novaEntrada(Cache *c, uint64_t chave)
+{
+  if (c->n == c->cap)
+  {
+    c->cap = c->cap ? c->cap * 2 : 256;
+    c->e = (Entrada *) realloc(c->e, sizeof(Entrada) * c->cap);
+  }
+  Entrada *e = &c->e[c->n++];
+  e->chave = chave;
+  e->n = 0;
+  e->diags = NULL;
+  return e;
+}
+
+static void liberaCache(Cache *c)
+{
+  for (int i = 0; i < c->n; i++)
+  {
+    for (int k = 0; k < c->e[i].n; k++) free(c->e[i].diags[k].texto);
+    free(c->e[i].diags);
+  }
+  free(c->e);
+  c->e = NULL;
+  c->n = c->cap = 0;
+}
+
+static int porChave(const void *a, const void *b)
+{
+  uint64_t x = ((const Entrada *) a)->chave, y = ((const Entrada *) b)->chave;
+  return (x > y) - (x < y);
+}
+
+static Entrada *procura(Cache *c, uint64_t chave)
+{
+  Entrada alvo;
+  if (c->n == 0) return NULL;  /* cache vazio: e é NULL */
+  alvo.chave = chave;
+  return (Entrada *) bsearch(&alvo, c->e, c->n, sizeof(Entrada), porChave);
+}
+
+/* --- Arquivo: "CMC1", entradas; inteiros na ordem da máquina --- */
+
+static char *nomeCache(const char *dir, const char *arquivo)
+{
+  uint64_t h = misturaTexto(FNV_BASE, arquivo);
+  size_t n = strlen(dir) + 32;
+  char *nome = (char *) malloc(n);
+  snprintf(nome, n, "%s/%016llx.cache", dir, (unsigned long long) h);
+  return nome;
+}
+
+static int le(FILE *f, void *p, size_t n)
+{
+  return fread(p, 1, n, f) == n;
+}
+
+/* um cache ausente ou estragado é só um cache vazio */
+static void carrega(Cache *c, const char *nome)
+{
+  FILE *f = fopen(nome, "rb");
+  if (f == NULL) return;
+  char magica[4];
+  int n, ok = le(f, magica, 4) && memcmp(magica, "CMC1", 4) == 0 && le(f, &n, sizeof(n)) && n >= 0;
+  for (int i = 0; ok && i < n; i++)
+  {
+    uint64_t chave;
+    int nd;
+    ok = le(f, &chave, sizeof(chave)) && le(f, &nd, sizeof(nd)) && nd >= 0 && nd < (1 << 20);
+    if (!ok) break;
+    Entrada *e = novaEntrada(c, chave);
+    e->diags = (Diagnostico *) calloc(nd > 0 ? nd : 1, sizeof(Diagnostico));
+    for (int k = 0; ok && k < nd; k++)
+    {
+      Diagnostico *d = &e->diags[k];
+      int tam;
+      ok = le(f, &d->linha, sizeof(int)) && le(f, &d->numero, sizeof(int)) && le(f, &tam, sizeof(int)) &&
+           tam >= 0 && tam < (1 << 20) && d->numero <= tam;
+      if (!ok) break;
+      d->texto = (char *) malloc(tam + 1);
+      ok = le(f, d->texto, tam);
+      d->texto[tam] = '\0';
+      e->n++;
+    }
+  }
+  fclose(f);
+  if (!ok)
+  {
+    liberaCache(c);
+    return;
+  }
+  if (c->n > 0) qsort(c->e, c->n, sizeof(Entrada), porChave);
+}
+
+/* grava num temporário e renomeia: quem lê ao mesmo tempo vê o antigo ou o novo */
+static int grava(Cache *c, const char *nome)
+{
+  size_t n = strlen(nome) + 32;
+  char *temp = (char *) malloc(n);
+  snprintf(temp, n, "%s.%d", nome, (int) getpid());
+  FILE *f = fopen(temp, "wb");
+  int ok = (f != NULL);
+  if (ok)
+  {
+    ok = fwrite("CMC1", 1, 4, f) == 4 && fwrite(&c->n, sizeof(int), 1, f) == 1;
+    for (int i = 0; ok && i < c->n; i++)
+    {
+      Entrada *e = &c->e[i];
+      ok = fwrite(&e->chave, sizeof(e->chave), 1, f) == 1 && fwrite(&e->n, sizeof(int), 1, f) == 1;
+      for (int k = 0; ok && k < e->n; k++)
+      {
+        int tam = (int) strlen(e->diags[k].texto);
+        ok = fwrite(&e->diags[k].linha, sizeof(int), 1, f) == 1 &&
+             fwrite(&e->diags[k].numero, sizeof(int), 1, f) == 1 &&
+             fwrite(&tam, sizeof(int), 1, f) == 1 &&
+             fwrite(e->diags[k].texto, 1, tam, f) == (size_t) tam;
+      }
+    }
+    ok = (fclose(f) == 0) && ok;
+  }
+  ok = ok && rename(temp, nome) == 0;
+  if (!ok)
+  {
+    perror("Erro ao gravar o cache");
+    unlink(temp);
+  }
+  free(temp);
+  return ok;
+}
+
+/* --- Diagnósticos --- */
+
+/* tira da mensagem o último número igual a 'linha' */
+static void guardaDiagnostico(Diagnostico *d, int linha, int linhaBase, const char *mensagem)
+{
+  char num[16];
+  snprintf(num, sizeof(num), "%d", linha);
+  size_t tn = strlen(num), tm = strlen(mensagem);
+  d->linha = linha - linhaBase;
+  d->numero = -1;
+  for (size_t i = tm; i >= tn && linha > 0; i--)
+  {
+    if (memcmp(mensagem + i - tn, num, tn) == 0)
+    {
+      d->numero = (int) (i - tn);
+      break;
+    }
+  }
+  d->texto = (char *) malloc(tm + 1);
+  if (d->numero < 0)
+  {
+    memcpy(d->texto, mensagem, tm + 1);
+  }
+  else
+  {
+    memcpy(d->texto, mensagem, d->numero);
+    strcpy(d->texto + d->numero, mensagem + d->numero + tn);
+  }
+}
+
+static void repeteDiagnostico(const Diagnostico *d, int linhaBase)
+{
+  int linha = linhaBase + d->linha;
+  if (d->numero < 0)
+  {
+    analyzeRelata(linha, d->texto);
+    return;
+  }
+  size_t tm = strlen(d->texto);
+  char *mensagem = (char *) malloc(tm + 16);
+  memcpy(mensagem, d->texto, d->numero);
+  int tn = sprintf(mensagem + d->numero, "%d", linha);
+  strcpy(mensagem + d->numero + tn, d->texto + d->numero);
+  analyzeRelata(linha, mensagem);
+  free(mensagem);
+}
+
+/* --- Sessão ---
+   Entre análises no mesmo processo, cada função guarda a chave e os nomes
+   que usa, pelo hash da sua árvore. Uma função com a mesma árvore que não
+   usa nenhum nome cuja assinatura mudou tem a mesma chave: só as que
+   mudaram e as que dependem de uma assinatura que mudou são percorridas. */
+
+typedef struct
+{
+  uint64_t arvore, chave;
+  int n;
+  uint64_t *nomes;      /* ordenados */
+} Memo;
+
+struct Incremental
+{
+  Cache cache;
+  Memo *memo;           /* ordenado por árvore */
+  int nMemo;
+  Assinaturas anteriores;
+};
+
+static void liberaMemo(Memo *m, int n)
+{
+  for (int i = 0; i < n; i++) free(m[i].nomes);
+  free(m);
+}
+
+Incremental *incrementalCria(void)
+{
+  return (Incremental *) calloc(1, sizeof(Incremental));
+}
+
+void incrementalLibera(Incremental *inc)
+{
+  if (inc == NULL) return;
+  liberaCache(&inc->cache);
+  liberaMemo(inc->memo, inc->nMemo);
+  free(inc->anteriores.a);
+  free(inc);
+}
+
+uint64_t incrementalHashArvore(TreeNode *decl)
+{
+  uint64_t h = FNV_BASE;
+  h = misturaInt(h, (int) decl->tipoNo);
+  return hashArvore(h, decl->filho, decl->lineno);
+}
+
+static int porArvore(const void *a, const void *b)
+{
+  uint64_t x = ((const Memo *) a)->arvore, y = ((const Memo *) b)->arvore;
+  return (x > y) - (x < y);
+}
+
+/* nomes cuja assinatura mudou (ou que entraram ou saíram) */
+static void mudancas(const Assinaturas *antes, const Assinaturas *agora, Assinaturas *mudou)
+{
+  reservaAssinaturas(mudou, antes->n + agora->n);
+  for (unsigned i = 0; i < agora->cap; i++)
+  {
+    if (agora->a[i].nome == 0) continue;
+    Assinatura *a = procuraAssinatura(antes, agora->a[i].nome);
+    if (a == NULL || a->assinatura != agora->a[i].assinatura) poeAssinatura(mudou, agora->a[i].nome, 0);
+  }
+  for (unsigned i = 0; i < antes->cap; i++)
+    if (antes->a[i].nome != 0 && procuraAssinatura(agora, antes->a[i].nome) == NULL)
+      poeAssinatura(mudou, antes->a[i].nome, 0);
+}
+
+static int depende(const Memo *m, const Assinaturas *mudou)
+{
+  if (mudou->n == 0) return 0;
+  for (int i = 0; i < m->n; i++)
+    if (procuraAssinatura(mudou, m->nomes[i]) != NULL) return 1;
+  return 0;
+}
+
+void incrementalVerifica(Incremental *inc, TreeNode *lista, const uint64_t *hashes,
+                         void (*prepara)(TreeNode *decl, void *ctx), void *ctx, IncrementalStats *stats)
+{
+  double inicio = loteRelogio();
+  memset(stats, 0, sizeof(*stats));
+  Cache *velho = &inc->cache, novo = { NULL, 0, 0 };
+
+  analyzeAssinaturas(lista);
+  Assinaturas atuais, mudou;
+  montaAssinaturas(&atuais);
+  mudancas(&inc->anteriores, &atuais, &mudou);
+
+  int nFuncoes = 0;
+  for (TreeNode *decl = lista; decl != NULL; decl = decl->irmao)
+    if (decl->tipoNo == NO_DECLARACAO_FUN) nFuncoes++;
+  Memo *memo = (Memo *) malloc(sizeof(Memo) * (nFuncoes > 0 ? nFuncoes : 1));
+  Nomes usados = { NULL, 0, 0 };
+
+  int i = 0;
+  for (TreeNode *decl = lista; decl != NULL; decl = decl->irmao, i++)
+  {
+    if (decl->tipoNo != NO_DECLARACAO_FUN) continue;
+    Memo *m = &memo[stats->funcoes++];
+    m->arvore = (hashes != NULL) ? hashes[i] : incrementalHashArvore(decl);
+    Memo *antes = (inc->nMemo > 0) ? (Memo *) bsearch(m, inc->memo, inc->nMemo, sizeof(Memo), porArvore) : NULL;
+    if (antes != NULL && antes->n >= 0 && !depende(antes, &mudou))
+    {
+      /* os nomes passam para a análise nova; uma segunda função com a
+         mesma árvore os calcula de novo */
+      *m = *antes;
+      antes->n = -1;
+      antes->nomes = NULL;
+    }
+    else
+    {
+      usados.n = 0;
+      m->chave = hashNomes(m->arvore, decl->filho, &atuais, &usados);
+      semRepeticao(&usados);
+      m->n = usados.n;
+      m->nomes = (uint64_t *) malloc(sizeof(uint64_t) * (m->n > 0 ? m->n : 1));
+      memcpy(m->nomes, usados.v, sizeof(uint64_t) * m->n);
+    }
+
+    Entrada *e = novaEntrada(&novo, m->chave);
+    Entrada *v = procura(velho, m->chave);
+    if (v != NULL)
+    {
+      stats->acertos++;
+      if (v->n > 0) e->diags = (Diagnostico *) malloc(sizeof(Diagnostico) * v->n);
+      for (int k = 0; k < v->n; k++)
+      {
+        repeteDiagnostico(&v->diags[k], decl->lineno);
+        e->diags[k] = v->diags[k];
+        e->diags[k].texto = strdup(v->diags[k].texto);
+      }
+      e->n = v->n;
+      continue;
+    }
+    if (prepara != NULL) prepara(decl, ctx);
+    int n = analyzeFuncao(decl);
+    if (n > 0) e->diags = (Diagnostico *) malloc(sizeof(Diagnostico) * n);
+    for (int k = 0; k < n; k++)
+    {
+      int linha;
+      const char *mensagem = analyzeRetido(k, &linha);
+      analyzeRelata(linha, mensagem);
+      guardaDiagnostico(&e->diags[k], linha, decl->lineno, mensagem);
+    }
+    e->n = n;
+    analyzeLiberaRetidos();
+    analyzeDescarta(decl);
+  }
+  free(usados.v);
+
+  /* ficam só as funções desta análise; uma função repetida no fonte tem
+     uma entrada só */
+  if (novo.n > 0) qsort(novo.e, novo.n, sizeof(Entrada), porChave);
+  int unicas = 0;
+  for (int k = 0; k < novo.n; k++)
+  {
+    if (unicas > 0 && novo.e[unicas - 1].chave == novo.e[k].chave)
+    {
+      for (int d = 0; d < novo.e[k].n; d++) free(novo.e[k].diags[d].texto);
+      free(novo.e[k].diags);
+      continue;
+    }
+    novo.e[unicas++] = novo.e[k];
+  }
+  novo.n = unicas;
+  liberaCache(velho);
+  *velho = novo;
+
+  qsort(memo, stats->funcoes, sizeof(Memo), porArvore);
+  liberaMemo(inc->memo, inc->nMemo);
+  inc->memo = memo;
+  inc->nMemo = stats->funcoes;
+  free(inc->anteriores.a);
+  inc->anteriores = atuais;
+  free(mudou.a);
+  stats->segundos = loteRelogio() - inicio;
+}
+
+void incrementalAnalisa(TreeNode *raiz, const char *dir, const char *arquivo, IncrementalStats *stats)
+{
+  double inicio = loteRelogio();
+  char *nome = nomeCache(dir, arquivo);
+  Incremental *inc = incrementalCria();
+  carrega(&inc->cache, nome);
+  incrementalVerifica(inc, (raiz != NULL) ? raiz->filho : NULL, NULL, NULL, NULL, stats);
+  grava(&inc->cache, nome);
+  incrementalLibera(inc);
+  free(nome);
+  stats->segundos = loteRelogio() - inicio;
+}
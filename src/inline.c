@@ -0,0 +1,296 @@
+#include "../include/inline.h"
+#include "../include/symtab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Modelo de custo (unidades ~ instruções geradas) */
+#define CUSTO_CHAMADA 6      /* salvar frame, saltar e retornar */
+#define CUSTO_ARG 1          /* empilhar cada argumento */
+#define FATOR_LACO 8         /* peso de cada nível de while em volta da chamada */
+#define MAX_NIVEL_LACO 3
+#define MAX_TAMANHO 40       /* corpos maiores nunca são expandidos */
+#define MAX_PROFUNDIDADE 4   /* expansões aninhadas (limita recursão) */
+
+#define MAX_PARAMS 32
+
+// Informações de uma função candidata à expansão
+typedef struct {
+  BucketList sym;
+  char *nome;
+  TreeNode *corpo;               /* NO_BLOCO da função */
+  TreeNode *expr;                /* forma 'return expr;' (função int) */
+  int comandos;                  /* forma lista de comandos (função void sem return) */
+  int nparams;
+  BucketList params[MAX_PARAMS];
+  int usos[MAX_PARAMS];          /* quantas vezes o parâmetro é lido */
+  int atribuido[MAX_PARAMS];     /* parâmetro escalar é alvo de atribuição */
+  int escreve;                   /* corpo tem atribuição ou chamada */
+  int tamanho;                   /* número de nós do corpo */
+} FunInfo;
+
+static FunInfo *funcoes = NULL;
+static int nFuncoes = 0;
+
+/* pilha das funções sendo expandidas (para limitar recursão) */
+static BucketList pilhaExp[MAX_PROFUNDIDADE + 1];
+static int topoExp = 0;
+
+static int totalExpandidas = 0;
+
+static int contaNos(TreeNode *t) {
+  int n = 0;
+  for (; t != NULL; t = t->irmao) n += 1 + contaNos(t->filho);
+  return n;
+}
+
+static int contemTipo(TreeNode *t, NodeType tipo) {
+  for (; t != NULL; t = t->irmao) {
+    if (t->tipoNo == tipo || contemTipo(t->filho, tipo)) return 1;
+  }
+  return 0;
+}
+
+static int semEfeitos(TreeNode *t) {
+  return !contemTipo(t, NO_CHAMADA) && !contemTipo(t, NO_ATRIBUICAO);
+}
+
+/* lê memória visível ao chamado (global escalar ou elemento de array)? */
+static int leMemoria(TreeNode *t) {
+  for (; t != NULL; t = t->irmao) {
+    if (t->tipoNo == NO_ARRAY_IDX) return 1;
+    if (t->tipoNo == NO_VAR && t->sym != NULL && t->sym->scope == 0) return 1;
+    if (leMemoria(t->filho)) return 1;
+  }
+  return 0;
+}
+
+static int indiceParam(FunInfo *f, BucketList s) {
+  for (int i = 0; i < f->nparams; i++)
+    if (f->params[i] == s) return i;
+  return -1;
+}
+
+static void coletaUsos(FunInfo *f, TreeNode *t) {
+  for (; t != NULL; t = t->irmao) {
+    if (t->tipoNo == NO_ATRIBUICAO && t->filho != NULL && t->filho->tipoNo == NO_VAR) {
+      int i = indiceParam(f, t->filho->sym);
+      if (i >= 0) f->atribuido[i] = 1;
+      /* o lado esquerdo não conta como leitura */
+      coletaUsos(f, t->filho->irmao);
+      continue;
+    }
+    if (t->tipoNo == NO_VAR) {
+      int i = indiceParam(f, t->sym);
+      if (i >= 0) f->usos[i]++;
+    }
+    coletaUsos(f, t->filho);
+  }
+}
+
+static FunInfo *buscaFuncao(BucketList s) {
+  for (int i = 0; i < nFuncoes; i++)
+    if (funcoes[i].sym == s) return &funcoes[i];
+  return NULL;
+}
+
+/* Classifica o corpo da função: só corpos sem declarações locais,
+   na forma 'return expr;' ou uma lista de comandos sem return. */
+static void analisaFuncao(TreeNode *decl, FunInfo *f) {
+  memset(f, 0, sizeof(FunInfo));
+  f->sym = decl->sym;
+  f->nome = decl->filho->irmao->attr.lexema;
+
+  TreeNode *p = decl->filho->irmao->irmao;
+  while (p != NULL && p->tipoNo != NO_BLOCO) {
+    if (p->tipoNo == NO_PARAM) {
+      if (f->nparams == MAX_PARAMS) return;
+      f->params[f->nparams++] = p->sym;
+    }
+    p = p->irmao;
+  }
+  f->corpo = p;
+  if (f->corpo == NULL || f->sym == NULL) return;
+  if (f->sym->numParams != f->nparams) return;
+  if (contemTipo(f->corpo->filho, NO_DECLARACAO_VAR)) return;
+
+  TreeNode *c = f->corpo->filho;
+  if (f->sym->type == Integer) {
+    if (c != NULL && c->irmao == NULL && c->tipoNo == NO_RETURN && c->filho != NULL)
+      f->expr = c->filho;
+    else
+      return;
+  } else {
+    if (contemTipo(c, NO_RETURN)) return;
+    f->comandos = 1;
+  }
+
+  TreeNode *alvo = (f->expr != NULL) ? f->expr : c;
+  f->tamanho = contaNos(alvo);
+  f->escreve = !semEfeitos(alvo);
+  coletaUsos(f, alvo);
+}
+
+/* Substitui, no lugar, o conteúdo de 'dest' por 'novo' preservando o irmão */
+static void substituiNo(TreeNode *dest, TreeNode *novo) {
+  TreeNode *irm = dest->irmao;
+  *dest = *novo;
+  dest->irmao = irm;
+  free(novo);
+}
+
+static void substituiParams(FunInfo *f, TreeNode *t, TreeNode **args) {
+  for (; t != NULL; t = t->irmao) {
+    if (t->tipoNo == NO_VAR) {
+      int i = indiceParam(f, t->sym);
+      if (i >= 0) {
+        if (f->params[i]->kind == ID_ARRAY) {
+          /* array por referência: usa diretamente o array do chamador */
+          free(t->attr.lexema);
+          t->attr.lexema = strdup(args[i]->attr.lexema);
+          t->sym = args[i]->sym;
+        } else {
+          free(t->attr.lexema);
+          substituiNo(t, copiaArvore(args[i]));
+        }
+        continue;
+      }
+    }
+    substituiParams(f, t->filho, args);
+  }
+}
+
+/* Verifica se os argumentos podem substituir os parâmetros diretamente */
+static int argumentosValidos(FunInfo *f, TreeNode **args) {
+  for (int i = 0; i < f->nparams; i++) {
+    TreeNode *a = args[i];
+    if (f->params[i]->kind == ID_ARRAY) {
+      if (a->tipoNo != NO_VAR || a->sym == NULL || a->sym->kind != ID_ARRAY) return 0;
+      continue;
+    }
+    if (f->atribuido[i]) return 0;
+    if (!semEfeitos(a)) return 0;
+    if (f->usos[i] > 1 && a->tipoNo != NO_NUM &&
+        !(a->tipoNo == NO_VAR && a->sym != NULL && a->sym->kind == ID_VAR))
+      return 0;
+    if (f->escreve && leMemoria(a)) return 0;
+  }
+  return 1;
+}
+
+static void expande(TreeNode *t, int ehComando, int nivelLaco, TreeNode *funAtual);
+
+static void tentaExpandir(TreeNode *t, int ehComando, int nivelLaco, TreeNode *funAtual) {
+  FunInfo *f = buscaFuncao(t->sym);
+  if (f == NULL || (f->expr == NULL && !f->comandos)) return;
+  if (f->comandos && !ehComando) return;
+  if (f->sym == funAtual->sym) return;
+  if (topoExp >= MAX_PROFUNDIDADE) return;
+  for (int i = 0; i < topoExp; i++)
+    if (pilhaExp[i] == f->sym) return;
+
+  TreeNode *args[MAX_PARAMS];
+  int nargs = 0;
+  for (TreeNode *a = t->filho; a != NULL; a = a->irmao) {
+    if (nargs == MAX_PARAMS) return;
+    args[nargs++] = a;
+  }
+  if (nargs != f->nparams) return;
+  if (!argumentosValidos(f, args)) return;
+
+  int sobrecarga = CUSTO_CHAMADA + CUSTO_ARG * nargs;
+  int fator = 1;
+  for (int i = 0; i < nivelLaco && i < MAX_NIVEL_LACO; i++) fator *= FATOR_LACO;
+  int custo = f->tamanho - sobrecarga;
+  int beneficio = sobrecarga * fator;
+  if (f->tamanho > MAX_TAMANHO || custo > beneficio) return;
+
+  TreeNode *copia = (f->expr != NULL) ? copiaArvore(f->expr) : copiaArvore(f->corpo);
+  substituiParams(f, (f->expr != NULL) ? copia : copia->filho, args);
+
+  fprintf(stderr, "INLINE: '%s' expandida em '%s' (linha %d, tamanho %d, custo %d, benefício %d)\n",
+          f->nome, funAtual->filho->irmao->attr.lexema, t->lineno, f->tamanho, custo, beneficio);
+  totalExpandidas++;
+
+  /* a chamada dá lugar à cópia; os argumentos originais já foram
+     copiados para dentro dela */
+  int linha = t->lineno;
+  free(t->attr.lexema);
+  for (TreeNode *a = t->filho, *prox; a != NULL; a = prox) {
+    prox = a->irmao;
+    liberaArvore(a);
+  }
+  substituiNo(t, copia);
+  t->lineno = linha;
+
+  /* continua expandindo dentro do corpo inserido */
+  pilhaExp[topoExp++] = f->sym;
+  TreeNode *irm = t->irmao;
+  t->irmao = NULL;
+  if (f->expr != NULL) {
+    expande(t, 0, nivelLaco, funAtual);
+  } else {
+    for (TreeNode *c = t->filho; c != NULL; c = c->irmao)
+      expande(c, 1, nivelLaco, funAtual);
+  }
+  t->irmao = irm;
+  topoExp--;
+}
+
+/* Percorre um nó (sem irmãos) expandindo as chamadas dos filhos antes */
+static void expande(TreeNode *t, int ehComando, int nivelLaco, TreeNode *funAtual) {
+  if (t == NULL) return;
+
+  switch (t->tipoNo) {
+  case NO_BLOCO:
+    for (TreeNode *c = t->filho; c != NULL; c = c->irmao)
+      expande(c, 1, nivelLaco, funAtual);
+    break;
+  case NO_IF:
+    expande(t->filho, 0, nivelLaco, funAtual);
+    for (TreeNode *c = t->filho->irmao; c != NULL; c = c->irmao)
+      expande(c, 1, nivelLaco, funAtual);
+    break;
+  case NO_WHILE:
+    expande(t->filho, 0, nivelLaco + 1, funAtual);
+    expande(t->filho->irmao, 1, nivelLaco + 1, funAtual);
+    break;
+  default:
+    for (TreeNode *c = t->filho; c != NULL; c = c->irmao)
+      expande(c, 0, nivelLaco, funAtual);
+    break;
+  }
+
+  if (t->tipoNo == NO_CHAMADA && t->sym != NULL)
+    tentaExpandir(t, ehComando, nivelLaco, funAtual);
+}
+
+int inlineFunctions(TreeNode *syntaxTree) {
+  if (syntaxTree == NULL) return 0;
+
+  nFuncoes = 0;
+  for (TreeNode *d = syntaxTree->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_FUN) nFuncoes++;
+  funcoes = (FunInfo *) malloc(sizeof(FunInfo) * (nFuncoes > 0 ? nFuncoes : 1));
+
+  int i = 0;
+  for (TreeNode *d = syntaxTree->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_FUN) analisaFuncao(d, &funcoes[i++]);
+
+  totalExpandidas = 0;
+  topoExp = 0;
+  for (TreeNode *d = syntaxTree->filho; d != NULL; d = d->irmao) {
+    if (d->tipoNo != NO_DECLARACAO_FUN) continue;
+    TreeNode *p = d->filho->irmao->irmao;
+    while (p != NULL && p->tipoNo != NO_BLOCO) p = p->irmao;
+    expande(p, 1, 0, d);
+  }
+
+  /* os resumos das funções apontam para corpos que podem ter mudado */
+  free(funcoes);
+  funcoes = NULL;
+  nFuncoes = 0;
+
+  fprintf(stderr, "INLINE: %d chamada(s) expandida(s)\n", totalExpandidas);
+  return totalExpandidas;
+}
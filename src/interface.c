@@ -0,0 +1,164 @@
+#include "../include/interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define INTERFACE_ARRAY 4   /* no byte de um parâmetro: int x[] */
+
+/* --- Gravação --- */
+
+static int poeInt(FILE *f, int v)
+{
+  return fwrite(&v, sizeof(int), 1, f) == 1;
+}
+
+/* parâmetros da declaração, na ordem: NO_PARAM até o corpo */
+static int gravaParametros(FILE *f, TreeNode *decl)
+{
+  int ok = 1;
+  for (TreeNode *p = decl->filho->irmao->irmao; ok && p != NULL && p->tipoNo != NO_BLOCO; p = p->irmao)
+  {
+    if (p->tipoNo != NO_PARAM) continue;
+    int tipo = (p->filho != NULL && p->filho->tipoNo == NO_TIPO_VOID) ? Void : Integer;
+    ok = fputc(tipo | (p->attr.valor == 1 ? INTERFACE_ARRAY : 0), f) != EOF;
+  }
+  return ok;
+}
+
+static int gravaSimbolo(FILE *f, TreeNode *decl)
+{
+  BucketList s = decl->sym;
+  int tam = (int) strlen(s->name);
+  int ok = poeInt(f, s->kind) && poeInt(f, s->type) && poeInt(f, s->kind == ID_ARRAY ? s->size : 0) &&
+           poeInt(f, s->kind == ID_FUN ? s->numParams : 0) && poeInt(f, tam) &&
+           fwrite(s->name, 1, tam, f) == (size_t) tam;
+  if (ok && s->kind == ID_FUN) ok = gravaParametros(f, decl);
+  return ok;
+}
+
+static int exportada(TreeNode *d)
+{
+  return (d->tipoNo == NO_DECLARACAO_FUN || d->tipoNo == NO_DECLARACAO_VAR) && d->sym != NULL;
+}
+
+/* grava num temporário e renomeia, como o cache: um build paralelo que lê
+   a interface vê a antiga ou a nova */
+int interfaceGrava(TreeNode *arvore, const char *arquivo)
+{
+  int n = 0;
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao) n += exportada(d);
+
+  size_t tam = strlen(arquivo) + 32;
+  char *temp = (char *) malloc(tam);
+  snprintf(temp, tam, "%s.%d", arquivo, (int) getpid());
+  FILE *f = fopen(temp, "wb");
+  int ok = (f != NULL);
+  if (ok)
+  {
+    ok = fwrite("CMI1", 1, 4, f) == 4 && poeInt(f, n);
+    for (TreeNode *d = arvore->filho; ok && d != NULL; d = d->irmao)
+      if (exportada(d)) ok = gravaSimbolo(f, d);
+    ok = (fclose(f) == 0) && ok;
+  }
+  if (ok) ok = (rename(temp, arquivo) == 0);
+  if (!ok)
+  {
+    perror("Erro ao gravar a interface");
+    unlink(temp);
+  }
+  free(temp);
+  return ok ? 0 : 1;
+}
+
+/* --- Leitura --- */
+
+static int le(FILE *f, void *p, size_t n)
+{
+  return fread(p, 1, n, f) == n;
+}
+
+static int valido(int kind, int tipo)
+{
+  return kind >= ID_VAR && kind <= ID_ARRAY && tipo >= Void && tipo <= Boolean;
+}
+
+static int leSimbolo(FILE *f, InterfaceSimbolo *s)
+{
+  int kind, tipo, tam;
+  if (!(le(f, &kind, sizeof(int)) && le(f, &tipo, sizeof(int)) && le(f, &s->tamanho, sizeof(int)) &&
+        le(f, &s->numParams, sizeof(int)) && le(f, &tam, sizeof(int))))
+    return 0;
+  if (!valido(kind, tipo) || s->tamanho < 0 || s->numParams < 0 || s->numParams > (1 << 16) ||
+      tam <= 0 || tam > 4096)
+    return 0;
+  s->kind = (IdKind) kind;
+  s->tipo = (ExpType) tipo;
+  s->nome = (char *) malloc(tam + 1);
+  if (!le(f, s->nome, tam)) return 0;
+  s->nome[tam] = '\0';
+
+  if (s->numParams == 0) return 1;
+  s->paramTypes = (ExpType *) malloc(sizeof(ExpType) * s->numParams);
+  s->paramArray = (char *) malloc(s->numParams);
+  for (int k = 0; k < s->numParams; k++)
+  {
+    int c = fgetc(f);
+    if (c == EOF || (c & ~INTERFACE_ARRAY) > Boolean) return 0;
+    s->paramTypes[k] = (ExpType) (c & ~INTERFACE_ARRAY);
+    s->paramArray[k] = (c & INTERFACE_ARRAY) != 0;
+  }
+  return 1;
+}
+
+Interface *interfaceLe(const char *arquivo, const char **motivo)
+{
+  FILE *f = fopen(arquivo, "rb");
+  if (f == NULL)
+  {
+    *motivo = strerror(errno);
+    return NULL;
+  }
+  Interface *i = (Interface *) calloc(1, sizeof(Interface));
+  i->arquivo = strdup(arquivo);
+  char magica[4];
+  int n;
+  int ok = le(f, magica, 4) && memcmp(magica, "CMI1", 4) == 0 && le(f, &n, sizeof(n)) && n >= 0 && n < (1 << 24);
+  if (ok) i->simbolos = (InterfaceSimbolo *) calloc(n > 0 ? n : 1, sizeof(InterfaceSimbolo));
+  for (int k = 0; ok && k < n; k++)
+  {
+    ok = leSimbolo(f, &i->simbolos[k]);
+    i->n++;
+  }
+  fclose(f);
+  if (!ok)
+  {
+    *motivo = "não é uma interface de unidade C- (gerada por --exporta)";
+    interfaceLibera(i);
+    return NULL;
+  }
+  return i;
+}
+
+Interface *interfaceCarrega(const char *arquivo)
+{
+  const char *motivo;
+  Interface *i = interfaceLe(arquivo, &motivo);
+  if (i == NULL) fprintf(stderr, "Erro ao carregar a interface %s: %s\n", arquivo, motivo);
+  return i;
+}
+
+void interfaceLibera(Interface *i)
+{
+  if (i == NULL) return;
+  for (int k = 0; k < i->n; k++)
+  {
+    free(i->simbolos[k].nome);
+    free(i->simbolos[k].paramTypes);
+    free(i->simbolos[k].paramArray);
+  }
+  free(i->simbolos);
+  free(i->arquivo);
+  free(i);
+}
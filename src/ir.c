@@ -0,0 +1,444 @@
+#include "../include/ir.h"
+#include "../include/limites.h"
+#include <stdlib.h>
+#include <string.h>
+
+static IrFuncao *fn;
+
+static IrInstr *emite(IrOp op, int lineno)
+{
+  if (fn->n == fn->cap)
+  {
+    fn->cap = fn->cap ? fn->cap * 2 : 64;
+    fn->instr = (IrInstr *) realloc(fn->instr, sizeof(IrInstr) * fn->cap);
+  }
+  IrInstr *i = &fn->instr[fn->n++];
+  memset(i, 0, sizeof(IrInstr));
+  i->op = op;
+  i->d = i->a = i->b = i->c = -1;
+  i->lineno = lineno;
+  return i;
+}
+
+static int novoTemp(int ponteiro)
+{
+  int v = fn->nvregs++;
+  fn->ehPonteiro = (char *) realloc(fn->ehPonteiro, fn->nvregs);
+  fn->ehPonteiro[v] = (char) ponteiro;
+  return v;
+}
+
+static int novoRotulo(void)
+{
+  return fn->nrotulos++;
+}
+
+static void rotulo(int r)
+{
+  emite(IR_LABEL, 0)->imm = r;
+}
+
+static int ehGlobal(BucketList s)
+{
+  return s->scope == 0;
+}
+
+static int contemAtribuicao(TreeNode *t)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    if (t->tipoNo == NO_ATRIBUICAO || contemAtribuicao(t->filho)) return 1;
+  }
+  return 0;
+}
+
+static IrCond condicao(char *op)
+{
+  if (strcmp(op, "<") == 0) return CC_LT;
+  if (strcmp(op, "<=") == 0) return CC_LE;
+  if (strcmp(op, ">") == 0) return CC_GT;
+  if (strcmp(op, ">=") == 0) return CC_GE;
+  if (strcmp(op, "==") == 0) return CC_EQ;
+  return CC_NE;
+}
+
+IrCond irNegaCond(IrCond cc)
+{
+  switch (cc)
+  {
+  case CC_LT: return CC_GE;
+  case CC_LE: return CC_GT;
+  case CC_GT: return CC_LE;
+  case CC_GE: return CC_LT;
+  case CC_EQ: return CC_NE;
+  default: return CC_EQ;
+  }
+}
+
+static int geraExpr(TreeNode *t);
+
+/* vreg com o endereço base de um array (global, local ou parâmetro) */
+static int geraBase(BucketList s, int lineno)
+{
+  if (!ehGlobal(s) && s->size == 0)
+    return s->loc;  /* parâmetro: a célula guarda o endereço */
+  IrInstr *i = emite(IR_ADDR, lineno);
+  i->d = novoTemp(1);
+  i->sym = s;
+  return i->d;
+}
+
+/* valor de uma variável local pode mudar antes do uso se o resto da
+   expressão tiver atribuições: nesse caso copia para um temporário */
+static int protege(int v, TreeNode *resto, int lineno)
+{
+  if (v >= fn->sym->frameSize || !contemAtribuicao(resto)) return v;
+  IrInstr *i = emite(IR_MOV, lineno);
+  i->d = novoTemp(fn->ehPonteiro[v]);
+  i->a = v;
+  return i->d;
+}
+
+/* --checked: testa o índice do acesso; num parâmetro int x[], contra o
+   tamanho que veio com ele */
+static void geraLimite(TreeNode *acesso, int idx)
+{
+  BucketList s = acesso->filho->sym;
+  if (!precisaTesteLimite(acesso)) return;
+  IrInstr *i = emite(IR_LIMITE, acesso->lineno);
+  i->a = idx;
+  if (s->size > 0) i->imm = s->size;
+  else i->b = st_celula_tamanho(s);
+}
+
+/* tamanho escondido do argumento de um parâmetro int x[]: o do array
+   passado, ou 0 se não for array (todo acesso falha com --checked) */
+static int geraTamanho(TreeNode *arg)
+{
+  BucketList s = (arg->tipoNo == NO_VAR) ? arg->sym : NULL;
+  if (s != NULL && s->kind == ID_ARRAY && !ehGlobal(s) && s->size == 0) return st_celula_tamanho(s);
+  IrInstr *i = emite(IR_LI, arg->lineno);
+  i->d = novoTemp(0);
+  i->imm = (s != NULL && s->kind == ID_ARRAY) ? s->size : 0;
+  return i->d;
+}
+
+static int geraChamada(TreeNode *t)
+{
+  BucketList f = t->sym;
+  int nargs = st_celulas_params(f);
+
+  int *args = (nargs > 0) ? (int *) malloc(sizeof(int) * nargs) : NULL;
+  int k = 0, p = 0;
+  for (TreeNode *a = t->filho; a != NULL; a = a->irmao, p++)
+  {
+    args[k++] = protege(geraExpr(a), a->irmao, t->lineno);
+    if (p < f->numParams && f->paramArray != NULL && f->paramArray[p]) args[k++] = geraTamanho(a);
+  }
+
+  IrInstr *i = emite(IR_CALL, t->lineno);
+  i->sym = t->sym;
+  i->args = args;
+  i->nargs = nargs;
+  i->d = (t->sym->type == Integer) ? novoTemp(0) : -1;
+  return i->d;
+}
+
+static int geraAtribuicao(TreeNode *t)
+{
+  TreeNode *lhs = t->filho;
+  TreeNode *rhs = lhs->irmao;
+
+  if (lhs->tipoNo == NO_ARRAY_IDX)
+  {
+    int base = geraBase(lhs->filho->sym, t->lineno);
+    int idx = protege(geraExpr(lhs->filho->irmao), rhs, t->lineno);
+    geraLimite(lhs, idx);
+    int v = geraExpr(rhs);
+    IrInstr *i = emite(IR_STORE, t->lineno);
+    i->a = base;
+    i->b = idx;
+    i->c = v;
+    return v;
+  }
+
+  int v = geraExpr(rhs);
+  if (ehGlobal(lhs->sym))
+  {
+    IrInstr *i = emite(IR_STOREG, t->lineno);
+    i->a = v;
+    i->sym = lhs->sym;
+  }
+  else if (v != lhs->sym->loc)
+  {
+    IrInstr *i = emite(IR_MOV, t->lineno);
+    i->d = lhs->sym->loc;
+    i->a = v;
+  }
+  return v;
+}
+
+static int geraExpr(TreeNode *t)
+{
+  switch (t->tipoNo)
+  {
+  case NO_NUM:
+  {
+    IrInstr *i = emite(IR_LI, t->lineno);
+    i->d = novoTemp(0);
+    i->imm = atoi(t->attr.lexema);
+    return i->d;
+  }
+
+  case NO_VAR:
+  {
+    BucketList s = t->sym;
+    if (s->kind == ID_ARRAY) return geraBase(s, t->lineno);
+    if (!ehGlobal(s)) return s->loc;
+    IrInstr *i = emite(IR_LOADG, t->lineno);
+    i->d = novoTemp(0);
+    i->sym = s;
+    return i->d;
+  }
+
+  case NO_ARRAY_IDX:
+  {
+    int base = geraBase(t->filho->sym, t->lineno);
+    int idx = geraExpr(t->filho->irmao);
+    geraLimite(t, idx);
+    IrInstr *i = emite(IR_LOAD, t->lineno);
+    i->d = novoTemp(0);
+    i->a = base;
+    i->b = idx;
+    return i->d;
+  }
+
+  case NO_ATRIBUICAO:
+    return geraAtribuicao(t);
+
+  case NO_OP_SOMA:
+  case NO_OP_MULT:
+  case NO_OP_REL:
+  {
+    int a = protege(geraExpr(t->filho), t->filho->irmao, t->lineno);
+    int b = geraExpr(t->filho->irmao);
+    char *op = t->attr.lexema;
+    IrOp irop;
+    if (t->tipoNo == NO_OP_REL) irop = IR_CMP;
+    else if (strcmp(op, "+") == 0) irop = IR_ADD;
+    else if (strcmp(op, "-") == 0) irop = IR_SUB;
+    else if (strcmp(op, "*") == 0) irop = IR_MUL;
+    else irop = IR_DIV;
+    IrInstr *i = emite(irop, t->lineno);
+    i->d = novoTemp(0);
+    i->a = a;
+    i->b = b;
+    if (irop == IR_CMP) i->cc = condicao(op);
+    return i->d;
+  }
+
+  case NO_CHAMADA:
+    return geraChamada(t);
+
+  default:
+    return -1;
+  }
+}
+
+/* desvia para 'alvo' quando a condição tem o valor 'quando' (0 ou 1) */
+static void geraDesvio(TreeNode *cond, int quando, int alvo)
+{
+  if (cond->tipoNo == NO_OP_REL)
+  {
+    int a = protege(geraExpr(cond->filho), cond->filho->irmao, cond->lineno);
+    int b = geraExpr(cond->filho->irmao);
+    IrInstr *i = emite(IR_BR, cond->lineno);
+    i->a = a;
+    i->b = b;
+    i->cc = quando ? condicao(cond->attr.lexema) : irNegaCond(condicao(cond->attr.lexema));
+    i->imm = alvo;
+    return;
+  }
+  int v = geraExpr(cond);
+  IrInstr *i = emite(quando ? IR_BNZ : IR_BZ, cond->lineno);
+  i->a = v;
+  i->imm = alvo;
+}
+
+static void declara(BucketList s)
+{
+  fn->decls = (IrDecl *) realloc(fn->decls, sizeof(IrDecl) * (fn->nDecls + 1));
+  fn->decls[fn->nDecls].pos = fn->n;
+  fn->decls[fn->nDecls].sym = s;
+  fn->nDecls++;
+}
+
+static void geraComando(TreeNode *t)
+{
+  switch (t->tipoNo)
+  {
+  case NO_DECLARACAO_VAR:
+    if (t->sym != NULL && t->sym->kind == ID_VAR) declara(t->sym);
+    break;
+
+  case NO_BLOCO:
+    for (TreeNode *c = t->filho; c != NULL; c = c->irmao)
+      geraComando(c);
+    break;
+
+  case NO_IF:
+  {
+    TreeNode *entao = t->filho->irmao;
+    TreeNode *senao = (entao != NULL) ? entao->irmao : NULL;
+    int falso = novoRotulo();
+    geraDesvio(t->filho, 0, falso);
+    if (entao != NULL) geraComando(entao);
+    if (senao != NULL)
+    {
+      int fim = novoRotulo();
+      emite(IR_JMP, t->lineno)->imm = fim;
+      rotulo(falso);
+      geraComando(senao);
+      rotulo(fim);
+    }
+    else
+    {
+      rotulo(falso);
+    }
+  }
+  break;
+
+  case NO_WHILE:
+  {
+    /* laço rotacionado: o teste fica no fim, um desvio por iteração */
+    int corpo = novoRotulo();
+    int teste = novoRotulo();
+    emite(IR_JMP, t->lineno)->imm = teste;
+    rotulo(corpo);
+    if (t->filho->irmao != NULL) geraComando(t->filho->irmao);
+    rotulo(teste);
+    geraDesvio(t->filho, 1, corpo);
+  }
+  break;
+
+  case NO_RETURN:
+  {
+    int v = (t->filho != NULL) ? geraExpr(t->filho) : -1;
+    emite(IR_RET, t->lineno)->a = v;
+  }
+  break;
+
+  default:
+    geraExpr(t);
+    break;
+  }
+}
+
+static void geraFuncao(TreeNode *decl, IrFuncao *f)
+{
+  memset(f, 0, sizeof(IrFuncao));
+  fn = f;
+  f->sym = decl->sym;
+
+  /* células do frame: parâmetros array guardam endereços */
+  f->nvregs = f->sym->frameSize;
+  f->ehPonteiro = (char *) calloc(f->nvregs > 0 ? f->nvregs : 1, 1);
+  TreeNode *p = decl->filho->irmao->irmao;
+  while (p != NULL && p->tipoNo != NO_BLOCO)
+  {
+    if (p->tipoNo == NO_PARAM && p->sym != NULL && p->sym->kind == ID_ARRAY)
+      f->ehPonteiro[p->sym->loc] = 1;
+    p = p->irmao;
+  }
+
+  if (p != NULL) geraComando(p);
+
+  /* retorno implícito ao fim do corpo */
+  int v = -1;
+  if (f->sym->type == Integer)
+  {
+    IrInstr *i = emite(IR_LI, decl->lineno);
+    i->d = v = novoTemp(0);
+    i->imm = 0;
+  }
+  emite(IR_RET, decl->lineno)->a = v;
+  fn = NULL;
+}
+
+IrPrograma *irGera(TreeNode *arvore)
+{
+  IrPrograma *ir = (IrPrograma *) calloc(1, sizeof(IrPrograma));
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_FUN && d->sym != NULL) ir->nFuncoes++;
+
+  ir->funcoes = (IrFuncao *) calloc(ir->nFuncoes > 0 ? ir->nFuncoes : 1, sizeof(IrFuncao));
+  int k = 0;
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_FUN && d->sym != NULL) geraFuncao(d, &ir->funcoes[k++]);
+  return ir;
+}
+
+void irLibera(IrPrograma *ir)
+{
+  if (ir == NULL) return;
+  for (int i = 0; i < ir->nFuncoes; i++)
+  {
+    IrFuncao *f = &ir->funcoes[i];
+    for (int j = 0; j < f->n; j++) free(f->instr[j].args);
+    free(f->instr);
+    free(f->ehPonteiro);
+    free(f->decls);
+  }
+  free(ir->funcoes);
+  free(ir);
+}
+
+static const char *nomesCond[] = { "<", "<=", ">", ">=", "==", "!=" };
+
+void irImprime(IrPrograma *ir, FILE *saida)
+{
+  for (int k = 0; k < ir->nFuncoes; k++)
+  {
+    IrFuncao *f = &ir->funcoes[k];
+    fprintf(saida, "%s: (frame %d, vregs %d)\n", f->sym->name, f->sym->frameSize, f->nvregs);
+    for (int j = 0; j < f->n; j++)
+    {
+      IrInstr *i = &f->instr[j];
+      switch (i->op)
+      {
+      case IR_LI: fprintf(saida, "  v%d = %d\n", i->d, i->imm); break;
+      case IR_MOV: fprintf(saida, "  v%d = v%d\n", i->d, i->a); break;
+      case IR_ADD: fprintf(saida, "  v%d = v%d + v%d\n", i->d, i->a, i->b); break;
+      case IR_SUB: fprintf(saida, "  v%d = v%d - v%d\n", i->d, i->a, i->b); break;
+      case IR_MUL: fprintf(saida, "  v%d = v%d * v%d\n", i->d, i->a, i->b); break;
+      case IR_DIV: fprintf(saida, "  v%d = v%d / v%d\n", i->d, i->a, i->b); break;
+      case IR_CMP: fprintf(saida, "  v%d = v%d %s v%d\n", i->d, i->a, nomesCond[i->cc], i->b); break;
+      case IR_LOADG: fprintf(saida, "  v%d = %s\n", i->d, i->sym->name); break;
+      case IR_STOREG: fprintf(saida, "  %s = v%d\n", i->sym->name, i->a); break;
+      case IR_ADDR: fprintf(saida, "  v%d = &%s\n", i->d, i->sym->name); break;
+      case IR_LOAD: fprintf(saida, "  v%d = v%d[v%d]\n", i->d, i->a, i->b); break;
+      case IR_STORE: fprintf(saida, "  v%d[v%d] = v%d\n", i->a, i->b, i->c); break;
+      case IR_LABEL: fprintf(saida, "L%d:\n", i->imm); break;
+      case IR_JMP: fprintf(saida, "  goto L%d\n", i->imm); break;
+      case IR_BR: fprintf(saida, "  if v%d %s v%d goto L%d\n", i->a, nomesCond[i->cc], i->b, i->imm); break;
+      case IR_BZ: fprintf(saida, "  if v%d == 0 goto L%d\n", i->a, i->imm); break;
+      case IR_BNZ: fprintf(saida, "  if v%d != 0 goto L%d\n", i->a, i->imm); break;
+      case IR_CALL:
+        if (i->d >= 0) fprintf(saida, "  v%d = ", i->d);
+        else fprintf(saida, "  ");
+        fprintf(saida, "%s(", i->sym->name);
+        for (int a = 0; a < i->nargs; a++) fprintf(saida, "%sv%d", a ? ", " : "", i->args[a]);
+        fprintf(saida, ")\n");
+        break;
+      case IR_RET:
+        if (i->a >= 0) fprintf(saida, "  return v%d\n", i->a);
+        else fprintf(saida, "  return\n");
+        break;
+      case IR_LIMITE:
+        if (i->b >= 0) fprintf(saida, "  limite v%d < v%d\n", i->a, i->b);
+        else fprintf(saida, "  limite v%d < %d\n", i->a, i->imm);
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,457 @@
+#include "../include/jit.h"
+#include "../include/x86.h"
+#include "../include/runtime.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/* Registradores do código nativo (todos preservados pelo chamado):
+     rbx  fp (int *) do frame da VM
+     r12  mem (int *), base dos endereços de célula
+     r13  fp - mem, em células (para ADDRL)
+   A pilha de operandos fica na memória, logo acima das locais; como a
+   profundidade em cada instrução é fixa, cada operando tem célula fixa. */
+
+struct JitMapa
+{
+  void *base;
+  size_t tamanho;
+  struct JitMapa *prox;
+};
+
+/* rótulos internos ficam depois das posições do bytecode */
+enum { R_INICIO, R_FIM, R_ERRO_DIV, R_ERRO_PILHA, R_ERRO_LIMITE, N_INTERNOS };
+
+static X86Asm as;
+static int frame;     /* frameSize da função sendo compilada */
+static int rotuloBase;
+
+static X86Mem operando(int k)
+{
+  return x86_mem(RBX, 4 * (frame + k));
+}
+
+static X86Mem celula(int d)
+{
+  return x86_mem(RBX, 4 * d);
+}
+
+static int interno(int r)
+{
+  return rotuloBase + r;
+}
+
+static void chamaC(void *funcao)
+{
+  x86_mov_ri64(&as, RAX, (long long) (intptr_t) funcao);
+  x86_call_r(&as, RAX);
+}
+
+static X86Cond condicaoNegada(OpCode op)
+{
+  switch (op)
+  {
+  case OP_JNLT: return X86_GE;
+  case OP_JNLE: return X86_G;
+  case OP_JNGT: return X86_LE;
+  case OP_JNGE: return X86_L;
+  case OP_JNEQ: return X86_NE;
+  default: return X86_E;
+  }
+}
+
+static X86Cond condicao(OpCode op)
+{
+  return (X86Cond) (X86_L + (op - OP_LT));
+}
+
+/* rcx = b + i (célula do elemento), com b e i nos operandos */
+static void enderecoIndice(int b, int i)
+{
+  x86_load(&as, 4, RAX, operando(b));
+  x86_alu_rm(&as, X86_ADD, 4, RAX, operando(i));
+  x86_movsx(&as, RCX, RAX);
+}
+
+static void geraChamada(Jit *jit, int g, int d)
+{
+  BcFuncao *f = &jit->bc->funcoes[g];
+  int base = d - f->nparams;
+  int zerar = f->frameSize - f->nparams;
+
+  /* frame novo começa nos argumentos; verifica o espaço como a VM */
+  x86_lea(&as, RDI, operando(base));
+  x86_lea(&as, RAX, x86_mem(RDI, 4 * (f->frameSize + f->maxPilha)));
+  x86_mov_ri64(&as, RDX, (long long) (intptr_t) jit->limite);
+  x86_alu(&as, X86_CMP, 8, RAX, RDX);
+  x86_jcc(&as, X86_A, interno(R_ERRO_PILHA));
+
+  if (zerar <= 16)
+  {
+    for (int k = 0; k < zerar; k++)
+      x86_store_i(&as, x86_mem(RDI, 4 * (f->nparams + k)), 0);
+  }
+  else
+  {
+    x86_lea(&as, RDI, operando(base + f->nparams));
+    x86_mov_ri(&as, RSI, 0);
+    x86_mov_ri64(&as, RDX, 4L * zerar);
+    chamaC((void *) memset);
+    x86_lea(&as, RDI, operando(base));
+  }
+
+  /* nativo se já compilada; senão volta ao interpretador */
+  int lento = rotuloBase + N_INTERNOS + 2 * (int) as.n;  /* rótulos únicos */
+  int feito = lento + 1;
+  x86_mov_ri64(&as, RAX, (long long) (intptr_t) &jit->nativo[g]);
+  x86_load(&as, 8, RAX, x86_mem(RAX, 0));
+  x86_alu(&as, X86_TEST, 8, RAX, RAX);
+  x86_jcc(&as, X86_E, lento);
+  x86_mov_ri(&as, RSI, 0);
+  x86_call_r(&as, RAX);
+  x86_jmp(&as, feito);
+  x86_label(&as, lento);
+  x86_mov_rr(&as, 8, RSI, RDI);
+  x86_mov_ri(&as, RDI, g);
+  chamaC((void *) jit->chamaVm);
+  x86_label(&as, feito);
+
+  if (f->retornaValor) x86_store(&as, 4, operando(base), RAX);
+}
+
+/* profundidade da pilha de operandos antes de cada instrução */
+static int *profundidades(Bytecode *bc, int inicio, int fim, char *alvoLaco)
+{
+  int *prof = (int *) malloc(sizeof(int) * (fim - inicio));
+  for (int k = 0; k < fim - inicio; k++) prof[k] = -1;
+  prof[0] = 0;
+  int d = 0;
+  for (int pc = inicio; pc < fim; )
+  {
+    OpCode op = (OpCode) bc->codigo[pc];
+    int arg = (bcOperandos(op) == 1) ? bc->codigo[pc + 1] : 0;
+    if (prof[pc - inicio] >= 0) d = prof[pc - inicio];
+    else prof[pc - inicio] = d;   /* inalcançável: mantém a anterior */
+
+    switch (op)
+    {
+    case OP_CONST: case OP_LOADL: case OP_LOADG: case OP_ADDRL: case OP_ADDRG:
+    case OP_DUP: case OP_INPUT:
+      d++;
+      break;
+    case OP_STOREL: case OP_STOREG: case OP_LOADI: case OP_POP: case OP_OUTPUT:
+    case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+    case OP_LT: case OP_LE: case OP_GT: case OP_GE: case OP_EQ: case OP_NE:
+    case OP_JZ:
+      d--;
+      break;
+    case OP_STOREI:
+      d -= 3;
+      break;
+    case OP_STOREIK:
+    case OP_JNLT: case OP_JNLE: case OP_JNGT: case OP_JNGE: case OP_JNEQ: case OP_JNNE:
+      d -= 2;
+      break;
+    case OP_CALL:
+      d += -bc->funcoes[arg].nparams + bc->funcoes[arg].retornaValor;
+      break;
+    default:
+      break;
+    }
+
+    if (op == OP_JMP || op == OP_JZ || (op >= OP_JNLT && op <= OP_JNNE))
+    {
+      if (arg > pc) prof[arg - inicio] = d;
+      else alvoLaco[arg - inicio] = 1;
+    }
+    pc += 1 + bcOperandos(op);
+  }
+  return prof;
+}
+
+static void geraInstrucao(Jit *jit, OpCode op, int arg, int d)
+{
+  switch (op)
+  {
+  case OP_CONST:
+  case OP_ADDRG:
+    x86_store_i(&as, operando(d), arg);
+    break;
+
+  case OP_LOADL:
+    x86_load(&as, 4, RAX, celula(arg));
+    x86_store(&as, 4, operando(d), RAX);
+    break;
+
+  case OP_STOREL:
+    x86_load(&as, 4, RAX, operando(d - 1));
+    x86_store(&as, 4, celula(arg), RAX);
+    break;
+
+  case OP_LOADG:
+    x86_load(&as, 4, RAX, x86_mem(R12, 4 * arg));
+    x86_store(&as, 4, operando(d), RAX);
+    break;
+
+  case OP_STOREG:
+    x86_load(&as, 4, RAX, operando(d - 1));
+    x86_store(&as, 4, x86_mem(R12, 4 * arg), RAX);
+    break;
+
+  case OP_ADDRL:
+    x86_mov_rr(&as, 4, RAX, R13);
+    x86_alu_ri(&as, X86_ADD, 4, RAX, arg);
+    x86_store(&as, 4, operando(d), RAX);
+    break;
+
+  case OP_LOADI:
+    enderecoIndice(d - 2, d - 1);
+    x86_load(&as, 4, RAX, x86_mem_idx(R12, RCX, 4, 0));
+    x86_store(&as, 4, operando(d - 2), RAX);
+    break;
+
+  case OP_STOREI:
+  case OP_STOREIK:
+    enderecoIndice(d - 3, d - 2);
+    x86_load(&as, 4, RDX, operando(d - 1));
+    x86_store(&as, 4, x86_mem_idx(R12, RCX, 4, 0), RDX);
+    if (op == OP_STOREIK) x86_store(&as, 4, operando(d - 3), RDX);
+    break;
+
+  case OP_DUP:
+    x86_load(&as, 4, RAX, operando(d - 1));
+    x86_store(&as, 4, operando(d), RAX);
+    break;
+
+  case OP_POP:
+    break;
+
+  case OP_ADD:
+  case OP_SUB:
+  case OP_MUL:
+    x86_load(&as, 4, RAX, operando(d - 2));
+    x86_alu_rm(&as, op == OP_ADD ? X86_ADD : op == OP_SUB ? X86_SUB : X86_IMUL,
+               4, RAX, operando(d - 1));
+    x86_store(&as, 4, operando(d - 2), RAX);
+    break;
+
+  case OP_DIV:
+  {
+    int divide = rotuloBase + N_INTERNOS + 2 * as.n;
+    int pronto = divide + 1;
+    x86_load(&as, 4, RAX, operando(d - 2));
+    x86_load(&as, 4, RCX, operando(d - 1));
+    x86_alu(&as, X86_TEST, 4, RCX, RCX);
+    x86_jcc(&as, X86_E, interno(R_ERRO_DIV));
+    x86_alu_ri(&as, X86_CMP, 4, RCX, -1);
+    x86_jcc(&as, X86_NE, divide);
+    x86_neg(&as, RAX);
+    x86_jmp(&as, pronto);
+    x86_label(&as, divide);
+    x86_cdq(&as);
+    x86_idiv(&as, RCX);
+    x86_label(&as, pronto);
+    x86_store(&as, 4, operando(d - 2), RAX);
+  }
+  break;
+
+  case OP_LT: case OP_LE: case OP_GT: case OP_GE: case OP_EQ: case OP_NE:
+    x86_load(&as, 4, RAX, operando(d - 2));
+    x86_alu_rm(&as, X86_CMP, 4, RAX, operando(d - 1));
+    x86_setcc(&as, condicao(op), RAX);
+    x86_store(&as, 4, operando(d - 2), RAX);
+    break;
+
+  case OP_JMP:
+    x86_jmp(&as, arg);
+    break;
+
+  case OP_JZ:
+    x86_load(&as, 4, RAX, operando(d - 1));
+    x86_alu(&as, X86_TEST, 4, RAX, RAX);
+    x86_jcc(&as, X86_E, arg);
+    break;
+
+  case OP_JNLT: case OP_JNLE: case OP_JNGT: case OP_JNGE: case OP_JNEQ: case OP_JNNE:
+    x86_load(&as, 4, RAX, operando(d - 2));
+    x86_alu_rm(&as, X86_CMP, 4, RAX, operando(d - 1));
+    x86_jcc(&as, condicaoNegada(op), arg);
+    break;
+
+  case OP_CALL:
+    geraChamada(jit, arg, d);
+    break;
+
+  case OP_RET:
+    x86_load(&as, 4, RAX, operando(d - 1));
+    x86_jmp(&as, interno(R_FIM));
+    break;
+
+  case OP_RETV:
+    x86_mov_ri(&as, RAX, 0);
+    x86_jmp(&as, interno(R_FIM));
+    break;
+
+  case OP_INPUT:
+    chamaC((void *) cm_input);
+    x86_store(&as, 4, operando(d), RAX);
+    break;
+
+  case OP_OUTPUT:
+    x86_load(&as, 4, RDI, operando(d - 1));
+    chamaC((void *) cm_output);
+    break;
+
+  case OP_LIMITE:
+    x86_load(&as, 4, RAX, operando(d - 1));
+    x86_alu_ri(&as, X86_CMP, 4, RAX, arg);
+    x86_jcc(&as, X86_AE, interno(R_ERRO_LIMITE));
+    break;
+
+  case OP_LIMITEL:
+    x86_load(&as, 4, RAX, operando(d - 1));
+    x86_alu_rm(&as, X86_CMP, 4, RAX, celula(arg));
+    x86_jcc(&as, X86_AE, interno(R_ERRO_LIMITE));
+    break;
+
+  default:
+    break;
+  }
+}
+
+static void geraErro(Jit *jit, int rotulo, const char *erro, const char *funcao)
+{
+  x86_label(&as, interno(rotulo));
+  x86_mov_ri64(&as, RDI, (long long) (intptr_t) erro);
+  x86_mov_ri64(&as, RSI, (long long) (intptr_t) funcao);
+  chamaC((void *) jit->falha);
+}
+
+Jit *jitCria(Bytecode *bc, int *mem, int *limite,
+             int (*chamaVm)(int, int *), void (*falha)(const char *, const char *))
+{
+  Jit *jit = (Jit *) calloc(1, sizeof(Jit));
+  jit->bc = bc;
+  jit->mem = mem;
+  jit->limite = limite;
+  jit->chamaVm = chamaVm;
+  jit->falha = falha;
+  jit->nativo = (JitNativo *) calloc(bc->nFuncoes, sizeof(JitNativo));
+  jit->entradaLaco = (void **) calloc(bc->nCodigo, sizeof(void *));
+  return jit;
+}
+
+int jitCompila(Jit *jit, int f)
+{
+  Bytecode *bc = jit->bc;
+  BcFuncao *bf = &bc->funcoes[f];
+  if (bf->entrada < 0 || jit->nativo[f] != NULL) return 1;
+
+  /* a função vai até a entrada seguinte */
+  int inicio = bf->entrada;
+  int fim = bc->nCodigo;
+  for (int k = 0; k < bc->nFuncoes; k++)
+    if (bc->funcoes[k].entrada > inicio && bc->funcoes[k].entrada < fim) fim = bc->funcoes[k].entrada;
+
+  char *alvoLaco = (char *) calloc(fim - inicio, 1);
+  int *prof = profundidades(bc, inicio, fim, alvoLaco);
+
+  x86_binario(&as);
+  frame = bf->frameSize;
+  rotuloBase = bc->nCodigo;
+
+  x86_push(&as, RBX);
+  x86_push(&as, R12);
+  x86_push(&as, R13);
+  x86_mov_ri64(&as, RAX, (long long) (intptr_t) &jit->limitePilhaC);
+  x86_alu_rm(&as, X86_CMP, 8, RSP, x86_mem(RAX, 0));
+  x86_jcc(&as, X86_B, interno(R_ERRO_PILHA));
+  x86_mov_rr(&as, 8, RBX, RDI);
+  x86_mov_ri64(&as, R12, (long long) (intptr_t) jit->mem);
+  x86_mov_rr(&as, 8, R13, RBX);
+  x86_alu(&as, X86_SUB, 8, R13, R12);
+  x86_sar_ri(&as, 8, R13, 2);
+  x86_alu(&as, X86_TEST, 8, RSI, RSI);
+  x86_jcc(&as, X86_E, interno(R_INICIO));
+  x86_jmp_r(&as, RSI);
+  x86_label(&as, interno(R_INICIO));
+
+  for (int pc = inicio; pc < fim; )
+  {
+    OpCode op = (OpCode) bc->codigo[pc];
+    int arg = (bcOperandos(op) == 1) ? bc->codigo[pc + 1] : 0;
+    x86_label(&as, pc);
+    geraInstrucao(jit, op, arg, prof[pc - inicio]);
+    pc += 1 + bcOperandos(op);
+  }
+
+  x86_label(&as, interno(R_FIM));
+  x86_pop(&as, R13);
+  x86_pop(&as, R12);
+  x86_pop(&as, RBX);
+  x86_ret(&as);
+
+  geraErro(jit, R_ERRO_DIV, "divisão por zero", bf->nome);
+  geraErro(jit, R_ERRO_PILHA, "estouro de pilha", bf->nome);
+  geraErro(jit, R_ERRO_LIMITE, "índice fora dos limites", bf->nome);
+
+  int status = x86_finaliza(&as);
+  void *base = MAP_FAILED;
+  size_t pagina = (size_t) sysconf(_SC_PAGESIZE);
+  size_t tamanho = ((size_t) as.n + pagina - 1) / pagina * pagina;
+  if (status == 0)
+    base = mmap(NULL, tamanho, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (base != MAP_FAILED)
+  {
+    memcpy(base, as.codigo, as.n);
+    if (mprotect(base, tamanho, PROT_READ | PROT_EXEC) != 0)
+    {
+      munmap(base, tamanho);
+      base = MAP_FAILED;
+    }
+  }
+
+  if (base != MAP_FAILED)
+  {
+    struct JitMapa *m = (struct JitMapa *) malloc(sizeof(struct JitMapa));
+    m->base = base;
+    m->tamanho = tamanho;
+    m->prox = jit->mapas;
+    jit->mapas = m;
+
+    for (int pc = inicio; pc < fim; pc++)
+      if (alvoLaco[pc - inicio])
+        jit->entradaLaco[pc] = (char *) base + x86_posicao(&as, pc);
+    jit->nativo[f] = (JitNativo) base;
+    jit->compiladas++;
+    jit->bytes += as.n;
+    status = 0;
+  }
+  else
+  {
+    status = 1;
+  }
+
+  x86_libera(&as);
+  free(prof);
+  free(alvoLaco);
+  return status;
+}
+
+void jitLibera(Jit *jit)
+{
+  if (jit == NULL) return;
+  while (jit->mapas != NULL)
+  {
+    struct JitMapa *m = jit->mapas;
+    jit->mapas = m->prox;
+    munmap(m->base, m->tamanho);
+    free(m);
+  }
+  free(jit->nativo);
+  free(jit->entradaLaco);
+  free(jit);
+}
@@ -0,0 +1,369 @@
+#include "../include/json.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+/* --- Leitura: descida recursiva sobre o texto inteiro --- */
+
+#define JSON_MAX_PROFUNDIDADE 256
+
+typedef struct
+{
+  const char *p, *fim;
+  int profundidade;
+} Leitor;
+
+static void pulaEspacos(Leitor *l)
+{
+  while (l->p < l->fim && (*l->p == ' ' || *l->p == '\t' || *l->p == '\n' || *l->p == '\r')) l->p++;
+}
+
+static int palavra(Leitor *l, const char *w)
+{
+  size_t n = strlen(w);
+  if ((size_t) (l->fim - l->p) < n || memcmp(l->p, w, n) != 0) return 0;
+  l->p += n;
+  return 1;
+}
+
+static int hex4(Leitor *l, unsigned *u)
+{
+  if (l->fim - l->p < 4) return 0;
+  *u = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    char c = *l->p++;
+    *u <<= 4;
+    if (c >= '0' && c <= '9') *u |= (unsigned) (c - '0');
+    else if (c >= 'a' && c <= 'f') *u |= (unsigned) (c - 'a' + 10);
+    else if (c >= 'A' && c <= 'F') *u |= (unsigned) (c - 'A' + 10);
+    else return 0;
+  }
+  return 1;
+}
+
+static char *poeUtf8(char *q, unsigned u)
+{
+  if (u < 0x80)
+  {
+    *q++ = (char) u;
+  }
+  else if (u < 0x800)
+  {
+    *q++ = (char) (0xC0 | (u >> 6));
+    *q++ = (char) (0x80 | (u & 0x3F));
+  }
+  else if (u < 0x10000)
+  {
+    *q++ = (char) (0xE0 | (u >> 12));
+    *q++ = (char) (0x80 | ((u >> 6) & 0x3F));
+    *q++ = (char) (0x80 | (u & 0x3F));
+  }
+  else
+  {
+    *q++ = (char) (0xF0 | (u >> 18));
+    *q++ = (char) (0x80 | ((u >> 12) & 0x3F));
+    *q++ = (char) (0x80 | ((u >> 6) & 0x3F));
+    *q++ = (char) (0x80 | (u & 0x3F));
+  }
+  return q;
+}
+
+/* depois da aspa de abertura; o texto decodificado nunca é maior que o
+   original */
+static char *leTexto(Leitor *l)
+{
+  const char *ini = l->p;
+  while (l->p < l->fim && *l->p != '"')
+  {
+    if (*l->p == '\\') l->p++;
+    l->p++;
+  }
+  if (l->p >= l->fim) return NULL;
+  size_t n = (size_t) (l->p - ini);
+  char *s = (char *) malloc(n + 1), *q = s;
+  Leitor e = { ini, l->p, 0 };
+  while (e.p < e.fim)
+  {
+    char c = *e.p++;
+    if (c != '\\')
+    {
+      *q++ = c;
+      continue;
+    }
+    c = *e.p++;
+    unsigned u;
+    switch (c)
+    {
+    case '"': *q++ = '"'; break;
+    case '\\': *q++ = '\\'; break;
+    case '/': *q++ = '/'; break;
+    case 'b': *q++ = '\b'; break;
+    case 'f': *q++ = '\f'; break;
+    case 'n': *q++ = '\n'; break;
+    case 'r': *q++ = '\r'; break;
+    case 't': *q++ = '\t'; break;
+    case 'u':
+      if (!hex4(&e, &u)) goto ruim;
+      /* par substituto: dois \u formam um caractere fora do plano básico */
+      if (u >= 0xD800 && u < 0xDC00 && e.fim - e.p >= 6 && e.p[0] == '\\' && e.p[1] == 'u')
+      {
+        unsigned baixo;
+        e.p += 2;
+        if (!hex4(&e, &baixo) || baixo < 0xDC00 || baixo >= 0xE000) goto ruim;
+        u = 0x10000 + ((u - 0xD800) << 10) + (baixo - 0xDC00);
+      }
+      q = poeUtf8(q, u);
+      break;
+    default:
+      goto ruim;
+    }
+  }
+  *q = '\0';
+  l->p++;
+  return s;
+ruim:
+  free(s);
+  return NULL;
+}
+
+static Json *leValor(Leitor *l);
+
+static Json *novo(JsonTipo tipo)
+{
+  Json *v = (Json *) calloc(1, sizeof(Json));
+  v->tipo = tipo;
+  return v;
+}
+
+/* elementos de lista ou membros de objeto, até 'fecha' */
+static int leElementos(Leitor *l, Json *v, char fecha)
+{
+  Json **ultimo = &v->filho;
+  pulaEspacos(l);
+  if (l->p < l->fim && *l->p == fecha)
+  {
+    l->p++;
+    return 1;
+  }
+  for (;;)
+  {
+    char *chave = NULL;
+    if (fecha == '}')
+    {
+      pulaEspacos(l);
+      if (l->p >= l->fim || *l->p != '"') return 0;
+      l->p++;
+      if ((chave = leTexto(l)) == NULL) return 0;
+      pulaEspacos(l);
+      if (l->p >= l->fim || *l->p != ':')
+      {
+        free(chave);
+        return 0;
+      }
+      l->p++;
+    }
+    Json *e = leValor(l);
+    if (e == NULL)
+    {
+      free(chave);
+      return 0;
+    }
+    e->chave = chave;
+    *ultimo = e;
+    ultimo = &e->irmao;
+    pulaEspacos(l);
+    if (l->p >= l->fim) return 0;
+    char c = *l->p++;
+    if (c == fecha) return 1;
+    if (c != ',') return 0;
+  }
+}
+
+static Json *leValor(Leitor *l)
+{
+  pulaEspacos(l);
+  if (l->p >= l->fim) return NULL;
+  Json *v;
+  char c = *l->p;
+  if (c == '{' || c == '[')
+  {
+    if (l->profundidade >= JSON_MAX_PROFUNDIDADE) return NULL;
+    l->p++;
+    l->profundidade++;
+    v = novo(c == '{' ? JSON_OBJETO : JSON_LISTA);
+    int ok = leElementos(l, v, c == '{' ? '}' : ']');
+    l->profundidade--;
+    if (!ok)
+    {
+      jsonLibera(v);
+      return NULL;
+    }
+    return v;
+  }
+  if (c == '"')
+  {
+    l->p++;
+    char *s = leTexto(l);
+    if (s == NULL) return NULL;
+    v = novo(JSON_TEXTO);
+    v->texto = s;
+    return v;
+  }
+  if (palavra(l, "true") || palavra(l, "false"))
+  {
+    v = novo(JSON_BOOL);
+    v->numero = (c == 't');
+    return v;
+  }
+  if (palavra(l, "null")) return novo(JSON_NULO);
+
+  /* número: strtod precisa de um texto terminado */
+  const char *ini = l->p;
+  while (l->p < l->fim && strchr("+-0123456789.eE", *l->p) != NULL) l->p++;
+  size_t n = (size_t) (l->p - ini);
+  if (n == 0 || n > 63) return NULL;
+  char buf[64];
+  memcpy(buf, ini, n);
+  buf[n] = '\0';
+  char *resto;
+  double d = strtod(buf, &resto);
+  if (*resto != '\0') return NULL;
+  v = novo(JSON_NUMERO);
+  v->numero = d;
+  return v;
+}
+
+Json *jsonLe(const char *texto, size_t tam)
+{
+  Leitor l = { texto, texto + tam, 0 };
+  Json *v = leValor(&l);
+  pulaEspacos(&l);
+  if (v != NULL && l.p != l.fim)
+  {
+    jsonLibera(v);
+    return NULL;
+  }
+  return v;
+}
+
+void jsonLibera(Json *v)
+{
+  while (v != NULL)
+  {
+    Json *prox = v->irmao;
+    jsonLibera(v->filho);
+    free(v->texto);
+    free(v->chave);
+    free(v);
+    v = prox;
+  }
+}
+
+Json *jsonCampo(const Json *v, const char *chave)
+{
+  if (v == NULL || v->tipo != JSON_OBJETO) return NULL;
+  for (Json *e = v->filho; e != NULL; e = e->irmao)
+    if (strcmp(e->chave, chave) == 0) return e;
+  return NULL;
+}
+
+const char *jsonTexto(const Json *v)
+{
+  return (v != NULL && v->tipo == JSON_TEXTO) ? v->texto : NULL;
+}
+
+int jsonInt(const Json *v, int padrao)
+{
+  return (v != NULL && v->tipo == JSON_NUMERO) ? (int) v->numero : padrao;
+}
+
+/* --- Escrita --- */
+
+static void reserva(JsonSaida *s, size_t n)
+{
+  if (s->n + n + 1 <= s->cap) return;
+  while (s->n + n + 1 > s->cap) s->cap = s->cap ? s->cap * 2 : 1024;
+  s->p = (char *) realloc(s->p, s->cap);
+}
+
+void jsonPoe(JsonSaida *s, const char *fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(NULL, 0, fmt, ap);
+  va_end(ap);
+  reserva(s, (size_t) n);
+  va_start(ap, fmt);
+  vsnprintf(s->p + s->n, (size_t) n + 1, fmt, ap);
+  va_end(ap);
+  s->n += (size_t) n;
+}
+
+void jsonPoeTexto(JsonSaida *s, const char *texto)
+{
+  reserva(s, 2 * strlen(texto) + 2);
+  s->p[s->n++] = '"';
+  for (const char *c = texto; *c != '\0'; c++)
+  {
+    unsigned char u = (unsigned char) *c;
+    if (u == '"' || u == '\\')
+    {
+      reserva(s, 2);
+      s->p[s->n++] = '\\';
+      s->p[s->n++] = (char) u;
+    }
+    else if (u < 0x20)
+    {
+      reserva(s, 6);
+      s->n += (size_t) sprintf(s->p + s->n, "\\u%04x", u);
+    }
+    else
+    {
+      reserva(s, 1);
+      s->p[s->n++] = (char) u;
+    }
+  }
+  reserva(s, 1);
+  s->p[s->n++] = '"';
+  s->p[s->n] = '\0';
+}
+
+void jsonPoeValor(JsonSaida *s, const Json *v)
+{
+  if (v == NULL)
+  {
+    jsonPoe(s, "null");
+    return;
+  }
+  switch (v->tipo)
+  {
+  case JSON_NULO: jsonPoe(s, "null"); break;
+  case JSON_BOOL: jsonPoe(s, v->numero != 0 ? "true" : "false"); break;
+  case JSON_NUMERO: jsonPoe(s, "%.17g", v->numero); break;
+  case JSON_TEXTO: jsonPoeTexto(s, v->texto); break;
+  case JSON_LISTA:
+  case JSON_OBJETO:
+    jsonPoe(s, v->tipo == JSON_LISTA ? "[" : "{");
+    for (Json *e = v->filho; e != NULL; e = e->irmao)
+    {
+      if (e != v->filho) jsonPoe(s, ",");
+      if (v->tipo == JSON_OBJETO)
+      {
+        jsonPoeTexto(s, e->chave);
+        jsonPoe(s, ":");
+      }
+      jsonPoeValor(s, e);
+    }
+    jsonPoe(s, v->tipo == JSON_LISTA ? "]" : "}");
+    break;
+  }
+}
+
+void jsonLiberaSaida(JsonSaida *s)
+{
+  free(s->p);
+  s->p = NULL;
+  s->n = s->cap = 0;
+}
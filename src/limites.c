@@ -0,0 +1,404 @@
+#include "../include/limites.h"
+#include "../include/symtab.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int modoVerificado = 0;
+
+typedef struct
+{
+  long long lo, hi;
+} Intervalo;
+
+/* estado abstrato: intervalo de cada célula do frame; morto = inalcançável */
+typedef struct
+{
+  Intervalo *v;
+  int morto;
+} Estado;
+
+static const Intervalo TOPO = { INT_MIN, INT_MAX };
+
+static int nCelulas;      /* frameSize da função analisada */
+static int registrando;   /* 0 durante o ponto fixo de um laço */
+static LimitesStats *st;
+static FILE *avisos;      /* NULL: só as marcas e as contagens */
+
+static Intervalo intervalo(long long lo, long long hi)
+{
+  Intervalo r = { lo, hi };
+  /* fora da faixa de int a aritmética dá a volta: qualquer valor */
+  if (lo < INT_MIN || hi > INT_MAX) return TOPO;
+  return r;
+}
+
+static Estado novoEstado(void)
+{
+  Estado e;
+  e.v = (Intervalo *) malloc(sizeof(Intervalo) * (nCelulas > 0 ? nCelulas : 1));
+  for (int k = 0; k < nCelulas; k++) e.v[k] = TOPO;
+  e.morto = 0;
+  return e;
+}
+
+static Estado copia(Estado *e)
+{
+  Estado c = novoEstado();
+  memcpy(c.v, e->v, sizeof(Intervalo) * nCelulas);
+  c.morto = e->morto;
+  return c;
+}
+
+static void substitui(Estado *destino, Estado origem)
+{
+  free(destino->v);
+  *destino = origem;
+}
+
+/* destino = destino U origem */
+static void junta(Estado *destino, Estado *origem)
+{
+  if (origem->morto) return;
+  if (destino->morto)
+  {
+    memcpy(destino->v, origem->v, sizeof(Intervalo) * nCelulas);
+    destino->morto = 0;
+    return;
+  }
+  for (int k = 0; k < nCelulas; k++)
+  {
+    if (origem->v[k].lo < destino->v[k].lo) destino->v[k].lo = origem->v[k].lo;
+    if (origem->v[k].hi > destino->v[k].hi) destino->v[k].hi = origem->v[k].hi;
+  }
+}
+
+/* alargamento: limite que ainda cresce vai direto ao extremo, e o que
+   encolheu fica como estava. A volta ao TOPO no estouro não é monótona,
+   então sem isso o ponto fixo pode oscilar para sempre. */
+static void alarga(Estado *velho, Estado *novo)
+{
+  if (velho->morto) return;
+  if (novo->morto)
+  {
+    memcpy(novo->v, velho->v, sizeof(Intervalo) * nCelulas);
+    novo->morto = 0;
+    return;
+  }
+  for (int k = 0; k < nCelulas; k++)
+  {
+    novo->v[k].lo = (novo->v[k].lo < velho->v[k].lo) ? INT_MIN : velho->v[k].lo;
+    novo->v[k].hi = (novo->v[k].hi > velho->v[k].hi) ? INT_MAX : velho->v[k].hi;
+  }
+}
+
+static int iguais(Estado *a, Estado *b)
+{
+  if (a->morto != b->morto) return 0;
+  return a->morto || memcmp(a->v, b->v, sizeof(Intervalo) * nCelulas) == 0;
+}
+
+/* local escalar acompanhada pela análise? */
+static int rastreada(BucketList s)
+{
+  return s != NULL && s->scope != 0 && s->kind != ID_ARRAY && s->loc < nCelulas;
+}
+
+static int temEfeito(TreeNode *t)
+{
+  if (t == NULL) return 0;
+  if (t->tipoNo == NO_ATRIBUICAO || t->tipoNo == NO_CHAMADA) return 1;
+  for (TreeNode *c = t->filho; c != NULL; c = c->irmao)
+    if (temEfeito(c)) return 1;
+  return 0;
+}
+
+static void registra(TreeNode *acesso, Intervalo idx, Estado *e)
+{
+  BucketList a = acesso->filho->sym;
+  if (!registrando || e->morto || a == NULL || a->kind != ID_ARRAY) return;
+
+  st->acessos++;
+  /* parâmetro int x[]: o tamanho só se sabe em execução */
+  if (a->size <= 0) return;
+  if (idx.lo >= 0 && idx.hi < a->size)
+  {
+    acesso->verificaLimite = 0;
+    st->seguros++;
+  }
+  else if (idx.hi < 0 || idx.lo >= a->size)
+  {
+    st->fora++;
+    if (avisos == NULL)
+      return;
+    if (idx.lo == idx.hi)
+      fprintf(avisos, "AVISO: índice %lld fora dos limites de '%s' (tamanho %d). Linha %d.\n",
+              idx.lo, a->name, a->size, acesso->lineno);
+    else
+      fprintf(avisos, "AVISO: índice em [%lld, %lld] fora dos limites de '%s' (tamanho %d). Linha %d.\n",
+              idx.lo, idx.hi, a->name, a->size, acesso->lineno);
+  }
+}
+
+static Intervalo divide(Intervalo a, Intervalo b)
+{
+  /* divisor só positivo ou só negativo: o quociente é monótono em cada
+     argumento, os extremos saem dos cantos */
+  if (b.lo > 0 || b.hi < 0)
+  {
+    if (a.lo == INT_MIN && b.lo <= -1 && b.hi >= -1) return TOPO;
+    long long q[4] = { a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi };
+    long long lo = q[0], hi = q[0];
+    for (int k = 1; k < 4; k++)
+    {
+      if (q[k] < lo) lo = q[k];
+      if (q[k] > hi) hi = q[k];
+    }
+    return intervalo(lo, hi);
+  }
+  if (a.lo == INT_MIN) return TOPO;
+  /* divisor pode ser ±1 (ou zero, que é erro): |a / b| <= |a| */
+  long long m = (-a.lo > a.hi) ? -a.lo : a.hi;
+  return intervalo(-m, m);
+}
+
+static Intervalo avalia(TreeNode *t, Estado *e);
+
+static Intervalo aritmetica(TreeNode *t, Estado *e)
+{
+  Intervalo a = avalia(t->filho, e);
+  Intervalo b = avalia(t->filho->irmao, e);
+  char *op = t->attr.lexema;
+
+  if (t->tipoNo == NO_OP_REL) return intervalo(0, 1);
+  if (strcmp(op, "+") == 0) return intervalo(a.lo + b.lo, a.hi + b.hi);
+  if (strcmp(op, "-") == 0) return intervalo(a.lo - b.hi, a.hi - b.lo);
+  if (strcmp(op, "*") == 0)
+  {
+    long long p[4] = { a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi };
+    long long lo = p[0], hi = p[0];
+    for (int k = 1; k < 4; k++)
+    {
+      if (p[k] < lo) lo = p[k];
+      if (p[k] > hi) hi = p[k];
+    }
+    return intervalo(lo, hi);
+  }
+  return divide(a, b);
+}
+
+/* avalia a expressão na ordem da VM, aplicando as atribuições ao estado */
+static Intervalo avalia(TreeNode *t, Estado *e)
+{
+  switch (t->tipoNo)
+  {
+  case NO_NUM:
+  {
+    long long v = atoi(t->attr.lexema);
+    return intervalo(v, v);
+  }
+
+  case NO_VAR:
+    return rastreada(t->sym) ? e->v[t->sym->loc] : TOPO;
+
+  case NO_ARRAY_IDX:
+    registra(t, avalia(t->filho->irmao, e), e);
+    return TOPO;
+
+  case NO_ATRIBUICAO:
+  {
+    TreeNode *lhs = t->filho;
+    if (lhs->tipoNo == NO_ARRAY_IDX)
+    {
+      Intervalo idx = avalia(lhs->filho->irmao, e);
+      registra(lhs, idx, e);
+    }
+    Intervalo v = avalia(lhs->irmao, e);
+    if (lhs->tipoNo == NO_VAR && rastreada(lhs->sym)) e->v[lhs->sym->loc] = v;
+    return v;
+  }
+
+  case NO_OP_SOMA:
+  case NO_OP_MULT:
+  case NO_OP_REL:
+    return aritmetica(t, e);
+
+  case NO_CHAMADA:
+    /* chamadas não alteram locais escalares (só globais e arrays) */
+    for (TreeNode *a = t->filho; a != NULL; a = a->irmao)
+      avalia(a, e);
+    return TOPO;
+
+  default:
+    return TOPO;
+  }
+}
+
+/* restringe x pela relação x op [lo, hi] */
+static void restringe(Estado *e, BucketList x, const char *op, Intervalo o)
+{
+  Intervalo *v = &e->v[x->loc];
+  if (strcmp(op, "<") == 0) { if (o.hi - 1 < v->hi) v->hi = o.hi - 1; }
+  else if (strcmp(op, "<=") == 0) { if (o.hi < v->hi) v->hi = o.hi; }
+  else if (strcmp(op, ">") == 0) { if (o.lo + 1 > v->lo) v->lo = o.lo + 1; }
+  else if (strcmp(op, ">=") == 0) { if (o.lo > v->lo) v->lo = o.lo; }
+  else if (strcmp(op, "==") == 0)
+  {
+    if (o.lo > v->lo) v->lo = o.lo;
+    if (o.hi < v->hi) v->hi = o.hi;
+  }
+  else if (o.lo == o.hi)  /* != constante: só corta uma ponta */
+  {
+    if (v->lo == o.lo) v->lo++;
+    else if (v->hi == o.lo) v->hi--;
+  }
+  if (v->lo > v->hi) e->morto = 1;
+}
+
+static const char *negaOp(const char *op)
+{
+  if (strcmp(op, "<") == 0) return ">=";
+  if (strcmp(op, "<=") == 0) return ">";
+  if (strcmp(op, ">") == 0) return "<=";
+  if (strcmp(op, ">=") == 0) return "<";
+  if (strcmp(op, "==") == 0) return "!=";
+  return "==";
+}
+
+static const char *espelhaOp(const char *op)
+{
+  if (strcmp(op, "<") == 0) return ">";
+  if (strcmp(op, "<=") == 0) return ">=";
+  if (strcmp(op, ">") == 0) return "<";
+  if (strcmp(op, ">=") == 0) return "<=";
+  return op;
+}
+
+/* estado no ramo em que a condição (já avaliada) vale 'verdade' */
+static void refina(TreeNode *cond, Estado *e, int verdade)
+{
+  if (e->morto || cond->tipoNo != NO_OP_REL || temEfeito(cond)) return;
+  const char *op = verdade ? cond->attr.lexema : negaOp(cond->attr.lexema);
+  TreeNode *a = cond->filho;
+  TreeNode *b = a->irmao;
+  /* os acessos da condição já foram registrados na avaliação */
+  int antes = registrando;
+  registrando = 0;
+  Intervalo va = avalia(a, e);
+  Intervalo vb = avalia(b, e);
+  registrando = antes;
+  if (a->tipoNo == NO_VAR && rastreada(a->sym)) restringe(e, a->sym, op, vb);
+  if (!e->morto && b->tipoNo == NO_VAR && rastreada(b->sym)) restringe(e, b->sym, espelhaOp(op), va);
+}
+
+static void executa(TreeNode *t, Estado *e);
+
+static void laco(TreeNode *t, Estado *e)
+{
+  TreeNode *cond = t->filho;
+  TreeNode *corpo = cond->irmao;
+
+  /* ponto fixo na cabeça do laço, sem registrar acessos */
+  int antes = registrando;
+  registrando = 0;
+  Estado cabeca = copia(e);
+  for (int it = 0; ; it++)
+  {
+    Estado x = copia(&cabeca);
+    avalia(cond, &x);
+    refina(cond, &x, 1);
+    executa(corpo, &x);
+    Estado novo = copia(e);
+    junta(&novo, &x);
+    free(x.v);
+    if (it >= 2) alarga(&cabeca, &novo);
+    int fixo = iguais(&cabeca, &novo);
+    substitui(&cabeca, novo);
+    if (fixo) break;
+  }
+  registrando = antes;
+
+  /* passada final com o invariante: registra os acessos do corpo */
+  avalia(cond, &cabeca);
+  Estado dentro = copia(&cabeca);
+  refina(cond, &dentro, 1);
+  executa(corpo, &dentro);
+  free(dentro.v);
+  refina(cond, &cabeca, 0);
+  substitui(e, cabeca);
+}
+
+static void executa(TreeNode *t, Estado *e)
+{
+  if (t == NULL || e->morto) return;
+
+  switch (t->tipoNo)
+  {
+  case NO_DECLARACAO_VAR:
+    /* célula reaproveitada de outro bloco: valor desconhecido */
+    if (rastreada(t->sym)) e->v[t->sym->loc] = TOPO;
+    break;
+
+  case NO_BLOCO:
+    for (TreeNode *c = t->filho; c != NULL; c = c->irmao)
+      executa(c, e);
+    break;
+
+  case NO_IF:
+  {
+    TreeNode *entao = t->filho->irmao;
+    TreeNode *senao = (entao != NULL) ? entao->irmao : NULL;
+    avalia(t->filho, e);
+    Estado falso = copia(e);
+    refina(t->filho, e, 1);
+    executa(entao, e);
+    refina(t->filho, &falso, 0);
+    executa(senao, &falso);
+    junta(e, &falso);
+    free(falso.v);
+  }
+  break;
+
+  case NO_WHILE:
+    laco(t, e);
+    break;
+
+  case NO_RETURN:
+    if (t->filho != NULL) avalia(t->filho, e);
+    e->morto = 1;
+    break;
+
+  default:
+    avalia(t, e);
+    break;
+  }
+}
+
+void analisaLimites(TreeNode *arvore, LimitesStats *stats, FILE *saida)
+{
+  LimitesStats local;
+  st = (stats != NULL) ? stats : &local;
+  avisos = saida;
+  memset(st, 0, sizeof(LimitesStats));
+
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+  {
+    if (d->tipoNo != NO_DECLARACAO_FUN || d->sym == NULL) continue;
+    TreeNode *corpo = d->filho->irmao->irmao;
+    while (corpo != NULL && corpo->tipoNo != NO_BLOCO) corpo = corpo->irmao;
+
+    /* parâmetros e locais começam desconhecidos */
+    nCelulas = d->sym->frameSize;
+    registrando = 1;
+    Estado e = novoEstado();
+    executa(corpo, &e);
+    free(e.v);
+  }
+}
+
+int precisaTesteLimite(TreeNode *acesso)
+{
+  BucketList a = acesso->filho->sym;
+  return modoVerificado && acesso->verificaLimite && a != NULL && a->kind == ID_ARRAY;
+}
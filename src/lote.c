@@ -0,0 +1,182 @@
+#include "../include/lote.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+double loteRelogio(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void compilaUm(char *arquivo, LoteCompila compila, LoteArquivo *r)
+{
+  double t0 = loteRelogio();
+  r->ok = compila(arquivo, &r->linhas);
+  r->segundos = loteRelogio() - t0;
+}
+
+static void sequencial(char **arquivos, int n, LoteCompila compila, LoteRelata relata, LoteArquivo *res)
+{
+  for (int k = 0; k < n; k++)
+  {
+    compilaUm(arquivos[k], compila, &res[k]);
+    relata(arquivos[k], &res[k]);
+  }
+}
+
+/* --- Paralelo --- */
+
+/* memória compartilhada entre os trabalhadores */
+typedef struct
+{
+  int cursor;           /* próxima posição de 'ordem' a compilar */
+  LoteArquivo res[];
+} Compartilhado;
+
+static long *tamanhos;
+
+static int maiorPrimeiro(const void *a, const void *b)
+{
+  long ta = tamanhos[*(const int *) a], tb = tamanhos[*(const int *) b];
+  if (ta != tb) return ta < tb ? 1 : -1;
+  return *(const int *) a - *(const int *) b;
+}
+
+static void nomeCaptura(char *nome, size_t tam, const char *dir, int k, int fd)
+{
+  snprintf(nome, tam, "%s/%d.%d", dir, k, fd);
+}
+
+static void trabalhador(char **arquivos, int n, int *ordem, Compartilhado *sh,
+                        const char *dir, LoteCompila compila)
+{
+  char nome[4096];
+  for (;;)
+  {
+    int i = __atomic_fetch_add(&sh->cursor, 1, __ATOMIC_RELAXED);
+    if (i >= n) break;
+    int k = ordem[i];
+
+    /* stdout e stderr do arquivo vão para dir/k.1 e dir/k.2 */
+    for (int fd = 1; fd <= 2; fd++)
+    {
+      nomeCaptura(nome, sizeof(nome), dir, k, fd);
+      int c = open(nome, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+      if (c >= 0)
+      {
+        dup2(c, fd);
+        close(c);
+      }
+    }
+
+    LoteArquivo r;
+    compilaUm(arquivos[k], compila, &r);
+    fflush(stdout);
+    fflush(stderr);
+    sh->res[k] = r;
+  }
+}
+
+/* copia a captura para fd e apaga o arquivo */
+static void despeja(const char *dir, int k, int fd)
+{
+  char nome[4096], buf[65536];
+  nomeCaptura(nome, sizeof(nome), dir, k, fd);
+  int c = open(nome, O_RDONLY);
+  if (c < 0) return;
+  ssize_t lidos;
+  while ((lidos = read(c, buf, sizeof(buf))) > 0)
+  {
+    ssize_t escritos = 0;
+    while (escritos < lidos)
+    {
+      ssize_t w = write(fd, buf + escritos, lidos - escritos);
+      if (w <= 0) break;
+      escritos += w;
+    }
+  }
+  close(c);
+  unlink(nome);
+}
+
+static void paralelo(char **arquivos, int n, int trabalhadores,
+                     LoteCompila compila, LoteRelata relata, LoteArquivo *res)
+{
+  /* maior primeiro: um arquivo grande no fim deixaria os outros parados */
+  int *ordem = (int *) malloc(sizeof(int) * n);
+  tamanhos = (long *) malloc(sizeof(long) * n);
+  for (int k = 0; k < n; k++)
+  {
+    struct stat st;
+    ordem[k] = k;
+    tamanhos[k] = stat(arquivos[k], &st) == 0 ? (long) st.st_size : 0;
+  }
+  qsort(ordem, n, sizeof(int), maiorPrimeiro);
+  free(tamanhos);
+  tamanhos = NULL;
+
+  size_t tam = sizeof(Compartilhado) + sizeof(LoteArquivo) * n;
+  Compartilhado *sh = (Compartilhado *) mmap(NULL, tam, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  char dir[] = "/tmp/cminus-lote-XXXXXX";
+  if (sh == MAP_FAILED || mkdtemp(dir) == NULL)
+  {
+    perror("Erro ao preparar o lote paralelo");
+    if (sh != MAP_FAILED) munmap(sh, tam);
+    free(ordem);
+    sequencial(arquivos, n, compila, relata, res);
+    return;
+  }
+  sh->cursor = 0;
+  /* um arquivo cujo trabalhador morreu no meio fica como erro */
+  memset(sh->res, 0, sizeof(LoteArquivo) * n);
+
+  fflush(stdout);
+  fflush(stderr);
+  pid_t *pids = (pid_t *) malloc(sizeof(pid_t) * trabalhadores);
+  int vivos = 0;
+  for (int w = 0; w < trabalhadores; w++)
+  {
+    pids[w] = fork();
+    if (pids[w] == 0)
+    {
+      trabalhador(arquivos, n, ordem, sh, dir, compila);
+      _exit(0);
+    }
+    if (pids[w] < 0) perror("Erro ao criar trabalhador");
+    else vivos++;
+  }
+  for (int w = 0; w < trabalhadores; w++)
+    if (pids[w] > 0) waitpid(pids[w], NULL, 0);
+
+  for (int k = 0; k < n; k++)
+  {
+    despeja(dir, k, 1);
+    despeja(dir, k, 2);
+    /* sem nenhum trabalhador, compila aqui mesmo */
+    if (vivos == 0) compilaUm(arquivos[k], compila, &sh->res[k]);
+    res[k] = sh->res[k];
+    relata(arquivos[k], &res[k]);
+  }
+  rmdir(dir);
+
+  free(pids);
+  free(ordem);
+  munmap(sh, tam);
+}
+
+void loteExecuta(char **arquivos, int n, int trabalhadores,
+                 LoteCompila compila, LoteRelata relata, LoteArquivo *res)
+{
+  if (trabalhadores > n) trabalhadores = n;
+  if (trabalhadores <= 1) sequencial(arquivos, n, compila, relata, res);
+  else paralelo(arquivos, n, trabalhadores, compila, relata, res);
+}
@@ -0,0 +1,990 @@
+#include "../include/lsp.h"
+#include "../include/json.h"
+#include "../include/arvore.h"
+#include "../include/analyze.h"
+#include "../include/symtab.h"
+#include "../include/diagnostico.h"
+#include "../include/incremental.h"
+#include "../include/lote.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <strings.h>
+#include <unistd.h>
+
+extern int yyparse(void);
+extern int yylineno;
+extern void lexReinicia(FILE *f);
+
+/* uma mensagem maior que isto encerra o servidor */
+#define LSP_MAX_MENSAGEM (256L << 20)
+
+/* --- Diagnósticos --- */
+
+typedef struct
+{
+  int linha;
+  char *mensagem;       /* sem o '\n' */
+} Erro;
+
+typedef struct
+{
+  Erro *e;
+  int n, cap;
+} Erros;
+
+static void coleta(void *ctx, DiagTipo tipo, int linha, const char *mensagem)
+{
+  (void) tipo;
+  Erros *l = (Erros *) ctx;
+  if (l->n == l->cap)
+  {
+    l->cap = l->cap ? l->cap * 2 : 8;
+    l->e = (Erro *) realloc(l->e, sizeof(Erro) * l->cap);
+  }
+  size_t n = strlen(mensagem);
+  while (n > 0 && mensagem[n - 1] == '\n') n--;
+  l->e[l->n].linha = linha;
+  l->e[l->n].mensagem = strndup(mensagem, n);
+  l->n++;
+}
+
+static void limpaErros(Erros *l)
+{
+  for (int i = 0; i < l->n; i++) free(l->e[i].mensagem);
+  l->n = 0;
+}
+
+/* --- Documentos --- */
+
+typedef struct
+{
+  size_t inicio, fim;   /* bytes [inicio, fim) do texto */
+  int linha;            /* linha do primeiro byte */
+  int vazio;            /* só espaços e comentários: não é analisado */
+  TreeNode *decls;      /* declarações, com linhas absolutas */
+  TreeNode *ultima;     /* a última; o 'irmao' dela aponta para o pedaço seguinte */
+  int nDecls;
+  uint64_t *hashes;     /* incrementalHashArvore de cada declaração */
+  int atraso;           /* linhas ainda não somadas abaixo das declarações */
+  Erros erros;          /* léxicos e sintáticos */
+} Pedaco;
+
+typedef struct
+{
+  char *uri;
+  char *texto;
+  size_t tam, cap;
+  Pedaco *p;
+  int n, capP;
+  Incremental *inc;
+  Erros semanticos;
+} Documento;
+
+static Documento **docs = NULL;
+static int nDocs = 0;
+
+/* documento cujas globais estão na tabela de símbolos */
+static Documento *analisado = NULL;
+
+static Documento *procuraDoc(const char *uri)
+{
+  for (int i = 0; i < nDocs; i++)
+    if (strcmp(docs[i]->uri, uri) == 0) return docs[i];
+  return NULL;
+}
+
+static void liberaDecls(Pedaco *p)
+{
+  for (TreeNode *d = p->decls; d != NULL;)
+  {
+    TreeNode *prox = d->irmao;
+    liberaArvore(d);
+    if (d == p->ultima) break;
+    d = prox;
+  }
+  p->decls = p->ultima = NULL;
+  p->nDecls = 0;
+  free(p->hashes);
+  p->hashes = NULL;
+}
+
+static void liberaPedaco(Pedaco *p)
+{
+  liberaDecls(p);
+  limpaErros(&p->erros);
+  free(p->erros.e);
+}
+
+/* --- Pedaços --- */
+
+/* Fim do pedaço que começa em 'i': depois de '}' ou ';' com profundidade
+   zero, fora de comentários (como a pré-varredura de particao.c). Um '}'
+   sobrando também corta, para o erro ficar só no seu pedaço. */
+static size_t corte(const char *t, size_t tam, size_t i, int *vazio)
+{
+  int prof = 0, comentario = 0;
+  *vazio = 1;
+  for (; i < tam; i++)
+  {
+    char c = t[i];
+    if (comentario)
+    {
+      if (c == '*' && i + 1 < tam && t[i + 1] == '/')
+      {
+        comentario = 0;
+        i++;
+      }
+      continue;
+    }
+    if (c == '/' && i + 1 < tam && t[i + 1] == '*')
+    {
+      comentario = 1;
+      i++;
+      continue;
+    }
+    if (c == ' ' || c == '\t' || c == '\n') continue;
+    *vazio = 0;
+    if (c == '{') prof++;
+    else if (c == '}' && --prof <= 0) return i + 1;
+    else if (c == ';' && prof == 0) return i + 1;
+  }
+  /* um comentário não fechado é erro léxico */
+  if (comentario) *vazio = 0;
+  return tam;
+}
+
+static int contaLinhas(const char *t, size_t n)
+{
+  int linhas = 0;
+  const char *fim = t + n;
+  while ((t = (const char *) memchr(t, '\n', (size_t) (fim - t))) != NULL)
+  {
+    linhas++;
+    t++;
+  }
+  return linhas;
+}
+
+static void analisaPedaco(Documento *d, Pedaco *p)
+{
+  liberaDecls(p);
+  limpaErros(&p->erros);
+  p->atraso = 0;
+  if (p->vazio) return;
+
+  FILE *f = fmemopen(d->texto + p->inicio, p->fim - p->inicio, "r");
+  if (f == NULL) return;
+  diagInstala(coleta, &p->erros);
+  lexReinicia(f);
+  yylineno = p->linha;
+  raizArvore = NULL;
+  /* um erro léxico encerra a leitura, mas o que veio antes dele pode ter
+     sido aceito */
+  if (yyparse() == 0 && raizArvore != NULL)
+  {
+    p->decls = raizArvore->filho;
+    raizArvore->filho = NULL;
+    liberaArvore(raizArvore);
+    for (TreeNode *t = p->decls; t != NULL; t = t->irmao)
+    {
+      p->ultima = t;
+      p->nDecls++;
+    }
+    p->hashes = (uint64_t *) malloc(sizeof(uint64_t) * (p->nDecls > 0 ? p->nDecls : 1));
+    int i = 0;
+    for (TreeNode *t = p->decls; t != NULL; t = t->irmao) p->hashes[i++] = incrementalHashArvore(t);
+  }
+  raizArvore = NULL;
+  diagInstala(NULL, NULL);
+  fclose(f);
+}
+
+static void deslocaArvore(TreeNode *t, int d)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    t->lineno += d;
+    deslocaArvore(t->filho, d);
+  }
+}
+
+/* Um pedaço que não mudou de texto, só de lugar. Só as declarações de topo
+   (o que a análise incremental lê de uma função que vem do cache) mudam de
+   linha agora; o resto da árvore espera em 'atraso' até alguém precisar
+   dele (acertaPedaco). Um Enter no começo de um arquivo grande não percorre
+   todas as árvores. */
+static void deslocaPedaco(Documento *d, Pedaco *p, long bytes, int linhas)
+{
+  p->inicio = (size_t) ((long) p->inicio + bytes);
+  p->fim = (size_t) ((long) p->fim + bytes);
+  if (linhas == 0) return;
+  p->linha += linhas;
+  for (TreeNode *t = p->decls; t != NULL; t = t->irmao)
+  {
+    t->lineno += linhas;
+    if (t == p->ultima) break;
+  }
+  p->atraso += linhas;
+  /* as mensagens trazem o número da linha: é mais simples reler */
+  if (p->erros.n > 0) analisaPedaco(d, p);
+}
+
+static void acertaPedaco(Pedaco *p)
+{
+  if (p->atraso == 0) return;
+  for (TreeNode *t = p->decls; t != NULL; t = t->irmao)
+  {
+    deslocaArvore(t->filho, p->atraso);
+    if (t == p->ultima) break;
+  }
+  p->atraso = 0;
+}
+
+/* primeiro pedaço que termina depois de 'pos' (o último, se nenhum) */
+static int pedacoDe(Documento *d, size_t pos)
+{
+  int lo = 0, hi = d->n - 1;
+  while (lo < hi)
+  {
+    int meio = (lo + hi) / 2;
+    if (d->p[meio].fim > pos) hi = meio;
+    else lo = meio + 1;
+  }
+  return lo;
+}
+
+typedef struct
+{
+  int relidos;          /* pedaços analisados sintaticamente de novo */
+  int funcoes, verificadas;
+} Atualizacao;
+
+/* Troca os bytes [a, b) do texto por 'novo' e refaz os pedaços afetados */
+static void edita(Documento *d, size_t a, size_t b, const char *novo, size_t nNovo, Atualizacao *at)
+{
+  if (a > d->tam) a = d->tam;
+  if (b > d->tam) b = d->tam;
+  if (b < a) b = a;
+  long delta = (long) nNovo - (long) (b - a);
+  int dLinhas = contaLinhas(novo, nNovo) - contaLinhas(d->texto + a, b - a);
+
+  if (d->tam + nNovo + 1 > d->cap + (b - a))
+  {
+    d->cap = (d->tam + nNovo - (b - a)) * 2 + 1;
+    d->texto = (char *) realloc(d->texto, d->cap);
+  }
+  memmove(d->texto + a + nNovo, d->texto + b, d->tam - b);
+  memcpy(d->texto + a, novo, nNovo);
+  d->tam = (size_t) ((long) d->tam + delta);
+  d->texto[d->tam] = '\0';
+
+  /* a varredura recomeça no pedaço da edição: o estado no início dele
+     (profundidade zero, fora de comentário) não depende do resto */
+  int s = (d->n > 0) ? pedacoDe(d, a) : 0;
+  size_t pos = (d->n > 0) ? d->p[s].inicio : 0;
+  int linha = (d->n > 0) ? d->p[s].linha : 1;
+  Pedaco *novos = NULL;
+  int nNovos = 0, capNovos = 0, j = s, sincronizou = 0;
+  while (pos < d->tam)
+  {
+    if (nNovos == capNovos)
+    {
+      capNovos = capNovos ? capNovos * 2 : 8;
+      novos = (Pedaco *) realloc(novos, sizeof(Pedaco) * capNovos);
+    }
+    Pedaco *p = &novos[nNovos++];
+    memset(p, 0, sizeof(*p));
+    p->inicio = pos;
+    p->fim = corte(d->texto, d->tam, pos, &p->vazio);
+    p->linha = linha;
+    linha += contaLinhas(d->texto + pos, p->fim - pos);
+    pos = p->fim;
+
+    /* depois do trecho editado, um corte que já existia antes: daí em
+       diante o texto e os cortes são os mesmos */
+    if (pos < a + nNovo) continue;
+    while (j < d->n && ((long) d->p[j].inicio < (long) b || (long) d->p[j].inicio + delta < (long) pos)) j++;
+    if (j < d->n && (long) d->p[j].inicio + delta == (long) pos)
+    {
+      sincronizou = 1;
+      break;
+    }
+  }
+  if (!sincronizou) j = d->n;
+
+  for (int k = s; k < j; k++) liberaPedaco(&d->p[k]);
+  int n = d->n - (j - s) + nNovos;
+  if (n > d->capP)
+  {
+    d->capP = n * 2;
+    d->p = (Pedaco *) realloc(d->p, sizeof(Pedaco) * d->capP);
+  }
+  memmove(&d->p[s + nNovos], &d->p[j], sizeof(Pedaco) * (d->n - j));
+  memcpy(&d->p[s], novos, sizeof(Pedaco) * nNovos);
+  free(novos);
+  d->n = n;
+
+  for (int k = s; k < s + nNovos; k++) analisaPedaco(d, &d->p[k]);
+  for (int k = s + nNovos; k < n; k++) deslocaPedaco(d, &d->p[k], delta, dLinhas);
+  at->relidos += nNovos;
+}
+
+/* antes de verificar uma função: o pedaço dela com as linhas em dia */
+static void prepara(TreeNode *decl, void *ctx)
+{
+  Documento *d = (Documento *) ctx;
+  /* o último pedaço que começa até a linha da declaração, ou um anterior
+     na mesma linha */
+  int lo = 0, hi = d->n - 1, k = 0;
+  while (lo <= hi)
+  {
+    int meio = (lo + hi) / 2;
+    if (d->p[meio].linha <= decl->lineno)
+    {
+      k = meio;
+      lo = meio + 1;
+    }
+    else
+    {
+      hi = meio - 1;
+    }
+  }
+  for (; k >= 0; k--)
+  {
+    for (TreeNode *t = d->p[k].decls; t != NULL; t = t->irmao)
+    {
+      if (t == decl)
+      {
+        acertaPedaco(&d->p[k]);
+        return;
+      }
+      if (t == d->p[k].ultima) break;
+    }
+  }
+}
+
+/* diretório de um uri file:// (onde import procura as interfaces), ou
+   NULL para o diretório corrente */
+static char *diretorioDoUri(const char *uri)
+{
+  if (strncmp(uri, "file://", 7) != 0) return NULL;
+  const char *c = uri + 7;
+  const char *barra = strrchr(c, '/');
+  if (barra == NULL) return NULL;
+  char *dir = (char *) malloc(barra - c + 1);
+  size_t n = 0;
+  for (; c < barra; c++)
+  {
+    unsigned int x;
+    if (*c == '%' && barra - c > 2 && sscanf(c + 1, "%2x", &x) == 1)
+    {
+      dir[n++] = (char) x;
+      c += 2;
+    }
+    else
+    {
+      dir[n++] = *c;
+    }
+  }
+  dir[n] = '\0';
+  return dir;
+}
+
+/* Semântica do documento inteiro, com o cache da análise anterior */
+static void analisaDocumento(Documento *d, Atualizacao *at)
+{
+  int total = 0;
+  for (int k = 0; k < d->n; k++) total += d->p[k].nDecls;
+  uint64_t *hashes = (uint64_t *) malloc(sizeof(uint64_t) * (total > 0 ? total : 1));
+  TreeNode *lista = NULL, *ultima = NULL;
+  int i = 0;
+  for (int k = 0; k < d->n; k++)
+  {
+    Pedaco *p = &d->p[k];
+    if (p->decls == NULL) continue;
+    if (ultima != NULL) ultima->irmao = p->decls;
+    else lista = p->decls;
+    ultima = p->ultima;
+    memcpy(hashes + i, p->hashes, sizeof(uint64_t) * p->nDecls);
+    i += p->nDecls;
+  }
+  if (ultima != NULL) ultima->irmao = NULL;
+
+  limpaErros(&d->semanticos);
+  diagInstala(coleta, &d->semanticos);
+  imprimeTabela = 0;
+  IncrementalStats st;
+  char *dir = diretorioDoUri(d->uri);
+  analyzeDiretorio(dir);
+  incrementalVerifica(d->inc, lista, hashes, prepara, d, &st);
+  analyzeTermina();
+  analyzeDiretorio(NULL);
+  free(dir);
+  diagInstala(NULL, NULL);
+  free(hashes);
+  analisado = d;
+  if (at != NULL)
+  {
+    at->funcoes = st.funcoes;
+    at->verificadas = st.funcoes - st.acertos;
+  }
+}
+
+/* --- Posições: linhas a partir de 0, colunas em unidades UTF-16 --- */
+
+/* byte onde começa a linha 'linha' (a primeira é 1) */
+static size_t inicioDaLinha(Documento *d, int linha)
+{
+  /* último pedaço que começa antes dela */
+  int lo = 0, hi = d->n - 1, k = -1;
+  while (lo <= hi)
+  {
+    int meio = (lo + hi) / 2;
+    if (d->p[meio].linha < linha)
+    {
+      k = meio;
+      lo = meio + 1;
+    }
+    else
+    {
+      hi = meio - 1;
+    }
+  }
+  size_t i = (k >= 0) ? d->p[k].inicio : 0;
+  int l = (k >= 0) ? d->p[k].linha : 1;
+  while (l < linha)
+  {
+    const char *nl = (const char *) memchr(d->texto + i, '\n', d->tam - i);
+    if (nl == NULL) return d->tam;
+    i = (size_t) (nl - d->texto) + 1;
+    l++;
+  }
+  return i;
+}
+
+static int tamUtf8(unsigned char c)
+{
+  return c < 0xC0 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+}
+
+static size_t deslocamento(Documento *d, const Json *posicao)
+{
+  int linha = jsonInt(jsonCampo(posicao, "line"), 0);
+  int coluna = jsonInt(jsonCampo(posicao, "character"), 0);
+  size_t i = inicioDaLinha(d, linha + 1);
+  while (coluna > 0 && i < d->tam && d->texto[i] != '\n')
+  {
+    int n = tamUtf8((unsigned char) d->texto[i]);
+    coluna -= (n == 4) ? 2 : 1;
+    i += (size_t) n;
+  }
+  return i < d->tam ? i : d->tam;
+}
+
+static int coluna(Documento *d, size_t inicioLinha, size_t i)
+{
+  int c = 0;
+  for (size_t k = inicioLinha; k < i && k < d->tam;)
+  {
+    int n = tamUtf8((unsigned char) d->texto[k]);
+    c += (n == 4) ? 2 : 1;
+    k += (size_t) n;
+  }
+  return c;
+}
+
+/* --- Mensagens --- */
+
+static FILE *saida;
+
+static void envia(JsonSaida *s)
+{
+  fprintf(saida, "Content-Length: %zu\r\n\r\n", s->n);
+  fwrite(s->p, 1, s->n, saida);
+  fflush(saida);
+  jsonLiberaSaida(s);
+}
+
+static void iniciaResposta(JsonSaida *s, const Json *id)
+{
+  jsonPoe(s, "{\"jsonrpc\":\"2.0\",\"id\":");
+  jsonPoeValor(s, id);
+  jsonPoe(s, ",\"result\":");
+}
+
+static void respondeErro(const Json *id, int codigo, const char *mensagem)
+{
+  JsonSaida s = { NULL, 0, 0 };
+  jsonPoe(&s, "{\"jsonrpc\":\"2.0\",\"id\":");
+  jsonPoeValor(&s, id);
+  jsonPoe(&s, ",\"error\":{\"code\":%d,\"message\":", codigo);
+  jsonPoeTexto(&s, mensagem);
+  jsonPoe(&s, "}}");
+  envia(&s);
+}
+
+static void poeDiagnostico(JsonSaida *s, int *primeiro, const Erro *e)
+{
+  int l = e->linha > 0 ? e->linha - 1 : 0;
+  jsonPoe(s, "%s{\"range\":{\"start\":{\"line\":%d,\"character\":0},\"end\":{\"line\":%d,\"character\":0}},"
+          "\"severity\":1,\"source\":\"cminus\",\"message\":", *primeiro ? "" : ",", l, l + 1);
+  jsonPoeTexto(s, e->mensagem);
+  jsonPoe(s, "}");
+  *primeiro = 0;
+}
+
+static void publica(const char *uri, Documento *d)
+{
+  JsonSaida s = { NULL, 0, 0 };
+  jsonPoe(&s, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+  jsonPoeTexto(&s, uri);
+  jsonPoe(&s, ",\"diagnostics\":[");
+  int primeiro = 1;
+  for (int k = 0; d != NULL && k < d->n; k++)
+    for (int i = 0; i < d->p[k].erros.n; i++) poeDiagnostico(&s, &primeiro, &d->p[k].erros.e[i]);
+  for (int i = 0; d != NULL && i < d->semanticos.n; i++) poeDiagnostico(&s, &primeiro, &d->semanticos.e[i]);
+  jsonPoe(&s, "]}}");
+  envia(&s);
+}
+
+/* --- Símbolo sob o cursor --- */
+
+typedef struct
+{
+  char *nome;
+  int linha, escopo, tamanho, numParams;
+  ExpType tipo;
+  IdKind kind;
+} Simbolo;
+
+static int letra(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static int letraOuDigito(char c)
+{
+  return letra(c) || (c >= '0' && c <= '9');
+}
+
+static void limpaSimbolos(TreeNode *t)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    t->sym = NULL;
+    limpaSimbolos(t->filho);
+  }
+}
+
+/* o primeiro uso ou declaração de 'nome' na linha com símbolo resolvido */
+static BucketList procuraNo(TreeNode *t, TreeNode *pai, const char *nome, int linha)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    if ((t->tipoNo == NO_VAR || t->tipoNo == NO_CHAMADA || t->tipoNo == NO_ID) && t->lineno == linha &&
+        t->attr.lexema != NULL && strcmp(t->attr.lexema, nome) == 0)
+    {
+      if (t->sym != NULL) return t->sym;
+      if (t->tipoNo == NO_ID && pai != NULL && pai->sym != NULL &&
+          (pai->tipoNo == NO_DECLARACAO_VAR || pai->tipoNo == NO_DECLARACAO_FUN || pai->tipoNo == NO_PARAM))
+        return pai->sym;
+    }
+    BucketList b = procuraNo(t->filho, t, nome, linha);
+    if (b != NULL) return b;
+  }
+  return NULL;
+}
+
+static void copiaSimbolo(Simbolo *s, BucketList b)
+{
+  s->linha = b->lineno;
+  s->escopo = b->scope;
+  s->tamanho = b->size;
+  s->numParams = b->numParams;
+  s->tipo = b->type;
+  s->kind = b->kind;
+}
+
+/* Resolve o identificador em 'pos' como a análise semântica o resolve: uma
+   função é inserida e verificada de novo (com as locais) só para a
+   consulta. Devolve 0 se não há identificador ou ele não tem símbolo. */
+static int simboloEm(Documento *d, size_t pos, Simbolo *s)
+{
+  size_t i = pos, f = pos;
+  while (i > 0 && letraOuDigito(d->texto[i - 1])) i--;
+  while (f < d->tam && letraOuDigito(d->texto[f])) f++;
+  while (i < f && !letra(d->texto[i])) i++;
+  if (i == f || d->n == 0) return 0;
+  s->nome = strndup(d->texto + i, f - i);
+  Pedaco *p = &d->p[pedacoDe(d, i)];
+  int linha = p->linha + contaLinhas(d->texto + p->inicio, i - p->inicio);
+
+  if (analisado != d) analisaDocumento(d, NULL);
+  acertaPedaco(p);
+
+  /* a declaração de topo que contém a linha */
+  TreeNode *decl = NULL;
+  for (TreeNode *t = p->decls; t != NULL; t = t->irmao)
+  {
+    if (t->lineno <= linha || decl == NULL) decl = t;
+    if (t == p->ultima) break;
+  }
+
+  BucketList b = NULL;
+  int achou = 0;
+  if (decl != NULL && decl->tipoNo == NO_DECLARACAO_FUN && decl->sym != NULL)
+  {
+    limpaSimbolos(decl->filho);
+    analyzeFuncao(decl);
+    analyzeLiberaRetidos();
+    b = procuraNo(decl->filho, decl, s->nome, linha);
+    if (b != NULL)
+    {
+      copiaSimbolo(s, b);
+      achou = 1;
+    }
+    analyzeDescarta(decl);
+  }
+  /* fora de funções (ou num pedaço com erro de sintaxe), as globais */
+  if (!achou && (b = st_lookup_rec(s->nome)) != NULL)
+  {
+    copiaSimbolo(s, b);
+    achou = 1;
+  }
+  if (!achou)
+  {
+    free(s->nome);
+    s->nome = NULL;
+  }
+  return achou;
+}
+
+/* Primeira ocorrência de 'nome' como palavra inteira em [i, fim), fora
+   de comentários; 'fim' se não há */
+static size_t procuraNome(Documento *d, size_t i, size_t fim, const char *nome)
+{
+  size_t tn = strlen(nome);
+  const char *t = d->texto;
+  while (i < fim)
+  {
+    if (t[i] == '/' && i + 1 < fim && t[i + 1] == '*')
+    {
+      const char *f = strstr(t + i + 2, "*/");
+      i = (f != NULL) ? (size_t) (f - t) + 2 : fim;
+      continue;
+    }
+    if (!letra(t[i]))
+    {
+      i++;
+      continue;
+    }
+    size_t k = i;
+    while (k < fim && letraOuDigito(t[k])) k++;
+    if (k - i == tn && memcmp(t + i, nome, tn) == 0) return i;
+    i = k;
+  }
+  return fim;
+}
+
+/* Onde o nome do símbolo aparece na declaração: a linha do registro na
+   tabela, e, se o nome não está nela (a linha de uma função é a do seu
+   '}'), o pedaço dessa linha. Devolve o byte do nome (d->tam se não achou)
+   e corrige s->linha. */
+static size_t localiza(Documento *d, Simbolo *s)
+{
+  size_t ini = inicioDaLinha(d, s->linha), fim = ini;
+  while (fim < d->tam && d->texto[fim] != '\n') fim++;
+  size_t k = procuraNome(d, ini, fim, s->nome);
+  if (k < fim || ini >= d->tam) return k < fim ? k : d->tam;
+  Pedaco *p = &d->p[pedacoDe(d, ini)];
+  k = procuraNome(d, p->inicio, p->fim, s->nome);
+  if (k == p->fim) return d->tam;
+  s->linha = p->linha + contaLinhas(d->texto + p->inicio, k - p->inicio);
+  return k;
+}
+
+static const char *nomeTipo(ExpType t)
+{
+  return t == Integer ? "INT" : t == Void ? "VOID" : "BOOL";
+}
+
+static const char *nomeKind(IdKind k)
+{
+  return k == ID_VAR ? "VAR" : k == ID_FUN ? "FUN" : "ARRAY";
+}
+
+static void hover(Documento *d, const Json *params, const Json *id)
+{
+  JsonSaida s = { NULL, 0, 0 };
+  iniciaResposta(&s, id);
+  Simbolo sim;
+  sim.nome = NULL;
+  if (d == NULL || !simboloEm(d, deslocamento(d, jsonCampo(params, "position")), &sim))
+  {
+    jsonPoe(&s, "null}");
+    envia(&s);
+    return;
+  }
+  char texto[256];
+  int n = snprintf(texto, sizeof(texto), "`%s`: %s %s", sim.nome, nomeKind(sim.kind), nomeTipo(sim.tipo));
+  if (sim.kind == ID_FUN) n += snprintf(texto + n, sizeof(texto) - n, ", %d parâmetro(s)", sim.numParams);
+  else if (sim.kind == ID_ARRAY && sim.tamanho > 0) n += snprintf(texto + n, sizeof(texto) - n, "[%d]", sim.tamanho);
+  if (sim.linha > 0)
+  {
+    localiza(d, &sim);
+    snprintf(texto + n, sizeof(texto) - n, ", %s, linha %d", sim.escopo == 0 ? "global" : "local", sim.linha);
+  }
+  else
+  {
+    snprintf(texto + n, sizeof(texto) - n, ", predefinida");
+  }
+  jsonPoe(&s, "{\"contents\":{\"kind\":\"markdown\",\"value\":");
+  jsonPoeTexto(&s, texto);
+  jsonPoe(&s, "}}}");
+  envia(&s);
+  free(sim.nome);
+}
+
+static void definicao(Documento *d, const char *uri, const Json *params, const Json *id)
+{
+  JsonSaida s = { NULL, 0, 0 };
+  iniciaResposta(&s, id);
+  Simbolo sim;
+  sim.nome = NULL;
+  /* as predefinidas (linha 0) não têm onde ir */
+  if (d == NULL || !simboloEm(d, deslocamento(d, jsonCampo(params, "position")), &sim) || sim.linha <= 0)
+  {
+    free(sim.nome);
+    jsonPoe(&s, "null}");
+    envia(&s);
+    return;
+  }
+  size_t k = localiza(d, &sim), ini = inicioDaLinha(d, sim.linha);
+  int c = 0, largura = 0;
+  if (k < d->tam)
+  {
+    c = coluna(d, ini, k);
+    largura = (int) strlen(sim.nome);
+  }
+  jsonPoe(&s, "{\"uri\":");
+  jsonPoeTexto(&s, uri);
+  jsonPoe(&s, ",\"range\":{\"start\":{\"line\":%d,\"character\":%d},\"end\":{\"line\":%d,\"character\":%d}}}}",
+          sim.linha - 1, c, sim.linha - 1, c + largura);
+  envia(&s);
+  free(sim.nome);
+}
+
+/* --- Documentos abertos --- */
+
+static Documento *abre(const char *uri)
+{
+  Documento *d = (Documento *) calloc(1, sizeof(Documento));
+  d->uri = strdup(uri);
+  d->cap = 1;
+  d->texto = (char *) malloc(d->cap);
+  d->texto[0] = '\0';
+  d->inc = incrementalCria();
+  docs = (Documento **) realloc(docs, sizeof(Documento *) * (nDocs + 1));
+  docs[nDocs++] = d;
+  return d;
+}
+
+static void fecha(Documento *d)
+{
+  for (int i = 0; i < nDocs; i++)
+  {
+    if (docs[i] != d) continue;
+    docs[i] = docs[--nDocs];
+    break;
+  }
+  /* a tabela de símbolos não aponta para as árvores: só deixa de valer */
+  if (analisado == d) analisado = NULL;
+  for (int k = 0; k < d->n; k++) liberaPedaco(&d->p[k]);
+  free(d->p);
+  free(d->texto);
+  free(d->uri);
+  limpaErros(&d->semanticos);
+  free(d->semanticos.e);
+  incrementalLibera(d->inc);
+  free(d);
+}
+
+/* Texto inteiro novo (abertura, ou edição sem intervalo): vira uma edição
+   do trecho entre o prefixo e o sufixo que não mudaram */
+static void substitui(Documento *d, const char *texto, Atualizacao *at)
+{
+  size_t n = strlen(texto), pre = 0, suf = 0;
+  while (pre < n && pre < d->tam && texto[pre] == d->texto[pre]) pre++;
+  while (suf < n - pre && suf < d->tam - pre && texto[n - 1 - suf] == d->texto[d->tam - 1 - suf]) suf++;
+  edita(d, pre, d->tam - suf, texto + pre, n - pre - suf, at);
+}
+
+static void mudancas(Documento *d, const Json *lista, Atualizacao *at)
+{
+  for (const Json *c = (lista != NULL) ? lista->filho : NULL; c != NULL; c = c->irmao)
+  {
+    const char *texto = jsonTexto(jsonCampo(c, "text"));
+    if (texto == NULL) continue;
+    const Json *intervalo = jsonCampo(c, "range");
+    if (intervalo == NULL)
+    {
+      substitui(d, texto, at);
+      continue;
+    }
+    size_t a = deslocamento(d, jsonCampo(intervalo, "start"));
+    size_t b = deslocamento(d, jsonCampo(intervalo, "end"));
+    edita(d, a, b, texto, strlen(texto), at);
+  }
+}
+
+/* --- Laço principal --- */
+
+/* cabeçalhos até a linha vazia, depois Content-Length bytes */
+static char *leMensagem(size_t *tam)
+{
+  char *linha = NULL;
+  size_t capLinha = 0;
+  long n = -1;
+  for (;;)
+  {
+    if (getline(&linha, &capLinha, stdin) < 0)
+    {
+      free(linha);
+      return NULL;
+    }
+    if (strcmp(linha, "\r\n") == 0 || strcmp(linha, "\n") == 0)
+    {
+      if (n >= 0) break;
+      continue;
+    }
+    if (strncasecmp(linha, "Content-Length:", 15) == 0) n = atol(linha + 15);
+  }
+  free(linha);
+  if (n > LSP_MAX_MENSAGEM) return NULL;
+  char *corpo = (char *) malloc((size_t) n + 1);
+  if (fread(corpo, 1, (size_t) n, stdin) != (size_t) n)
+  {
+    free(corpo);
+    return NULL;
+  }
+  corpo[n] = '\0';
+  *tam = (size_t) n;
+  return corpo;
+}
+
+static void responde(const Json *id, const char *resultado)
+{
+  JsonSaida s = { NULL, 0, 0 };
+  iniciaResposta(&s, id);
+  jsonPoe(&s, "%s}", resultado);
+  envia(&s);
+}
+
+int lspExecuta(int stats)
+{
+  /* o protocolo fica com o stdout original; qualquer outra saída vai para
+     stderr */
+  int fd = dup(1);
+  saida = (fd >= 0) ? fdopen(fd, "w") : NULL;
+  if (saida == NULL)
+  {
+    perror("Erro ao abrir a saída do protocolo");
+    return 1;
+  }
+  fflush(stdout);
+  dup2(2, 1);
+
+  int desligado = 0;
+  size_t tam;
+  char *corpo;
+  while ((corpo = leMensagem(&tam)) != NULL)
+  {
+    double inicio = loteRelogio();
+    Json *m = jsonLe(corpo, tam);
+    free(corpo);
+    if (m == NULL)
+    {
+      respondeErro(NULL, -32700, "JSON inválido");
+      continue;
+    }
+    const char *metodo = jsonTexto(jsonCampo(m, "method"));
+    const Json *id = jsonCampo(m, "id");
+    const Json *params = jsonCampo(m, "params");
+    const char *uri = jsonTexto(jsonCampo(jsonCampo(params, "textDocument"), "uri"));
+    Documento *d = (uri != NULL) ? procuraDoc(uri) : NULL;
+    Atualizacao at = { 0, 0, 0 };
+    int atualizou = 0;
+
+    if (metodo == NULL)
+    {
+      /* resposta a um pedido do servidor: não fazemos nenhum */
+    }
+    else if (strcmp(metodo, "exit") == 0)
+    {
+      jsonLibera(m);
+      break;
+    }
+    else if (desligado)
+    {
+      if (id != NULL) respondeErro(id, -32600, "servidor desligado");
+    }
+    else if (strcmp(metodo, "initialize") == 0)
+    {
+      responde(id, "{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2},"
+                   "\"hoverProvider\":true,\"definitionProvider\":true},\"serverInfo\":{\"name\":\"cminus\"}}");
+    }
+    else if (strcmp(metodo, "shutdown") == 0)
+    {
+      desligado = 1;
+      responde(id, "null");
+    }
+    else if (strcmp(metodo, "textDocument/didOpen") == 0 && uri != NULL)
+    {
+      const char *texto = jsonTexto(jsonCampo(jsonCampo(params, "textDocument"), "text"));
+      if (d == NULL) d = abre(uri);
+      substitui(d, texto != NULL ? texto : "", &at);
+      atualizou = 1;
+    }
+    else if (strcmp(metodo, "textDocument/didChange") == 0 && d != NULL)
+    {
+      mudancas(d, jsonCampo(params, "contentChanges"), &at);
+      atualizou = 1;
+    }
+    else if (strcmp(metodo, "textDocument/didClose") == 0 && d != NULL)
+    {
+      fecha(d);
+      publica(uri, NULL);
+    }
+    else if (strcmp(metodo, "textDocument/hover") == 0)
+    {
+      hover(d, params, id);
+    }
+    else if (strcmp(metodo, "textDocument/definition") == 0)
+    {
+      definicao(d, uri, params, id);
+    }
+    else if (id != NULL)
+    {
+      respondeErro(id, -32601, "método não suportado");
+    }
+
+    if (atualizou)
+    {
+      analisaDocumento(d, &at);
+      publica(uri, d);
+      if (stats)
+        fprintf(stderr, "LSP: %s em %.2f ms: %d de %d pedaço(s) relido(s), %d de %d função(ões) verificada(s)\n",
+                metodo + strlen("textDocument/"), 1000.0 * (loteRelogio() - inicio), at.relidos, d->n,
+                at.verificadas, at.funcoes);
+    }
+    jsonLibera(m);
+  }
+
+  while (nDocs > 0) fecha(docs[0]);
+  free(docs);
+  docs = NULL;
+  fclose(saida);
+  return desligado ? 0 : 1;
+}
@@ -0,0 +1,291 @@
+#include "../include/cminus.h"
+#include "../include/lote.h"
+#include "../include/servidor.h"
+#include "../include/lsp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+/* Linha de comando: lê as opções e chama a libcminus (cminus.h) para cada
+   arquivo, sozinho ou em lote. */
+
+static void uso(char *prog) {
+    fprintf(stderr, "Uso: %s [opções] arquivo_de_entrada...\n", prog);
+    fprintf(stderr, "  Vários arquivos (ou @lista, um nome por linha) são compilados em lote,\n");
+    fprintf(stderr, "  no mesmo processo, sem listagens e com um relatório por arquivo em stderr\n");
+    fprintf(stderr, "  -j N         no lote, compila com N processos trabalhadores; com um arquivo\n");
+    fprintf(stderr, "               grande, divide a análise sintática entre N processos\n");
+    fprintf(stderr, "  --inline     expande chamadas a funções pequenas\n");
+    fprintf(stderr, "  --bytecode   lista o bytecode gerado\n");
+    fprintf(stderr, "  --run        executa o programa na VM (sem listagens)\n");
+    fprintf(stderr, "  --stats      com --run, relata instruções executadas por segundo; sem --run,\n");
+    fprintf(stderr, "               o tempo da análise sintática e o pico de memória\n");
+    fprintf(stderr, "  --sintaxe    para depois da análise sintática\n");
+    fprintf(stderr, "  --esteira    léxico, sintaxe e semântica em threads, declaração por declaração\n");
+    fprintf(stderr, "  --continuo   analisa e libera cada declaração assim que lida; para depois da semântica\n");
+    fprintf(stderr, "  --retem-erros  com --esteira ou --continuo, erros semânticos só depois de a\n");
+    fprintf(stderr, "               análise sintática terminar sem erro, como na análise normal\n");
+    fprintf(stderr, "  --cache dir  verifica só as funções que mudaram desde a última vez; para depois da semântica\n");
+    fprintf(stderr, "  --jit        com --run, compila funções quentes para código nativo\n");
+    fprintf(stderr, "  --checked    testa em execução os índices de array não provados seguros\n");
+    fprintf(stderr, "  --sem-poda   mantém funções e globais não alcançáveis a partir de main\n");
+    fprintf(stderr, "  --cfg        lista o grafo de fluxo de controle de cada função\n");
+    fprintf(stderr, "  --chamadas arquivo  grava o grafo de chamadas (JSON se terminar em .json, senão DOT)\n");
+    fprintf(stderr, "  --ir         lista a representação intermediária\n");
+    fprintf(stderr, "  -S           gera assembly x86-64 (ligar com obj/runtime.o)\n");
+    fprintf(stderr, "  -c           gera objeto ELF64 direto, sem montador (ligar com obj/runtime.o)\n");
+    fprintf(stderr, "  --emit-c     traduz o programa para C (compilar com src/runtime.c)\n");
+    fprintf(stderr, "  -o arquivo   saída do -S, -c ou --emit-c (padrão: entrada com extensão .s, .o ou .c)\n");
+    fprintf(stderr, "  --exporta arquivo  grava a interface da unidade (funções e globais) para outras unidades\n");
+    fprintf(stderr, "  --importa arquivo  usa a interface de outra unidade (pode repetir); ligar com o objeto dela\n");
+    fprintf(stderr, "  --regalloc   com -S, relata a alocação de registradores por função\n");
+    fprintf(stderr, "  --fluxo      relata blocos e iterações da análise de fluxo por função\n");
+    fprintf(stderr, "  --servidor socket  fica no ar analisando os fontes pedidos pelo socket Unix\n");
+    fprintf(stderr, "  --lsp        servidor de linguagem para editores (LSP em stdin/stdout); com --stats,\n");
+    fprintf(stderr, "               relata em stderr o tempo de cada atualização\n");
+}
+
+/* opções da linha de comando: valem para todos os arquivos do lote */
+static CmOpcoes opcoes;
+
+/* arquivos de entrada; mais de um (ou uma @lista) é o modo lote */
+static char **arquivos = NULL;
+static int nArquivos = 0, capArquivos = 0;
+
+/* --importa: interfaces de outras unidades, para todos os arquivos */
+static const char **importa = NULL;
+static int nImporta = 0, capImporta = 0;
+
+static void adicionaImporta(const char *nome) {
+    if (nImporta == capImporta) {
+        capImporta = capImporta ? capImporta * 2 : 8;
+        importa = (const char **) realloc(importa, sizeof(char *) * capImporta);
+    }
+    importa[nImporta++] = nome;
+}
+
+static void adicionaArquivo(const char *nome) {
+    if (nArquivos == capArquivos) {
+        capArquivos = capArquivos ? capArquivos * 2 : 16;
+        arquivos = (char **) realloc(arquivos, sizeof(char *) * capArquivos);
+    }
+    arquivos[nArquivos++] = strdup(nome);
+}
+
+/* @lista: um nome por linha; linhas vazias e começadas por # são ignoradas */
+static int leLista(const char *lista) {
+    FILE *f = fopen(lista, "r");
+    if (f == NULL) {
+        perror("Erro ao abrir lista de arquivos");
+        return 1;
+    }
+    char linha[4096];
+    while (fgets(linha, sizeof(linha), f) != NULL) {
+        size_t n = strlen(linha);
+        while (n > 0 && (linha[n - 1] == '\n' || linha[n - 1] == '\r' || linha[n - 1] == ' ' || linha[n - 1] == '\t'))
+            linha[--n] = '\0';
+        if (n > 0 && linha[0] != '#') adicionaArquivo(linha);
+    }
+    fclose(f);
+    return 0;
+}
+
+/* erros semânticos não mudam o código de saída de um arquivo só, mas no
+   lote contam como falha */
+static int compilaLote(char *arquivo, int *linhas) {
+    CmArquivo info;
+    int result = cmCompilaArquivo(arquivo, &opcoes, &info);
+    *linhas = info.linhas;
+    return result == 0 && info.errosSemanticos == 0;
+}
+
+static void relataLote(char *arquivo, LoteArquivo *r) {
+    fprintf(stderr, "LOTE: %s: %s (%d linha(s), %.3f ms)\n",
+            arquivo, r->ok ? "ok" : "ERRO", r->linhas, r->segundos * 1e3);
+}
+
+int main(int argc, char **argv) {
+    int lote = 0;
+    int trabalhadores = 1;
+    const char *socketServidor = NULL;
+    int lsp = 0;
+    cmOpcoesPadrao(&opcoes);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--inline") == 0) {
+            opcoes.expandeInline = 1;
+        } else if (strcmp(argv[i], "--bytecode") == 0) {
+            opcoes.bytecode = 1;
+        } else if (strcmp(argv[i], "--run") == 0) {
+            opcoes.executa = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            opcoes.stats = 1;
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            opcoes.jit = 1;
+        } else if (strcmp(argv[i], "--checked") == 0) {
+            opcoes.verificado = 1;
+        } else if (strcmp(argv[i], "--ir") == 0) {
+            opcoes.ir = 1;
+        } else if (strcmp(argv[i], "--chamadas") == 0 && i + 1 < argc) {
+            opcoes.chamadas = argv[++i];
+        } else if (strcmp(argv[i], "--sintaxe") == 0) {
+            opcoes.sintaxe = 1;
+        } else if (strcmp(argv[i], "--esteira") == 0) {
+            opcoes.esteira = 1;
+        } else if (strcmp(argv[i], "--continuo") == 0) {
+            opcoes.continuo = 1;
+        } else if (strcmp(argv[i], "--retem-erros") == 0) {
+            opcoes.retemErros = 1;
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            opcoes.cache = argv[++i];
+        } else if (strcmp(argv[i], "--sem-poda") == 0) {
+            opcoes.poda = 0;
+        } else if (strcmp(argv[i], "--cfg") == 0) {
+            opcoes.cfg = 1;
+        } else if (strcmp(argv[i], "--fluxo") == 0) {
+            opcoes.relatorioFluxo = 1;
+        } else if (strcmp(argv[i], "--regalloc") == 0) {
+            opcoes.relatorioRegs = 1;
+        } else if (strcmp(argv[i], "-S") == 0) {
+            opcoes.assembly = 1;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            opcoes.objeto = 1;
+        } else if (strcmp(argv[i], "--emit-c") == 0) {
+            opcoes.traduzC = 1;
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            trabalhadores = atoi(argv[++i]);
+            if (trabalhadores < 1) {
+                fprintf(stderr, "-j espera um número de processos >= 1\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--exporta") == 0 && i + 1 < argc) {
+            opcoes.exporta = argv[++i];
+        } else if (strcmp(argv[i], "--importa") == 0 && i + 1 < argc) {
+            adicionaImporta(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            opcoes.saida = argv[++i];
+        } else if (strcmp(argv[i], "--servidor") == 0 && i + 1 < argc) {
+            socketServidor = argv[++i];
+        } else if (strcmp(argv[i], "--lsp") == 0) {
+            lsp = 1;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Opção desconhecida: %s\n", argv[i]);
+            uso(argv[0]);
+            return 1;
+        } else if (argv[i][0] == '@') {
+            if (leLista(argv[i] + 1) != 0) return 1;
+            lote = 1;
+        } else {
+            adicionaArquivo(argv[i]);
+        }
+    }
+
+    opcoes.importa = importa;
+    opcoes.nImporta = nImporta;
+    if ((lsp || socketServidor != NULL) && (nImporta > 0 || opcoes.exporta != NULL)) {
+        fprintf(stderr, "--importa e --exporta valem só para arquivos compilados pela linha de comando\n");
+        return 1;
+    }
+
+    if (lsp) {
+        if (socketServidor != NULL) {
+            fprintf(stderr, "--lsp e --servidor não podem ser usados juntos\n");
+            return 1;
+        }
+        if (nArquivos > 0) {
+            fprintf(stderr, "--lsp não recebe arquivos: os documentos chegam pelo protocolo\n");
+            return 1;
+        }
+        return lspExecuta(opcoes.stats);
+    }
+
+    if (socketServidor != NULL) {
+        if (nArquivos > 0) {
+            fprintf(stderr, "--servidor não recebe arquivos: os fontes chegam pelo socket\n");
+            return 1;
+        }
+        return servidorExecuta(socketServidor);
+    }
+
+    if (nArquivos == 0) {
+        uso(argv[0]);
+        return 1;
+    }
+    if (nArquivos > 1) lote = 1;
+    if (lote && (opcoes.saida != NULL || opcoes.chamadas != NULL || opcoes.exporta != NULL)) {
+        fprintf(stderr, "-o, --chamadas e --exporta valem só para um arquivo de entrada\n");
+        return 1;
+    }
+    /* a VM não liga unidades: o programa inteiro tem de estar no arquivo */
+    if ((nImporta > 0 || opcoes.exporta != NULL) && (opcoes.executa || opcoes.bytecode)) {
+        fprintf(stderr, "--run e --bytecode precisam do programa num arquivo só; com --importa e --exporta, "
+                        "use -c, -S ou --emit-c e ligue as unidades\n");
+        return 1;
+    }
+    if (opcoes.exporta != NULL && opcoes.sintaxe) {
+        fprintf(stderr, "--exporta precisa da análise semântica e não combina com --sintaxe\n");
+        return 1;
+    }
+    if (opcoes.continuo && opcoes.esteira) {
+        fprintf(stderr, "--continuo não combina com --esteira\n");
+        return 1;
+    }
+    if (opcoes.cache != NULL && (opcoes.continuo || opcoes.esteira || opcoes.sintaxe)) {
+        fprintf(stderr, "--cache não combina com --continuo, --esteira nem --sintaxe\n");
+        return 1;
+    }
+    /* as funções do cache não têm as anotações da semântica: não há
+       árvore anotada para gerar código */
+    if (opcoes.cache != NULL && (opcoes.assembly || opcoes.objeto || opcoes.traduzC || opcoes.executa ||
+                                 opcoes.bytecode || opcoes.ir || opcoes.cfg)) {
+        fprintf(stderr, "--cache só verifica o programa e não gera código: "
+                        "não combina com -S, -c, --emit-c, --run, --bytecode, --ir nem --cfg\n");
+        return 1;
+    }
+    /* com vários processos, a entrada e a saída do programa seriam disputadas */
+    if (lote && opcoes.executa && trabalhadores > 1) {
+        fprintf(stderr, "-j não combina com --run\n");
+        return 1;
+    }
+
+    opcoes.listagem = !opcoes.executa && !lote;
+
+    if (!lote) {
+        CmArquivo info;
+        opcoes.processosParse = trabalhadores;
+        int result = cmCompilaArquivo(arquivos[0], &opcoes, &info);
+        if (opcoes.stats && !opcoes.executa) {
+            struct rusage ru;
+            getrusage(RUSAGE_SELF, &ru);
+            fprintf(stderr, "MEMÓRIA: pico de %ld KB\n", ru.ru_maxrss);
+        }
+        free(arquivos[0]);
+        free(arquivos);
+        free(importa);
+        return result;
+    }
+
+    LoteArquivo *res = (LoteArquivo *) malloc(sizeof(LoteArquivo) * nArquivos);
+    double inicio = loteRelogio();
+    loteExecuta(arquivos, nArquivos, trabalhadores, compilaLote, relataLote, res);
+    double segundos = loteRelogio() - inicio;
+
+    int erros = 0;
+    long totalLinhas = 0;
+    for (int k = 0; k < nArquivos; k++) {
+        erros += !res[k].ok;
+        totalLinhas += res[k].linhas;
+    }
+    fprintf(stderr, "LOTE: %d arquivo(s), %d com erro, %ld linha(s) em %.3f s (%.1f arquivos/s, %.0f linhas/s)",
+            nArquivos, erros, totalLinhas, segundos,
+            segundos > 0 ? nArquivos / segundos : 0.0, segundos > 0 ? totalLinhas / segundos : 0.0);
+    if (trabalhadores > 1) fprintf(stderr, ", %d processo(s)", trabalhadores < nArquivos ? trabalhadores : nArquivos);
+    fprintf(stderr, "\n");
+
+    for (int k = 0; k < nArquivos; k++) free(arquivos[k]);
+    free(arquivos);
+    free(importa);
+    free(res);
+    return erros > 0;
+}
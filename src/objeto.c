@@ -0,0 +1,207 @@
+#include "../include/objeto.h"
+#include <elf.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Seções do objeto, na ordem da tabela de cabeçalhos */
+enum
+{
+  SEC_NULA, SEC_TEXT, SEC_DATA, SEC_BSS, SEC_SYMTAB, SEC_STRTAB,
+  SEC_RELA, SEC_SHSTRTAB, SEC_PILHA, NUM_SECOES
+};
+
+static const char *nomesSecao[NUM_SECOES] = {
+  "", ".text", ".data", ".bss", ".symtab", ".strtab",
+  ".rela.text", ".shstrtab", ".note.GNU-stack"
+};
+
+/* tabela de strings ELF: concatenação de nomes terminados em zero */
+typedef struct
+{
+  char *dados;
+  int n, cap;
+} Strings;
+
+static int adicionaString(Strings *t, const char *s)
+{
+  int tam = (int) strlen(s) + 1;
+  while (t->n + tam > t->cap)
+  {
+    t->cap = t->cap ? t->cap * 2 : 256;
+    t->dados = (char *) realloc(t->dados, t->cap);
+  }
+  memcpy(t->dados + t->n, s, tam);
+  t->n += tam;
+  return t->n - tam;
+}
+
+static long alinha(long v, long a)
+{
+  return (v + a - 1) / a * a;
+}
+
+static void completa(FILE *f, long ate)
+{
+  while (ftell(f) < ate) fputc(0, f);
+}
+
+/* índice na tabela de símbolos (0: ainda não está) */
+static int procuraSimbolo(char **nomes, int n, const char *nome)
+{
+  for (int k = 1; k < n; k++)
+    if (strcmp(nomes[k], nome) == 0) return k;
+  return 0;
+}
+
+int objEscreveElf(X86Asm *a, const char *origem, FILE *saida)
+{
+  /* símbolos: nulo, arquivo, definidos (globais) e depois os externos
+     referenciados pelas relocações (cm_input, cm_output, ...) */
+  int cap = a->nSimbolos + a->nRelocs + 2;
+  Elf64_Sym *simbolos = (Elf64_Sym *) calloc(cap, sizeof(Elf64_Sym));
+  char **nomes = (char **) calloc(cap, sizeof(char *));
+  Strings strtab = { 0 };
+  int n = 1;
+  adicionaString(&strtab, "");
+  nomes[0] = "";
+
+  const char *base = strrchr(origem, '/');
+  simbolos[n].st_name = adicionaString(&strtab, base ? base + 1 : origem);
+  simbolos[n].st_info = ELF64_ST_INFO(STB_LOCAL, STT_FILE);
+  simbolos[n].st_shndx = SHN_ABS;
+  nomes[n++] = "";
+  int primeiroGlobal = n;
+
+  for (int k = 0; k < a->nSimbolos; k++)
+  {
+    X86Simbolo *s = &a->simbolos[k];
+    simbolos[n].st_name = adicionaString(&strtab, s->nome);
+    simbolos[n].st_info = ELF64_ST_INFO(STB_GLOBAL, s->bss ? STT_OBJECT : STT_FUNC);
+    simbolos[n].st_shndx = s->bss ? SEC_BSS : SEC_TEXT;
+    simbolos[n].st_value = s->pos;
+    simbolos[n].st_size = s->tamanho;
+    nomes[n++] = s->nome;
+  }
+
+  Elf64_Rela *relas = (Elf64_Rela *) calloc(a->nRelocs > 0 ? a->nRelocs : 1, sizeof(Elf64_Rela));
+  for (int k = 0; k < a->nRelocs; k++)
+  {
+    X86Reloc *r = &a->relocs[k];
+    int idx = procuraSimbolo(nomes, n, r->simbolo);
+    if (idx == 0)
+    {
+      idx = n;
+      simbolos[n].st_name = adicionaString(&strtab, r->simbolo);
+      simbolos[n].st_info = ELF64_ST_INFO(STB_GLOBAL, STT_NOTYPE);
+      simbolos[n].st_shndx = SHN_UNDEF;
+      nomes[n++] = r->simbolo;
+    }
+    relas[k].r_offset = r->pos;
+    relas[k].r_info = ELF64_R_INFO(idx, r->chamada ? R_X86_64_PLT32 : R_X86_64_PC32);
+    relas[k].r_addend = r->addend;
+  }
+
+  Strings shstrtab = { 0 };
+  int nomeSecao[NUM_SECOES];
+  for (int k = 0; k < NUM_SECOES; k++)
+    nomeSecao[k] = adicionaString(&shstrtab, nomesSecao[k]);
+
+  /* leiaute: cabeçalho, .text, .symtab, .strtab, .rela.text, .shstrtab,
+     tabela de seções (.data e .bss não ocupam bytes no arquivo) */
+  Elf64_Shdr secoes[NUM_SECOES];
+  memset(secoes, 0, sizeof(secoes));
+  long pos = sizeof(Elf64_Ehdr);
+
+  secoes[SEC_TEXT].sh_type = SHT_PROGBITS;
+  secoes[SEC_TEXT].sh_flags = SHF_ALLOC | SHF_EXECINSTR;
+  secoes[SEC_TEXT].sh_offset = pos = alinha(pos, 16);
+  secoes[SEC_TEXT].sh_size = a->n;
+  secoes[SEC_TEXT].sh_addralign = 16;
+  pos += a->n;
+
+  secoes[SEC_DATA].sh_type = SHT_PROGBITS;
+  secoes[SEC_DATA].sh_flags = SHF_ALLOC | SHF_WRITE;
+  secoes[SEC_DATA].sh_offset = pos;
+  secoes[SEC_DATA].sh_addralign = 1;
+
+  secoes[SEC_BSS].sh_type = SHT_NOBITS;
+  secoes[SEC_BSS].sh_flags = SHF_ALLOC | SHF_WRITE;
+  secoes[SEC_BSS].sh_offset = pos;
+  secoes[SEC_BSS].sh_size = a->tamBss;
+  secoes[SEC_BSS].sh_addralign = 16;
+
+  secoes[SEC_SYMTAB].sh_type = SHT_SYMTAB;
+  secoes[SEC_SYMTAB].sh_offset = pos = alinha(pos, 8);
+  secoes[SEC_SYMTAB].sh_size = n * sizeof(Elf64_Sym);
+  secoes[SEC_SYMTAB].sh_link = SEC_STRTAB;
+  secoes[SEC_SYMTAB].sh_info = primeiroGlobal;
+  secoes[SEC_SYMTAB].sh_addralign = 8;
+  secoes[SEC_SYMTAB].sh_entsize = sizeof(Elf64_Sym);
+  pos += secoes[SEC_SYMTAB].sh_size;
+
+  secoes[SEC_STRTAB].sh_type = SHT_STRTAB;
+  secoes[SEC_STRTAB].sh_offset = pos;
+  secoes[SEC_STRTAB].sh_size = strtab.n;
+  secoes[SEC_STRTAB].sh_addralign = 1;
+  pos += strtab.n;
+
+  secoes[SEC_RELA].sh_type = SHT_RELA;
+  secoes[SEC_RELA].sh_flags = SHF_INFO_LINK;
+  secoes[SEC_RELA].sh_offset = pos = alinha(pos, 8);
+  secoes[SEC_RELA].sh_size = a->nRelocs * sizeof(Elf64_Rela);
+  secoes[SEC_RELA].sh_link = SEC_SYMTAB;
+  secoes[SEC_RELA].sh_info = SEC_TEXT;
+  secoes[SEC_RELA].sh_addralign = 8;
+  secoes[SEC_RELA].sh_entsize = sizeof(Elf64_Rela);
+  pos += secoes[SEC_RELA].sh_size;
+
+  secoes[SEC_SHSTRTAB].sh_type = SHT_STRTAB;
+  secoes[SEC_SHSTRTAB].sh_offset = pos;
+  secoes[SEC_SHSTRTAB].sh_size = shstrtab.n;
+  secoes[SEC_SHSTRTAB].sh_addralign = 1;
+  pos += shstrtab.n;
+
+  /* pilha não executável, como o .note.GNU-stack do -S */
+  secoes[SEC_PILHA].sh_type = SHT_PROGBITS;
+  secoes[SEC_PILHA].sh_offset = pos;
+  secoes[SEC_PILHA].sh_addralign = 1;
+
+  for (int k = 0; k < NUM_SECOES; k++)
+    secoes[k].sh_name = nomeSecao[k];
+  long posSecoes = alinha(pos, 8);
+
+  Elf64_Ehdr cab;
+  memset(&cab, 0, sizeof(cab));
+  memcpy(cab.e_ident, ELFMAG, SELFMAG);
+  cab.e_ident[EI_CLASS] = ELFCLASS64;
+  cab.e_ident[EI_DATA] = ELFDATA2LSB;
+  cab.e_ident[EI_VERSION] = EV_CURRENT;
+  cab.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+  cab.e_type = ET_REL;
+  cab.e_machine = EM_X86_64;
+  cab.e_version = EV_CURRENT;
+  cab.e_shoff = posSecoes;
+  cab.e_ehsize = sizeof(Elf64_Ehdr);
+  cab.e_shentsize = sizeof(Elf64_Shdr);
+  cab.e_shnum = NUM_SECOES;
+  cab.e_shstrndx = SEC_SHSTRTAB;
+
+  fwrite(&cab, sizeof(cab), 1, saida);
+  completa(saida, secoes[SEC_TEXT].sh_offset);
+  fwrite(a->codigo, 1, a->n, saida);
+  completa(saida, secoes[SEC_SYMTAB].sh_offset);
+  fwrite(simbolos, sizeof(Elf64_Sym), n, saida);
+  fwrite(strtab.dados, 1, strtab.n, saida);
+  completa(saida, secoes[SEC_RELA].sh_offset);
+  fwrite(relas, sizeof(Elf64_Rela), a->nRelocs, saida);
+  fwrite(shstrtab.dados, 1, shstrtab.n, saida);
+  completa(saida, posSecoes);
+  fwrite(secoes, sizeof(Elf64_Shdr), NUM_SECOES, saida);
+
+  free(simbolos);
+  free(nomes);
+  free(relas);
+  free(strtab.dados);
+  free(shstrtab.dados);
+  return ferror(saida) ? 1 : 0;
+}
@@ -0,0 +1,336 @@
+#include "../include/particao.h"
+#include "../include/arvore.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+extern int yyparse(void);
+extern int yylineno;
+extern void lexReinicia(FILE *f);
+
+typedef struct
+{
+  long inicio, fim;     /* bytes [inicio, fim) do fonte */
+  int linha;            /* linha do primeiro byte */
+} Pedaco;
+
+/* Pré-varredura: corta depois de '}' ou ';' com profundidade zero, fora de
+   comentários, quando o pedaço corrente já passou do tamanho alvo.
+   Devolve o número de pedaços; 'linhas' recebe o yylineno final. */
+static int divide(const char *fonte, long tam, int maxPedacos, Pedaco *p, int *linhas)
+{
+  long alvo = tam / maxPedacos;
+  long ultimoFim = 0;   /* depois do último fim de declaração */
+  int n = 0, prof = 0, comentario = 0, linha = 1;
+  p[0].inicio = 0;
+  p[0].linha = 1;
+  for (long i = 0; i < tam; i++)
+  {
+    char c = fonte[i];
+    if (c == '\n') linha++;
+    if (comentario)
+    {
+      if (c == '*' && i + 1 < tam && fonte[i + 1] == '/')
+      {
+        comentario = 0;
+        i++;
+      }
+      continue;
+    }
+    if (c == '/' && i + 1 < tam && fonte[i + 1] == '*')
+    {
+      comentario = 1;
+      i++;
+      continue;
+    }
+    if (c == '{') prof++;
+    else if (c == '}') prof--;
+    else if (c != ';') continue;
+    if (prof != 0 || c == '{') continue;
+
+    ultimoFim = i + 1;
+    if (n + 1 < maxPedacos && i + 1 - p[n].inicio >= alvo)
+    {
+      p[n].fim = i + 1;
+      n++;
+      p[n].inicio = i + 1;
+      p[n].linha = linha;
+    }
+  }
+  /* o último pedaço precisa de ao menos uma declaração */
+  if (n > 0 && ultimoFim <= p[n].inicio) n--;
+  p[n].fim = tam;
+  *linhas = linha;
+  return n + 1;
+}
+
+/* --- Serialização da lista de declarações --- */
+
+typedef struct
+{
+  unsigned char *p;
+  long usado, cap;
+  int estourou;
+} Saida;
+
+static void poe(Saida *s, const void *dado, long n)
+{
+  if (s->usado + n > s->cap)
+  {
+    s->estourou = 1;
+    return;
+  }
+  memcpy(s->p + s->usado, dado, n);
+  s->usado += n;
+}
+
+static int temLexema(NodeType tipo)
+{
+  switch (tipo)
+  {
+  case NO_OP_REL:
+  case NO_OP_SOMA:
+  case NO_OP_MULT:
+  case NO_VAR:
+  case NO_CHAMADA:
+  case NO_ID:
+  case NO_NUM:
+  case NO_IMPORT:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/* lista de irmãos: [1 tipo linha (lexema | valor) filhos]* 0 */
+static void serializa(Saida *s, TreeNode *t)
+{
+  unsigned char marca = 1;
+  for (; t != NULL && !s->estourou; t = t->irmao)
+  {
+    unsigned char tipo = (unsigned char) t->tipoNo;
+    poe(s, &marca, 1);
+    poe(s, &tipo, 1);
+    poe(s, &t->lineno, sizeof(int));
+    if (temLexema(t->tipoNo))
+    {
+      int n = (t->attr.lexema != NULL) ? (int) strlen(t->attr.lexema) + 1 : 0;
+      poe(s, &n, sizeof(int));
+      if (n > 0) poe(s, t->attr.lexema, n);
+    }
+    else
+    {
+      poe(s, &t->attr.valor, sizeof(int));
+    }
+    serializa(s, t->filho);
+  }
+  marca = 0;
+  poe(s, &marca, 1);
+}
+
+static TreeNode *desserializa(const unsigned char **p)
+{
+  TreeNode *primeiro = NULL;
+  TreeNode **fim = &primeiro;
+  while (*(*p)++ == 1)
+  {
+    NodeType tipo = (NodeType) *(*p)++;
+    int lineno, valor;
+    memcpy(&lineno, *p, sizeof(int));
+    memcpy(&valor, *p + sizeof(int), sizeof(int));
+    *p += 2 * sizeof(int);
+
+    TreeNode *t;
+    if (temLexema(tipo))
+    {
+      t = novoNoToken(tipo, valor > 0 ? (char *) *p : NULL, lineno);
+      *p += valor;
+    }
+    else
+    {
+      t = novoNo(tipo, lineno);
+      t->attr.valor = valor;
+    }
+    t->filho = desserializa(p);
+    *fim = t;
+    fim = &t->irmao;
+  }
+  return primeiro;
+}
+
+/* --- Trabalhadores --- */
+
+typedef struct
+{
+  int ok;
+  long usado;
+} Resultado;
+
+/* lista de declarações do pedaço, ou NULL se ele tem erro */
+static TreeNode *analisaPedaco(const char *fonte, Pedaco *pd)
+{
+  FILE *f = fmemopen((void *) (fonte + pd->inicio), pd->fim - pd->inicio, "r");
+  if (f == NULL) return NULL;
+  lexReinicia(f);
+  yylineno = pd->linha;
+  raizArvore = NULL;
+  int erro = yyparse();
+  fclose(f);
+  if (erro != 0 || raizArvore == NULL) return NULL;
+  TreeNode *lista = raizArvore->filho;
+  raizArvore->filho = NULL;
+  liberaArvore(raizArvore);
+  raizArvore = NULL;
+  return lista;
+}
+
+/* os erros saem na análise sequencial que vem depois */
+static void silencia(void)
+{
+  int nulo = open("/dev/null", O_WRONLY);
+  if (nulo < 0) return;
+  dup2(nulo, 1);
+  dup2(nulo, 2);
+  close(nulo);
+}
+
+int particaoAnalisa(const char *arquivo, int trabalhadores, int *linhas)
+{
+  FILE *f = fopen(arquivo, "rb");
+  if (f == NULL) return -1;
+  fseek(f, 0, SEEK_END);
+  long tam = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  /* com um núcleo só, os pedaços rodam em fila e a serialização é puro
+     custo: mais processos que núcleos nunca se paga */
+  long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+  if (nucleos > 0 && trabalhadores > nucleos) trabalhadores = (int) nucleos;
+  int maxPedacos = (int) (tam / PARTICAO_MIN_BYTES);
+  if (maxPedacos > trabalhadores) maxPedacos = trabalhadores;
+  if (maxPedacos < 2)
+  {
+    fclose(f);
+    return -1;
+  }
+  char *fonte = (char *) malloc(tam + 1);
+  long lidos = (long) fread(fonte, 1, tam, f);
+  fclose(f);
+  if (lidos != tam)
+  {
+    free(fonte);
+    return -1;
+  }
+
+  Pedaco *p = (Pedaco *) malloc(sizeof(Pedaco) * maxPedacos);
+  int n = divide(fonte, tam, maxPedacos, p, linhas);
+  if (n < 2)
+  {
+    free(p);
+    free(fonte);
+    return -1;
+  }
+
+  /* região compartilhada: resultados e, para cada pedaço, espaço folgado
+     para a árvore serializada (só as páginas tocadas ocupam memória). O
+     primeiro pedaço fica com o processo principal, sem serialização. */
+  long *base = (long *) malloc(sizeof(long) * (n + 1));
+  base[0] = ((sizeof(Resultado) * n + 4095) / 4096) * 4096;
+  for (int k = 0; k < n; k++) base[k + 1] = base[k] + 32 * (p[k].fim - p[k].inicio) + 4096;
+  unsigned char *sh = (unsigned char *) mmap(NULL, base[n], PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  int ok = (sh != MAP_FAILED);
+  Resultado *res = (Resultado *) sh;
+  TreeNode *primeiro = NULL;
+
+  if (ok)
+  {
+    memset(res, 0, sizeof(Resultado) * n);
+    fflush(stdout);
+    fflush(stderr);
+    pid_t *pids = (pid_t *) malloc(sizeof(pid_t) * n);
+    for (int k = 1; k < n; k++)
+    {
+      pids[k] = fork();
+      if (pids[k] == 0)
+      {
+        silencia();
+        Saida s = { sh + base[k], 0, base[k + 1] - base[k], 0 };
+        TreeNode *lista = analisaPedaco(fonte, &p[k]);
+        if (lista != NULL)
+        {
+          serializa(&s, lista);
+          res[k].usado = s.usado;
+          res[k].ok = !s.estourou;
+        }
+        _exit(0);
+      }
+    }
+
+    int saida = dup(1), erros = dup(2);
+    silencia();
+    primeiro = analisaPedaco(fonte, &p[0]);
+    fflush(stdout);
+    fflush(stderr);
+    dup2(saida, 1);
+    dup2(erros, 2);
+    close(saida);
+    close(erros);
+
+    for (int k = 1; k < n; k++)
+      if (pids[k] > 0) waitpid(pids[k], NULL, 0);
+    free(pids);
+
+    ok = (primeiro != NULL);
+    for (int k = 1; k < n; k++) ok = ok && res[k].ok;
+  }
+
+  if (ok)
+  {
+    /* remonta a declaration_list na ordem do fonte */
+    TreeNode *lista = primeiro;
+    TreeNode **fim = &lista;
+    while (*fim != NULL) fim = &(*fim)->irmao;
+    for (int k = 1; k < n; k++)
+    {
+      const unsigned char *q = sh + base[k];
+      *fim = desserializa(&q);
+      while (*fim != NULL) fim = &(*fim)->irmao;
+    }
+    /* cada pedaço aceita import no começo: um que venha depois de
+       declarações de outro pedaço é erro, relatado pela análise sequencial */
+    int declaracoes = 0;
+    for (TreeNode *d = lista; ok && d != NULL; d = d->irmao)
+    {
+      if (d->tipoNo != NO_IMPORT) declaracoes = 1;
+      else if (declaracoes) ok = 0;
+    }
+    if (ok)
+    {
+      raizArvore = novoNo(NO_PROGRAMA, *linhas);
+      raizArvore->filho = lista;
+    }
+    else
+    {
+      primeiro = lista;
+    }
+  }
+  if (!ok)
+  {
+    for (TreeNode *d = primeiro; d != NULL;)
+    {
+      TreeNode *prox = d->irmao;
+      liberaArvore(d);
+      d = prox;
+    }
+  }
+
+  if (sh != MAP_FAILED) munmap(sh, base[n]);
+  free(base);
+  free(p);
+  free(fonte);
+  return ok ? n : -1;
+}
@@ -0,0 +1,100 @@
+#include "../include/poda.h"
+#include "../include/chamadas.h"
+#include "../include/analyze.h"
+
+static char *globalUsada;   /* por loc (antigo) do segmento de globais */
+
+static void marcaGlobais(TreeNode *t)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    if (t->tipoNo == NO_VAR && t->sym != NULL && t->sym->scope == 0 && t->sym->kind != ID_FUN)
+      globalUsada[t->sym->loc] = 1;
+    marcaGlobais(t->filho);
+  }
+}
+
+static void conta(TreeNode *t, PodaStats *stats)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    stats->nos++;
+    stats->bytesArvore += sizeof(TreeNode);
+    switch (t->tipoNo)
+    {
+    case NO_OP_REL: case NO_OP_SOMA: case NO_OP_MULT:
+    case NO_VAR: case NO_CHAMADA: case NO_ID: case NO_NUM:
+      if (t->attr.lexema != NULL) stats->bytesArvore += strlen(t->attr.lexema) + 1;
+      break;
+    default:
+      break;
+    }
+    conta(t->filho, stats);
+  }
+}
+
+static int celulas(BucketList s)
+{
+  return s->kind == ID_ARRAY ? s->size : 1;
+}
+
+void podaPrograma(TreeNode *arvore, PodaStats *stats)
+{
+  memset(stats, 0, sizeof(PodaStats));
+  GrafoChamadas *g = chamadasConstroi(arvore);
+  if (g->main < 0)
+  {
+    chamadasLibera(g);
+    return;
+  }
+
+  globalUsada = (char *) calloc(analyzeGlobalSize() + 1, 1);
+  for (int f = 0; f < g->nFuncoes; f++)
+    if (g->alcancavel[f] && g->decl[f] != NULL) marcaGlobais(g->decl[f]->filho);
+
+  /* remove as mortas e renumera as vivas, na ordem de declaração, depois
+     das importadas (que não estão na árvore) */
+  int proxGlobal;
+  int proxFuncao = FUN_OUTPUT + 1 + analyzeImportadas(&proxGlobal);
+  TreeNode **elo = &arvore->filho;
+  while (*elo != NULL)
+  {
+    TreeNode *d = *elo;
+    int morta = 0;
+    if (d->tipoNo == NO_DECLARACAO_FUN && d->sym != NULL)
+    {
+      morta = !g->alcancavel[d->sym->loc];
+      if (morta) stats->funcoes++;
+      else d->sym->loc = proxFuncao++;
+    }
+    else if (d->tipoNo == NO_DECLARACAO_VAR && d->sym != NULL)
+    {
+      morta = !globalUsada[d->sym->loc];
+      if (morta)
+      {
+        stats->globais++;
+        stats->bytesGlobais += (long) sizeof(int) * celulas(d->sym);
+      }
+      else
+      {
+        d->sym->loc = proxGlobal;
+        proxGlobal += celulas(d->sym);
+      }
+    }
+
+    if (!morta)
+    {
+      elo = &d->irmao;
+      continue;
+    }
+    *elo = d->irmao;
+    d->irmao = NULL;
+    conta(d, stats);
+    liberaArvore(d);
+  }
+
+  if (stats->funcoes > 0 || stats->globais > 0) analyzeCompacta(proxGlobal, proxFuncao);
+  free(globalUsada);
+  globalUsada = NULL;
+  chamadasLibera(g);
+}
@@ -0,0 +1,319 @@
+#include "../include/puras.h"
+#include "../include/chamadas.h"
+#include "../include/analyze.h"
+#include <limits.h>
+
+static GrafoChamadas *grafo;
+static char *pura;          /* por função */
+static char *esgotada;      /* por função: já estourou o orçamento uma vez */
+
+/* --- Efeitos diretos --- */
+
+static int temEfeitoDireto(TreeNode *t)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    switch (t->tipoNo)
+    {
+    case NO_VAR:
+      if (t->sym != NULL && t->sym->scope == 0 && t->sym->kind != ID_FUN) return 1;
+      break;
+    case NO_ARRAY_IDX:
+      return 1;
+    case NO_PARAM:
+    case NO_DECLARACAO_VAR:
+      if (t->sym != NULL && t->sym->kind == ID_ARRAY) return 1;
+      break;
+    case NO_CHAMADA:
+      if (t->sym != NULL && (t->sym->loc == FUN_INPUT || t->sym->loc == FUN_OUTPUT)) return 1;
+      break;
+    default:
+      break;
+    }
+    if (temEfeitoDireto(t->filho)) return 1;
+  }
+  return 0;
+}
+
+/* componentes na ordem de baixo para cima: os chamados de fora da
+   componente já estão decididos quando ela é examinada */
+static void classifica(void)
+{
+  GrafoChamadas *g = grafo;
+  for (int k = 0; k < g->nFuncoes;)
+  {
+    int fim = k;
+    while (fim < g->nFuncoes && g->scc[g->ordem[fim]] == g->scc[g->ordem[k]]) fim++;
+
+    int ok = 1;
+    for (int j = k; j < fim && ok; j++)
+    {
+      int f = g->ordem[j];
+      if (g->decl[f] == NULL || temEfeitoDireto(g->decl[f]->filho)) ok = 0;
+      for (int c = g->inicioChamados[f]; c < g->inicioChamados[f + 1] && ok; c++)
+      {
+        int chamado = g->chamados[c];
+        if (g->scc[chamado] != g->scc[f] && !pura[chamado]) ok = 0;
+      }
+    }
+    for (int j = k; j < fim; j++) pura[g->ordem[j]] = (char) ok;
+    k = fim;
+  }
+}
+
+/* --- Interpretador --- */
+
+typedef enum { SEGUE, RETORNA, DESISTE } Estado;
+
+static long passos;
+static int profundidade;
+static int desistiu;
+static int esgotou;         /* desistiu por passos ou profundidade, não por divisão por zero */
+
+static int interpreta(BucketList f, int *args);
+
+static int avalia(TreeNode *t, int *frame)
+{
+  if (desistiu) return 0;
+  if (--passos < 0)
+  {
+    desistiu = esgotou = 1;
+    return 0;
+  }
+
+  switch (t->tipoNo)
+  {
+  case NO_NUM:
+    return atoi(t->attr.lexema);
+
+  case NO_VAR:
+    return frame[t->sym->loc];
+
+  case NO_ATRIBUICAO:
+  {
+    int v = avalia(t->filho->irmao, frame);
+    frame[t->filho->sym->loc] = v;
+    return v;
+  }
+
+  case NO_OP_SOMA:
+  case NO_OP_MULT:
+  case NO_OP_REL:
+  {
+    int a = avalia(t->filho, frame);
+    int b = avalia(t->filho->irmao, frame);
+    if (desistiu) return 0;
+    char *op = t->attr.lexema;
+    switch (op[0])
+    {
+    case '+': return (int) ((unsigned) a + (unsigned) b);
+    case '-': return (int) ((unsigned) a - (unsigned) b);
+    case '*': return (int) ((unsigned) a * (unsigned) b);
+    case '/':
+      /* divisão por zero fica para a execução relatar */
+      if (b == 0)
+      {
+        desistiu = 1;
+        return 0;
+      }
+      return (b == -1) ? (int) (0u - (unsigned) a) : a / b;
+    case '<': return op[1] == '=' ? a <= b : a < b;
+    case '>': return op[1] == '=' ? a >= b : a > b;
+    case '=': return a == b;
+    default: return a != b;
+    }
+  }
+
+  case NO_CHAMADA:
+  {
+    int args[64];
+    int n = 0;
+    for (TreeNode *a = t->filho; a != NULL; a = a->irmao)
+    {
+      if (n == 64)
+      {
+        desistiu = 1;
+        return 0;
+      }
+      args[n++] = avalia(a, frame);
+    }
+    if (desistiu) return 0;
+    return interpreta(t->sym, args);
+  }
+
+  default:
+    desistiu = 1;
+    return 0;
+  }
+}
+
+static Estado executaLista(TreeNode *t, int *frame, int *retorno);
+
+/* um comando (sem os irmãos) */
+static Estado executa(TreeNode *t, int *frame, int *retorno)
+{
+  if (t == NULL || desistiu) return desistiu ? DESISTE : SEGUE;
+  switch (t->tipoNo)
+  {
+  case NO_DECLARACAO_VAR:
+    return SEGUE;
+
+  case NO_BLOCO:
+    return executaLista(t->filho, frame, retorno);
+
+  case NO_IF:
+  {
+    TreeNode *entao = t->filho->irmao;
+    TreeNode *senao = (entao != NULL) ? entao->irmao : NULL;
+    return executa(avalia(t->filho, frame) ? entao : senao, frame, retorno);
+  }
+
+  case NO_WHILE:
+    while (!desistiu && avalia(t->filho, frame))
+    {
+      Estado e = executa(t->filho->irmao, frame, retorno);
+      if (e != SEGUE) return e;
+    }
+    break;
+
+  case NO_RETURN:
+    *retorno = (t->filho != NULL) ? avalia(t->filho, frame) : 0;
+    return desistiu ? DESISTE : RETORNA;
+
+  default:
+    avalia(t, frame);
+    break;
+  }
+  return desistiu ? DESISTE : SEGUE;
+}
+
+static Estado executaLista(TreeNode *t, int *frame, int *retorno)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    Estado e = executa(t, frame, retorno);
+    if (e != SEGUE) return e;
+  }
+  return SEGUE;
+}
+
+static int interpreta(BucketList f, int *args)
+{
+  TreeNode *decl = grafo->decl[f->loc];
+  if (decl == NULL)
+  {
+    desistiu = 1;
+    return 0;
+  }
+  if (++profundidade > PURAS_MAX_PROFUNDIDADE)
+  {
+    desistiu = esgotou = 1;
+    return 0;
+  }
+
+  int *frame = (int *) calloc(f->frameSize + 1, sizeof(int));
+  for (int k = 0; k < f->numParams; k++) frame[k] = args[k];
+
+  TreeNode *corpo = decl->filho->irmao->irmao;
+  while (corpo != NULL && corpo->tipoNo != NO_BLOCO) corpo = corpo->irmao;
+
+  int retorno = 0;
+  executa(corpo, frame, &retorno);
+
+  free(frame);
+  profundidade--;
+  return retorno;
+}
+
+/* --- Substituição --- */
+
+static PurasStats *st;
+static long restantes;      /* passos que ainda cabem nesta compilação */
+
+static int argumentosConstantes(TreeNode *chamada)
+{
+  int n = 0;
+  for (TreeNode *a = chamada->filho; a != NULL; a = a->irmao, n++)
+    if (a->tipoNo != NO_NUM || n == 64) return 0;
+  return 1;
+}
+
+/* de dentro para fora: gcd(f(2), 3) avalia f(2) antes */
+static void substitui(TreeNode *t)
+{
+  for (; t != NULL; t = t->irmao)
+  {
+    substitui(t->filho);
+    if (t->tipoNo != NO_CHAMADA || t->sym == NULL || t->sym->type != Integer) continue;
+    if (!pura[t->sym->loc] || !argumentosConstantes(t)) continue;
+
+    /* uma função que já estourou o orçamento (provavelmente não termina
+       ou é cara demais) não é tentada de novo, nem com outros argumentos */
+    if (esgotada[t->sym->loc] || restantes <= 0)
+    {
+      st->desistencias++;
+      continue;
+    }
+
+    int args[64];
+    int n = 0;
+    for (TreeNode *a = t->filho; a != NULL; a = a->irmao) args[n++] = atoi(a->attr.lexema);
+
+    long orcamento = restantes < PURAS_MAX_PASSOS ? restantes : PURAS_MAX_PASSOS;
+    passos = orcamento;
+    profundidade = 0;
+    desistiu = esgotou = 0;
+    int v = interpreta(t->sym, args);
+    long gastos = orcamento - (passos > 0 ? passos : 0);
+    st->passos += gastos;
+    restantes -= gastos;
+    /* INT_MIN não tem literal em C- nem em C */
+    if (desistiu || v == INT_MIN)
+    {
+      if (esgotou) esgotada[t->sym->loc] = 1;
+      st->desistencias++;
+      continue;
+    }
+
+    TreeNode *a = t->filho;
+    while (a != NULL)
+    {
+      TreeNode *prox = a->irmao;
+      liberaArvore(a);
+      a = prox;
+    }
+    char num[16];
+    snprintf(num, sizeof(num), "%d", v);
+    free(t->attr.lexema);
+    t->attr.lexema = strdup(num);
+    t->tipoNo = NO_NUM;
+    t->filho = NULL;
+    t->sym = NULL;
+    t->type = Integer;
+    st->avaliadas++;
+  }
+}
+
+void avaliaPuras(TreeNode *arvore, PurasStats *stats)
+{
+  memset(stats, 0, sizeof(PurasStats));
+  st = stats;
+  grafo = chamadasConstroi(arvore);
+  pura = (char *) calloc(grafo->nFuncoes + 1, 1);
+  esgotada = (char *) calloc(grafo->nFuncoes + 1, 1);
+  restantes = PURAS_MAX_PASSOS_TOTAL;
+  classifica();
+  for (int f = 0; f < grafo->nFuncoes; f++)
+    if (grafo->decl[f] != NULL && pura[f]) stats->puras++;
+
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_FUN && d->sym != NULL) substitui(d->filho);
+
+  free(pura);
+  pura = NULL;
+  free(esgotada);
+  esgotada = NULL;
+  chamadasLibera(grafo);
+  grafo = NULL;
+  st = NULL;
+}
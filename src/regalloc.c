@@ -0,0 +1,218 @@
+#include "../include/regalloc.h"
+#include "../include/fluxo.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/* Registradores alocáveis. rax, rdx, r10 e r11 ficam de fora: são os
+   temporários do gerador (divisão, índices, operandos na memória). Os
+   preservados pelo chamado vêm por último para que intervalos que não
+   cruzam chamadas não custem salvamento no prólogo. */
+static const X86Reg regsChamador[] = { RCX, RSI, RDI, R8, R9 };
+static const X86Reg regsChamado[] = { RBX, R12, R13, R14, R15 };
+#define N_CHAMADOR 5
+#define N_CHAMADO 5
+
+static void estende(Alocacao *ra, int v, int pos)
+{
+  if (ra->inicio[v] < 0 || pos < ra->inicio[v]) ra->inicio[v] = pos;
+  if (pos > ra->fim[v]) ra->fim[v] = pos;
+}
+
+/* Vivos por bloco (fluxo.c) e intervalos */
+static void vivacidade(Alocacao *ra, IrFuncao *f)
+{
+  FluxoCfg *cfg = fluxoCfg(f);
+  FluxoProblema *vivos = fluxoVivacidade(cfg);
+  int *u = (int *) malloc(sizeof(int) * fluxoMaxUsos(f));
+
+  /* intervalo = menor faixa contínua que cobre usos, definições e vivos */
+  for (int k = 0; k < cfg->nBlocos; k++)
+  {
+    FluxoBloco *b = &cfg->blocos[k];
+    unsigned long *in = fluxoConj(vivos, vivos->in, k);
+    unsigned long *out = fluxoConj(vivos, vivos->out, k);
+    for (int v = 0; v < ra->nvregs; v++)
+    {
+      if (fluxoTem(in, v)) estende(ra, v, b->ini);
+      if (fluxoTem(out, v)) estende(ra, v, b->fim);
+    }
+    IrInstr *primeira = &f->instr[b->ini];
+    if (primeira->op == IR_LABEL)
+    {
+      ra->posRotulo[primeira->imm] = b->ini;
+      memcpy(ra->vivosRotulo + (size_t) primeira->imm * ra->nPalavras, in, sizeof(unsigned long) * ra->nPalavras);
+    }
+  }
+  for (int k = 0; k < f->n; k++)
+  {
+    int n = fluxoUsos(&f->instr[k], u);
+    for (int x = 0; x < n; x++) estende(ra, u[x], k);
+    int d = fluxoDefinicao(&f->instr[k]);
+    if (d >= 0) estende(ra, d, k);
+  }
+
+  free(u);
+  fluxoLibera(vivos);
+  fluxoLiberaCfg(cfg);
+}
+
+static Alocacao *ordenaRa;
+
+static int comparaInicio(const void *x, const void *y)
+{
+  int a = *(const int *) x, b = *(const int *) y;
+  if (ordenaRa->inicio[a] != ordenaRa->inicio[b]) return ordenaRa->inicio[a] - ordenaRa->inicio[b];
+  return a - b;
+}
+
+static void marcaSalvo(Alocacao *ra, X86Reg r)
+{
+  for (int k = 0; k < N_CHAMADO; k++)
+  {
+    if (regsChamado[k] != r) continue;
+    for (int j = 0; j < ra->nSalvos; j++)
+      if (ra->salvos[j] == r) return;
+    ra->salvos[ra->nSalvos++] = r;
+  }
+}
+
+Alocacao *raAloca(IrFuncao *f)
+{
+  Alocacao *ra = (Alocacao *) calloc(1, sizeof(Alocacao));
+  int nv = f->nvregs;
+  ra->nvregs = nv;
+  ra->nPalavras = (nv + FLUXO_BITS - 1) / FLUXO_BITS;
+  if (ra->nPalavras == 0) ra->nPalavras = 1;
+  ra->inicio = (int *) malloc(sizeof(int) * (nv + 1));
+  ra->fim = (int *) malloc(sizeof(int) * (nv + 1));
+  ra->divisao = (int *) malloc(sizeof(int) * (nv + 1));
+  ra->reg = (X86Reg *) malloc(sizeof(X86Reg) * (nv + 1));
+  ra->vivosRotulo = (unsigned long *) calloc((size_t) (f->nrotulos + 1) * ra->nPalavras, sizeof(unsigned long));
+  ra->posRotulo = (int *) calloc(f->nrotulos + 1, sizeof(int));
+  for (int v = 0; v < nv; v++)
+  {
+    ra->inicio[v] = -1;
+    ra->fim[v] = -1;
+    ra->divisao[v] = INT_MAX;
+    ra->reg[v] = SEM_REG;
+  }
+
+  if (f->n > 0) vivacidade(ra, f);
+
+  /* chamadas antes de cada posição: o intervalo cruza uma chamada se
+     houver alguma estritamente entre início e fim */
+  int *chamadas = (int *) calloc(f->n + 1, sizeof(int));
+  for (int k = 0; k < f->n; k++)
+    chamadas[k + 1] = chamadas[k] + (f->instr[k].op == IR_CALL);
+
+  int *ordem = (int *) malloc(sizeof(int) * (nv + 1));
+  int n = 0;
+  for (int v = 0; v < nv; v++)
+    if (ra->inicio[v] >= 0) ordem[n++] = v;
+  ordenaRa = ra;
+  qsort(ordem, n, sizeof(int), comparaInicio);
+  ra->nIntervalos = n;
+
+  int ativos[N_CHAMADOR + N_CHAMADO];
+  int nAtivos = 0;
+
+  for (int k = 0; k < n; k++)
+  {
+    int cur = ordem[k];
+    int pos = ra->inicio[cur];
+
+    /* libera os intervalos que terminaram */
+    for (int j = 0; j < nAtivos;)
+    {
+      if (ra->fim[ativos[j]] < pos) ativos[j] = ativos[--nAtivos];
+      else j++;
+    }
+
+    int cruza = chamadas[ra->fim[cur]] - chamadas[pos + 1] > 0;
+    X86Reg permitidos[N_CHAMADOR + N_CHAMADO];
+    int nPermitidos = 0;
+    if (!cruza)
+      for (int j = 0; j < N_CHAMADOR; j++) permitidos[nPermitidos++] = regsChamador[j];
+    for (int j = 0; j < N_CHAMADO; j++) permitidos[nPermitidos++] = regsChamado[j];
+
+    X86Reg livre = SEM_REG;
+    for (int j = 0; j < nPermitidos && livre == SEM_REG; j++)
+    {
+      int ocupado = 0;
+      for (int a = 0; a < nAtivos; a++)
+        if (ra->reg[ativos[a]] == permitidos[j]) ocupado = 1;
+      if (!ocupado) livre = permitidos[j];
+    }
+
+    if (livre != SEM_REG)
+    {
+      ra->reg[cur] = livre;
+      ativos[nAtivos++] = cur;
+      continue;
+    }
+
+    /* sem registrador: divide o ativo (com registrador permitido) que
+       termina mais tarde, se ele terminar depois do atual */
+    int vitima = -1;
+    for (int a = 0; a < nAtivos; a++)
+    {
+      int ok = 0;
+      for (int j = 0; j < nPermitidos; j++)
+        if (ra->reg[ativos[a]] == permitidos[j]) ok = 1;
+      if (ok && (vitima < 0 || ra->fim[ativos[a]] > ra->fim[ativos[vitima]])) vitima = a;
+    }
+
+    if (vitima >= 0 && ra->fim[ativos[vitima]] > ra->fim[cur])
+    {
+      int v = ativos[vitima];
+      ra->reg[cur] = ra->reg[v];
+      ra->divisao[v] = pos;
+      if (pos <= ra->inicio[v]) ra->reg[v] = SEM_REG;
+      ativos[vitima] = cur;
+    }
+  }
+
+  for (int v = 0; v < nv; v++)
+  {
+    if (ra->inicio[v] < 0) continue;
+    if (ra->reg[v] == SEM_REG) ra->nMemoria++;
+    else if (ra->divisao[v] != INT_MAX) ra->nDivididos++;
+    else ra->nRegistrador++;
+    if (ra->reg[v] != SEM_REG) marcaSalvo(ra, ra->reg[v]);
+  }
+
+  free(chamadas);
+  free(ordem);
+  return ra;
+}
+
+void raLibera(Alocacao *ra)
+{
+  if (ra == NULL) return;
+  free(ra->inicio);
+  free(ra->fim);
+  free(ra->divisao);
+  free(ra->reg);
+  free(ra->vivosRotulo);
+  free(ra->posRotulo);
+  free(ra);
+}
+
+X86Reg raLocal(Alocacao *ra, int v, int pos)
+{
+  if (ra->reg[v] == SEM_REG || pos >= ra->divisao[v]) return SEM_REG;
+  return ra->reg[v];
+}
+
+int raVivoRotulo(Alocacao *ra, int rotulo, int v)
+{
+  return fluxoTem(ra->vivosRotulo + (size_t) rotulo * ra->nPalavras, v);
+}
+
+void raRelatorio(Alocacao *ra, IrFuncao *f, FILE *saida)
+{
+  fprintf(saida, "REGALLOC: '%s': %d intervalo(s), %d em registrador, %d dividido(s), %d na memória (spills: %d)\n",
+          f->sym->name, ra->nIntervalos, ra->nRegistrador, ra->nDivididos, ra->nMemoria,
+          ra->nDivididos + ra->nMemoria);
+}
@@ -0,0 +1,162 @@
+#include "../include/runtime.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Entrada e saída com buffers próprios de 1 MiB sobre read/write: um
+   inteiro custa só a conversão, e as chamadas ao sistema são por bloco. */
+
+#define TAM_BUFFER (1 << 20)
+
+static char entrada[TAM_BUFFER];
+static int posEntrada, fimEntrada;
+static int fimArquivo;
+
+static char saida[TAM_BUFFER];
+static int posSaida;
+
+static int terminal = -1;  /* saída é um terminal? (descobre na 1ª leitura) */
+
+/* pares "00".."99" para formatar dois dígitos por vez */
+static const char digitos[201] =
+  "00010203040506070809101112131415161718192021222324"
+  "25262728293031323334353637383940414243444546474849"
+  "50515253545556575859606162636465666768697071727374"
+  "75767778798081828384858687888990919293949596979899";
+
+static void escreveTudo(const char *p, int n)
+{
+  while (n > 0)
+  {
+    ssize_t k = write(1, p, n);
+    if (k < 0)
+    {
+      if (errno == EINTR) continue;
+      return;
+    }
+    p += k;
+    n -= (int) k;
+  }
+}
+
+void cm_flush(void)
+{
+  escreveTudo(saida, posSaida);
+  posSaida = 0;
+}
+
+/* descarrega também na saída normal do processo (exit, fim do main) */
+static void __attribute__((destructor)) fimRuntime(void)
+{
+  cm_flush();
+}
+
+/* recarrega o buffer de entrada; 0 no fim do arquivo */
+static int recarrega(void)
+{
+  if (fimArquivo) return 0;
+
+  /* programa interativo: o que foi escrito aparece antes de esperar a entrada */
+  if (terminal < 0) terminal = isatty(1);
+  if (terminal) cm_flush();
+
+  for (;;)
+  {
+    ssize_t k = read(0, entrada, TAM_BUFFER);
+    if (k < 0 && errno == EINTR) continue;
+    if (k <= 0)
+    {
+      fimArquivo = 1;
+      return 0;
+    }
+    posEntrada = 0;
+    fimEntrada = (int) k;
+    return 1;
+  }
+}
+
+static inline int espia(void)
+{
+  if (posEntrada == fimEntrada && !recarrega()) return -1;
+  return (unsigned char) entrada[posEntrada];
+}
+
+/* Mesmo resultado do scanf("%d") anterior: pula espaços, aceita sinal e
+   devolve 0 no fim da entrada ou diante de algo que não é número (que
+   fica na entrada, então as leituras seguintes também dão 0). */
+int cm_input(void)
+{
+  int c;
+  while ((c = espia()) == ' ' || (c >= '\t' && c <= '\r'))
+    posEntrada++;
+
+  int negativo = 0;
+  if (c == '-' || c == '+')
+  {
+    negativo = (c == '-');
+    posEntrada++;
+    c = espia();
+  }
+  if (c < '0' || c > '9') return 0;
+
+  unsigned valor = 0;
+  for (;;)
+  {
+    /* caminho rápido: dígitos dentro do buffer, sem testar recarga */
+    const char *p = entrada + posEntrada;
+    const char *fim = entrada + fimEntrada;
+    while (p < fim && (unsigned) (*p - '0') < 10)
+      valor = valor * 10 + (unsigned) (*p++ - '0');
+    posEntrada = (int) (p - entrada);
+    if (p < fim || !recarrega()) break;
+  }
+  return (int) (negativo ? 0u - valor : valor);
+}
+
+void cm_output(int valor)
+{
+  /* maior saída: "-2147483648\n" (12 bytes) */
+  if (posSaida > TAM_BUFFER - 12) cm_flush();
+
+  char tmp[12];
+  char *p = tmp + sizeof(tmp);
+  unsigned u = (valor < 0) ? 0u - (unsigned) valor : (unsigned) valor;
+  while (u >= 100)
+  {
+    unsigned d = (u % 100) * 2;
+    u /= 100;
+    *--p = digitos[d + 1];
+    *--p = digitos[d];
+  }
+  if (u >= 10)
+  {
+    *--p = digitos[u * 2 + 1];
+    *--p = digitos[u * 2];
+  }
+  else
+  {
+    *--p = (char) ('0' + u);
+  }
+  if (valor < 0) *--p = '-';
+
+  char *s = saida + posSaida;
+  int n = (int) (tmp + sizeof(tmp) - p);
+  for (int k = 0; k < n; k++) s[k] = p[k];
+  s[n] = '\n';
+  posSaida += n + 1;
+}
+
+void cm_div_zero(void)
+{
+  cm_flush();
+  fprintf(stderr, "ERRO DE EXECUÇÃO: divisão por zero.\n");
+  exit(1);
+}
+
+void cm_indice_invalido(void)
+{
+  cm_flush();
+  fprintf(stderr, "ERRO DE EXECUÇÃO: índice fora dos limites.\n");
+  exit(1);
+}
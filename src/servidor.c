@@ -0,0 +1,221 @@
+#include "../include/servidor.h"
+#include "../include/cminus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/* Lê ou escreve exatamente n bytes; 0 se a conexão caiu */
+static int leTudo(int fd, void *buf, size_t n)
+{
+  char *p = (char *) buf;
+  while (n > 0)
+  {
+    ssize_t k = read(fd, p, n);
+    if (k < 0 && errno == EINTR) continue;
+    if (k <= 0) return 0;
+    p += k;
+    n -= (size_t) k;
+  }
+  return 1;
+}
+
+static int escreveTudo(int fd, const void *buf, size_t n)
+{
+  const char *p = (const char *) buf;
+  while (n > 0)
+  {
+    ssize_t k = write(fd, p, n);
+    if (k < 0 && errno == EINTR) continue;
+    if (k <= 0) return 0;
+    p += k;
+    n -= (size_t) k;
+  }
+  return 1;
+}
+
+static int endereco(const char *caminho, struct sockaddr_un *end)
+{
+  memset(end, 0, sizeof(*end));
+  end->sun_family = AF_UNIX;
+  if (strlen(caminho) >= sizeof(end->sun_path)) return 0;
+  strcpy(end->sun_path, caminho);
+  return 1;
+}
+
+/* --- Servidor --- */
+
+/* diagnósticos de uma resposta, um por linha */
+static char *textoDiagnosticos(const CmResultado *r, unsigned *tam)
+{
+  size_t total = 0;
+  for (int i = 0; i < cmNumDiagnosticos(r); i++) total += strlen(cmDiagnostico(r, i)->mensagem) + 1;
+  char *texto = (char *) malloc(total + 1);
+  char *p = texto;
+  for (int i = 0; i < cmNumDiagnosticos(r); i++)
+  {
+    size_t n = strlen(cmDiagnostico(r, i)->mensagem);
+    memcpy(p, cmDiagnostico(r, i)->mensagem, n);
+    p[n] = '\n';
+    p += n + 1;
+  }
+  *p = '\0';
+  *tam = (unsigned) total;
+  return texto;
+}
+
+static void *atende(void *arg)
+{
+  int fd = (int) (long) arg;
+  char *fonte = NULL;
+  unsigned cap = 0;
+  for (;;)
+  {
+    uint32_t tam;
+    if (!leTudo(fd, &tam, sizeof(tam))) break;
+    tam = ntohl(tam);
+    if (tam > SERVIDOR_MAX_FONTE) break;
+    if (tam > cap || fonte == NULL)
+    {
+      cap = tam > 0 ? tam : 1;
+      fonte = (char *) realloc(fonte, cap);
+    }
+    if (!leTudo(fd, fonte, tam)) break;
+
+    CmResultado *r = cmCompilaFonte(fonte, tam);
+    unsigned tamTexto;
+    char *texto = textoDiagnosticos(r, &tamTexto);
+    uint32_t cab[2] = { htonl((uint32_t) cmNumDiagnosticos(r)), htonl(tamTexto) };
+    cmLibera(r);
+    int ok = escreveTudo(fd, cab, sizeof(cab)) && escreveTudo(fd, texto, tamTexto);
+    free(texto);
+    if (!ok) break;
+  }
+  free(fonte);
+  close(fd);
+  return NULL;
+}
+
+static volatile sig_atomic_t parar = 0;
+
+static void sinalParar(int sinal)
+{
+  (void) sinal;
+  parar = 1;
+}
+
+int servidorExecuta(const char *caminho)
+{
+  struct sockaddr_un end;
+  if (!endereco(caminho, &end))
+  {
+    fprintf(stderr, "Caminho do socket longo demais: %s\n", caminho);
+    return 1;
+  }
+  int escuta = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (escuta < 0)
+  {
+    perror("Erro ao criar socket");
+    return 1;
+  }
+  /* só remove o que for um socket (de uma execução anterior) */
+  struct stat st;
+  if (lstat(caminho, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(caminho);
+  if (bind(escuta, (struct sockaddr *) &end, sizeof(end)) < 0 || listen(escuta, 64) < 0)
+  {
+    perror("Erro ao escutar no socket");
+    close(escuta);
+    return 1;
+  }
+
+  /* sem SA_RESTART: o accept volta com EINTR e o laço vê 'parar' */
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = sinalParar;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  fprintf(stderr, "SERVIDOR: escutando em %s\n", caminho);
+  long atendidas = 0;
+  /* as threads das conexões nascem com os sinais bloqueados, para que
+     cheguem a esta e interrompam o accept */
+  sigset_t sinais, antes;
+  sigemptyset(&sinais);
+  sigaddset(&sinais, SIGINT);
+  sigaddset(&sinais, SIGTERM);
+  int espera = 0;   /* ms antes de tentar de novo depois de um erro */
+  while (!parar)
+  {
+    int fd = accept(escuta, NULL, NULL);
+    if (fd < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      /* EMFILE, ENFILE, ENOBUFS...: não adianta repetir na hora; espera
+         (10 ms, dobrando até 1 s) e avisa uma vez por sequência de erros */
+      if (espera == 0) perror("SERVIDOR: accept");
+      espera = (espera == 0) ? 10 : (espera < 1000 ? espera * 2 : 1000);
+      usleep(espera * 1000);
+      continue;
+    }
+    espera = 0;
+    pthread_t t;
+    pthread_sigmask(SIG_BLOCK, &sinais, &antes);
+    int criou = pthread_create(&t, NULL, atende, (void *) (long) fd) == 0;
+    pthread_sigmask(SIG_SETMASK, &antes, NULL);
+    if (!criou)
+    {
+      close(fd);
+      continue;
+    }
+    pthread_detach(t);
+    atendidas++;
+  }
+
+  close(escuta);
+  unlink(caminho);
+  fprintf(stderr, "SERVIDOR: %ld conexão(ões) atendida(s)\n", atendidas);
+  return 0;
+}
+
+/* --- Cliente --- */
+
+int servidorConecta(const char *caminho)
+{
+  struct sockaddr_un end;
+  if (!endereco(caminho, &end)) return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  if (connect(fd, (struct sockaddr *) &end, sizeof(end)) < 0)
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int servidorPede(int fd, const char *fonte, unsigned tam, char **texto)
+{
+  *texto = NULL;
+  uint32_t n = htonl(tam);
+  if (!escreveTudo(fd, &n, sizeof(n)) || !escreveTudo(fd, fonte, tam)) return -1;
+  uint32_t cab[2];
+  if (!leTudo(fd, cab, sizeof(cab))) return -1;
+  unsigned tamTexto = ntohl(cab[1]);
+  *texto = (char *) malloc(tamTexto + 1);
+  if (!leTudo(fd, *texto, tamTexto))
+  {
+    free(*texto);
+    *texto = NULL;
+    return -1;
+  }
+  (*texto)[tamTexto] = '\0';
+  return (int) ntohl(cab[0]);
+}
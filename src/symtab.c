@@ -38,8 +38,10 @@ void st_insert(char * name, int lineno, int loc, int scope,
     
     /* Zera os campos opcionais por segurança */
     l->size = 0;
+    l->frameSize = 0;
     l->numParams = 0;
     l->paramTypes = NULL;
+    l->paramArray = NULL;
 
     /* Encadeia na lista */
     l->next = hashTable[h];
@@ -95,23 +97,78 @@ BucketList st_lookup_rec(char * name) {
 }
 
 /* Define parâmetros para função já inserida */
-void st_set_params(char * name, int numParams, ExpType * types) {
+void st_set_params(char * name, int numParams, ExpType * types, char * arrays) {
     BucketList l = st_lookup_rec(name);
     if (l == NULL) return;
-    if (l->paramTypes != NULL) {
-        free(l->paramTypes);
-        l->paramTypes = NULL;
-    }
+    free(l->paramTypes);
+    free(l->paramArray);
+    l->paramTypes = NULL;
+    l->paramArray = NULL;
     if (numParams > 0) {
         l->paramTypes = (ExpType *) malloc(sizeof(ExpType) * numParams);
-        for (int i = 0; i < numParams; ++i) l->paramTypes[i] = types[i];
+        l->paramArray = (char *) calloc(numParams, 1);
+        for (int i = 0; i < numParams; ++i) {
+            l->paramTypes[i] = types[i];
+            if (arrays != NULL) l->paramArray[i] = arrays[i];
+        }
         l->numParams = numParams;
     } else {
-        l->paramTypes = NULL;
         l->numParams = 0;
     }
 }
 
+int st_celula_tamanho(BucketList s) {
+    return s->loc + 1;
+}
+
+int st_celulas_params(BucketList f) {
+    int n = f->numParams;
+    for (int i = 0; i < f->numParams && f->paramArray != NULL; ++i) n += f->paramArray[i];
+    return n;
+}
+
+/* Remove os símbolos dos escopos >= primeiro (locais de uma função já
+   analisada, no modo --continuo). Eles são os últimos inseridos, então
+   estão no começo das cadeias: cada cadeia é lida só até o primeiro
+   símbolo de outro escopo. */
+void st_descarta_escopos(int primeiro) {
+    for (int i = 0; i < SIZE; ++i) {
+        BucketList l = hashTable[i];
+        while (l != NULL && l->scope >= primeiro) {
+            BucketList prox = l->next;
+            free(l->name);
+            free(l->paramTypes);
+            free(l->paramArray);
+            free(l);
+            l = prox;
+        }
+        hashTable[i] = l;
+    }
+}
+
+/* Visita todos os símbolos, balde por balde */
+void st_percorre(void (*visita)(BucketList l, void *ctx), void *ctx) {
+    for (int i = 0; i < SIZE; ++i)
+        for (BucketList l = hashTable[i]; l != NULL; l = l->next)
+            visita(l, ctx);
+}
+
+/* Esvazia a tabela (compilação de vários arquivos no mesmo processo) */
+void st_limpa(void) {
+    for (int i = 0; i < SIZE; ++i) {
+        BucketList l = hashTable[i];
+        while (l != NULL) {
+            BucketList prox = l->next;
+            free(l->name);
+            free(l->paramTypes);
+            free(l->paramArray);
+            free(l);
+            l = prox;
+        }
+        hashTable[i] = NULL;
+    }
+}
+
 /* Imprime a tabela formatada */
 void printSymTab(FILE * listing) {
     int i;
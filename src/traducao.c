@@ -0,0 +1,476 @@
+#include "../include/traducao.h"
+#include "../include/symtab.h"
+#include "../include/limites.h"
+#include "../include/analyze.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Nomes gerados (identificadores de C- só têm letras, então não colidem):
+     cm_<nome>         globais e funções
+     <nome>_<loc>      parâmetros e locais
+     <nome>_n<loc>     tamanho escondido do parâmetro int x[]
+     cm_t<n>           temporários que fixam a ordem de avaliação
+     cm__<op>          aritmética com a semântica da VM */
+
+static int nTemps;  /* temporários da função corrente */
+
+int traducaoSeparada = 0;
+
+static void expr(FILE *o, TreeNode *t);
+
+static int ehGlobal(BucketList s)
+{
+  return s->scope == 0;
+}
+
+static void nome(FILE *o, BucketList s)
+{
+  if (ehGlobal(s))
+    fprintf(o, "cm_%s", s->name);
+  else
+    fprintf(o, "%s_%d", s->name, s->loc);
+}
+
+/* tamanho de um array: o declarado, ou o que veio com o parâmetro int x[] */
+static void tamanho(FILE *o, BucketList s)
+{
+  if (ehGlobal(s) || s->size > 0)
+    fprintf(o, "%d", s->size);
+  else
+    fprintf(o, "%s_n%d", s->name, s->loc);
+}
+
+static void recua(FILE *o, int nivel)
+{
+  for (int k = 0; k < nivel; k++) fputs("  ", o);
+}
+
+/* a subárvore escreve em variáveis (atribuição ou chamada)? */
+static int temEfeito(TreeNode *t)
+{
+  if (t == NULL) return 0;
+  if (t->tipoNo == NO_ATRIBUICAO || t->tipoNo == NO_CHAMADA) return 1;
+  for (TreeNode *c = t->filho; c != NULL; c = c->irmao)
+    if (temEfeito(c)) return 1;
+  return 0;
+}
+
+static int ehArray(TreeNode *t)
+{
+  return t->tipoNo == NO_VAR && t->sym != NULL && t->sym->kind == ID_ARRAY;
+}
+
+/* C não ordena os operandos de um operador nem os argumentos de uma
+   chamada; quando a ordem importa, o valor vai antes para um temporário
+   e o resto da expressão segue depois de um operador vírgula */
+static int novoTemp(FILE *o, TreeNode *valor)
+{
+  int t = nTemps++;
+  fprintf(o, "cm_t%d = ", t);
+  expr(o, valor);
+  fputs(", ", o);
+  return t;
+}
+
+/* índice do acesso, testado em execução no modo --checked */
+static void indice(FILE *o, TreeNode *acesso)
+{
+  if (!precisaTesteLimite(acesso))
+  {
+    expr(o, acesso->filho->irmao);
+    return;
+  }
+  fputs("cm__limite(", o);
+  expr(o, acesso->filho->irmao);
+  fputs(", ", o);
+  tamanho(o, acesso->filho->sym);
+  fputc(')', o);
+}
+
+/* topo: comando de expressão, sem parênteses em volta */
+static void atribuicao(FILE *o, TreeNode *t, int topo)
+{
+  TreeNode *lhs = t->filho;
+  TreeNode *rhs = lhs->irmao;
+  /* x = f(...) já é ordenado em C; o resto com efeito vai antes */
+  int efeito = temEfeito(rhs);
+  int tempValor = efeito && rhs->tipoNo != NO_CHAMADA;
+
+  if (!topo) fputc('(', o);
+  int idx = -1;
+  if (lhs->tipoNo == NO_ARRAY_IDX)
+  {
+    TreeNode *i = lhs->filho->irmao;
+    if (i->tipoNo != NO_NUM && (efeito || temEfeito(i)))
+    {
+      /* o teste vai junto, antes do valor (como na VM) */
+      idx = nTemps++;
+      fprintf(o, "cm_t%d = ", idx);
+      indice(o, lhs);
+      fputs(", ", o);
+    }
+  }
+  int v = tempValor ? novoTemp(o, rhs) : -1;
+
+  if (lhs->tipoNo == NO_ARRAY_IDX)
+  {
+    nome(o, lhs->filho->sym);
+    fputc('[', o);
+    if (idx >= 0)
+      fprintf(o, "cm_t%d", idx);
+    else
+      indice(o, lhs);
+    fputc(']', o);
+  }
+  else
+  {
+    nome(o, lhs->sym);
+  }
+  fputs(" = ", o);
+  if (v >= 0)
+    fprintf(o, "cm_t%d", v);
+  else
+    expr(o, rhs);
+  if (!topo) fputc(')', o);
+}
+
+/* topo: condição de if/while, que já vem entre parênteses */
+static void binaria(FILE *o, TreeNode *t, int topo)
+{
+  TreeNode *a = t->filho;
+  TreeNode *b = a->irmao;
+  char *op = t->attr.lexema;
+  int temp = -1;
+  int ordena = a->tipoNo != NO_NUM && b->tipoNo != NO_NUM && (temEfeito(a) || temEfeito(b));
+  int parenteses = ordena || (t->tipoNo == NO_OP_REL && !topo);
+
+  if (parenteses) fputc('(', o);
+  if (ordena) temp = novoTemp(o, a);
+
+  /* + - * / passam pelos auxiliares com a semântica da VM */
+  const char *aux = NULL;
+  if (t->tipoNo != NO_OP_REL)
+  {
+    if (strcmp(op, "+") == 0) aux = "cm__soma";
+    else if (strcmp(op, "-") == 0) aux = "cm__sub";
+    else if (strcmp(op, "*") == 0) aux = "cm__mul";
+    else aux = "cm__div";
+    fprintf(o, "%s(", aux);
+  }
+  if (temp >= 0)
+    fprintf(o, "cm_t%d", temp);
+  else
+    expr(o, a);
+  if (aux != NULL)
+    fputs(", ", o);
+  else
+    fprintf(o, " %s ", op);
+  expr(o, b);
+  if (aux != NULL) fputc(')', o);
+  if (parenteses) fputc(')', o);
+}
+
+static void chamada(FILE *o, TreeNode *t)
+{
+  int nargs = 0, efeito = 0;
+  for (TreeNode *a = t->filho; a != NULL; a = a->irmao)
+  {
+    nargs++;
+    efeito |= temEfeito(a);
+  }
+
+  /* argumentos antes do último viram temporários se algum tiver efeito */
+  int *temps = (int *) malloc(sizeof(int) * (nargs > 0 ? nargs : 1));
+  int k = 0, ordena = 0;
+  for (TreeNode *a = t->filho; a != NULL; a = a->irmao, k++)
+  {
+    temps[k] = -1;
+    if (efeito && a->irmao != NULL && a->tipoNo != NO_NUM && !ehArray(a))
+    {
+      if (!ordena) fputc('(', o);
+      ordena = 1;
+      temps[k] = novoTemp(o, a);
+    }
+  }
+
+  BucketList f = t->sym;
+  fprintf(o, "cm_%s(", f->name);
+  k = 0;
+  for (TreeNode *a = t->filho; a != NULL; a = a->irmao, k++)
+  {
+    if (k > 0) fputs(", ", o);
+    if (temps[k] >= 0)
+      fprintf(o, "cm_t%d", temps[k]);
+    else
+      expr(o, a);
+    /* int x[] leva o tamanho junto; 0 se o argumento não é array */
+    if (k < f->numParams && f->paramArray != NULL && f->paramArray[k])
+    {
+      fputs(", ", o);
+      if (ehArray(a))
+        tamanho(o, a->sym);
+      else
+        fputc('0', o);
+    }
+  }
+  fputc(')', o);
+  if (ordena) fputc(')', o);
+  free(temps);
+}
+
+static void expr(FILE *o, TreeNode *t)
+{
+  switch (t->tipoNo)
+  {
+  case NO_NUM:
+    fprintf(o, "%d", atoi(t->attr.lexema));
+    break;
+
+  case NO_VAR:
+    nome(o, t->sym);
+    break;
+
+  case NO_ARRAY_IDX:
+    nome(o, t->filho->sym);
+    fputc('[', o);
+    indice(o, t);
+    fputc(']', o);
+    break;
+
+  case NO_ATRIBUICAO:
+    atribuicao(o, t, 0);
+    break;
+
+  case NO_OP_SOMA:
+  case NO_OP_MULT:
+  case NO_OP_REL:
+    binaria(o, t, 0);
+    break;
+
+  case NO_CHAMADA:
+    chamada(o, t);
+    break;
+
+  default:
+    fputc('0', o);
+    break;
+  }
+}
+
+static void condicao(FILE *o, TreeNode *t)
+{
+  if (t->tipoNo == NO_OP_REL)
+    binaria(o, t, 1);
+  else
+    expr(o, t);
+}
+
+static void declaracao(FILE *o, TreeNode *d)
+{
+  BucketList s = d->sym;
+  if (ehGlobal(s) && !traducaoSeparada) fputs("static ", o);
+  fputs("int ", o);
+  nome(o, s);
+  if (s->kind == ID_ARRAY) fprintf(o, "[%d]", s->size);
+  fputs(";\n", o);
+}
+
+static void comando(FILE *o, TreeNode *t, int nivel)
+{
+  if (t == NULL)
+  {
+    recua(o, nivel);
+    fputs(";\n", o);
+    return;
+  }
+
+  switch (t->tipoNo)
+  {
+  case NO_DECLARACAO_VAR:
+    if (t->sym != NULL)
+    {
+      recua(o, nivel);
+      declaracao(o, t);
+    }
+    break;
+
+  case NO_BLOCO:
+    recua(o, nivel - 1 > 0 ? nivel - 1 : 0);
+    fputs("{\n", o);
+    for (TreeNode *c = t->filho; c != NULL; c = c->irmao)
+      comando(o, c, c->tipoNo == NO_BLOCO ? nivel + 1 : nivel);
+    recua(o, nivel - 1 > 0 ? nivel - 1 : 0);
+    fputs("}\n", o);
+    break;
+
+  case NO_IF:
+  {
+    TreeNode *entao = t->filho->irmao;
+    TreeNode *senao = (entao != NULL) ? entao->irmao : NULL;
+    recua(o, nivel);
+    fputs("if (", o);
+    condicao(o, t->filho);
+    fputs(")\n", o);
+    comando(o, entao, nivel + 1);
+    if (senao != NULL)
+    {
+      recua(o, nivel);
+      fputs("else\n", o);
+      comando(o, senao, nivel + 1);
+    }
+  }
+  break;
+
+  case NO_WHILE:
+    recua(o, nivel);
+    fputs("while (", o);
+    condicao(o, t->filho);
+    fputs(")\n", o);
+    comando(o, t->filho->irmao, nivel + 1);
+    break;
+
+  case NO_RETURN:
+    recua(o, nivel);
+    if (t->filho != NULL)
+    {
+      fputs("return ", o);
+      expr(o, t->filho);
+      fputs(";\n", o);
+    }
+    else
+    {
+      fputs("return;\n", o);
+    }
+    break;
+
+  default:
+    recua(o, nivel);
+    if (t->tipoNo == NO_ATRIBUICAO)
+      atribuicao(o, t, 1);
+    else
+      expr(o, t);
+    fputs(";\n", o);
+    break;
+  }
+}
+
+static void prototipo(FILE *o, TreeNode *decl)
+{
+  BucketList f = decl->sym;
+  fprintf(o, "%s%s cm_%s(", traducaoSeparada ? "" : "static ", f->type == Integer ? "int" : "void", f->name);
+  int n = 0;
+  for (TreeNode *p = decl->filho->irmao->irmao; p != NULL && p->tipoNo != NO_BLOCO; p = p->irmao)
+  {
+    if (p->tipoNo != NO_PARAM || p->sym == NULL) continue;
+    if (n++ > 0) fputs(", ", o);
+    fputs(p->sym->kind == ID_ARRAY ? "int *" : "int ", o);
+    nome(o, p->sym);
+    if (p->sym->kind == ID_ARRAY) fprintf(o, ", int %s_n%d", p->sym->name, p->sym->loc);
+  }
+  if (n == 0) fputs("void", o);
+  fputc(')', o);
+}
+
+/* símbolos de outras unidades, com os tipos da interface */
+static void importadas(FILE *o)
+{
+  for (int k = 0; analyzeImportada(k) != NULL; k++)
+  {
+    const Interface *i = analyzeImportada(k);
+    for (int j = 0; j < i->n; j++)
+    {
+      const InterfaceSimbolo *s = &i->simbolos[j];
+      if (s->kind == ID_VAR)
+        fprintf(o, "extern int cm_%s;\n", s->nome);
+      else if (s->kind == ID_ARRAY)
+        fprintf(o, "extern int cm_%s[%d];\n", s->nome, s->tamanho);
+      else
+      {
+        fprintf(o, "extern %s cm_%s(", s->tipo == Integer ? "int" : "void", s->nome);
+        for (int p = 0; p < s->numParams; p++)
+          fprintf(o, "%s%s", p > 0 ? ", " : "", s->paramArray[p] ? "int *, int" : "int");
+        fputs(s->numParams == 0 ? "void);\n" : ");\n", o);
+      }
+    }
+  }
+}
+
+static int defineMain(TreeNode *arvore)
+{
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_FUN && d->sym != NULL && strcmp(d->sym->name, "main") == 0) return 1;
+  return 0;
+}
+
+static void funcao(FILE *o, TreeNode *decl)
+{
+  TreeNode *corpo = decl->filho->irmao->irmao;
+  while (corpo != NULL && corpo->tipoNo != NO_BLOCO) corpo = corpo->irmao;
+
+  /* o corpo vai para um buffer: os temporários só são conhecidos no fim */
+  char *texto = NULL;
+  size_t tam = 0;
+  FILE *b = open_memstream(&texto, &tam);
+  nTemps = 0;
+  if (corpo != NULL)
+    for (TreeNode *c = corpo->filho; c != NULL; c = c->irmao)
+      comando(b, c, c->tipoNo == NO_BLOCO ? 2 : 1);
+  fclose(b);
+
+  fputc('\n', o);
+  prototipo(o, decl);
+  fputs("\n{\n", o);
+  for (int t = 0; t < nTemps; t++)
+    fprintf(o, "  int cm_t%d;\n", t);
+  fputs(texto, o);
+  /* retorno implícito ao fim do corpo */
+  if (decl->sym->type == Integer) fputs("  return 0;\n", o);
+  fputs("}\n", o);
+  free(texto);
+}
+
+void traduzParaC(TreeNode *arvore, const char *origem, FILE *saida)
+{
+  fprintf(saida, "/* Gerado pelo compilador C- a partir de %s.\n", origem);
+  fputs("   Ligar com o runtime: cc -O2 prog.c src/runtime.c */\n\n", saida);
+
+  fputs("int cm_input(void);\n"
+        "void cm_output(int valor);\n"
+        "void cm_flush(void);\n"
+        "void cm_div_zero(void);\n", saida);
+  if (modoVerificado) fputs("void cm_indice_invalido(void);\n", saida);
+  fputc('\n', saida);
+
+  /* aritmética da VM: overflow com volta, divisão por zero é erro */
+  fputs("static inline int cm__soma(int a, int b) { return (int) ((unsigned) a + (unsigned) b); }\n"
+        "static inline int cm__sub(int a, int b) { return (int) ((unsigned) a - (unsigned) b); }\n"
+        "static inline int cm__mul(int a, int b) { return (int) ((unsigned) a * (unsigned) b); }\n"
+        "static inline int cm__div(int a, int b)\n"
+        "{\n"
+        "  if (b == 0) cm_div_zero();\n"
+        "  return (b == -1) ? (int) (0u - (unsigned) a) : a / b;\n"
+        "}\n\n", saida);
+  if (modoVerificado)
+    fputs("static inline int cm__limite(int i, int n)\n"
+          "{\n"
+          "  if ((unsigned) i >= (unsigned) n) cm_indice_invalido();\n"
+          "  return i;\n"
+          "}\n\n", saida);
+
+  if (traducaoSeparada) importadas(saida);
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_VAR && d->sym != NULL) declaracao(saida, d);
+
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_FUN && d->sym != NULL)
+    {
+      prototipo(saida, d);
+      fputs(";\n", saida);
+    }
+
+  for (TreeNode *d = arvore->filho; d != NULL; d = d->irmao)
+    if (d->tipoNo == NO_DECLARACAO_FUN && d->sym != NULL) funcao(saida, d);
+
+  if (!traducaoSeparada || defineMain(arvore))
+    fputs("\nint main(void)\n{\n  cm_main();\n  cm_flush();\n  return 0;\n}\n", saida);
+}
@@ -0,0 +1,487 @@
+#include "../include/vm.h"
+#include "../include/runtime.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <setjmp.h>
+#include <sys/resource.h>
+
+/* Memória da VM: globais contíguas a partir de 0 e, logo acima,
+   a pilha pré-alocada onde ficam os frames e os operandos. */
+#define VM_PILHA (1 << 22)      /* células para frames e operandos */
+#define VM_CHAMADAS (1 << 20)   /* profundidade máxima de chamadas */
+
+// Função já resolvida para o código encadeado
+typedef struct
+{
+  void **entrada;
+  int nparams;
+  int frameSize;
+  int maxPilha;
+  int indice;
+  int retornaValor;
+  int contador;     // chamadas (para o JIT)
+} VmFuncao;
+
+// Registro de retorno (fica fora da memória de dados). pc == NULL marca
+// o retorno para quem chamou vmLaco (início ou código nativo).
+typedef struct
+{
+  void **pc;
+  int *fp;
+} VmRetorno;
+
+int usaJit = 0;
+
+/* estado da execução corrente */
+static Bytecode *bc;
+static void **codigo;
+static VmFuncao *funcoes;
+static int *mem;
+static int *limite;
+static VmRetorno *retornos, *rp, *rlimite;
+static long executadas;
+static Jit *jit;
+static int *contLaco;     /* por posição: desvios de volta executados */
+static int *funcaoDoPc;   /* por posição: índice da função */
+static jmp_buf saidaErro;
+static void **rotulos;    /* tabela de despacho de vmLaco */
+
+static double agora(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* nome da função que contém a instrução 'pc' (para mensagens de erro) */
+static const char *funcaoDe(int pc)
+{
+  const char *nome = "?";
+  int melhor = -1;
+  for (int i = 0; i < bc->nFuncoes; i++)
+  {
+    int e = bc->funcoes[i].entrada;
+    if (e >= 0 && e <= pc && e > melhor)
+    {
+      melhor = e;
+      nome = bc->funcoes[i].nome;
+    }
+  }
+  return nome;
+}
+
+static void falha(const char *erro, const char *funcao)
+{
+  cm_flush();
+  fprintf(stderr, "ERRO DE EXECUÇÃO: %s na função '%s'.\n", erro, funcao);
+  longjmp(saidaErro, 1);
+}
+
+/* Interpretador: executa a partir de pc até o retorno da função em que
+   entrou (ou HALT) e devolve o valor retornado. Reentrante: o código
+   nativo chama funções ainda interpretadas por aqui. */
+static int vmLaco(void **pc, int *fp, int *sp)
+{
+  /* tabela de despacho: um rótulo por opcode (computed goto) */
+  static void *tabela[OP_COUNT] = {
+    [OP_HALT] = &&op_halt, [OP_CONST] = &&op_const,
+    [OP_LOADL] = &&op_loadl, [OP_STOREL] = &&op_storel,
+    [OP_LOADG] = &&op_loadg, [OP_STOREG] = &&op_storeg,
+    [OP_ADDRL] = &&op_addrl, [OP_ADDRG] = &&op_addrg,
+    [OP_LOADI] = &&op_loadi, [OP_STOREI] = &&op_storei, [OP_STOREIK] = &&op_storeik,
+    [OP_DUP] = &&op_dup, [OP_POP] = &&op_pop,
+    [OP_ADD] = &&op_add, [OP_SUB] = &&op_sub, [OP_MUL] = &&op_mul, [OP_DIV] = &&op_div,
+    [OP_LT] = &&op_lt, [OP_LE] = &&op_le, [OP_GT] = &&op_gt,
+    [OP_GE] = &&op_ge, [OP_EQ] = &&op_eq, [OP_NE] = &&op_ne,
+    [OP_JMP] = &&op_jmp, [OP_JZ] = &&op_jz,
+    [OP_JNLT] = &&op_jnlt, [OP_JNLE] = &&op_jnle, [OP_JNGT] = &&op_jngt,
+    [OP_JNGE] = &&op_jnge, [OP_JNEQ] = &&op_jneq, [OP_JNNE] = &&op_jnne,
+    [OP_CALL] = &&op_call, [OP_RET] = &&op_ret, [OP_RETV] = &&op_retv,
+    [OP_INPUT] = &&op_input, [OP_OUTPUT] = &&op_output, [OP_LIMITE] = &&op_limite,
+    [OP_LIMITEL] = &&op_limitel
+  };
+
+  if (pc == NULL)
+  {
+    rotulos = tabela;
+    return 0;
+  }
+
+  const char *erro = NULL;
+  char marca;
+  if (rp == rlimite || (jit != NULL && &marca < jit->limitePilhaC))
+  {
+    erro = "estouro de pilha";
+    goto falha;
+  }
+  rp->pc = NULL;
+  rp->fp = NULL;
+  rp++;
+
+#define PROXIMA() do { executadas++; goto **pc++; } while (0)
+#define ARG() ((intptr_t) *pc++)
+#define ALVO() ((void **) *pc++)
+#define BINARIA(expr) do { sp--; int a = sp[-1], b = sp[0]; (void) a; (void) b; sp[-1] = (expr); } while (0)
+#define DESVIA_SE_NAO(cond) do { void **alvo = ALVO(); sp -= 2; int a = sp[0], b = sp[1]; if (!(cond)) pc = alvo; } while (0)
+#define RETORNA(v, temValor) do { \
+    sp = fp; rp--; \
+    if (rp->pc == NULL) return (v); \
+    pc = rp->pc; fp = rp->fp; \
+    if (temValor) *sp++ = (v); \
+  } while (0)
+
+  PROXIMA();
+
+op_halt:
+  rp--;
+  return 0;
+
+op_const:
+  *sp++ = (int) ARG();
+  PROXIMA();
+
+op_loadl:
+  *sp++ = fp[ARG()];
+  PROXIMA();
+
+op_storel:
+  fp[ARG()] = *--sp;
+  PROXIMA();
+
+op_loadg:
+  *sp++ = mem[ARG()];
+  PROXIMA();
+
+op_storeg:
+  mem[ARG()] = *--sp;
+  PROXIMA();
+
+op_addrl:
+  *sp++ = (int) (fp - mem) + (int) ARG();
+  PROXIMA();
+
+op_addrg:
+  *sp++ = (int) ARG();
+  PROXIMA();
+
+op_loadi:
+  sp--;
+  sp[-1] = mem[sp[-1] + sp[0]];
+  PROXIMA();
+
+op_storei:
+  sp -= 3;
+  mem[sp[0] + sp[1]] = sp[2];
+  PROXIMA();
+
+op_storeik:
+  sp -= 2;
+  mem[sp[-1] + sp[0]] = sp[1];
+  sp[-1] = sp[1];
+  PROXIMA();
+
+op_dup:
+  *sp = sp[-1];
+  sp++;
+  PROXIMA();
+
+op_pop:
+  sp--;
+  PROXIMA();
+
+  /* aritmética em complemento de dois (sem comportamento indefinido) */
+op_add:
+  BINARIA((int) ((unsigned) a + (unsigned) b));
+  PROXIMA();
+
+op_sub:
+  BINARIA((int) ((unsigned) a - (unsigned) b));
+  PROXIMA();
+
+op_mul:
+  BINARIA((int) ((unsigned) a * (unsigned) b));
+  PROXIMA();
+
+op_div:
+  if (sp[-1] == 0)
+  {
+    erro = "divisão por zero";
+    goto falha;
+  }
+  BINARIA((b == -1) ? (int) (0u - (unsigned) a) : a / b);
+  PROXIMA();
+
+op_lt:
+  BINARIA(a < b);
+  PROXIMA();
+
+op_le:
+  BINARIA(a <= b);
+  PROXIMA();
+
+op_gt:
+  BINARIA(a > b);
+  PROXIMA();
+
+op_ge:
+  BINARIA(a >= b);
+  PROXIMA();
+
+op_eq:
+  BINARIA(a == b);
+  PROXIMA();
+
+op_ne:
+  BINARIA(a != b);
+  PROXIMA();
+
+op_jmp:
+  {
+    void **alvo = (void **) *pc;
+    if (jit != NULL && alvo < pc)
+    {
+      /* desvio de volta: laço quente compila a função e continua no
+         código nativo a partir do início do laço (frame é o mesmo) */
+      int pos = (int) (pc - codigo);
+      int f = funcaoDoPc[pos];
+      if (jit->nativo[f] == NULL && ++contLaco[pos] == JIT_LIMIAR) jitCompila(jit, f);
+      void *entrada = jit->entradaLaco[alvo - codigo];
+      if (jit->nativo[f] != NULL && entrada != NULL)
+      {
+        int v = jit->nativo[f](fp, entrada);
+        RETORNA(v, funcoes[f].retornaValor);
+        PROXIMA();
+      }
+    }
+    pc = alvo;
+  }
+  PROXIMA();
+
+op_jz:
+  {
+    void **alvo = ALVO();
+    if (*--sp == 0) pc = alvo;
+  }
+  PROXIMA();
+
+op_jnlt:
+  DESVIA_SE_NAO(a < b);
+  PROXIMA();
+
+op_jnle:
+  DESVIA_SE_NAO(a <= b);
+  PROXIMA();
+
+op_jngt:
+  DESVIA_SE_NAO(a > b);
+  PROXIMA();
+
+op_jnge:
+  DESVIA_SE_NAO(a >= b);
+  PROXIMA();
+
+op_jneq:
+  DESVIA_SE_NAO(a == b);
+  PROXIMA();
+
+op_jnne:
+  DESVIA_SE_NAO(a != b);
+  PROXIMA();
+
+op_call:
+  {
+    VmFuncao *f = (VmFuncao *) *pc++;
+    int *novo = sp - f->nparams;
+    if (novo + f->frameSize + f->maxPilha > limite || rp == rlimite)
+    {
+      erro = "estouro de pilha";
+      goto falha;
+    }
+    memset(novo + f->nparams, 0, sizeof(int) * (f->frameSize - f->nparams));
+    if (jit != NULL)
+    {
+      if (jit->nativo[f->indice] == NULL && ++f->contador == JIT_LIMIAR) jitCompila(jit, f->indice);
+      if (jit->nativo[f->indice] != NULL)
+      {
+        int v = jit->nativo[f->indice](novo, NULL);
+        sp = novo;
+        if (f->retornaValor) *sp++ = v;
+        PROXIMA();
+      }
+    }
+    rp->pc = pc;
+    rp->fp = fp;
+    rp++;
+    fp = novo;
+    sp = fp + f->frameSize;
+    pc = f->entrada;
+  }
+  PROXIMA();
+
+op_ret:
+  {
+    int v = sp[-1];
+    RETORNA(v, 1);
+  }
+  PROXIMA();
+
+op_retv:
+  RETORNA(0, 0);
+  PROXIMA();
+
+op_input:
+  *sp++ = cm_input();
+  PROXIMA();
+
+op_output:
+  cm_output(*--sp);
+  PROXIMA();
+
+op_limite:
+  if ((unsigned) sp[-1] >= (unsigned) ARG())
+  {
+    erro = "índice fora dos limites";
+    goto falha;
+  }
+  PROXIMA();
+
+op_limitel:
+  if ((unsigned) sp[-1] >= (unsigned) fp[ARG()])
+  {
+    erro = "índice fora dos limites";
+    goto falha;
+  }
+  PROXIMA();
+
+falha:
+  {
+    /* pc já avançou além do opcode que falhou */
+    falha(erro, funcaoDe((int) (pc - 1 - codigo)));
+  }
+  return 0;
+
+#undef PROXIMA
+#undef ARG
+#undef ALVO
+#undef BINARIA
+#undef DESVIA_SE_NAO
+#undef RETORNA
+}
+
+/* chamada do código nativo para uma função ainda interpretada; o frame
+   já foi preparado (argumentos, locais zeradas, espaço verificado) */
+static int chamaInterpretada(int f, int *fp)
+{
+  return vmLaco(funcoes[f].entrada, fp, fp + funcoes[f].frameSize);
+}
+
+int vmExecuta(Bytecode *programa, VmStats *stats)
+{
+  bc = programa;
+  vmLaco(NULL, NULL, NULL);
+
+  /* converte o bytecode em código encadeado: opcodes viram endereços
+     de rótulos, alvos de desvio viram ponteiros para o código */
+  codigo = (void **) malloc(sizeof(void *) * bc->nCodigo);
+  funcoes = (VmFuncao *) calloc(bc->nFuncoes, sizeof(VmFuncao));
+  for (int i = 0; i < bc->nFuncoes; i++)
+  {
+    BcFuncao *f = &bc->funcoes[i];
+    funcoes[i].entrada = (f->entrada >= 0) ? codigo + f->entrada : NULL;
+    funcoes[i].nparams = f->nparams;
+    funcoes[i].frameSize = f->frameSize;
+    funcoes[i].maxPilha = f->maxPilha;
+    funcoes[i].indice = i;
+    funcoes[i].retornaValor = f->retornaValor;
+  }
+  for (int pc = 0; pc < bc->nCodigo; )
+  {
+    OpCode op = (OpCode) bc->codigo[pc];
+    codigo[pc] = rotulos[op];
+    if (bcOperandos(op) == 1)
+    {
+      int arg = bc->codigo[pc + 1];
+      if (op == OP_JMP || op == OP_JZ || (op >= OP_JNLT && op <= OP_JNNE))
+        codigo[pc + 1] = codigo + arg;
+      else if (op == OP_CALL)
+        codigo[pc + 1] = &funcoes[arg];
+      else
+        codigo[pc + 1] = (void *) (intptr_t) arg;
+    }
+    pc += 1 + bcOperandos(op);
+  }
+
+  mem = (int *) calloc((size_t) bc->tamGlobais + VM_PILHA, sizeof(int));
+  limite = mem + bc->tamGlobais + VM_PILHA;
+  retornos = (VmRetorno *) malloc(sizeof(VmRetorno) * VM_CHAMADAS);
+  rp = retornos;
+  rlimite = retornos + VM_CHAMADAS;
+  executadas = 0;
+  jit = NULL;
+  contLaco = NULL;
+  funcaoDoPc = NULL;
+
+  if (mem == NULL || retornos == NULL)
+  {
+    fprintf(stderr, "ERRO DE EXECUÇÃO: memória insuficiente para a VM.\n");
+    free(codigo);
+    free(funcoes);
+    free(mem);
+    free(retornos);
+    return 1;
+  }
+
+  if (usaJit)
+  {
+    jit = jitCria(bc, mem, limite, chamaInterpretada, falha);
+    contLaco = (int *) calloc(bc->nCodigo, sizeof(int));
+    funcaoDoPc = (int *) malloc(sizeof(int) * bc->nCodigo);
+    for (int pc = 0; pc < bc->nCodigo; pc++) funcaoDoPc[pc] = -1;
+    for (int i = 0; i < bc->nFuncoes; i++)
+    {
+      int e = bc->funcoes[i].entrada;
+      if (e < 0) continue;
+      int fim = bc->nCodigo;
+      for (int k = 0; k < bc->nFuncoes; k++)
+        if (bc->funcoes[k].entrada > e && bc->funcoes[k].entrada < fim) fim = bc->funcoes[k].entrada;
+      for (int pc = e; pc < fim; pc++) funcaoDoPc[pc] = i;
+    }
+
+    /* a recursão nativa usa a pilha do processo: deixa uma margem */
+    struct rlimit rl;
+    size_t pilhaC = 8u << 20;
+    if (getrlimit(RLIMIT_STACK, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur < (rlim_t) 1 << 30)
+      pilhaC = (size_t) rl.rlim_cur;
+    char marca;
+    jit->limitePilhaC = &marca - pilhaC + (512u << 10);
+  }
+
+  int status = 0;
+  double inicio = agora();
+  if (setjmp(saidaErro) == 0)
+    vmLaco(codigo, mem + bc->tamGlobais, mem + bc->tamGlobais);
+  else
+    status = 1;
+
+  cm_flush();
+  if (stats != NULL)
+  {
+    stats->instrucoes = executadas;
+    stats->segundos = agora() - inicio;
+    stats->compiladas = jit ? jit->compiladas : 0;
+    stats->bytesJit = jit ? jit->bytes : 0;
+  }
+
+  jitLibera(jit);
+  free(contLaco);
+  free(funcaoDoPc);
+  free(codigo);
+  free(funcoes);
+  free(mem);
+  free(retornos);
+  jit = NULL;
+  return status;
+}
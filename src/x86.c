@@ -0,0 +1,616 @@
+#include "../include/x86.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *nomes64[] = {
+  "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+  "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+static const char *nomes32[] = {
+  "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+  "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+};
+static const char *nomes8[] = {
+  "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+  "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"
+};
+static const char *sufixosCond[] = { "l", "le", "g", "ge", "e", "ne", "b", "ae", "be", "a" };
+static const char *nomesAlu[] = { "add", "sub", "imul", "cmp", "xor", "test" };
+
+/* codificação: nibble de condição, opcodes reg/mem e extensão /n com imediato */
+static const int codCond[] = { 0xC, 0xE, 0xF, 0xD, 0x4, 0x5, 0x2, 0x3, 0x6, 0x7 };
+static const int opAluRm[] = { 0x01, 0x29, -1, 0x39, 0x31, 0x85 };  // rm op= reg
+static const int opAluReg[] = { 0x03, 0x2B, -1, 0x3B, 0x33, 0x85 }; // reg op= rm
+static const int extAluImm[] = { 0, 5, -1, 7, 6, 0 };
+
+static const char *reg(int w, X86Reg r)
+{
+  return (w == 8) ? nomes64[r] : nomes32[r];
+}
+
+static char sufixo(int w)
+{
+  return (w == 8) ? 'q' : 'l';
+}
+
+/* ---------- modo binário ---------- */
+
+static void byte(X86Asm *a, int b)
+{
+  if (a->n == a->cap)
+  {
+    a->cap = a->cap ? a->cap * 2 : 256;
+    a->codigo = (unsigned char *) realloc(a->codigo, a->cap);
+  }
+  a->codigo[a->n++] = (unsigned char) b;
+}
+
+static void dword(X86Asm *a, int v)
+{
+  unsigned u = (unsigned) v;
+  for (int k = 0; k < 4; k++) byte(a, (u >> (8 * k)) & 0xFF);
+}
+
+static void escreveDword(X86Asm *a, int pos, int v)
+{
+  unsigned u = (unsigned) v;
+  for (int k = 0; k < 4; k++) a->codigo[pos + k] = (unsigned char) ((u >> (8 * k)) & 0xFF);
+}
+
+static int cabe8(int v)
+{
+  return v >= -128 && v <= 127;
+}
+
+/* prefixo REX: W (64 bits), R (campo reg), X (índice), B (base/rm).
+   'forca' emite mesmo sem bits (registradores de 8 bits spl..dil) */
+static void rex(X86Asm *a, int w, int r, int x, int b, int forca)
+{
+  int v = 0x40 | ((w == 8) << 3) | (((r >> 3) & 1) << 2) | (((x >> 3) & 1) << 1) | ((b >> 3) & 1);
+  if (v != 0x40 || forca) byte(a, v);
+}
+
+static void opcode(X86Asm *a, int op)
+{
+  if (op > 0xFF) byte(a, op >> 8);
+  byte(a, op & 0xFF);
+}
+
+/* instrução com operando registrador-registrador (mod = 11) */
+static void codRR(X86Asm *a, int w, int op, int r, int rm, int forca8)
+{
+  rex(a, w, r, 0, rm, forca8 && ((r >= 4 && r <= 7) || (rm >= 4 && rm <= 7)));
+  opcode(a, op);
+  byte(a, 0xC0 | ((r & 7) << 3) | (rm & 7));
+}
+
+static void reloc(X86Asm *a, const char *simbolo, int addend, int chamada)
+{
+  if (a->nRelocs == a->capRelocs)
+  {
+    a->capRelocs = a->capRelocs ? a->capRelocs * 2 : 16;
+    a->relocs = (X86Reloc *) realloc(a->relocs, sizeof(X86Reloc) * a->capRelocs);
+  }
+  X86Reloc *r = &a->relocs[a->nRelocs++];
+  r->pos = a->n;
+  r->simbolo = strdup(simbolo);
+  r->addend = addend;
+  r->chamada = chamada;
+}
+
+static X86Simbolo *defineSimbolo(X86Asm *a, const char *nome, int bss, int pos)
+{
+  if (a->nSimbolos == a->capSimbolos)
+  {
+    a->capSimbolos = a->capSimbolos ? a->capSimbolos * 2 : 16;
+    a->simbolos = (X86Simbolo *) realloc(a->simbolos, sizeof(X86Simbolo) * a->capSimbolos);
+  }
+  X86Simbolo *s = &a->simbolos[a->nSimbolos++];
+  s->nome = strdup(nome);
+  s->bss = bss;
+  s->pos = pos;
+  s->tamanho = 0;
+  return s;
+}
+
+/* ModRM (+ SIB + deslocamento) de um operando de memória */
+static void modrmMem(X86Asm *a, int r, X86Mem m, int imediato)
+{
+  if (m.simbolo != NULL)
+  {
+    /* rip-relativo: o rel32 é contado a partir do fim da instrução */
+    byte(a, 0x05 | ((r & 7) << 3));
+    reloc(a, m.simbolo, -4 - imediato, 0);
+    dword(a, 0);
+    return;
+  }
+  int base = m.base & 7;
+  int sib = (m.indice != SEM_REG) || base == 4;
+  int mod = (m.desloc == 0 && base != 5) ? 0 : cabe8(m.desloc) ? 1 : 2;
+  byte(a, (mod << 6) | ((r & 7) << 3) | (sib ? 4 : base));
+  if (sib)
+  {
+    int escala = (m.escala == 8) ? 3 : (m.escala == 4) ? 2 : (m.escala == 2) ? 1 : 0;
+    int indice = (m.indice != SEM_REG) ? (m.indice & 7) : 4;
+    byte(a, (escala << 6) | (indice << 3) | base);
+  }
+  if (mod == 1) byte(a, m.desloc & 0xFF);
+  else if (mod == 2) dword(a, m.desloc);
+}
+
+/* instrução com operando de memória; 'imediato' = bytes de imediato que
+   seguem (para o ajuste do rel32 rip-relativo) */
+static void codRM(X86Asm *a, int w, int op, int r, X86Mem m, int imediato)
+{
+  int x = (m.indice != SEM_REG) ? m.indice : 0;
+  int b = (m.simbolo == NULL) ? m.base : 0;
+  rex(a, w, r, x, b, 0);
+  opcode(a, op);
+  modrmMem(a, r, m, imediato);
+}
+
+static void garanteRotulo(X86Asm *a, int rotulo)
+{
+  if (rotulo < a->capRotulos) return;
+  int novo = a->capRotulos ? a->capRotulos : 64;
+  while (novo <= rotulo) novo *= 2;
+  a->rotulos = (int *) realloc(a->rotulos, sizeof(int) * novo);
+  for (int k = a->capRotulos; k < novo; k++) a->rotulos[k] = -1;
+  a->capRotulos = novo;
+}
+
+/* rel32 para um rótulo, corrigido em x86_finaliza */
+static void relRotulo(X86Asm *a, int rotulo)
+{
+  if (a->nPendencias == a->capPendencias)
+  {
+    a->capPendencias = a->capPendencias ? a->capPendencias * 2 : 64;
+    a->pendencias = (X86Pendencia *) realloc(a->pendencias, sizeof(X86Pendencia) * a->capPendencias);
+  }
+  a->pendencias[a->nPendencias].pos = a->n;
+  a->pendencias[a->nPendencias].rotulo = rotulo;
+  a->nPendencias++;
+  dword(a, 0);
+}
+
+void x86_binario(X86Asm *a)
+{
+  memset(a, 0, sizeof(X86Asm));
+}
+
+int x86_finaliza(X86Asm *a)
+{
+  for (int k = 0; k < a->nPendencias; k++)
+  {
+    X86Pendencia *p = &a->pendencias[k];
+    if (p->rotulo >= a->capRotulos || a->rotulos[p->rotulo] < 0) return 1;
+    escreveDword(a, p->pos, a->rotulos[p->rotulo] - (p->pos + 4));
+  }
+  a->nPendencias = 0;
+  return 0;
+}
+
+void x86_libera(X86Asm *a)
+{
+  for (int k = 0; k < a->nRelocs; k++) free(a->relocs[k].simbolo);
+  free(a->relocs);
+  for (int k = 0; k < a->nSimbolos; k++) free(a->simbolos[k].nome);
+  free(a->simbolos);
+  free(a->codigo);
+  free(a->rotulos);
+  free(a->pendencias);
+  memset(a, 0, sizeof(X86Asm));
+}
+
+int x86_posicao(X86Asm *a, int rotulo)
+{
+  return (rotulo < a->capRotulos) ? a->rotulos[rotulo] : -1;
+}
+
+/* ---------- operandos ---------- */
+
+X86Mem x86_mem(X86Reg base, int desloc)
+{
+  X86Mem m = { base, SEM_REG, 1, desloc, NULL };
+  return m;
+}
+
+X86Mem x86_mem_idx(X86Reg base, X86Reg indice, int escala, int desloc)
+{
+  X86Mem m = { base, indice, escala, desloc, NULL };
+  return m;
+}
+
+X86Mem x86_mem_sym(const char *simbolo)
+{
+  X86Mem m = { SEM_REG, SEM_REG, 1, 0, simbolo };
+  return m;
+}
+
+static void imprimeMem(X86Asm *a, X86Mem m)
+{
+  if (m.simbolo != NULL)
+  {
+    fprintf(a->saida, "%s(%%rip)", m.simbolo);
+    return;
+  }
+  if (m.desloc != 0) fprintf(a->saida, "%d", m.desloc);
+  if (m.indice != SEM_REG)
+    fprintf(a->saida, "(%%%s,%%%s,%d)", nomes64[m.base], nomes64[m.indice], m.escala);
+  else
+    fprintf(a->saida, "(%%%s)", nomes64[m.base]);
+}
+
+/* ---------- instruções ---------- */
+
+void x86_mov_rr(X86Asm *a, int w, X86Reg dst, X86Reg src)
+{
+  if (dst == src) return;
+  if (a->saida == NULL)
+  {
+    codRR(a, w, 0x89, src, dst, 0);
+    return;
+  }
+  fprintf(a->saida, "\tmov%c\t%%%s, %%%s\n", sufixo(w), reg(w, src), reg(w, dst));
+}
+
+void x86_mov_ri(X86Asm *a, X86Reg dst, int imm)
+{
+  if (a->saida == NULL)
+  {
+    if (imm == 0)
+    {
+      codRR(a, 4, 0x31, dst, dst, 0);
+      return;
+    }
+    rex(a, 4, 0, 0, dst, 0);
+    byte(a, 0xB8 + (dst & 7));
+    dword(a, imm);
+    return;
+  }
+  if (imm == 0)
+    fprintf(a->saida, "\txorl\t%%%s, %%%s\n", nomes32[dst], nomes32[dst]);
+  else
+    fprintf(a->saida, "\tmovl\t$%d, %%%s\n", imm, nomes32[dst]);
+}
+
+void x86_mov_ri64(X86Asm *a, X86Reg dst, long long imm)
+{
+  if (a->saida == NULL)
+  {
+    rex(a, 8, 0, 0, dst, 0);
+    byte(a, 0xB8 + (dst & 7));
+    unsigned long long u = (unsigned long long) imm;
+    for (int k = 0; k < 8; k++) byte(a, (u >> (8 * k)) & 0xFF);
+    return;
+  }
+  fprintf(a->saida, "\tmovabsq\t$%lld, %%%s\n", imm, nomes64[dst]);
+}
+
+void x86_load(X86Asm *a, int w, X86Reg dst, X86Mem m)
+{
+  if (a->saida == NULL)
+  {
+    codRM(a, w, 0x8B, dst, m, 0);
+    return;
+  }
+  fprintf(a->saida, "\tmov%c\t", sufixo(w));
+  imprimeMem(a, m);
+  fprintf(a->saida, ", %%%s\n", reg(w, dst));
+}
+
+void x86_store(X86Asm *a, int w, X86Mem m, X86Reg src)
+{
+  if (a->saida == NULL)
+  {
+    codRM(a, w, 0x89, src, m, 0);
+    return;
+  }
+  fprintf(a->saida, "\tmov%c\t%%%s, ", sufixo(w), reg(w, src));
+  imprimeMem(a, m);
+  fprintf(a->saida, "\n");
+}
+
+void x86_store_i(X86Asm *a, X86Mem m, int imm)
+{
+  if (a->saida == NULL)
+  {
+    codRM(a, 4, 0xC7, 0, m, 4);
+    dword(a, imm);
+    return;
+  }
+  fprintf(a->saida, "\tmovl\t$%d, ", imm);
+  imprimeMem(a, m);
+  fprintf(a->saida, "\n");
+}
+
+void x86_lea(X86Asm *a, X86Reg dst, X86Mem m)
+{
+  if (a->saida == NULL)
+  {
+    codRM(a, 8, 0x8D, dst, m, 0);
+    return;
+  }
+  fprintf(a->saida, "\tleaq\t");
+  imprimeMem(a, m);
+  fprintf(a->saida, ", %%%s\n", nomes64[dst]);
+}
+
+void x86_movsx(X86Asm *a, X86Reg dst, X86Reg src)
+{
+  if (a->saida == NULL)
+  {
+    codRR(a, 8, 0x63, dst, src, 0);
+    return;
+  }
+  fprintf(a->saida, "\tmovslq\t%%%s, %%%s\n", nomes32[src], nomes64[dst]);
+}
+
+void x86_alu(X86Asm *a, X86Alu op, int w, X86Reg dst, X86Reg src)
+{
+  if (a->saida == NULL)
+  {
+    if (op == X86_IMUL) codRR(a, w, 0x0FAF, dst, src, 0);
+    else codRR(a, w, opAluRm[op], src, dst, 0);
+    return;
+  }
+  fprintf(a->saida, "\t%s%c\t%%%s, %%%s\n", nomesAlu[op], sufixo(w), reg(w, src), reg(w, dst));
+}
+
+void x86_alu_ri(X86Asm *a, X86Alu op, int w, X86Reg dst, int imm)
+{
+  if (a->saida == NULL)
+  {
+    if (op == X86_IMUL)
+    {
+      codRR(a, w, cabe8(imm) ? 0x6B : 0x69, dst, dst, 0);
+    }
+    else if (op == X86_TEST)
+    {
+      codRR(a, w, 0xF7, 0, dst, 0);
+      dword(a, imm);
+      return;
+    }
+    else
+    {
+      codRR(a, w, cabe8(imm) ? 0x83 : 0x81, extAluImm[op], dst, 0);
+    }
+    if (cabe8(imm)) byte(a, imm & 0xFF);
+    else dword(a, imm);
+    return;
+  }
+  if (op == X86_IMUL)
+    fprintf(a->saida, "\timul%c\t$%d, %%%s, %%%s\n", sufixo(w), imm, reg(w, dst), reg(w, dst));
+  else
+    fprintf(a->saida, "\t%s%c\t$%d, %%%s\n", nomesAlu[op], sufixo(w), imm, reg(w, dst));
+}
+
+void x86_alu_rm(X86Asm *a, X86Alu op, int w, X86Reg dst, X86Mem m)
+{
+  if (a->saida == NULL)
+  {
+    codRM(a, w, (op == X86_IMUL) ? 0x0FAF : opAluReg[op], dst, m, 0);
+    return;
+  }
+  fprintf(a->saida, "\t%s%c\t", nomesAlu[op], sufixo(w));
+  imprimeMem(a, m);
+  fprintf(a->saida, ", %%%s\n", reg(w, dst));
+}
+
+void x86_sar_ri(X86Asm *a, int w, X86Reg r, int imm)
+{
+  if (a->saida == NULL)
+  {
+    codRR(a, w, 0xC1, 7, r, 0);
+    byte(a, imm & 0xFF);
+    return;
+  }
+  fprintf(a->saida, "\tsar%c\t$%d, %%%s\n", sufixo(w), imm, reg(w, r));
+}
+
+void x86_neg(X86Asm *a, X86Reg r)
+{
+  if (a->saida == NULL)
+  {
+    codRR(a, 4, 0xF7, 3, r, 0);
+    return;
+  }
+  fprintf(a->saida, "\tnegl\t%%%s\n", nomes32[r]);
+}
+
+void x86_cdq(X86Asm *a)
+{
+  if (a->saida == NULL)
+  {
+    byte(a, 0x99);
+    return;
+  }
+  fprintf(a->saida, "\tcltd\n");
+}
+
+void x86_idiv(X86Asm *a, X86Reg r)
+{
+  if (a->saida == NULL)
+  {
+    codRR(a, 4, 0xF7, 7, r, 0);
+    return;
+  }
+  fprintf(a->saida, "\tidivl\t%%%s\n", nomes32[r]);
+}
+
+void x86_setcc(X86Asm *a, X86Cond cc, X86Reg dst)
+{
+  if (a->saida == NULL)
+  {
+    codRR(a, 4, 0x0F90 + codCond[cc], 0, dst, 1);
+    codRR(a, 4, 0x0FB6, dst, dst, 1);
+    return;
+  }
+  fprintf(a->saida, "\tset%s\t%%%s\n", sufixosCond[cc], nomes8[dst]);
+  fprintf(a->saida, "\tmovzbl\t%%%s, %%%s\n", nomes8[dst], nomes32[dst]);
+}
+
+void x86_push(X86Asm *a, X86Reg r)
+{
+  if (a->saida == NULL)
+  {
+    rex(a, 4, 0, 0, r, 0);
+    byte(a, 0x50 + (r & 7));
+    return;
+  }
+  fprintf(a->saida, "\tpushq\t%%%s\n", nomes64[r]);
+}
+
+void x86_push_m(X86Asm *a, X86Mem m)
+{
+  if (a->saida == NULL)
+  {
+    codRM(a, 4, 0xFF, 6, m, 0);
+    return;
+  }
+  fprintf(a->saida, "\tpushq\t");
+  imprimeMem(a, m);
+  fprintf(a->saida, "\n");
+}
+
+void x86_pop(X86Asm *a, X86Reg r)
+{
+  if (a->saida == NULL)
+  {
+    rex(a, 4, 0, 0, r, 0);
+    byte(a, 0x58 + (r & 7));
+    return;
+  }
+  fprintf(a->saida, "\tpopq\t%%%s\n", nomes64[r]);
+}
+
+void x86_ret(X86Asm *a)
+{
+  if (a->saida == NULL)
+  {
+    byte(a, 0xC3);
+    return;
+  }
+  fprintf(a->saida, "\tret\n");
+}
+
+void x86_label(X86Asm *a, int rotulo)
+{
+  if (a->saida == NULL)
+  {
+    garanteRotulo(a, rotulo);
+    a->rotulos[rotulo] = a->n;
+    return;
+  }
+  fprintf(a->saida, "%s%d:\n", a->prefixoRotulo, rotulo);
+}
+
+void x86_jmp(X86Asm *a, int rotulo)
+{
+  if (a->saida == NULL)
+  {
+    byte(a, 0xE9);
+    relRotulo(a, rotulo);
+    return;
+  }
+  fprintf(a->saida, "\tjmp\t%s%d\n", a->prefixoRotulo, rotulo);
+}
+
+void x86_jcc(X86Asm *a, X86Cond cc, int rotulo)
+{
+  if (a->saida == NULL)
+  {
+    byte(a, 0x0F);
+    byte(a, 0x80 + codCond[cc]);
+    relRotulo(a, rotulo);
+    return;
+  }
+  fprintf(a->saida, "\tj%s\t%s%d\n", sufixosCond[cc], a->prefixoRotulo, rotulo);
+}
+
+void x86_call(X86Asm *a, const char *simbolo)
+{
+  if (a->saida == NULL)
+  {
+    byte(a, 0xE8);
+    reloc(a, simbolo, -4, 1);
+    dword(a, 0);
+    return;
+  }
+  fprintf(a->saida, "\tcall\t%s\n", simbolo);
+}
+
+void x86_call_r(X86Asm *a, X86Reg r)
+{
+  if (a->saida == NULL)
+  {
+    codRR(a, 4, 0xFF, 2, r, 0);
+    return;
+  }
+  fprintf(a->saida, "\tcall\t*%%%s\n", nomes64[r]);
+}
+
+void x86_jmp_r(X86Asm *a, X86Reg r)
+{
+  if (a->saida == NULL)
+  {
+    codRR(a, 4, 0xFF, 4, r, 0);
+    return;
+  }
+  fprintf(a->saida, "\tjmp\t*%%%s\n", nomes64[r]);
+}
+
+/* ---------- diretivas ---------- */
+
+void x86_text(X86Asm *a)
+{
+  if (a->saida == NULL) return;
+  fprintf(a->saida, "\t.text\n");
+}
+
+void x86_funcao(X86Asm *a, const char *simbolo)
+{
+  if (a->saida == NULL)
+  {
+    /* alinha o início da função em 16 com nops */
+    while (a->n % 16 != 0) byte(a, 0x90);
+    defineSimbolo(a, simbolo, 0, a->n);
+    return;
+  }
+  fprintf(a->saida, "\n\t.globl\t%s\n", simbolo);
+  fprintf(a->saida, "\t.type\t%s, @function\n", simbolo);
+  fprintf(a->saida, "%s:\n", simbolo);
+}
+
+void x86_fim_funcao(X86Asm *a, const char *simbolo)
+{
+  if (a->saida == NULL)
+  {
+    for (int k = a->nSimbolos - 1; k >= 0; k--)
+      if (!a->simbolos[k].bss && strcmp(a->simbolos[k].nome, simbolo) == 0)
+      {
+        a->simbolos[k].tamanho = a->n - a->simbolos[k].pos;
+        break;
+      }
+    return;
+  }
+  fprintf(a->saida, "\t.size\t%s, .-%s\n", simbolo, simbolo);
+}
+
+void x86_bss(X86Asm *a, const char *simbolo, int bytes)
+{
+  if (a->saida == NULL)
+  {
+    a->tamBss = (a->tamBss + 15) & ~15;
+    defineSimbolo(a, simbolo, 1, a->tamBss)->tamanho = bytes;
+    a->tamBss += bytes;
+    return;
+  }
+  fprintf(a->saida, "\n\t.bss\n");
+  fprintf(a->saida, "\t.globl\t%s\n", simbolo);
+  fprintf(a->saida, "\t.align\t16\n");
+  fprintf(a->saida, "\t.type\t%s, @object\n", simbolo);
+  fprintf(a->saida, "\t.size\t%s, %d\n", simbolo, bytes);
+  fprintf(a->saida, "%s:\n", simbolo);
+  fprintf(a->saida, "\t.zero\t%d\n", bytes);
+}
@@ -0,0 +1,72 @@
+/* Testes da libcminus (make check-lib): diagnósticos e símbolos de
+   cmCompilaFonte, e a árvore devolvida depois de outras compilações. */
+#include "cminus.h"
+#include <stdio.h>
+#include <string.h>
+
+static int falhas = 0;
+
+static void confere(int cond, const char *caso) {
+    printf("%s %s\n", cond ? "ok  " : "FALHA", caso);
+    falhas += !cond;
+}
+
+static CmResultado *compila(const char *fonte) {
+    return cmCompilaFonte(fonte, strlen(fonte));
+}
+
+/* nenhum nó pode apontar para a tabela, que já foi liberada */
+static int semSimbolos(const TreeNode *t) {
+    for (; t != NULL; t = t->irmao)
+        if (t->sym != NULL || !semSimbolos(t->filho)) return 0;
+    return 1;
+}
+
+static int temDiagnostico(const CmResultado *r, DiagTipo tipo, int linha) {
+    for (int i = 0; i < cmNumDiagnosticos(r); i++) {
+        const CmDiagnostico *d = cmDiagnostico(r, i);
+        if (d->tipo == tipo && d->linha == linha) return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    CmResultado *a = compila("int g[4];\nint f(int x) { return x + g[1]; }\nvoid main(void) { output(f(2)); }\n");
+    int simbolos = cmNumSimbolos(a);
+    confere(cmOk(a) && simbolos > 0, "programa correto");
+    confere(cmArvore(a) != NULL && semSimbolos(cmArvore(a)), "árvore sem ponteiros para a tabela");
+
+    /* outra compilação não mexe no resultado anterior */
+    CmResultado *b = compila("void main(void) { int x; x = y; }\n");
+    confere(!cmOk(b) && temDiagnostico(b, DIAG_SEMANTICO, 1), "erro semântico");
+    confere(cmOk(a) && cmNumSimbolos(a) == simbolos && cmArvore(a)->filho != NULL, "resultado anterior intacto");
+    cmLibera(b);
+    cmLibera(a);
+
+    CmResultado *c = compila("void main(void) { int x; x = 1; }\n");
+    confere(cmOk(c), "tabela recomeça depois de liberada");
+    cmLibera(c);
+
+    /* os erros léxicos também chegam pelo coletor, e o analisador recomeça
+       fora do comentário na compilação seguinte */
+    CmResultado *d = compila("void main(void)\n{ int x; x = 1 @ 2; }\n");
+    confere(temDiagnostico(d, DIAG_LEXICO, 2) && cmArvore(d) == NULL, "erro léxico");
+    cmLibera(d);
+    CmResultado *e = compila("void main(void) { }\n/* sem fim\n");
+    confere(temDiagnostico(e, DIAG_LEXICO, 2), "comentário não fechado");
+    cmLibera(e);
+    CmResultado *f = compila("void main(void) { }\n");
+    confere(cmOk(f), "analisador léxico recomeça");
+    cmLibera(f);
+
+    /* import: a falta da interface é erro semântico, pelo coletor; depois
+       de uma declaração, erro sintático */
+    CmResultado *g = compila("import semunidade;\nvoid main(void) { }\n");
+    confere(temDiagnostico(g, DIAG_SEMANTICO, 1), "import sem interface");
+    cmLibera(g);
+    CmResultado *h = compila("int x;\nimport semunidade;\nvoid main(void) { }\n");
+    confere(temDiagnostico(h, DIAG_SINTATICO, 2), "import depois de declaração");
+    cmLibera(h);
+
+    return falhas > 0;
+}